@@ -0,0 +1,31 @@
+# Copyright 2022 gRPC authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# lz4 is an optional dependency used for message compression. It is not
+# vendored under third_party, so the only providers are "package", which
+# locates a pre-installed library, and "none", which builds gRPC without
+# support for GRPC_COMPRESS_LZ4.
+
+if(gRPC_LZ4_PROVIDER STREQUAL "package")
+  find_path(LZ4_INCLUDE_DIR NAMES lz4frame.h)
+  find_library(LZ4_LIBRARY NAMES lz4)
+  if(NOT LZ4_INCLUDE_DIR OR NOT LZ4_LIBRARY)
+    message(FATAL_ERROR "gRPC_LZ4_PROVIDER is \"package\" but lz4 was not found")
+  endif()
+  include_directories(${LZ4_INCLUDE_DIR})
+  set(_gRPC_LZ4_LIBRARIES ${LZ4_LIBRARY})
+  add_definitions(-DGRPC_HAVE_LZ4)
+elseif(gRPC_LZ4_PROVIDER STREQUAL "none")
+  set(_gRPC_LZ4_LIBRARIES)
+endif()
@@ -0,0 +1,31 @@
+# Copyright 2022 gRPC authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# zstd is an optional dependency used for message compression. It is not
+# vendored under third_party, so the only providers are "package", which
+# locates a pre-installed library, and "none", which builds gRPC without
+# support for GRPC_COMPRESS_ZSTD.
+
+if(gRPC_ZSTD_PROVIDER STREQUAL "package")
+  find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+  find_library(ZSTD_LIBRARY NAMES zstd)
+  if(NOT ZSTD_INCLUDE_DIR OR NOT ZSTD_LIBRARY)
+    message(FATAL_ERROR "gRPC_ZSTD_PROVIDER is \"package\" but zstd was not found")
+  endif()
+  include_directories(${ZSTD_INCLUDE_DIR})
+  set(_gRPC_ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+  add_definitions(-DGRPC_HAVE_ZSTD)
+elseif(gRPC_ZSTD_PROVIDER STREQUAL "none")
+  set(_gRPC_ZSTD_LIBRARIES)
+endif()
@@ -495,11 +495,14 @@
         'src/core/ext/filters/client_channel/lb_policy/grpclb/grpclb_channel_secure.cc',
         'src/core/ext/filters/client_channel/lb_policy/grpclb/grpclb_client_stats.cc',
         'src/core/ext/filters/client_channel/lb_policy/grpclb/load_balancer_api.cc',
+        'src/core/ext/filters/client_channel/lb_policy/least_request/least_request.cc',
         'src/core/ext/filters/client_channel/lb_policy/pick_first/pick_first.cc',
         'src/core/ext/filters/client_channel/lb_policy/priority/priority.cc',
         'src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.cc',
         'src/core/ext/filters/client_channel/lb_policy/rls/rls.cc',
         'src/core/ext/filters/client_channel/lb_policy/round_robin/round_robin.cc',
+        'src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/static_stride_scheduler.cc',
+        'src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/weighted_round_robin.cc',
         'src/core/ext/filters/client_channel/lb_policy/weighted_target/weighted_target.cc',
         'src/core/ext/filters/client_channel/lb_policy/xds/cds.cc',
         'src/core/ext/filters/client_channel/lb_policy/xds/xds_cluster_impl.cc',
@@ -570,6 +573,8 @@
         'src/core/ext/transport/chttp2/transport/frame_window_update.cc',
         'src/core/ext/transport/chttp2/transport/hpack_encoder.cc',
         'src/core/ext/transport/chttp2/transport/hpack_encoder_table.cc',
+        'src/core/ext/transport/chttp2/transport/hpack_huffman_decoder.cc',
+        'src/core/ext/transport/chttp2/transport/hpack_huffman_encoder.cc',
         'src/core/ext/transport/chttp2/transport/hpack_parser.cc',
         'src/core/ext/transport/chttp2/transport/hpack_parser_table.cc',
         'src/core/ext/transport/chttp2/transport/http2_settings.cc',
@@ -890,6 +895,7 @@
         'src/core/lib/channel/handshaker_registry.cc',
         'src/core/lib/channel/status_util.cc',
         'src/core/lib/compression/compression.cc',
+        'src/core/lib/compression/compression_dictionary.cc',
         'src/core/lib/compression/compression_internal.cc',
         'src/core/lib/compression/message_compress.cc',
         'src/core/lib/config/core_configuration.cc',
@@ -920,6 +926,7 @@
         'src/core/lib/iomgr/ev_apple.cc',
         'src/core/lib/iomgr/ev_epoll1_linux.cc',
         'src/core/lib/iomgr/ev_epollex_linux.cc',
+        'src/core/lib/iomgr/ev_io_uring_linux.cc',
         'src/core/lib/iomgr/ev_poll_posix.cc',
         'src/core/lib/iomgr/ev_posix.cc',
         'src/core/lib/iomgr/ev_windows.cc',
@@ -935,6 +942,7 @@
         'src/core/lib/iomgr/executor.cc',
         'src/core/lib/iomgr/executor/mpmcqueue.cc',
         'src/core/lib/iomgr/executor/threadpool.cc',
+        'src/core/lib/iomgr/executor/work_stealing_threadpool.cc',
         'src/core/lib/iomgr/fork_posix.cc',
         'src/core/lib/iomgr/fork_windows.cc',
         'src/core/lib/iomgr/gethostname_fallback.cc',
@@ -992,6 +1000,7 @@
         'src/core/lib/iomgr/timer_generic.cc',
         'src/core/lib/iomgr/timer_heap.cc',
         'src/core/lib/iomgr/timer_manager.cc',
+        'src/core/lib/iomgr/timer_wheel.cc',
         'src/core/lib/iomgr/unix_sockets_posix.cc',
         'src/core/lib/iomgr/unix_sockets_posix_noop.cc',
         'src/core/lib/iomgr/wakeup_fd_eventfd.cc',
@@ -1258,10 +1267,13 @@
         'src/core/ext/filters/client_channel/lb_policy/grpclb/grpclb_channel.cc',
         'src/core/ext/filters/client_channel/lb_policy/grpclb/grpclb_client_stats.cc',
         'src/core/ext/filters/client_channel/lb_policy/grpclb/load_balancer_api.cc',
+        'src/core/ext/filters/client_channel/lb_policy/least_request/least_request.cc',
         'src/core/ext/filters/client_channel/lb_policy/pick_first/pick_first.cc',
         'src/core/ext/filters/client_channel/lb_policy/priority/priority.cc',
         'src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.cc',
         'src/core/ext/filters/client_channel/lb_policy/round_robin/round_robin.cc',
+        'src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/static_stride_scheduler.cc',
+        'src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/weighted_round_robin.cc',
         'src/core/ext/filters/client_channel/lb_policy/weighted_target/weighted_target.cc',
         'src/core/ext/filters/client_channel/lb_policy_registry.cc',
         'src/core/ext/filters/client_channel/local_subchannel_pool.cc',
@@ -1320,6 +1332,8 @@
         'src/core/ext/transport/chttp2/transport/frame_window_update.cc',
         'src/core/ext/transport/chttp2/transport/hpack_encoder.cc',
         'src/core/ext/transport/chttp2/transport/hpack_encoder_table.cc',
+        'src/core/ext/transport/chttp2/transport/hpack_huffman_decoder.cc',
+        'src/core/ext/transport/chttp2/transport/hpack_huffman_encoder.cc',
         'src/core/ext/transport/chttp2/transport/hpack_parser.cc',
         'src/core/ext/transport/chttp2/transport/hpack_parser_table.cc',
         'src/core/ext/transport/chttp2/transport/http2_settings.cc',
@@ -1360,6 +1374,7 @@
         'src/core/lib/channel/handshaker_registry.cc',
         'src/core/lib/channel/status_util.cc',
         'src/core/lib/compression/compression.cc',
+        'src/core/lib/compression/compression_dictionary.cc',
         'src/core/lib/compression/compression_internal.cc',
         'src/core/lib/compression/message_compress.cc',
         'src/core/lib/config/core_configuration.cc',
@@ -1389,6 +1404,7 @@
         'src/core/lib/iomgr/ev_apple.cc',
         'src/core/lib/iomgr/ev_epoll1_linux.cc',
         'src/core/lib/iomgr/ev_epollex_linux.cc',
+        'src/core/lib/iomgr/ev_io_uring_linux.cc',
         'src/core/lib/iomgr/ev_poll_posix.cc',
         'src/core/lib/iomgr/ev_posix.cc',
         'src/core/lib/iomgr/ev_windows.cc',
@@ -1404,6 +1420,7 @@
         'src/core/lib/iomgr/executor.cc',
         'src/core/lib/iomgr/executor/mpmcqueue.cc',
         'src/core/lib/iomgr/executor/threadpool.cc',
+        'src/core/lib/iomgr/executor/work_stealing_threadpool.cc',
         'src/core/lib/iomgr/fork_posix.cc',
         'src/core/lib/iomgr/fork_windows.cc',
         'src/core/lib/iomgr/gethostname_fallback.cc',
@@ -1461,6 +1478,7 @@
         'src/core/lib/iomgr/timer_generic.cc',
         'src/core/lib/iomgr/timer_heap.cc',
         'src/core/lib/iomgr/timer_manager.cc',
+        'src/core/lib/iomgr/timer_wheel.cc',
         'src/core/lib/iomgr/unix_sockets_posix.cc',
         'src/core/lib/iomgr/unix_sockets_posix_noop.cc',
         'src/core/lib/iomgr/wakeup_fd_eventfd.cc',
@@ -1597,6 +1615,7 @@
         'src/cpp/common/channel_arguments.cc',
         'src/cpp/common/channel_filter.cc',
         'src/cpp/common/completion_queue_cc.cc',
+        'src/cpp/common/compression_dictionary.cc',
         'src/cpp/common/core_codegen.cc',
         'src/cpp/common/resource_quota_cc.cc',
         'src/cpp/common/rpc_method.cc',
@@ -1727,6 +1746,7 @@
         'src/cpp/common/channel_arguments.cc',
         'src/cpp/common/channel_filter.cc',
         'src/cpp/common/completion_queue_cc.cc',
+        'src/cpp/common/compression_dictionary.cc',
         'src/cpp/common/core_codegen.cc',
         'src/cpp/common/insecure_create_auth_context.cc',
         'src/cpp/common/resource_quota_cc.cc',
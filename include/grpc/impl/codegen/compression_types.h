@@ -49,9 +49,30 @@ extern "C" {
  * GRPC_COMPRESS_NONE, the next bit to GRPC_COMPRESS_DEFLATE, etc.
  * Unset bits disable support for the algorithm. By default all algorithms are
  * supported. It's not possible to disable GRPC_COMPRESS_NONE (the attempt will
- * be ignored). */
+ * be ignored). Algorithms that are not built into this binary (see \a
+ * grpc_compression_algorithm) are never used or advertised, regardless of
+ * this setting. */
 #define GRPC_COMPRESSION_CHANNEL_ENABLED_ALGORITHMS_BITSET \
   "grpc.compression_enabled_algorithms_bitset"
+/** Compression level used by GRPC_COMPRESS_ZSTD when sending messages, as
+ * understood by zstd: higher levels compress better but more slowly, and
+ * negative levels trade ratio for speed. 0 selects zstd's default (3).
+ * Its value is an int. */
+#define GRPC_COMPRESSION_CHANNEL_ZSTD_LEVEL "grpc.compression_zstd_level"
+/** If non-zero, each call keeps the compression contexts it uses until it
+ * ends, rather than returning them to a pool shared by all calls after each
+ * message. This saves CPU on streams carrying many messages, at the cost of
+ * memory held by every active call (~256KiB for gzip and deflate).
+ * Its value is an int, 0 (the default) or 1. */
+#define GRPC_COMPRESSION_CHANNEL_PER_CALL_CONTEXTS \
+  "grpc.compression_per_call_contexts"
+/** Messages of at least this many bytes that are sent with
+ * GRPC_COMPRESS_DEFLATE or GRPC_COMPRESS_GZIP are split into blocks that are
+ * compressed in parallel on the executor, rather than on the thread sending
+ * them. The output is an ordinary zlib or gzip stream. Its value is an int:
+ * 0 disables parallel compression. Defaults to 4MiB. */
+#define GRPC_COMPRESSION_CHANNEL_PARALLEL_THRESHOLD \
+  "grpc.compression_parallel_threshold"
 /** \} */
 
 /** The various compression algorithms supported by gRPC (not sorted by
@@ -60,6 +81,10 @@ typedef enum {
   GRPC_COMPRESS_NONE = 0,
   GRPC_COMPRESS_DEFLATE,
   GRPC_COMPRESS_GZIP,
+  /** Only available if gRPC is built with zstd (GRPC_HAVE_ZSTD) */
+  GRPC_COMPRESS_ZSTD,
+  /** Only available if gRPC is built with LZ4 (GRPC_HAVE_LZ4) */
+  GRPC_COMPRESS_LZ4,
   /* TODO(ctiller): snappy */
   GRPC_COMPRESS_ALGORITHMS_COUNT
 } grpc_compression_algorithm;
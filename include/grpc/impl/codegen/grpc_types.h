@@ -298,6 +298,33 @@ typedef struct {
 #define GRPC_ARG_RESOURCE_QUOTA "grpc.resource_quota"
 /** If non-zero, expand wildcard addresses to a list of local addresses. */
 #define GRPC_ARG_EXPAND_WILDCARD_ADDRS "grpc.expand_wildcard_addrs"
+/** If non-zero, bind each connection accepted by a server to a single one of
+    its completion queues, and deliver every call on the connection to that
+    queue only. Where SO_INCOMING_CPU is available, the queue is picked from
+    the CPU that received the connection (CPU i maps to the i-th queue modulo
+    the number of queues), so that pinning the threads polling each queue to
+    the matching CPUs keeps a connection's work on one core. Otherwise queues
+    are assigned round robin. Defaults to 0. */
+#define GRPC_ARG_SERVER_CQ_AFFINITY "grpc.server_cq_affinity"
+/** If non-zero, and SO_REUSEPORT is in use, a server listens on each port with
+    one socket per completion queue pollset, and every connection accepted by
+    a socket is polled by that socket's pollset only, so that each shard of
+    connections is served by the threads polling one completion queue.
+    Combine with GRPC_ARG_SERVER_CQ_AFFINITY to deliver the calls of those
+    connections to that completion queue too. Defaults to 0. */
+#define GRPC_ARG_SHARDED_LISTENERS "grpc.sharded_listeners"
+/** If non-zero, along with GRPC_ARG_SHARDED_LISTENERS, attach a BPF program to
+    the listening sockets of each port so that the kernel hands a connection
+    received on CPU i to the i-th socket (modulo the number of sockets)
+    instead of picking one by hash. Linux only. Defaults to 0. */
+#define GRPC_ARG_REUSEPORT_CPU_STEERING "grpc.reuseport_cpu_steering"
+/** C++ synchronous servers only: if positive, the time in microseconds that
+    incoming calls should wait at most, in a steady state, for a thread to
+    handle them. The number of threads serving each completion queue is then
+    driven by that target rather than kept between the minimum and maximum
+    number of pollers. Defaults to 0 (disabled). */
+#define GRPC_ARG_SYNC_SERVER_QUEUEING_DELAY_TARGET_US \
+  "grpc.sync_server_queueing_delay_target_us"
 /** Service config data in JSON form.
     This value will be ignored if the name resolver returns a service config. */
 #define GRPC_ARG_SERVICE_CONFIG "grpc.service_config"
@@ -349,6 +376,26 @@ typedef struct {
    issued by the tcp_write(). By default, this is set to 4. */
 #define GRPC_ARG_TCP_TX_ZEROCOPY_MAX_SIMULT_SENDS \
   "grpc.experimental.tcp_tx_zerocopy_max_simultaneous_sends"
+/* TCP TX Zerocopy adaptive tuning: when non-zero (the default), each
+   connection measures its copy cost against the cost of handling zerocopy
+   completions and adjusts the send threshold and the number of simultaneous
+   sends at runtime. The two settings above then only provide the initial
+   threshold and the upper bound on simultaneous sends. Setting the send
+   threshold explicitly turns adaptive tuning off, unless this argument is
+   also set. The current decisions are reported as channelz socket options. */
+#define GRPC_ARG_TCP_TX_ZEROCOPY_ADAPTIVE \
+  "grpc.experimental.tcp_tx_zerocopy_adaptive"
+/* TCP RX Zerocopy enable state: zero is disabled, non-zero is enabled. When
+   enabled, large reads map the kernel's receive buffer pages into slices
+   (TCP_ZEROCOPY_RECEIVE) instead of copying them, falling back to copying when
+   the data is not page aligned. Mapped pages are charged to the resource
+   quota. By default, it is disabled. */
+#define GRPC_ARG_TCP_RX_ZEROCOPY_ENABLED \
+  "grpc.experimental.tcp_rx_zerocopy_enabled"
+/* TCP RX Zerocopy receive threshold: only try zerocopy if >= this many bytes
+   are queued on the socket. By default, this is set to 128KB. */
+#define GRPC_ARG_TCP_RX_ZEROCOPY_RECV_BYTES_THRESHOLD \
+  "grpc.experimental.tcp_rx_zerocopy_recv_bytes_threshold"
 /* Timeout in milliseconds to use for calls to the grpclb load balancer.
    If 0 or unset, the balancer calls will have no deadline. */
 #define GRPC_ARG_GRPCLB_CALL_TIMEOUT_MS "grpc.grpclb_call_timeout_ms"
@@ -354,6 +354,8 @@ class ClientContext {
   /// Set \a algorithm to be the compression algorithm used for the client call.
   ///
   /// \param algorithm The compression algorithm used for the client call.
+  /// GRPC_COMPRESS_ZSTD and GRPC_COMPRESS_LZ4 fall back to no compression if
+  /// gRPC was built without them.
   void set_compression_algorithm(grpc_compression_algorithm algorithm);
 
   /// Flag whether the initial metadata should be \a corked
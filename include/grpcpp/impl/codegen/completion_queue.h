@@ -416,7 +416,10 @@ class CompletionQueue : private ::grpc::GrpcLibraryCodegen {
     return true;
   }
 
-  static CompletionQueue* CallbackAlternativeCQ();
+  // Returns the CQ for the callback API when the iomgr has no background
+  // pollers. Unless \a may_block, it may run callbacks inline on its polling
+  // threads (see grpc_callback_inline_execution).
+  static CompletionQueue* CallbackAlternativeCQ(bool may_block = false);
   static void ReleaseCallbackAlternativeCQ(CompletionQueue* cq);
 
   grpc_completion_queue* cq_;  // owned
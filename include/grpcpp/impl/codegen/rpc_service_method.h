@@ -106,6 +106,10 @@ class RpcServiceMethod : public RpcMethod {
   /// if MethodHandler is nullptr, then this is an async method
   MethodHandler* handler() const { return handler_.get(); }
   ApiType api_type() const { return api_type_; }
+  /// whether the callback handler may block, and so must not run inline on
+  /// threads polling for I/O
+  bool may_block() const { return may_block_; }
+  void set_may_block(bool may_block) { may_block_ = may_block; }
   void SetHandler(MethodHandler* handler) { handler_.reset(handler); }
   void SetServerApiType(RpcServiceMethod::ApiType type) {
     if ((api_type_ == ApiType::SYNC) &&
@@ -129,6 +133,7 @@ class RpcServiceMethod : public RpcMethod {
  private:
   void* server_tag_;
   ApiType api_type_;
+  bool may_block_ = false;
   std::unique_ptr<MethodHandler> handler_;
 
   const char* TypeToString(RpcServiceMethod::ApiType type) {
@@ -221,6 +221,20 @@ class Service {
         internal::RpcServiceMethod::ApiType::RAW_CALL_BACK);
   }
 
+  /// Declare that the callback handler and reactions of the method may block,
+  /// e.g. on I/O of their own. When callback reactions run inline on the
+  /// threads polling for gRPC's I/O (see grpc_callback_inline_execution), the
+  /// method's are handed to other threads instead so that they do not stall
+  /// unrelated calls. No effect on other API types.
+  void MarkMethodMayBlock(int index) {
+    size_t idx = static_cast<size_t>(index);
+    GPR_CODEGEN_ASSERT(
+        methods_[idx].get() != nullptr &&
+        "Cannot mark the method as 'may block' because it has already been "
+        "marked as 'generic'.");
+    methods_[idx]->set_may_block(true);
+  }
+
   internal::MethodHandler* GetHandler(int index) {
     size_t idx = static_cast<size_t>(index);
     return methods_[idx]->handler();
@@ -121,6 +121,13 @@ class Server : public ServerInterface, private GrpcLibraryCodegen {
             std::unique_ptr<experimental::ClientInterceptorFactoryInterface>>
             interceptor_creators);
 
+    /// Histogram of the time calls to synchronous methods waited for a
+    /// thread, from their arrival to the start of their handling, over all
+    /// the sync completion queues of the server. Bucket 0 counts waits below
+    /// 1us, bucket i waits in [2^(i-1), 2^i) microseconds, and the last
+    /// bucket all longer waits.
+    std::vector<uint64_t> GetSyncQueueingDelayHistogram();
+
    private:
     Server* server_;
   };
@@ -259,6 +266,10 @@ class Server : public ServerInterface, private GrpcLibraryCodegen {
 
   CompletionQueue* CallbackCQ() ABSL_LOCKS_EXCLUDED(mu_) override;
 
+  // The CQ for callback methods marked as possibly blocking: CallbackCQ(),
+  // unless that one may run callbacks inline on threads polling for I/O.
+  CompletionQueue* BlockingCallbackCQ();
+
   ServerInitializer* initializer();
 
   // Functions to manage the server shutdown ref count. Things that increase
@@ -335,6 +346,9 @@ class Server : public ServerInterface, private GrpcLibraryCodegen {
   // It is _not owned_ by the server; ownership belongs with its internal
   // shutdown callback tag (invoked when the CQ is fully shutdown).
   std::atomic<CompletionQueue*> callback_cq_{nullptr};
+  // The alternative CQ used by BlockingCallbackCQ(), if any. Set while
+  // registering services and released at shutdown.
+  CompletionQueue* blocking_callback_cq_ = nullptr;
 
   // List of CQs passed in by user that must be Shutdown only after Server is
   // Shutdown.  Even though this is only used with NDEBUG, instantiate it in all
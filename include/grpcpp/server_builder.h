@@ -201,7 +201,8 @@ class ServerBuilder {
   }
 
   /// Set the support status for compression algorithms. All algorithms are
-  /// enabled by default.
+  /// enabled by default. zstd and LZ4 are only ever supported if gRPC was
+  /// built with them, regardless of this setting.
   ///
   /// Incoming calls compressed with an unsupported algorithm will fail with
   /// \a GRPC_STATUS_UNIMPLEMENTED.
@@ -218,17 +219,39 @@ class ServerBuilder {
   ServerBuilder& SetDefaultCompressionAlgorithm(
       grpc_compression_algorithm algorithm);
 
+  /// The zstd compression level (as understood by libzstd) to use for
+  /// messages compressed with \a GRPC_COMPRESS_ZSTD. If unset, zstd's default
+  /// level is used.
+  ServerBuilder& SetZstdCompressionLevel(int level);
+
   /// Set the attached buffer pool for this server
   ServerBuilder& SetResourceQuota(const grpc::ResourceQuota& resource_quota);
 
   ServerBuilder& SetOption(std::unique_ptr<grpc::ServerBuilderOption> option);
 
+  /// Bind each accepted connection to one of the server's completion queues,
+  /// and deliver every call on that connection to that queue only, so that a
+  /// connection's transport and call state stay on the threads polling its
+  /// queue. On Linux the queue is picked from the CPU that received the
+  /// connection: CPU i maps to the i-th completion queue modulo the number of
+  /// queues, so threads polling each queue should be pinned accordingly.
+  /// Calls on a connection wait for requests on its own queue even when other
+  /// queues have requests available, so every queue needs enough outstanding
+  /// requests. Disabled by default.
+  ServerBuilder& SetConnectionCompletionQueueAffinity(bool enable);
+
   /// Options for synchronous servers.
   enum SyncServerOption {
-    NUM_CQS,         ///< Number of completion queues.
-    MIN_POLLERS,     ///< Minimum number of polling threads.
-    MAX_POLLERS,     ///< Maximum number of polling threads.
-    CQ_TIMEOUT_MSEC  ///< Completion queue timeout in milliseconds.
+    NUM_CQS,          ///< Number of completion queues.
+    MIN_POLLERS,      ///< Minimum number of polling threads.
+    MAX_POLLERS,      ///< Maximum number of polling threads.
+    CQ_TIMEOUT_MSEC,  ///< Completion queue timeout in milliseconds.
+    /// Target, in microseconds, for the time calls wait for a thread. When
+    /// set, threads are added while calls keep waiting longer than that and
+    /// removed while most of them are idle, instead of keeping between
+    /// MIN_POLLERS and MAX_POLLERS threads polling. Threads still count
+    /// against the thread quota of the resource quota. Disabled by default.
+    QUEUEING_DELAY_TARGET_USEC
   };
 
   /// Only useful if this is a Synchronous server.
@@ -398,6 +421,10 @@ class ServerBuilder {
     bool is_set;
     grpc_compression_algorithm algorithm;
   } maybe_default_compression_algorithm_;
+  struct {
+    bool is_set;
+    int level;
+  } maybe_zstd_compression_level_;
   uint32_t enabled_compression_algorithms_bitset_;
   std::vector<
       std::unique_ptr<grpc::experimental::ServerInterceptorFactoryInterface>>
@@ -64,6 +64,10 @@ class ChannelArguments {
   /// Set the compression algorithm for the channel.
   void SetCompressionAlgorithm(grpc_compression_algorithm algorithm);
 
+  /// Set the zstd compression level used when the channel compresses messages
+  /// with GRPC_COMPRESS_ZSTD.
+  void SetZstdCompressionLevel(int level);
+
   /// Set the grpclb fallback timeout (in ms) for the channel. If this amount
   /// of time has passed but we have not gotten any non-empty \a serverlist from
   /// the balancer, we will fall back to use the backend address(es) returned by
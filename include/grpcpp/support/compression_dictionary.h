@@ -0,0 +1,54 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef GRPCPP_SUPPORT_COMPRESSION_DICTIONARY_H
+#define GRPCPP_SUPPORT_COMPRESSION_DICTIONARY_H
+
+#include <stdint.h>
+
+#include <string>
+
+#include <grpcpp/impl/codegen/status.h>
+#include <grpcpp/support/config.h>
+
+namespace grpc {
+
+namespace experimental {
+/// Registers \a dictionary to prime GRPC_COMPRESS_ZSTD for the messages of
+/// \a method, in this process. \a method is either a full method name
+/// ("/package.Service/Method") or a service prefix ("/package.Service/").
+/// \a dictionary is either a zstd dictionary, e.g. trained by
+/// grpc_train_compression_dictionary, or raw content.
+///
+/// Both peers advertise the dictionaries they hold, and compress with one only
+/// once the other peer has advertised it too: servers as soon as the client
+/// has, clients from the following call on a channel whose server advertised
+/// it. Peers without the dictionary keep receiving messages compressed without
+/// it. A channel assumes that all of its servers hold the dictionaries one of
+/// them advertised. If \a id is not null, it is set to the id that identifies
+/// the dictionary on the wire.
+///
+/// Fails if gRPC was built without zstd.
+Status RegisterCompressionDictionary(const std::string& method,
+                                     const std::string& dictionary,
+                                     uint32_t* id = nullptr);
+}  // namespace experimental
+
+}  // namespace grpc
+
+#endif  // GRPCPP_SUPPORT_COMPRESSION_DICTIONARY_H
@@ -158,9 +158,9 @@ class ClientChannel::CallData {
   // that the resolver has returned results to the channel.
   // If an error is returned, the error indicates the status with which
   // the call should be failed.
-  grpc_error_handle ApplyServiceConfigToCallLocked(
-      grpc_call_element* elem, grpc_metadata_batch* initial_metadata)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(&ClientChannel::resolution_mu_);
+  grpc_error_handle ApplyServiceConfigToCall(
+      grpc_call_element* elem, grpc_metadata_batch* initial_metadata,
+      const ResolverData& resolver_data);
   // Invoked when the resolver result is applied to the caller, on both
   // success or failure.
   static void ResolutionDone(void* arg, grpc_error_handle error);
@@ -200,9 +200,10 @@ class ClientChannel::CallData {
 
   grpc_closure resolution_done_closure_;
 
-  // Accessed while holding ClientChannel::resolution_mu_.
-  bool service_config_applied_ ABSL_GUARDED_BY(&ClientChannel::resolution_mu_) =
-      false;
+  // Set without holding ClientChannel::resolution_mu_ when the resolver
+  // result is already available the first time the call checks for it, and
+  // while holding it otherwise.
+  bool service_config_applied_ = false;
   bool queued_pending_resolver_result_
       ABSL_GUARDED_BY(&ClientChannel::resolution_mu_) = false;
   ClientChannel::ResolverQueuedCall resolver_queued_call_
@@ -1036,6 +1037,8 @@ ClientChannel::ClientChannel(grpc_channel_element_args* args,
           ClientChannelFactory::GetFromChannelArgs(args->channel_args)),
       channelz_node_(GetChannelzNode(args->channel_args)),
       interested_parties_(grpc_pollset_set_create()),
+      resolver_data_([this] { ScheduleReclaim(); }),
+      picker_([this] { ScheduleReclaim(); }),
       work_serializer_(std::make_shared<WorkSerializer>()),
       state_tracker_("client_channel", GRPC_CHANNEL_IDLE),
       subchannel_pool_(GetSubchannelPool(args->channel_args)) {
@@ -1115,6 +1118,9 @@ ClientChannel::~ClientChannel() {
     gpr_log(GPR_INFO, "chand=%p: destroying channel", this);
   }
   DestroyResolverAndLbPolicyLocked();
+  // No call is left, so this destroys all the retired values.
+  picker_.Reclaim();
+  resolver_data_.Reclaim();
   grpc_channel_args_destroy(channel_args_);
   // Stop backup polling.
   grpc_client_channel_stop_backup_polling(interested_parties_);
@@ -1483,6 +1489,10 @@ void ClientChannel::UpdateServiceConfigInDataPlaneLocked() {
       DynamicFilters::Create(new_args, std::move(filters));
   GPR_ASSERT(dynamic_filters != nullptr);
   grpc_channel_args_destroy(new_args);
+  auto resolver_data = absl::make_unique<ResolverData>();
+  resolver_data->service_config = std::move(service_config);
+  resolver_data->config_selector = std::move(config_selector);
+  resolver_data->dynamic_filters = std::move(dynamic_filters);
   // Grab data plane lock to update service config.
   //
   // We defer unreffing the old values (and deallocating memory) until
@@ -1490,12 +1500,9 @@ void ClientChannel::UpdateServiceConfigInDataPlaneLocked() {
   {
     MutexLock lock(&resolution_mu_);
     resolver_transient_failure_error_ = absl::OkStatus();
-    // Update service config.
-    received_service_config_data_ = true;
-    // Old values will be unreffed after lock is released.
-    service_config_.swap(service_config);
-    config_selector_.swap(config_selector);
-    dynamic_filters_.swap(dynamic_filters);
+    // Update service config.  Calls that are still using the old values
+    // keep them alive until they are done.
+    resolver_data_.Publish(std::move(resolver_data));
     // Process calls that were queued waiting for the resolver result.
     for (ResolverQueuedCall* call = resolver_queued_calls_; call != nullptr;
          call = call->next) {
@@ -1516,8 +1523,9 @@ void ClientChannel::UpdateServiceConfigInDataPlaneLocked() {
       }
     }
   }
-  // Old values will be unreffed after lock is released when they go out
-  // of scope.
+  // Old values will be unreffed after lock is released, once no call is
+  // using them.
+  resolver_data_.Reclaim();
 }
 
 void ClientChannel::CreateResolverLocked() {
@@ -1569,16 +1577,11 @@ void ClientChannel::UpdateStateAndPickerLocked(
     // Acquire resolution lock to update config selector and associated state.
     // To minimize lock contention, we wait to unref these objects until
     // after we release the lock.
-    RefCountedPtr<ServiceConfig> service_config_to_unref;
-    RefCountedPtr<ConfigSelector> config_selector_to_unref;
-    RefCountedPtr<DynamicFilters> dynamic_filters_to_unref;
     {
       MutexLock lock(&resolution_mu_);
-      received_service_config_data_ = false;
-      service_config_to_unref = std::move(service_config_);
-      config_selector_to_unref = std::move(config_selector_);
-      dynamic_filters_to_unref = std::move(dynamic_filters_);
+      resolver_data_.Publish(nullptr);
     }
+    resolver_data_.Reclaim();
   }
   // Update connectivity state.
   state_tracker_.SetState(state, status, reason);
@@ -1594,8 +1597,9 @@ void ClientChannel::UpdateStateAndPickerLocked(
   {
     MutexLock lock(&data_plane_mu_);
     // Swap out the picker.
-    // Note: Original value will be destroyed after the lock is released.
-    picker_.swap(picker);
+    // Note: Original value will be destroyed after the lock is released,
+    // once no call is picking from it.
+    picker_.Publish(std::move(picker));
     // Re-process queued picks.
     for (LbQueuedCall* call = lb_queued_calls_; call != nullptr;
          call = call->next) {
@@ -1614,6 +1618,28 @@ void ClientChannel::UpdateStateAndPickerLocked(
       }
     }
   }
+  picker_.Reclaim();
+}
+
+void ClientChannel::ScheduleReclaim() {
+  GRPC_CHANNEL_STACK_REF(owning_stack_, "ScheduleReclaim");
+  ExecCtx::Run(
+      DEBUG_LOCATION,
+      GRPC_CLOSURE_CREATE(
+          [](void* arg, grpc_error_handle /*error*/) {
+            auto* chand = static_cast<ClientChannel*>(arg);
+            chand->work_serializer_->Run(
+                [chand]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+                    chand->work_serializer_) {
+                  chand->picker_.Reclaim();
+                  chand->resolver_data_.Reclaim();
+                  GRPC_CHANNEL_STACK_UNREF(chand->owning_stack_,
+                                           "ScheduleReclaim");
+                },
+                DEBUG_LOCATION);
+          },
+          this, nullptr),
+      GRPC_ERROR_NONE);
 }
 
 namespace {
@@ -1654,11 +1680,9 @@ grpc_error_handle ClientChannel::DoPingLocked(grpc_transport_op* op) {
   if (state_tracker_.state() != GRPC_CHANNEL_READY) {
     return GRPC_ERROR_CREATE_FROM_STATIC_STRING("channel not connected");
   }
-  LoadBalancingPolicy::PickResult result;
-  {
-    MutexLock lock(&data_plane_mu_);
-    result = picker_->Pick(LoadBalancingPolicy::PickArgs());
-  }
+  // The picker is only replaced from within the work serializer.
+  LoadBalancingPolicy::PickResult result =
+      picker_.get()->Pick(LoadBalancingPolicy::PickArgs());
   return HandlePickResult<grpc_error_handle>(
       &result,
       // Complete pick.
@@ -1952,15 +1976,12 @@ void ClientChannel::CallData::StartTransportStreamOpBatch(
   }
   // Add the batch to the pending list.
   calld->PendingBatchesAdd(elem, batch);
-  // For batches containing a send_initial_metadata op, acquire the
-  // channel's resolution mutex to apply the service config to the call,
-  // after which we will create a dynamic call.
+  // For batches containing a send_initial_metadata op, apply the service
+  // config to the call, after which we will create a dynamic call.
   if (GPR_LIKELY(batch->send_initial_metadata)) {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_call_trace)) {
-      gpr_log(GPR_INFO,
-              "chand=%p calld=%p: grabbing resolution mutex to apply service "
-              "config",
-              chand, calld);
+      gpr_log(GPR_INFO, "chand=%p calld=%p: applying service config", chand,
+              calld);
     }
     CheckResolution(elem, GRPC_ERROR_NONE);
   } else {
@@ -1988,7 +2009,7 @@ void ClientChannel::CallData::SetPollent(grpc_call_element* elem,
 size_t ClientChannel::CallData::GetBatchIndex(
     grpc_transport_stream_op_batch* batch) {
   // Note: It is important the send_initial_metadata be the first entry
-  // here, since the code in ApplyServiceConfigToCallLocked() and
+  // here, since the code in ApplyServiceConfigToCall() and
   // CheckResolutionLocked() assumes it will be.
   if (batch->send_initial_metadata) return 0;
   if (batch->send_message) return 1;
@@ -2179,14 +2200,15 @@ void ClientChannel::CallData::MaybeAddCallToResolverQueuedCallsLocked(
   resolver_call_canceller_ = new ResolverQueuedCallCanceller(elem);
 }
 
-grpc_error_handle ClientChannel::CallData::ApplyServiceConfigToCallLocked(
-    grpc_call_element* elem, grpc_metadata_batch* initial_metadata) {
+grpc_error_handle ClientChannel::CallData::ApplyServiceConfigToCall(
+    grpc_call_element* elem, grpc_metadata_batch* initial_metadata,
+    const ResolverData& resolver_data) {
   ClientChannel* chand = static_cast<ClientChannel*>(elem->channel_data);
   if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
     gpr_log(GPR_INFO, "chand=%p calld=%p: applying service config to call",
             chand, this);
   }
-  ConfigSelector* config_selector = chand->config_selector_.get();
+  ConfigSelector* config_selector = resolver_data.config_selector.get();
   if (config_selector != nullptr) {
     // Use the ConfigSelector to determine the config for the call.
     ConfigSelector::CallConfig call_config =
@@ -2234,7 +2256,7 @@ grpc_error_handle ClientChannel::CallData::ApplyServiceConfigToCallLocked(
       }
     }
     // Set the dynamic filter stack.
-    dynamic_filters_ = chand->dynamic_filters_;
+    dynamic_filters_ = resolver_data.dynamic_filters;
   }
   return GRPC_ERROR_NONE;
 }
@@ -2295,8 +2317,22 @@ void ClientChannel::CallData::CheckResolution(void* arg,
   grpc_call_element* elem = static_cast<grpc_call_element*>(arg);
   CallData* calld = static_cast<CallData*>(elem->call_data);
   ClientChannel* chand = static_cast<ClientChannel*>(elem->channel_data);
-  bool resolution_complete;
+  // Once the channel has a resolver result, which is the common case, apply
+  // it without taking resolution_mu_. This is the call's first check, so it
+  // can't be queued yet.
   {
+    RcuPointer<ResolverData>::ReadGuard resolver_data(&chand->resolver_data_);
+    if (GPR_LIKELY(resolver_data.get() != nullptr)) {
+      calld->service_config_applied_ = true;
+      error = calld->ApplyServiceConfigToCall(
+          elem,
+          calld->pending_batches_[0]
+              ->payload->send_initial_metadata.send_initial_metadata,
+          *resolver_data);
+    }
+  }
+  bool resolution_complete = calld->service_config_applied_;
+  if (!resolution_complete) {
     MutexLock lock(&chand->resolution_mu_);
     resolution_complete = calld->CheckResolutionLocked(elem, &error);
   }
@@ -2342,7 +2378,7 @@ bool ClientChannel::CallData::CheckResolutionLocked(grpc_call_element* elem,
       send_initial_metadata.send_initial_metadata_flags;
   // If we don't yet have a resolver result, we need to queue the call
   // until we get one.
-  if (GPR_UNLIKELY(!chand->received_service_config_data_)) {
+  if (GPR_UNLIKELY(chand->resolver_data_.get() == nullptr)) {
     // If the resolver returned transient failure before returning the
     // first service config, fail any non-wait_for_ready calls.
     absl::Status resolver_error = chand->resolver_transient_failure_error_;
@@ -2361,7 +2397,8 @@ bool ClientChannel::CallData::CheckResolutionLocked(grpc_call_element* elem,
   // Apply service config to call if not yet applied.
   if (GPR_LIKELY(!service_config_applied_)) {
     service_config_applied_ = true;
-    *error = ApplyServiceConfigToCallLocked(elem, initial_metadata_batch);
+    *error = ApplyServiceConfigToCall(elem, initial_metadata_batch,
+                                      *chand->resolver_data_.get());
   }
   MaybeRemoveCallFromResolverQueuedCallsLocked(elem);
   return true;
@@ -2804,13 +2841,10 @@ void ClientChannel::LoadBalancedCall::StartTransportStreamOpBatch(
   }
   // Add the batch to the pending list.
   PendingBatchesAdd(batch);
-  // For batches containing a send_initial_metadata op, acquire the
-  // channel's data plane mutex to pick a subchannel.
+  // For batches containing a send_initial_metadata op, pick a subchannel.
   if (GPR_LIKELY(batch->send_initial_metadata)) {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_call_trace)) {
-      gpr_log(GPR_INFO,
-              "chand=%p lb_call=%p: grabbing data plane mutex to perform pick",
-              chand_, this);
+      gpr_log(GPR_INFO, "chand=%p lb_call=%p: performing pick", chand_, this);
     }
     PickSubchannel(this, GRPC_ERROR_NONE);
   } else {
@@ -3035,10 +3069,25 @@ void ClientChannel::LoadBalancedCall::PickDone(void* arg,
 void ClientChannel::LoadBalancedCall::PickSubchannel(void* arg,
                                                      grpc_error_handle error) {
   auto* self = static_cast<LoadBalancedCall*>(arg);
+  ClientChannel* chand = self->chand_;
   bool pick_complete;
   {
-    MutexLock lock(&self->chand_->data_plane_mu_);
-    pick_complete = self->PickSubchannelLocked(&error);
+    // Pick without holding the data plane mutex, which is needed only if
+    // the call has to be queued.
+    RcuPointer<LoadBalancingPolicy::SubchannelPicker>::ReadGuard picker(
+        &chand->picker_);
+    pick_complete = self->PickSubchannelImpl(picker.get(), &error);
+    if (!pick_complete) {
+      MutexLock lock(&chand->data_plane_mu_);
+      // If the picker was replaced after we picked from it, the queued
+      // calls have been re-processed without us, so try the new one.
+      // Holding the read guard keeps the old picker from being reused.
+      if (chand->picker_.get() != picker.get()) {
+        pick_complete = self->PickSubchannelLocked(&error);
+      } else {
+        self->MaybeAddCallToLbQueuedCallsLocked();
+      }
+    }
   }
   if (pick_complete) {
     PickDone(self, error);
@@ -3048,6 +3097,16 @@ void ClientChannel::LoadBalancedCall::PickSubchannel(void* arg,
 
 bool ClientChannel::LoadBalancedCall::PickSubchannelLocked(
     grpc_error_handle* error) {
+  if (PickSubchannelImpl(chand_->picker_.get(), error)) {
+    MaybeRemoveCallFromLbQueuedCallsLocked();
+    return true;
+  }
+  MaybeAddCallToLbQueuedCallsLocked();
+  return false;
+}
+
+bool ClientChannel::LoadBalancedCall::PickSubchannelImpl(
+    LoadBalancingPolicy::SubchannelPicker* picker, grpc_error_handle* error) {
   GPR_ASSERT(connected_subchannel_ == nullptr);
   GPR_ASSERT(subchannel_call_ == nullptr);
   // Grab initial metadata.
@@ -3064,93 +3123,83 @@ bool ClientChannel::LoadBalancedCall::PickSubchannelLocked(
   pick_args.call_state = &lb_call_state;
   Metadata initial_metadata(initial_metadata_batch);
   pick_args.initial_metadata = &initial_metadata;
-  auto result = chand_->picker_->Pick(pick_args);
+  auto result = picker->Pick(pick_args);
   return HandlePickResult<bool>(
       &result,
       // CompletePick
-      [this](LoadBalancingPolicy::PickResult::Complete* complete_pick)
-          ABSL_EXCLUSIVE_LOCKS_REQUIRED(&ClientChannel::data_plane_mu_) {
-            if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
-              gpr_log(GPR_INFO,
-                      "chand=%p lb_call=%p: LB pick succeeded: subchannel=%p",
-                      chand_, this, complete_pick->subchannel.get());
-            }
-            GPR_ASSERT(complete_pick->subchannel != nullptr);
-            // Grab a ref to the connected subchannel while we're still
-            // holding the data plane mutex.
-            SubchannelWrapper* subchannel = static_cast<SubchannelWrapper*>(
-                complete_pick->subchannel.get());
-            connected_subchannel_ = subchannel->connected_subchannel();
-            // If the subchannel has no connected subchannel (e.g., if the
-            // subchannel has moved out of state READY but the LB policy hasn't
-            // yet seen that change and given us a new picker), then just
-            // queue the pick.  We'll try again as soon as we get a new picker.
-            if (connected_subchannel_ == nullptr) {
-              if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
-                gpr_log(GPR_INFO,
-                        "chand=%p lb_call=%p: subchannel returned by LB picker "
-                        "has no connected subchannel; queueing pick",
-                        chand_, this);
-              }
-              MaybeAddCallToLbQueuedCallsLocked();
-              return false;
-            }
-            lb_subchannel_call_tracker_ =
-                std::move(complete_pick->subchannel_call_tracker);
-            if (lb_subchannel_call_tracker_ != nullptr) {
-              lb_subchannel_call_tracker_->Start();
-            }
-            MaybeRemoveCallFromLbQueuedCallsLocked();
-            return true;
-          },
+      [this](LoadBalancingPolicy::PickResult::Complete* complete_pick) {
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
+          gpr_log(GPR_INFO,
+                  "chand=%p lb_call=%p: LB pick succeeded: subchannel=%p",
+                  chand_, this, complete_pick->subchannel.get());
+        }
+        GPR_ASSERT(complete_pick->subchannel != nullptr);
+        // Grab a ref to the connected subchannel while the picker, and
+        // so the subchannel, is still alive.
+        SubchannelWrapper* subchannel = static_cast<SubchannelWrapper*>(
+            complete_pick->subchannel.get());
+        connected_subchannel_ = subchannel->connected_subchannel();
+        // If the subchannel has no connected subchannel (e.g., if the
+        // subchannel has moved out of state READY but the LB policy hasn't
+        // yet seen that change and given us a new picker), then just
+        // queue the pick.  We'll try again as soon as we get a new picker.
+        if (connected_subchannel_ == nullptr) {
+          if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
+            gpr_log(GPR_INFO,
+                    "chand=%p lb_call=%p: subchannel returned by LB picker "
+                    "has no connected subchannel; queueing pick",
+                    chand_, this);
+          }
+          return false;
+        }
+        lb_subchannel_call_tracker_ =
+            std::move(complete_pick->subchannel_call_tracker);
+        if (lb_subchannel_call_tracker_ != nullptr) {
+          lb_subchannel_call_tracker_->Start();
+        }
+        return true;
+      },
       // QueuePick
-      [this](LoadBalancingPolicy::PickResult::Queue* /*queue_pick*/)
-          ABSL_EXCLUSIVE_LOCKS_REQUIRED(&ClientChannel::data_plane_mu_) {
-            if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
-              gpr_log(GPR_INFO, "chand=%p lb_call=%p: LB pick queued", chand_,
-                      this);
-            }
-            MaybeAddCallToLbQueuedCallsLocked();
-            return false;
-          },
+      [this](LoadBalancingPolicy::PickResult::Queue* /*queue_pick*/) {
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
+          gpr_log(GPR_INFO, "chand=%p lb_call=%p: LB pick queued", chand_,
+                  this);
+        }
+        return false;
+      },
       // FailPick
       [this, send_initial_metadata_flags,
-       &error](LoadBalancingPolicy::PickResult::Fail* fail_pick)
-          ABSL_EXCLUSIVE_LOCKS_REQUIRED(&ClientChannel::data_plane_mu_) {
-            if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
-              gpr_log(GPR_INFO, "chand=%p lb_call=%p: LB pick failed: %s",
-                      chand_, this, fail_pick->status.ToString().c_str());
-            }
-            // If wait_for_ready is false, then the error indicates the RPC
-            // attempt's final status.
-            if ((send_initial_metadata_flags &
-                 GRPC_INITIAL_METADATA_WAIT_FOR_READY) == 0) {
-              grpc_error_handle lb_error =
-                  absl_status_to_grpc_error(fail_pick->status);
-              *error = GRPC_ERROR_CREATE_REFERENCING_FROM_STATIC_STRING(
-                  "Failed to pick subchannel", &lb_error, 1);
-              GRPC_ERROR_UNREF(lb_error);
-              MaybeRemoveCallFromLbQueuedCallsLocked();
-              return true;
-            }
-            // If wait_for_ready is true, then queue to retry when we get a new
-            // picker.
-            MaybeAddCallToLbQueuedCallsLocked();
-            return false;
-          },
+       &error](LoadBalancingPolicy::PickResult::Fail* fail_pick) {
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
+          gpr_log(GPR_INFO, "chand=%p lb_call=%p: LB pick failed: %s",
+                  chand_, this, fail_pick->status.ToString().c_str());
+        }
+        // If wait_for_ready is false, then the error indicates the RPC
+        // attempt's final status.
+        if ((send_initial_metadata_flags &
+             GRPC_INITIAL_METADATA_WAIT_FOR_READY) == 0) {
+          grpc_error_handle lb_error =
+              absl_status_to_grpc_error(fail_pick->status);
+          *error = GRPC_ERROR_CREATE_REFERENCING_FROM_STATIC_STRING(
+              "Failed to pick subchannel", &lb_error, 1);
+          GRPC_ERROR_UNREF(lb_error);
+          return true;
+        }
+        // If wait_for_ready is true, then queue to retry when we get a new
+        // picker.
+        return false;
+      },
       // DropPick
-      [this, &error](LoadBalancingPolicy::PickResult::Drop* drop_pick)
-          ABSL_EXCLUSIVE_LOCKS_REQUIRED(&ClientChannel::data_plane_mu_) {
-            if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
-              gpr_log(GPR_INFO, "chand=%p lb_call=%p: LB pick dropped: %s",
-                      chand_, this, drop_pick->status.ToString().c_str());
-            }
-            *error =
-                grpc_error_set_int(absl_status_to_grpc_error(drop_pick->status),
-                                   GRPC_ERROR_INT_LB_POLICY_DROP, 1);
-            MaybeRemoveCallFromLbQueuedCallsLocked();
-            return true;
-          });
+      [this, &error](LoadBalancingPolicy::PickResult::Drop* drop_pick) {
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_client_channel_routing_trace)) {
+          gpr_log(GPR_INFO, "chand=%p lb_call=%p: LB pick dropped: %s",
+                  chand_, this, drop_pick->status.ToString().c_str());
+        }
+        *error =
+            grpc_error_set_int(absl_status_to_grpc_error(drop_pick->status),
+                               GRPC_ERROR_INT_LB_POLICY_DROP, 1);
+        return true;
+      });
 }
 
 }  // namespace grpc_core
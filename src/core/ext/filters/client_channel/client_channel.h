@@ -39,6 +39,7 @@
 #include "src/core/ext/filters/client_channel/subchannel_pool_interface.h"
 #include "src/core/lib/channel/call_tracer.h"
 #include "src/core/lib/channel/context.h"
+#include "src/core/lib/gprpp/rcu.h"
 #include "src/core/lib/gprpp/ref_counted_ptr.h"
 #include "src/core/lib/gprpp/sync.h"
 #include "src/core/lib/iomgr/error.h"
@@ -199,6 +200,13 @@ class ClientChannel {
     LbQueuedCall* next = nullptr;
   };
 
+  // The parts of the resolver result that calls use, published together.
+  struct ResolverData {
+    RefCountedPtr<ServiceConfig> service_config;
+    RefCountedPtr<ConfigSelector> config_selector;
+    RefCountedPtr<DynamicFilters> dynamic_filters;
+  };
+
   ClientChannel(grpc_channel_element_args* args, grpc_error_handle* error);
   ~ClientChannel();
 
@@ -253,6 +261,10 @@ class ClientChannel {
 
   void TryToConnectLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(work_serializer_);
 
+  // Called by calls leaving a read-side critical section of resolver_data_
+  // or picker_, when old values wait for them to be destroyed.
+  void ScheduleReclaim();
+
   // These methods all require holding resolution_mu_.
   void AddResolverQueuedCall(ResolverQueuedCall* call,
                              grpc_polling_entity* pollent)
@@ -290,19 +302,18 @@ class ClientChannel {
   // Data from service config.
   absl::Status resolver_transient_failure_error_
       ABSL_GUARDED_BY(resolution_mu_);
-  bool received_service_config_data_ ABSL_GUARDED_BY(resolution_mu_) = false;
-  RefCountedPtr<ServiceConfig> service_config_ ABSL_GUARDED_BY(resolution_mu_);
-  RefCountedPtr<ConfigSelector> config_selector_
-      ABSL_GUARDED_BY(resolution_mu_);
-  RefCountedPtr<DynamicFilters> dynamic_filters_
-      ABSL_GUARDED_BY(resolution_mu_);
+  // Null until the first resolver result is received. Published from
+  // work_serializer_ while holding resolution_mu_, and read by calls
+  // without holding it. Only calls that need to be queued take the mutex.
+  RcuPointer<ResolverData> resolver_data_;
 
   //
   // Fields used in the data plane.  Guarded by data_plane_mu_.
   //
   mutable Mutex data_plane_mu_;
-  std::unique_ptr<LoadBalancingPolicy::SubchannelPicker> picker_
-      ABSL_GUARDED_BY(data_plane_mu_);
+  // Published from work_serializer_ while holding data_plane_mu_, and read by
+  // calls without holding it, like resolver_data_.
+  RcuPointer<LoadBalancingPolicy::SubchannelPicker> picker_;
   // Linked list of calls queued waiting for LB pick.
   LbQueuedCall* lb_queued_calls_ ABSL_GUARDED_BY(data_plane_mu_) = nullptr;
 
@@ -384,6 +395,11 @@ class ClientChannel::LoadBalancedCall
   // must invoke PickDone() or AsyncPickDone() with the returned error.
   bool PickSubchannelLocked(grpc_error_handle* error)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(&ClientChannel::data_plane_mu_);
+  // Performs an LB pick using picker, which may be done without holding the
+  // data plane mutex.  Returns true if the pick is complete, as above, and
+  // false if the call has to wait for a new picker.
+  bool PickSubchannelImpl(LoadBalancingPolicy::SubchannelPicker* picker,
+                          grpc_error_handle* error);
   // Schedules a callback to process the completed pick.  The callback
   // will not run until after this method returns.
   void AsyncPickDone(grpc_error_handle error);
@@ -104,6 +104,7 @@ class ConfigSelector : public RefCounted<ConfigSelector> {
     return args;
   }
 
+  // May be called concurrently for different calls, without any lock held.
   virtual CallConfig GetCallConfig(GetCallConfigArgs args) = 0;
 
   grpc_arg MakeChannelArg() const;
@@ -19,6 +19,7 @@
 
 #include <grpc/support/port_platform.h>
 
+#include <atomic>
 #include <functional>
 #include <iterator>
 
@@ -267,9 +268,9 @@ class LoadBalancingPolicy : public InternallyRefCounted<LoadBalancingPolicy> {
   /// updates, connectivity state notifications, etc); the latter should
   /// live in the LB policy object itself.
   ///
-  /// Currently, pickers are always accessed from within the
-  /// client_channel data plane mutex, so they do not have to be
-  /// thread-safe.
+  /// Pick() may be called concurrently from multiple threads without any
+  /// lock held, so any state it modifies must be thread-safe.  Pickers are
+  /// created and destroyed in the control plane work_serializer.
   class SubchannelPicker {
    public:
     SubchannelPicker() = default;
@@ -413,7 +414,7 @@ class LoadBalancingPolicy : public InternallyRefCounted<LoadBalancingPolicy> {
 
    private:
     RefCountedPtr<LoadBalancingPolicy> parent_;
-    bool exit_idle_called_ = false;
+    std::atomic<bool> exit_idle_called_{false};
   };
 
   // A picker that returns PickResult::Fail for all picks.
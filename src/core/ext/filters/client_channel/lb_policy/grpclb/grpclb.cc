@@ -57,6 +57,8 @@
 #include <limits.h>
 #include <string.h>
 
+#include <atomic>
+
 #include "absl/container/inlined_vector.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -317,10 +319,10 @@ class GrpcLb : public LoadBalancingPolicy {
    private:
     std::vector<GrpcLbServer> serverlist_;
 
-    // Guarded by the channel's data plane mutex, NOT the control
-    // plane work_serializer.  It should not be accessed by anything but the
-    // picker via the ShouldDrop() method.
-    size_t drop_index_ = 0;
+    // Updated by concurrent picks, NOT the control plane work_serializer.
+    // It should not be accessed by anything but the picker via the
+    // ShouldDrop() method.
+    std::atomic<size_t> drop_index_{0};
   };
 
   class Picker : public SubchannelPicker {
@@ -608,8 +610,9 @@ bool GrpcLb::Serverlist::ContainsAllDropEntries() const {
 
 const char* GrpcLb::Serverlist::ShouldDrop() {
   if (serverlist_.empty()) return nullptr;
-  GrpcLbServer& server = serverlist_[drop_index_];
-  drop_index_ = (drop_index_ + 1) % serverlist_.size();
+  GrpcLbServer& server =
+      serverlist_[drop_index_.fetch_add(1, std::memory_order_relaxed) %
+                  serverlist_.size()];
   return server.drop ? server.load_balance_token : nullptr;
 }
 
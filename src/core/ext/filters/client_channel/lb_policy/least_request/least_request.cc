@@ -0,0 +1,332 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/ext/filters/client_channel/lb_policy/least_request/least_request.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/random/random.h"
+
+#include "src/core/ext/filters/client_channel/lb_policy/ready_subchannel_list.h"
+#include "src/core/ext/filters/client_channel/lb_policy_registry.h"
+#include "src/core/ext/filters/client_channel/subchannel.h"
+#include "src/core/lib/channel/channel_args.h"
+#include "src/core/lib/debug/trace.h"
+#include "src/core/lib/gpr/string.h"
+#include "src/core/lib/gprpp/per_cpu.h"
+#include "src/core/lib/gprpp/ref_counted.h"
+#include "src/core/lib/gprpp/ref_counted_ptr.h"
+#include "src/core/lib/iomgr/exec_ctx.h"
+#include "src/core/lib/transport/connectivity_state.h"
+
+namespace grpc_core {
+
+TraceFlag grpc_lb_least_request_trace(false, "least_request");
+
+void ParseLeastRequestLbConfig(const Json& json, uint32_t* choice_count,
+                               std::vector<grpc_error_handle>* error_list) {
+  *choice_count = 2;
+  if (json.type() != Json::Type::OBJECT) {
+    error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+        "least_request_experimental should be of type object"));
+    return;
+  }
+  const Json::Object& least_request = json.object_value();
+  auto it = least_request.find("choice_count");
+  if (it != least_request.end()) {
+    if (it->second.type() != Json::Type::NUMBER) {
+      error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "field:choice_count error: should be of type number"));
+      return;
+    }
+    int value = gpr_parse_nonnegative_int(it->second.string_value().c_str());
+    if (value < 2) {
+      error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "field:choice_count error: must be at least 2"));
+      return;
+    }
+    // Larger values cost more per pick while balancing hardly any better.
+    *choice_count = static_cast<uint32_t>(std::min(value, 10));
+  }
+}
+
+namespace {
+
+//
+// least_request LB policy
+//
+
+constexpr char kLeastRequest[] = "least_request_experimental";
+
+class LeastRequestConfig : public LoadBalancingPolicy::Config {
+ public:
+  explicit LeastRequestConfig(uint32_t choice_count)
+      : choice_count_(choice_count) {}
+
+  const char* name() const override { return kLeastRequest; }
+
+  uint32_t choice_count() const { return choice_count_; }
+
+ private:
+  uint32_t choice_count_;
+};
+
+// Counts the calls in flight on a subchannel.  Shared by every picker
+// created from the same subchannel list, and by the calls themselves, so
+// that it outlives both.
+class OutstandingRequestCounter
+    : public RefCounted<OutstandingRequestCounter> {
+ public:
+  void Increment() { count_.fetch_add(1, std::memory_order_relaxed); }
+  void Decrement() { count_.fetch_sub(1, std::memory_order_relaxed); }
+  uint32_t Load() const { return count_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint32_t> count_{0};
+};
+
+// Data for a particular subchannel in a subchannel list.
+// This subclass adds the following functionality:
+// - Holds the counter of calls in flight on the subchannel.
+class LeastRequestSubchannelData
+    : public ReadySubchannelData<LeastRequestSubchannelData> {
+ public:
+  LeastRequestSubchannelData(
+      SubchannelList<ReadySubchannelList<LeastRequestSubchannelData>,
+                     LeastRequestSubchannelData>* subchannel_list,
+      const ServerAddress& address,
+      RefCountedPtr<SubchannelInterface> subchannel)
+      : ReadySubchannelData(subchannel_list, address, std::move(subchannel)),
+        counter_(MakeRefCounted<OutstandingRequestCounter>()) {}
+
+  const RefCountedPtr<OutstandingRequestCounter>& counter() const {
+    return counter_;
+  }
+
+ private:
+  const RefCountedPtr<OutstandingRequestCounter> counter_;
+};
+
+class LeastRequest : public ReadySubchannelPolicy<LeastRequestSubchannelData> {
+ public:
+  explicit LeastRequest(Args args)
+      : ReadySubchannelPolicy(std::move(args), &grpc_lb_least_request_trace) {}
+
+  const char* name() const override { return kLeastRequest; }
+
+  void UpdateLocked(UpdateArgs args) override;
+
+ private:
+  // Random numbers for pickers called concurrently on many CPUs.  Each CPU
+  // steps a counter of its own, the values of which are scrambled with the
+  // splitmix64 finalizer, so that picks on different CPUs don't bounce a
+  // shared cacheline, as rand(3) would.
+  class PerCpuRandom {
+   public:
+    explicit PerCpuRandom(uint64_t seed) {
+      for (size_t i = 0; i < states_.size(); ++i) {
+        // Spread the shards far apart along the same sequence.
+        states_[i].store(seed + (static_cast<uint64_t>(i) << 58),
+                         std::memory_order_relaxed);
+      }
+    }
+
+    // Must be called within an ExecCtx.
+    uint64_t Next() {
+      uint64_t z = states_.ForCpu(ExecCtx::Get()->starting_cpu())
+                       .fetch_add(kIncrement, std::memory_order_relaxed);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+      return z ^ (z >> 31);
+    }
+
+   private:
+    static constexpr uint64_t kIncrement = 0x9e3779b97f4a7c15u;
+
+    PerCpu<std::atomic<uint64_t>> states_;
+  };
+
+  class Picker : public SubchannelPicker {
+   public:
+    Picker(LeastRequest* parent, SubchannelListType* subchannel_list);
+
+    PickResult Pick(PickArgs args) override;
+
+   private:
+    class SubchannelCallTracker;
+
+    struct Entry {
+      RefCountedPtr<SubchannelInterface> subchannel;
+      RefCountedPtr<OutstandingRequestCounter> counter;
+    };
+    using EntryVector = absl::InlinedVector<Entry, 10>;
+
+    static EntryVector ReadySubchannels(SubchannelListType* subchannel_list);
+
+    // Using pointer value only, no ref held -- do not dereference!
+    LeastRequest* parent_;
+
+    const uint32_t choice_count_;
+    const EntryVector subchannels_;
+    PerCpuRandom random_;
+  };
+
+  std::unique_ptr<SubchannelPicker> MakePickerLocked(
+      SubchannelListType* subchannel_list) override {
+    return absl::make_unique<Picker>(this, subchannel_list);
+  }
+
+  RefCountedPtr<LeastRequestConfig> config_;
+  // Seeds the pickers.  Only used in the work serializer.
+  absl::BitGen bit_gen_;
+};
+
+//
+// LeastRequest::Picker::SubchannelCallTracker
+//
+
+class LeastRequest::Picker::SubchannelCallTracker
+    : public LoadBalancingPolicy::SubchannelCallTrackerInterface {
+ public:
+  explicit SubchannelCallTracker(
+      RefCountedPtr<OutstandingRequestCounter> counter)
+      : counter_(std::move(counter)) {}
+
+  ~SubchannelCallTracker() override { GPR_DEBUG_ASSERT(!started_); }
+
+  void Start() override {
+    counter_->Increment();
+#ifndef NDEBUG
+    started_ = true;
+#endif
+  }
+
+  void Finish(FinishArgs /*args*/) override {
+    counter_->Decrement();
+#ifndef NDEBUG
+    started_ = false;
+#endif
+  }
+
+ private:
+  RefCountedPtr<OutstandingRequestCounter> counter_;
+#ifndef NDEBUG
+  bool started_ = false;
+#endif
+};
+
+//
+// LeastRequest::Picker
+//
+
+LeastRequest::Picker::EntryVector LeastRequest::Picker::ReadySubchannels(
+    SubchannelListType* subchannel_list) {
+  EntryVector subchannels;
+  for (size_t i = 0; i < subchannel_list->num_subchannels(); ++i) {
+    LeastRequestSubchannelData* sd = subchannel_list->subchannel(i);
+    if (sd->connectivity_state() == GRPC_CHANNEL_READY) {
+      subchannels.push_back({sd->subchannel()->Ref(), sd->counter()});
+    }
+  }
+  return subchannels;
+}
+
+LeastRequest::Picker::Picker(LeastRequest* parent,
+                             SubchannelListType* subchannel_list)
+    : parent_(parent),
+      choice_count_(parent->config_->choice_count()),
+      subchannels_(ReadySubchannels(subchannel_list)),
+      random_(absl::Uniform<uint64_t>(parent->bit_gen_)) {
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_least_request_trace)) {
+    gpr_log(GPR_INFO,
+            "[LR %p picker %p] created picker from subchannel_list=%p "
+            "with %" PRIuPTR " READY subchannels and choice_count %u",
+            parent_, this, subchannel_list, subchannels_.size(),
+            choice_count_);
+  }
+}
+
+LeastRequest::PickResult LeastRequest::Picker::Pick(PickArgs /*args*/) {
+  // Picks may run concurrently on many CPUs: the counters may change under
+  // us, which at worst makes us pick the busier of the candidates.
+  const size_t index = PickLeastLoaded(
+      subchannels_.size(), choice_count_, [this]() { return random_.Next(); },
+      [this](size_t i) { return subchannels_[i].counter->Load(); });
+  const Entry& entry = subchannels_[index];
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_least_request_trace)) {
+    gpr_log(GPR_INFO,
+            "[LR %p picker %p] returning index %" PRIuPTR
+            ", subchannel=%p, outstanding requests=%u",
+            parent_, this, index, entry.subchannel.get(),
+            entry.counter->Load());
+  }
+  return PickResult::Complete(
+      entry.subchannel,
+      absl::make_unique<SubchannelCallTracker>(entry.counter));
+}
+
+//
+// LeastRequest
+//
+
+void LeastRequest::UpdateLocked(UpdateArgs args) {
+  config_ = std::move(args.config);
+  ReadySubchannelPolicy::UpdateLocked(std::move(args));
+}
+
+//
+// factory
+//
+
+class LeastRequestFactory : public LoadBalancingPolicyFactory {
+ public:
+  OrphanablePtr<LoadBalancingPolicy> CreateLoadBalancingPolicy(
+      LoadBalancingPolicy::Args args) const override {
+    return MakeOrphanable<LeastRequest>(std::move(args));
+  }
+
+  const char* name() const override { return kLeastRequest; }
+
+  RefCountedPtr<LoadBalancingPolicy::Config> ParseLoadBalancingConfig(
+      const Json& json, grpc_error_handle* error) const override {
+    uint32_t choice_count;
+    std::vector<grpc_error_handle> error_list;
+    ParseLeastRequestLbConfig(json, &choice_count, &error_list);
+    if (error_list.empty()) {
+      return MakeRefCounted<LeastRequestConfig>(choice_count);
+    } else {
+      *error = GRPC_ERROR_CREATE_FROM_VECTOR(
+          "least_request_experimental LB policy config", &error_list);
+      return nullptr;
+    }
+  }
+};
+
+}  // namespace
+
+void GrpcLbPolicyLeastRequestInit() {
+  LoadBalancingPolicyRegistry::Builder::RegisterLoadBalancingPolicyFactory(
+      absl::make_unique<LeastRequestFactory>());
+}
+
+void GrpcLbPolicyLeastRequestShutdown() {}
+
+}  // namespace grpc_core
@@ -0,0 +1,59 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_LEAST_REQUEST_LEAST_REQUEST_H
+#define GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_LEAST_REQUEST_LEAST_REQUEST_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "src/core/lib/iomgr/error.h"
+#include "src/core/lib/json/json.h"
+
+namespace grpc_core {
+
+// Helper parsing method to parse least request policy configs; for example,
+// the number of choices to pick from.
+void ParseLeastRequestLbConfig(const Json& json, uint32_t* choice_count,
+                               std::vector<grpc_error_handle>* error_list);
+
+// Returns the least loaded of choice_count items drawn at random, with
+// replacement, from num_items items ("power of two choices" when
+// choice_count is 2). random() returns a random number, and load(i) the
+// number of requests outstanding on item i. Ties go to the first drawn.
+template <typename RandomFn, typename LoadFn>
+size_t PickLeastLoaded(size_t num_items, uint32_t choice_count,
+                       RandomFn random, LoadFn load) {
+  size_t best = random() % num_items;
+  auto best_load = load(best);
+  for (uint32_t i = 1; i < choice_count; ++i) {
+    const size_t candidate = random() % num_items;
+    const auto candidate_load = load(candidate);
+    if (candidate_load < best_load) {
+      best = candidate;
+      best_load = candidate_load;
+    }
+  }
+  return best;
+}
+
+}  // namespace grpc_core
+
+#endif  // GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_LEAST_REQUEST_LEAST_REQUEST_H
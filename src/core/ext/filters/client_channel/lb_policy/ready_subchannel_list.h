@@ -0,0 +1,513 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_READY_SUBCHANNEL_LIST_H
+#define GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_READY_SUBCHANNEL_LIST_H
+
+#include <grpc/support/port_platform.h>
+
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
+#include <grpc/support/log.h>
+
+#include "src/core/ext/filters/client_channel/lb_policy.h"
+#include "src/core/ext/filters/client_channel/lb_policy/subchannel_list.h"
+#include "src/core/lib/debug/trace.h"
+#include "src/core/lib/gprpp/orphanable.h"
+#include "src/core/lib/transport/connectivity_state.h"
+
+// Code shared by the LB policies that spread picks over all of their READY
+// subchannels, such as round_robin.
+//
+// Such a policy connects to every address it is given.  It keeps serving
+// from its current subchannel list while the list for a new update
+// connects, and swaps the new list in once one of its subchannels is READY
+// or all of them have failed.  The policy is READY when any subchannel of
+// the current list is READY, else CONNECTING when any of them is, else
+// TRANSIENT_FAILURE once all of them have failed.  A subchannel that failed
+// counts as TRANSIENT_FAILURE until it is READY again.
+//
+// To use this, policies provide the picker for READY subchannel lists, like
+// so:
+/*
+
+class MySubchannelData : public ReadySubchannelData<MySubchannelData> {
+ public:
+  using ReadySubchannelData::ReadySubchannelData;
+};
+
+class MyPolicy : public ReadySubchannelPolicy<MySubchannelData> {
+ public:
+  explicit MyPolicy(Args args)
+      : ReadySubchannelPolicy(std::move(args), &grpc_lb_my_policy_trace) {}
+
+ private:
+  std::unique_ptr<SubchannelPicker> MakePickerLocked(
+      SubchannelListType* subchannel_list) override;
+};
+
+*/
+// All methods will be called from within the client_channel work serializer.
+
+namespace grpc_core {
+
+// Forward declarations.
+template <typename SubchannelDataType>
+class ReadySubchannelList;
+template <typename SubchannelDataType>
+class ReadySubchannelPolicy;
+
+// Data for a particular subchannel in a ReadySubchannelList.
+// This subclass adds the following functionality:
+// - Tracks the previous connectivity state of the subchannel, so that
+//   we know how many subchannels are in each state.
+template <typename SubchannelDataType>
+class ReadySubchannelData
+    : public SubchannelData<ReadySubchannelList<SubchannelDataType>,
+                            SubchannelDataType> {
+ public:
+  ReadySubchannelData(
+      SubchannelList<ReadySubchannelList<SubchannelDataType>,
+                     SubchannelDataType>* subchannel_list,
+      const ServerAddress& address,
+      RefCountedPtr<SubchannelInterface> subchannel)
+      : SubchannelData<ReadySubchannelList<SubchannelDataType>,
+                       SubchannelDataType>(subchannel_list, address,
+                                           std::move(subchannel)) {}
+
+  grpc_connectivity_state connectivity_state() const {
+    return last_connectivity_state_;
+  }
+
+  // Performs connectivity state updates that need to be done both when we
+  // first start watching and when a watcher notification is received.
+  void UpdateConnectivityStateLocked(
+      grpc_connectivity_state connectivity_state);
+
+ private:
+  // Performs connectivity state updates that need to be done only
+  // after we have started watching.
+  void ProcessConnectivityChangeLocked(
+      grpc_connectivity_state connectivity_state) override;
+
+  grpc_connectivity_state last_connectivity_state_ = GRPC_CHANNEL_IDLE;
+  bool seen_failure_since_ready_ = false;
+};
+
+// A list of subchannels, along with the counts of subchannels in each
+// state.
+template <typename SubchannelDataType>
+class ReadySubchannelList
+    : public SubchannelList<ReadySubchannelList<SubchannelDataType>,
+                            SubchannelDataType> {
+ public:
+  ReadySubchannelList(ReadySubchannelPolicy<SubchannelDataType>* policy,
+                      ServerAddressList addresses,
+                      const grpc_channel_args& args)
+      : SubchannelList<ReadySubchannelList<SubchannelDataType>,
+                       SubchannelDataType>(
+            policy, policy->tracer_, std::move(addresses),
+            policy->channel_control_helper(), args) {
+    // Need to maintain a ref to the LB policy as long as we maintain
+    // any references to subchannels, since the subchannels'
+    // pollset_sets will include the LB policy's pollset_set.
+    policy->Ref(DEBUG_LOCATION, "subchannel_list").release();
+  }
+
+  ~ReadySubchannelList() override {
+    ready_policy()->Unref(DEBUG_LOCATION, "subchannel_list");
+  }
+
+  size_t num_ready() const { return num_ready_; }
+
+  // Starts watching the subchannels in this list.
+  void StartWatchingLocked();
+
+  // Updates the counters of subchannels in each state when a
+  // subchannel transitions from old_state to new_state.
+  void UpdateStateCountersLocked(grpc_connectivity_state old_state,
+                                 grpc_connectivity_state new_state);
+
+  // If this subchannel list is the policy's current subchannel list,
+  // updates the policy's connectivity state based on the subchannel
+  // list's state counters.
+  void MaybeUpdatePolicyConnectivityStateLocked();
+
+  // Updates the policy's overall state based on the counters of
+  // subchannels in each state.
+  void UpdatePolicyStateFromSubchannelStateCountsLocked();
+
+ private:
+  ReadySubchannelPolicy<SubchannelDataType>* ready_policy() const {
+    return static_cast<ReadySubchannelPolicy<SubchannelDataType>*>(
+        this->policy());
+  }
+
+  size_t num_ready_ = 0;
+  size_t num_connecting_ = 0;
+  size_t num_transient_failure_ = 0;
+};
+
+// Base class for the policies, which handles address updates and sets the
+// policy's state.
+template <typename SubchannelDataType>
+class ReadySubchannelPolicy : public LoadBalancingPolicy {
+ public:
+  using SubchannelListType = ReadySubchannelList<SubchannelDataType>;
+
+  void UpdateLocked(UpdateArgs args) override;
+  void ResetBackoffLocked() override;
+
+ protected:
+  ReadySubchannelPolicy(Args args, TraceFlag* tracer);
+  ~ReadySubchannelPolicy() override;
+
+  void ShutdownLocked() override;
+
+  // Returns a picker for the subchannels of subchannel_list, which is the
+  // current list and has at least one READY subchannel.
+  virtual std::unique_ptr<SubchannelPicker> MakePickerLocked(
+      SubchannelListType* subchannel_list) = 0;
+
+  // The current subchannel list, if any.
+  SubchannelListType* subchannel_list() const {
+    return subchannel_list_.get();
+  }
+
+  bool shutdown() const { return shutdown_; }
+
+ private:
+  friend class ReadySubchannelData<SubchannelDataType>;
+  friend class ReadySubchannelList<SubchannelDataType>;
+
+  TraceFlag* const tracer_;
+
+  // List of subchannels.
+  OrphanablePtr<SubchannelListType> subchannel_list_;
+  // Latest pending subchannel list.
+  // When we get an updated address list, we create a new subchannel list
+  // for it here, and we wait to swap it into subchannel_list_ until the new
+  // list becomes READY.
+  OrphanablePtr<SubchannelListType> latest_pending_subchannel_list_;
+
+  bool shutdown_ = false;
+};
+
+//
+// implementation -- no user-servicable parts below
+//
+
+//
+// ReadySubchannelData
+//
+
+template <typename SubchannelDataType>
+void ReadySubchannelData<SubchannelDataType>::UpdateConnectivityStateLocked(
+    grpc_connectivity_state connectivity_state) {
+  ReadySubchannelList<SubchannelDataType>* subchannel_list =
+      this->subchannel_list();
+  if (GRPC_TRACE_FLAG_ENABLED(*subchannel_list->tracer())) {
+    gpr_log(
+        GPR_INFO,
+        "[%s %p] connectivity changed for subchannel %p, subchannel_list %p "
+        "(index %" PRIuPTR " of %" PRIuPTR "): prev_state=%s new_state=%s",
+        subchannel_list->tracer()->name(), subchannel_list->policy(),
+        this->subchannel(), subchannel_list, this->Index(),
+        subchannel_list->num_subchannels(),
+        ConnectivityStateName(last_connectivity_state_),
+        ConnectivityStateName(connectivity_state));
+  }
+  // Decide what state to report for aggregation purposes.
+  // If we haven't seen a failure since the last time we were in state
+  // READY, then we report the state change as-is.  However, once we do see
+  // a failure, we report TRANSIENT_FAILURE and do not report any subsequent
+  // state changes until we go back into state READY.
+  if (!seen_failure_since_ready_) {
+    if (connectivity_state == GRPC_CHANNEL_TRANSIENT_FAILURE) {
+      seen_failure_since_ready_ = true;
+    }
+    subchannel_list->UpdateStateCountersLocked(last_connectivity_state_,
+                                               connectivity_state);
+  } else {
+    if (connectivity_state == GRPC_CHANNEL_READY) {
+      seen_failure_since_ready_ = false;
+      subchannel_list->UpdateStateCountersLocked(
+          GRPC_CHANNEL_TRANSIENT_FAILURE, connectivity_state);
+    }
+  }
+  // Record last seen connectivity state.
+  last_connectivity_state_ = connectivity_state;
+}
+
+template <typename SubchannelDataType>
+void ReadySubchannelData<SubchannelDataType>::ProcessConnectivityChangeLocked(
+    grpc_connectivity_state connectivity_state) {
+  ReadySubchannelList<SubchannelDataType>* subchannel_list =
+      this->subchannel_list();
+  auto* p = static_cast<ReadySubchannelPolicy<SubchannelDataType>*>(
+      subchannel_list->policy());
+  GPR_ASSERT(this->subchannel() != nullptr);
+  // If the new state is TRANSIENT_FAILURE, re-resolve.
+  // Only do this if we've started watching, not at startup time.
+  // Otherwise, if the subchannel was already in state TRANSIENT_FAILURE
+  // when the subchannel list was created, we'd wind up in a constant
+  // loop of re-resolution.
+  // Also attempt to reconnect.
+  if (connectivity_state == GRPC_CHANNEL_TRANSIENT_FAILURE) {
+    if (GRPC_TRACE_FLAG_ENABLED(*p->tracer_)) {
+      gpr_log(GPR_INFO,
+              "[%s %p] Subchannel %p has gone into TRANSIENT_FAILURE. "
+              "Requesting re-resolution",
+              p->tracer_->name(), p, this->subchannel());
+    }
+    p->channel_control_helper()->RequestReresolution();
+    this->subchannel()->AttemptToConnect();
+  }
+  // Update state counters.
+  UpdateConnectivityStateLocked(connectivity_state);
+  // Update overall state and renew notification.
+  subchannel_list->UpdatePolicyStateFromSubchannelStateCountsLocked();
+}
+
+//
+// ReadySubchannelList
+//
+
+template <typename SubchannelDataType>
+void ReadySubchannelList<SubchannelDataType>::StartWatchingLocked() {
+  if (this->num_subchannels() == 0) return;
+  // Check current state of each subchannel synchronously, since any
+  // subchannel already used by some other channel may have a non-IDLE
+  // state.
+  for (size_t i = 0; i < this->num_subchannels(); ++i) {
+    grpc_connectivity_state state =
+        this->subchannel(i)->CheckConnectivityStateLocked();
+    if (state != GRPC_CHANNEL_IDLE) {
+      this->subchannel(i)->UpdateConnectivityStateLocked(state);
+    }
+  }
+  // Start connectivity watch for each subchannel.
+  for (size_t i = 0; i < this->num_subchannels(); i++) {
+    if (this->subchannel(i)->subchannel() != nullptr) {
+      this->subchannel(i)->StartConnectivityWatchLocked();
+      this->subchannel(i)->subchannel()->AttemptToConnect();
+    }
+  }
+  // Now set the LB policy's state based on the subchannels' states.
+  UpdatePolicyStateFromSubchannelStateCountsLocked();
+}
+
+template <typename SubchannelDataType>
+void ReadySubchannelList<SubchannelDataType>::UpdateStateCountersLocked(
+    grpc_connectivity_state old_state, grpc_connectivity_state new_state) {
+  GPR_ASSERT(old_state != GRPC_CHANNEL_SHUTDOWN);
+  GPR_ASSERT(new_state != GRPC_CHANNEL_SHUTDOWN);
+  if (old_state == GRPC_CHANNEL_READY) {
+    GPR_ASSERT(num_ready_ > 0);
+    --num_ready_;
+  } else if (old_state == GRPC_CHANNEL_CONNECTING) {
+    GPR_ASSERT(num_connecting_ > 0);
+    --num_connecting_;
+  } else if (old_state == GRPC_CHANNEL_TRANSIENT_FAILURE) {
+    GPR_ASSERT(num_transient_failure_ > 0);
+    --num_transient_failure_;
+  }
+  if (new_state == GRPC_CHANNEL_READY) {
+    ++num_ready_;
+  } else if (new_state == GRPC_CHANNEL_CONNECTING) {
+    ++num_connecting_;
+  } else if (new_state == GRPC_CHANNEL_TRANSIENT_FAILURE) {
+    ++num_transient_failure_;
+  }
+}
+
+// Sets the policy's connectivity state and generates a new picker based
+// on the current subchannel list.
+template <typename SubchannelDataType>
+void ReadySubchannelList<
+    SubchannelDataType>::MaybeUpdatePolicyConnectivityStateLocked() {
+  ReadySubchannelPolicy<SubchannelDataType>* p = ready_policy();
+  // Only set connectivity state if this is the current subchannel list.
+  if (p->subchannel_list_.get() != this) return;
+  // In priority order. The first rule to match terminates the search (ie, if we
+  // are on rule n, all previous rules were unfulfilled).
+  //
+  // 1) RULE: ANY subchannel is READY => policy is READY.
+  //    CHECK: subchannel_list->num_ready > 0.
+  //
+  // 2) RULE: ANY subchannel is CONNECTING => policy is CONNECTING.
+  //    CHECK: sd->curr_connectivity_state == CONNECTING.
+  //
+  // 3) RULE: ALL subchannels are TRANSIENT_FAILURE => policy is
+  //                                                   TRANSIENT_FAILURE.
+  //    CHECK: subchannel_list->num_transient_failures ==
+  //           subchannel_list->num_subchannels.
+  if (num_ready_ > 0) {
+    // 1) READY
+    p->channel_control_helper()->UpdateState(
+        GRPC_CHANNEL_READY, absl::Status(), p->MakePickerLocked(this));
+  } else if (num_connecting_ > 0) {
+    // 2) CONNECTING
+    p->channel_control_helper()->UpdateState(
+        GRPC_CHANNEL_CONNECTING, absl::Status(),
+        absl::make_unique<LoadBalancingPolicy::QueuePicker>(
+            p->Ref(DEBUG_LOCATION, "QueuePicker")));
+  } else if (num_transient_failure_ == this->num_subchannels()) {
+    // 3) TRANSIENT_FAILURE
+    absl::Status status =
+        absl::UnavailableError("connections to all backends failing");
+    p->channel_control_helper()->UpdateState(
+        GRPC_CHANNEL_TRANSIENT_FAILURE, status,
+        absl::make_unique<LoadBalancingPolicy::TransientFailurePicker>(status));
+  }
+}
+
+template <typename SubchannelDataType>
+void ReadySubchannelList<
+    SubchannelDataType>::UpdatePolicyStateFromSubchannelStateCountsLocked() {
+  ReadySubchannelPolicy<SubchannelDataType>* p = ready_policy();
+  // If we have at least one READY subchannel, then swap to the new list.
+  // Also, if all of the subchannels are in TRANSIENT_FAILURE, then we know
+  // we've tried all of them and failed, so we go ahead and swap over
+  // anyway; this may cause the channel to go from READY to TRANSIENT_FAILURE,
+  // but we are doing what the control plane told us to do.
+  if (num_ready_ > 0 || num_transient_failure_ == this->num_subchannels()) {
+    if (p->subchannel_list_.get() != this) {
+      // Promote this list to p->subchannel_list_.
+      // This list must be p->latest_pending_subchannel_list_, because
+      // any previous update would have been shut down already and
+      // therefore we would not be receiving a notification for them.
+      GPR_ASSERT(p->latest_pending_subchannel_list_.get() == this);
+      GPR_ASSERT(!this->shutting_down());
+      if (GRPC_TRACE_FLAG_ENABLED(*this->tracer())) {
+        const size_t old_num_subchannels =
+            p->subchannel_list_ != nullptr
+                ? p->subchannel_list_->num_subchannels()
+                : 0;
+        gpr_log(GPR_INFO,
+                "[%s %p] phasing out subchannel list %p (size %" PRIuPTR
+                ") in favor of %p (size %" PRIuPTR ")",
+                this->tracer()->name(), p, p->subchannel_list_.get(),
+                old_num_subchannels, this, this->num_subchannels());
+      }
+      p->subchannel_list_ = std::move(p->latest_pending_subchannel_list_);
+    }
+  }
+  // Update the policy's connectivity state if needed.
+  MaybeUpdatePolicyConnectivityStateLocked();
+}
+
+//
+// ReadySubchannelPolicy
+//
+
+template <typename SubchannelDataType>
+ReadySubchannelPolicy<SubchannelDataType>::ReadySubchannelPolicy(
+    Args args, TraceFlag* tracer)
+    : LoadBalancingPolicy(std::move(args)), tracer_(tracer) {
+  if (GRPC_TRACE_FLAG_ENABLED(*tracer_)) {
+    gpr_log(GPR_INFO, "[%s %p] Created", tracer_->name(), this);
+  }
+}
+
+template <typename SubchannelDataType>
+ReadySubchannelPolicy<SubchannelDataType>::~ReadySubchannelPolicy() {
+  if (GRPC_TRACE_FLAG_ENABLED(*tracer_)) {
+    gpr_log(GPR_INFO, "[%s %p] Destroying %s policy", tracer_->name(), this,
+            tracer_->name());
+  }
+  GPR_ASSERT(subchannel_list_ == nullptr);
+  GPR_ASSERT(latest_pending_subchannel_list_ == nullptr);
+}
+
+template <typename SubchannelDataType>
+void ReadySubchannelPolicy<SubchannelDataType>::ShutdownLocked() {
+  if (GRPC_TRACE_FLAG_ENABLED(*tracer_)) {
+    gpr_log(GPR_INFO, "[%s %p] Shutting down", tracer_->name(), this);
+  }
+  shutdown_ = true;
+  subchannel_list_.reset();
+  latest_pending_subchannel_list_.reset();
+}
+
+template <typename SubchannelDataType>
+void ReadySubchannelPolicy<SubchannelDataType>::ResetBackoffLocked() {
+  subchannel_list_->ResetBackoffLocked();
+  if (latest_pending_subchannel_list_ != nullptr) {
+    latest_pending_subchannel_list_->ResetBackoffLocked();
+  }
+}
+
+template <typename SubchannelDataType>
+void ReadySubchannelPolicy<SubchannelDataType>::UpdateLocked(
+    UpdateArgs args) {
+  ServerAddressList addresses;
+  if (args.addresses.ok()) {
+    if (GRPC_TRACE_FLAG_ENABLED(*tracer_)) {
+      gpr_log(GPR_INFO, "[%s %p] received update with %" PRIuPTR " addresses",
+              tracer_->name(), this, args.addresses->size());
+    }
+    addresses = std::move(*args.addresses);
+  } else {
+    if (GRPC_TRACE_FLAG_ENABLED(*tracer_)) {
+      gpr_log(GPR_INFO, "[%s %p] received update with address error: %s",
+              tracer_->name(), this,
+              args.addresses.status().ToString().c_str());
+    }
+    // If we already have a subchannel list, then ignore the resolver
+    // failure and keep using the existing list.
+    if (subchannel_list_ != nullptr) return;
+  }
+  // Replace latest_pending_subchannel_list_.
+  if (GRPC_TRACE_FLAG_ENABLED(*tracer_) &&
+      latest_pending_subchannel_list_ != nullptr) {
+    gpr_log(GPR_INFO,
+            "[%s %p] Shutting down previous pending subchannel list %p",
+            tracer_->name(), this, latest_pending_subchannel_list_.get());
+  }
+  latest_pending_subchannel_list_ = MakeOrphanable<SubchannelListType>(
+      this, std::move(addresses), *args.args);
+  if (latest_pending_subchannel_list_->num_subchannels() == 0) {
+    // If the new list is empty, immediately promote the new list to the
+    // current list and transition to TRANSIENT_FAILURE.
+    absl::Status status =
+        args.addresses.ok() ? absl::UnavailableError(absl::StrCat(
+                                  "empty address list: ", args.resolution_note))
+                            : args.addresses.status();
+    channel_control_helper()->UpdateState(
+        GRPC_CHANNEL_TRANSIENT_FAILURE, status,
+        absl::make_unique<TransientFailurePicker>(status));
+    subchannel_list_ = std::move(latest_pending_subchannel_list_);
+  } else if (subchannel_list_ == nullptr) {
+    // If there is no current list, immediately promote the new list to
+    // the current list and start watching it.
+    subchannel_list_ = std::move(latest_pending_subchannel_list_);
+    subchannel_list_->StartWatchingLocked();
+  } else {
+    // Start watching the pending list.  It will get swapped into the
+    // current list when it reports READY.
+    latest_pending_subchannel_list_->StartWatchingLocked();
+  }
+}
+
+}  // namespace grpc_core
+
+#endif  // GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_READY_SUBCHANNEL_LIST_H
@@ -19,6 +19,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #define XXH_INLINE_ALL
@@ -26,6 +33,7 @@
 
 #include <grpc/support/alloc.h>
 
+#include "src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.h"
 #include "src/core/ext/filters/client_channel/lb_policy/subchannel_list.h"
 #include "src/core/ext/filters/client_channel/lb_policy_registry.h"
 #include "src/core/ext/filters/client_channel/subchannel.h"
@@ -43,12 +51,30 @@ namespace grpc_core {
 const char* kRequestRingHashAttribute = "request_ring_hash";
 TraceFlag grpc_lb_ring_hash_trace(false, "ring_hash_lb");
 
+namespace {
+
+bool IsPrime(size_t n) {
+  if (n < 2) return false;
+  for (size_t i = 2; i * i <= n; ++i) {
+    if (n % i == 0) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 // Helper Parser method
 void ParseRingHashLbConfig(const Json& json, size_t* min_ring_size,
                            size_t* max_ring_size,
+                           RingHashLookupTable* lookup_table,
+                           size_t* maglev_table_size,
+                           uint32_t* hash_balance_factor,
                            std::vector<grpc_error_handle>* error_list) {
   *min_ring_size = 1024;
   *max_ring_size = 8388608;
+  *lookup_table = RingHashLookupTable::kRing;
+  *maglev_table_size = 65537;
+  *hash_balance_factor = 0;
   if (json.type() != Json::Type::OBJECT) {
     error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
         "ring_hash_experimental should be of type object"));
@@ -83,6 +109,244 @@ void ParseRingHashLbConfig(const Json& json, size_t* min_ring_size,
         "and max_ring_size cannot be smaller than "
         "min_ring_size"));
   }
+  ring_hash_it = ring_hash.find("lookup_table");
+  if (ring_hash_it != ring_hash.end()) {
+    if (ring_hash_it->second.type() != Json::Type::STRING) {
+      error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "field:lookup_table error: should be of type string"));
+    } else if (ring_hash_it->second.string_value() == "RING") {
+      *lookup_table = RingHashLookupTable::kRing;
+    } else if (ring_hash_it->second.string_value() == "MAGLEV") {
+      *lookup_table = RingHashLookupTable::kMaglev;
+    } else {
+      error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "field:lookup_table error: should be RING or MAGLEV"));
+    }
+  }
+  ring_hash_it = ring_hash.find("maglev_table_size");
+  if (ring_hash_it != ring_hash.end()) {
+    if (ring_hash_it->second.type() != Json::Type::NUMBER) {
+      error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "field:maglev_table_size error: should be of type number"));
+    } else {
+      int value = gpr_parse_nonnegative_int(
+          ring_hash_it->second.string_value().c_str());
+      if (value < 0 || value > 8388608 || !IsPrime(value)) {
+        error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+            "field:maglev_table_size error: should be a prime number "
+            "no larger than 8388608"));
+      } else {
+        *maglev_table_size = value;
+      }
+    }
+  }
+  ring_hash_it = ring_hash.find("hash_balance_factor");
+  if (ring_hash_it != ring_hash.end()) {
+    if (ring_hash_it->second.type() != Json::Type::NUMBER) {
+      error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "field:hash_balance_factor error: should be of type number"));
+    } else {
+      int value = gpr_parse_nonnegative_int(
+          ring_hash_it->second.string_value().c_str());
+      if (value < 100) {
+        error_list->push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+            "field:hash_balance_factor error: should be at least 100"));
+      } else {
+        *hash_balance_factor = value;
+      }
+    }
+  }
+}
+
+std::vector<RingHashEntry> MakeHashRing(
+    const std::vector<RingHashAddressWeight>& address_weights,
+    size_t min_ring_size, size_t max_ring_size) {
+  size_t sum = 0;
+  for (const auto& address : address_weights) sum += address.weight;
+  // Calculating normalized weights and find min and max.
+  std::vector<double> normalized_weights;
+  normalized_weights.reserve(address_weights.size());
+  double min_normalized_weight = 1.0;
+  double max_normalized_weight = 0.0;
+  for (const auto& address : address_weights) {
+    normalized_weights.push_back(static_cast<double>(address.weight) / sum);
+    min_normalized_weight =
+        std::min(normalized_weights.back(), min_normalized_weight);
+    max_normalized_weight =
+        std::max(normalized_weights.back(), max_normalized_weight);
+  }
+  // Scale up the number of hashes per host such that the least-weighted host
+  // gets a whole number of hashes on the ring. Other hosts might not end up
+  // with whole numbers, and that's fine (the ring-building algorithm below can
+  // handle this). This preserves the original implementation's behavior: when
+  // weights aren't provided, all hosts should get an equal number of hashes. In
+  // the case where this number exceeds the max_ring_size, it's scaled back down
+  // to fit.
+  const double scale = std::min(
+      std::ceil(min_normalized_weight * min_ring_size) / min_normalized_weight,
+      static_cast<double>(max_ring_size));
+  // Reserve memory for the entire ring up front.
+  const uint64_t ring_size = std::ceil(scale);
+  std::vector<RingHashEntry> ring;
+  ring.reserve(ring_size);
+  // Populate the hash ring by walking through the (host, weight) pairs in
+  // normalized_host_weights, and generating (scale * weight) hashes for each
+  // host. Since these aren't necessarily whole numbers, we maintain running
+  // sums -- current_hashes and target_hashes -- which allows us to populate the
+  // ring in a mostly stable way.
+  absl::InlinedVector<char, 196> hash_key_buffer;
+  double current_hashes = 0.0;
+  double target_hashes = 0.0;
+  for (size_t i = 0; i < address_weights.size(); ++i) {
+    const std::string& address_string = address_weights[i].address;
+    hash_key_buffer.assign(address_string.begin(), address_string.end());
+    hash_key_buffer.emplace_back('_');
+    auto offset_start = hash_key_buffer.end();
+    target_hashes += scale * normalized_weights[i];
+    size_t count = 0;
+    while (current_hashes < target_hashes) {
+      const std::string count_str = absl::StrCat(count);
+      hash_key_buffer.insert(offset_start, count_str.begin(), count_str.end());
+      absl::string_view hash_key(hash_key_buffer.data(),
+                                 hash_key_buffer.size());
+      const uint64_t hash = XXH64(hash_key.data(), hash_key.size(), 0);
+      ring.push_back({hash, static_cast<uint32_t>(i)});
+      ++count;
+      ++current_hashes;
+      hash_key_buffer.erase(offset_start, hash_key_buffer.end());
+    }
+  }
+  std::sort(ring.begin(), ring.end(),
+            [](const RingHashEntry& lhs, const RingHashEntry& rhs) -> bool {
+              return lhs.hash < rhs.hash;
+            });
+  return ring;
+}
+
+size_t FindInHashRing(const std::vector<RingHashEntry>& ring, uint64_t hash) {
+  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c
+  // (ketama_get_server) NOTE: The algorithm depends on using signed integers
+  // for lowp, highp, and first_index. Do not change them!
+  int64_t lowp = 0;
+  int64_t highp = ring.size();
+  int64_t first_index = 0;
+  while (true) {
+    first_index = (lowp + highp) / 2;
+    if (first_index == static_cast<int64_t>(ring.size())) {
+      first_index = 0;
+      break;
+    }
+    uint64_t midval = ring[first_index].hash;
+    uint64_t midval1 = first_index == 0 ? 0 : ring[first_index - 1].hash;
+    if (hash <= midval && hash > midval1) {
+      break;
+    }
+    if (midval < hash) {
+      lowp = first_index + 1;
+    } else {
+      highp = first_index - 1;
+    }
+    if (lowp > highp) {
+      first_index = 0;
+      break;
+    }
+  }
+  return first_index;
+}
+
+std::vector<uint32_t> MakeMaglevTable(
+    const std::vector<RingHashAddressWeight>& address_weights,
+    size_t table_size) {
+  GPR_ASSERT(!address_weights.empty());
+  constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+  // Each address has its own order of preference for the slots of the
+  // table, (offset + n * skip) % table_size for n = 0, 1, ..., which visits
+  // every slot since table_size is prime.
+  struct Permutation {
+    uint64_t offset;
+    uint64_t skip;
+    uint64_t next;
+    uint64_t target_weight;
+  };
+  std::vector<Permutation> permutations;
+  permutations.reserve(address_weights.size());
+  uint64_t max_weight = 0;
+  for (const auto& address : address_weights) {
+    const uint64_t offset =
+        XXH64(address.address.data(), address.address.size(), 0) % table_size;
+    const uint64_t skip =
+        XXH64(address.address.data(), address.address.size(), 1) %
+            (table_size - 1) +
+        1;
+    permutations.push_back({offset, skip, 0, 0});
+    max_weight = std::max<uint64_t>(max_weight, address.weight);
+  }
+  // Addresses take turns to claim their next preferred slot that is still
+  // empty, until the table is full.  The address with the highest weight
+  // takes a turn in every round, one with half of that weight in every
+  // other round, and so on.
+  std::vector<uint32_t> table(table_size, kEmpty);
+  size_t num_filled = 0;
+  for (uint64_t round = 1; num_filled < table_size; ++round) {
+    for (size_t i = 0; i < address_weights.size() && num_filled < table_size;
+         ++i) {
+      Permutation& permutation = permutations[i];
+      if (address_weights[i].weight * round < permutation.target_weight) {
+        continue;
+      }
+      permutation.target_weight += max_weight;
+      size_t slot;
+      do {
+        slot = (permutation.offset + permutation.next * permutation.skip) %
+               table_size;
+        ++permutation.next;
+      } while (table[slot] != kEmpty);
+      table[slot] = static_cast<uint32_t>(i);
+      ++num_filled;
+    }
+  }
+  return table;
+}
+
+absl::Status ValidateMaglevTableSize(size_t table_size, size_t num_addresses) {
+  if (table_size >= num_addresses) return absl::OkStatus();
+  return absl::InvalidArgumentError(
+      absl::StrCat("maglev_table_size ", table_size,
+                   " is smaller than the number of addresses (",
+                   num_addresses, ")"));
+}
+
+std::vector<double> RingHashCapacityFactors(
+    const std::vector<uint32_t>& weights, const std::vector<bool>& ready,
+    uint32_t hash_balance_factor) {
+  const double balance_factor = hash_balance_factor / 100.0;
+  uint64_t total_weight = 0;
+  uint64_t ready_weight = 0;
+  for (size_t i = 0; i < weights.size(); ++i) {
+    total_weight += weights[i];
+    if (ready[i]) ready_weight += weights[i];
+  }
+  std::vector<double> capacity_factors;
+  capacity_factors.reserve(weights.size());
+  for (size_t i = 0; i < weights.size(); ++i) {
+    // Before any address is READY, spread the capacity over all of them.
+    if (ready_weight == 0) {
+      capacity_factors.push_back(balance_factor * weights[i] / total_weight);
+    } else if (ready[i]) {
+      capacity_factors.push_back(balance_factor * weights[i] / ready_weight);
+    } else {
+      capacity_factors.push_back(0);
+    }
+  }
+  return capacity_factors;
+}
+
+bool RingHashHasCapacity(uint32_t outstanding, uint32_t total_outstanding,
+                         double capacity_factor) {
+  // Count the call being picked, so that an idle address has room for it.
+  return outstanding <
+         std::ceil(capacity_factor * (static_cast<double>(total_outstanding) +
+                                      1));
 }
 
 namespace {
@@ -91,15 +355,31 @@ constexpr char kRingHash[] = "ring_hash_experimental";
 
 class RingHashLbConfig : public LoadBalancingPolicy::Config {
  public:
-  RingHashLbConfig(size_t min_ring_size, size_t max_ring_size)
-      : min_ring_size_(min_ring_size), max_ring_size_(max_ring_size) {}
+  RingHashLbConfig(size_t min_ring_size, size_t max_ring_size,
+                   RingHashLookupTable lookup_table, size_t maglev_table_size,
+                   uint32_t hash_balance_factor)
+      : min_ring_size_(min_ring_size),
+        max_ring_size_(max_ring_size),
+        lookup_table_(lookup_table),
+        maglev_table_size_(maglev_table_size),
+        hash_balance_factor_(hash_balance_factor) {}
   const char* name() const override { return kRingHash; }
   size_t min_ring_size() const { return min_ring_size_; }
   size_t max_ring_size() const { return max_ring_size_; }
+  RingHashLookupTable lookup_table() const { return lookup_table_; }
+  size_t maglev_table_size() const { return maglev_table_size_; }
+  // If non-zero, no subchannel gets more than hash_balance_factor percent
+  // of its fair share of the calls in flight, as in "Consistent Hashing
+  // with Bounded Loads" (Mirrokni et al., SODA 2018).  Calls that would
+  // exceed that go to the next subchannel in the ring or table instead.
+  uint32_t hash_balance_factor() const { return hash_balance_factor_; }
 
  private:
   size_t min_ring_size_;
   size_t max_ring_size_;
+  RingHashLookupTable lookup_table_;
+  size_t maglev_table_size_;
+  uint32_t hash_balance_factor_;
 };
 
 //
@@ -207,31 +487,95 @@ class RingHash : public LoadBalancingPolicy {
     size_t num_transient_failure_ = 0;
   };
 
-  class Ring : public RefCounted<Ring> {
+  // The number of calls in flight on each subchannel of a ring, when loads
+  // are bounded.  Calls hold refs to it, so it may outlive the ring.
+  class OutstandingRequests : public RefCounted<OutstandingRequests> {
    public:
-    struct Entry {
-      uint64_t hash;
-      RingHashSubchannelData* subchannel;
-    };
+    explicit OutstandingRequests(size_t num_subchannels)
+        : counts_(absl::make_unique<std::atomic<uint32_t>[]>(num_subchannels)) {
+    }
+
+    uint32_t total() const { return total_.load(std::memory_order_relaxed); }
+    uint32_t count(size_t index) const {
+      return counts_[index].load(std::memory_order_relaxed);
+    }
+
+    void Add(size_t index) {
+      counts_[index].fetch_add(1, std::memory_order_relaxed);
+      total_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void Remove(size_t index) {
+      counts_[index].fetch_sub(1, std::memory_order_relaxed);
+      total_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+   private:
+    std::unique_ptr<std::atomic<uint32_t>[]> counts_;
+    std::atomic<uint32_t> total_{0};
+  };
 
+  // The ring or Maglev table of a subchannel list.  Either way, it maps a
+  // hash to a position, and the positions that follow it are where the
+  // picker looks for another subchannel if the first is not usable.
+  class Ring : public RefCounted<Ring> {
+   public:
     Ring(RingHash* parent,
          RefCountedPtr<RingHashSubchannelList> subchannel_list);
 
-    const std::vector<Entry>& ring() const { return ring_; }
+    size_t size() const {
+      return lookup_table_ == RingHashLookupTable::kMaglev
+                 ? maglev_table_.size()
+                 : ring_.size();
+    }
+
+    // Returns the position that hash maps to.
+    size_t Find(uint64_t hash) const {
+      return lookup_table_ == RingHashLookupTable::kMaglev
+                 ? hash % maglev_table_.size()
+                 : FindInHashRing(ring_, hash);
+    }
+
+    RingHashSubchannelData* subchannel(size_t position) const {
+      return subchannel_list_->subchannel(
+          lookup_table_ == RingHashLookupTable::kMaglev
+              ? maglev_table_[position]
+              : ring_[position].index);
+    }
+
+    // Null unless loads are bounded.
+    const RefCountedPtr<OutstandingRequests>& outstanding_requests() const {
+      return outstanding_requests_;
+    }
+
+    // When loads are bounded, returns for each subchannel the share of the
+    // calls in flight that it may have, which is hash_balance_factor
+    // percent of its share of the weight of the READY subchannels.
+    std::vector<double> CapacityFactors() const;
 
    private:
     RefCountedPtr<RingHashSubchannelList> subchannel_list_;
-    std::vector<Entry> ring_;
+    const RingHashLookupTable lookup_table_;
+    // Only the one for lookup_table_ is populated.
+    std::vector<RingHashEntry> ring_;
+    std::vector<uint32_t> maglev_table_;
+    // Only set when loads are bounded.
+    std::vector<uint32_t> weights_;
+    uint32_t hash_balance_factor_ = 0;
+    RefCountedPtr<OutstandingRequests> outstanding_requests_;
   };
 
   class Picker : public SubchannelPicker {
    public:
     Picker(RefCountedPtr<RingHash> parent, RefCountedPtr<Ring> ring)
-        : parent_(std::move(parent)), ring_(std::move(ring)) {}
+        : parent_(std::move(parent)),
+          ring_(std::move(ring)),
+          capacity_factors_(ring_->CapacityFactors()) {}
 
     PickResult Pick(PickArgs args) override;
 
    private:
+    class SubchannelCallTracker;
+
     // A fire-and-forget class that schedules subchannel connection attempts
     // on the control plane WorkSerializer.
     class SubchannelConnectionAttempter : public Orphanable {
@@ -272,8 +616,14 @@ class RingHash : public LoadBalancingPolicy {
       absl::InlinedVector<RefCountedPtr<SubchannelInterface>, 10> subchannels_;
     };
 
+    // Returns the subchannel at position, which must be READY, or if loads
+    // are bounded and it is full, the next READY one that is not.
+    PickResult CompletePick(size_t position);
+
     RefCountedPtr<RingHash> parent_;
     RefCountedPtr<Ring> ring_;
+    // Empty unless loads are bounded.
+    const std::vector<double> capacity_factors_;
   };
 
   void ShutdownLocked() override;
@@ -296,108 +646,118 @@ class RingHash : public LoadBalancingPolicy {
 
 RingHash::Ring::Ring(RingHash* parent,
                      RefCountedPtr<RingHashSubchannelList> subchannel_list)
-    : subchannel_list_(std::move(subchannel_list)) {
+    : subchannel_list_(std::move(subchannel_list)),
+      lookup_table_(parent->config_->lookup_table()) {
   size_t num_subchannels = subchannel_list_->num_subchannels();
-  // Store the weights while finding the sum.
-  struct AddressWeight {
-    std::string address;
-    // Default weight is 1 for the cases where a weight is not provided,
-    // each occurrence of the address will be counted a weight value of 1.
-    uint32_t weight = 1;
-    double normalized_weight;
-  };
-  std::vector<AddressWeight> address_weights;
-  size_t sum = 0;
+  std::vector<RingHashAddressWeight> address_weights;
   address_weights.reserve(num_subchannels);
   for (size_t i = 0; i < num_subchannels; ++i) {
     RingHashSubchannelData* sd = subchannel_list_->subchannel(i);
     const ServerAddressWeightAttribute* weight_attribute = static_cast<
         const ServerAddressWeightAttribute*>(sd->address().GetAttribute(
         ServerAddressWeightAttribute::kServerAddressWeightAttributeKey));
-    AddressWeight address_weight;
+    RingHashAddressWeight address_weight;
     address_weight.address =
         grpc_sockaddr_to_string(&sd->address().address(), false);
+    // Default weight is 1 for the cases where a weight is not provided,
+    // each occurrence of the address will be counted a weight value of 1.
+    address_weight.weight = 1;
     if (weight_attribute != nullptr) {
       GPR_ASSERT(weight_attribute->weight() != 0);
       address_weight.weight = weight_attribute->weight();
     }
-    sum += address_weight.weight;
     address_weights.push_back(std::move(address_weight));
   }
-  // Calculating normalized weights and find min and max.
-  double min_normalized_weight = 1.0;
-  double max_normalized_weight = 0.0;
-  for (auto& address : address_weights) {
-    address.normalized_weight = static_cast<double>(address.weight) / sum;
-    min_normalized_weight =
-        std::min(address.normalized_weight, min_normalized_weight);
-    max_normalized_weight =
-        std::max(address.normalized_weight, max_normalized_weight);
+  if (lookup_table_ == RingHashLookupTable::kMaglev) {
+    maglev_table_ = MakeMaglevTable(address_weights,
+                                    parent->config_->maglev_table_size());
+  } else {
+    ring_ = MakeHashRing(address_weights, parent->config_->min_ring_size(),
+                         parent->config_->max_ring_size());
   }
-  // Scale up the number of hashes per host such that the least-weighted host
-  // gets a whole number of hashes on the ring. Other hosts might not end up
-  // with whole numbers, and that's fine (the ring-building algorithm below can
-  // handle this). This preserves the original implementation's behavior: when
-  // weights aren't provided, all hosts should get an equal number of hashes. In
-  // the case where this number exceeds the max_ring_size, it's scaled back down
-  // to fit.
-  const size_t min_ring_size = parent->config_->min_ring_size();
-  const size_t max_ring_size = parent->config_->max_ring_size();
-  const double scale = std::min(
-      std::ceil(min_normalized_weight * min_ring_size) / min_normalized_weight,
-      static_cast<double>(max_ring_size));
-  // Reserve memory for the entire ring up front.
-  const uint64_t ring_size = std::ceil(scale);
-  ring_.reserve(ring_size);
-  // Populate the hash ring by walking through the (host, weight) pairs in
-  // normalized_host_weights, and generating (scale * weight) hashes for each
-  // host. Since these aren't necessarily whole numbers, we maintain running
-  // sums -- current_hashes and target_hashes -- which allows us to populate the
-  // ring in a mostly stable way.
-  absl::InlinedVector<char, 196> hash_key_buffer;
-  double current_hashes = 0.0;
-  double target_hashes = 0.0;
-  uint64_t min_hashes_per_host = ring_size;
-  uint64_t max_hashes_per_host = 0;
-  for (size_t i = 0; i < num_subchannels; ++i) {
-    const std::string& address_string = address_weights[i].address;
-    hash_key_buffer.assign(address_string.begin(), address_string.end());
-    hash_key_buffer.emplace_back('_');
-    auto offset_start = hash_key_buffer.end();
-    target_hashes += scale * address_weights[i].normalized_weight;
-    size_t count = 0;
-    while (current_hashes < target_hashes) {
-      const std::string count_str = absl::StrCat(count);
-      hash_key_buffer.insert(offset_start, count_str.begin(), count_str.end());
-      absl::string_view hash_key(hash_key_buffer.data(),
-                                 hash_key_buffer.size());
-      const uint64_t hash = XXH64(hash_key.data(), hash_key.size(), 0);
-      ring_.push_back({hash, subchannel_list_->subchannel(i)});
-      ++count;
-      ++current_hashes;
-      hash_key_buffer.erase(offset_start, hash_key_buffer.end());
+  if (parent->config_->hash_balance_factor() > 0) {
+    weights_.reserve(num_subchannels);
+    for (const auto& address_weight : address_weights) {
+      weights_.push_back(address_weight.weight);
     }
-    min_hashes_per_host =
-        std::min(static_cast<uint64_t>(i), min_hashes_per_host);
-    max_hashes_per_host =
-        std::max(static_cast<uint64_t>(i), max_hashes_per_host);
+    hash_balance_factor_ = parent->config_->hash_balance_factor();
+    outstanding_requests_ = MakeRefCounted<OutstandingRequests>(num_subchannels);
   }
-  std::sort(ring_.begin(), ring_.end(),
-            [](const Entry& lhs, const Entry& rhs) -> bool {
-              return lhs.hash < rhs.hash;
-            });
   if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_ring_hash_trace)) {
     gpr_log(GPR_INFO,
-            "[RH %p picker %p] created ring from subchannel_list=%p "
-            "with %" PRIuPTR " ring entries",
-            parent, this, subchannel_list_.get(), ring_.size());
+            "[RH %p picker %p] created %s from subchannel_list=%p "
+            "with %" PRIuPTR " entries",
+            parent, this,
+            lookup_table_ == RingHashLookupTable::kMaglev ? "Maglev table"
+                                                          : "ring",
+            subchannel_list_.get(), size());
+  }
+}
+
+std::vector<double> RingHash::Ring::CapacityFactors() const {
+  if (outstanding_requests_ == nullptr) return {};
+  std::vector<bool> ready;
+  ready.reserve(weights_.size());
+  for (size_t i = 0; i < weights_.size(); ++i) {
+    ready.push_back(subchannel_list_->subchannel(i)->GetConnectivityState() ==
+                    GRPC_CHANNEL_READY);
   }
+  return RingHashCapacityFactors(weights_, ready, hash_balance_factor_);
 }
 
 //
 // RingHash::Picker
 //
 
+//
+// RingHash::Picker::SubchannelCallTracker
+//
+
+class RingHash::Picker::SubchannelCallTracker
+    : public LoadBalancingPolicy::SubchannelCallTrackerInterface {
+ public:
+  SubchannelCallTracker(
+      RefCountedPtr<OutstandingRequests> outstanding_requests, size_t index)
+      : outstanding_requests_(std::move(outstanding_requests)), index_(index) {}
+
+  void Start() override { outstanding_requests_->Add(index_); }
+
+  void Finish(FinishArgs /*args*/) override {
+    outstanding_requests_->Remove(index_);
+  }
+
+ private:
+  RefCountedPtr<OutstandingRequests> outstanding_requests_;
+  const size_t index_;
+};
+
+//
+// RingHash::Picker
+//
+
+RingHash::PickResult RingHash::Picker::CompletePick(size_t position) {
+  const RefCountedPtr<OutstandingRequests>& outstanding_requests =
+      ring_->outstanding_requests();
+  RingHashSubchannelData* sd = ring_->subchannel(position);
+  if (outstanding_requests == nullptr) {
+    return PickResult::Complete(sd->subchannel()->Ref());
+  }
+  // The capacity factors of the READY subchannels add up to more than 1,
+  // so one of them is not full, unless their states changed since this
+  // picker was created.  In that case, stay with the first one.
+  const uint32_t total = outstanding_requests->total();
+  sd = ring_->subchannel(FindRingHashPositionWithCapacity(
+      position, ring_->size(), [&](size_t next_position) {
+        const RingHashSubchannelData* next = ring_->subchannel(next_position);
+        return next->GetConnectivityState() == GRPC_CHANNEL_READY &&
+               RingHashHasCapacity(outstanding_requests->count(next->Index()),
+                                   total, capacity_factors_[next->Index()]);
+      }));
+  return PickResult::Complete(sd->subchannel()->Ref(),
+                              absl::make_unique<SubchannelCallTracker>(
+                                  outstanding_requests, sd->Index()));
+}
+
 RingHash::PickResult RingHash::Picker::Pick(PickArgs args) {
   auto hash =
       args.call_state->ExperimentalGetCallAttribute(kRequestRingHashAttribute);
@@ -406,34 +766,8 @@ RingHash::PickResult RingHash::Picker::Pick(PickArgs args) {
     return PickResult::Fail(
         absl::InternalError("xds ring hash value is not a number"));
   }
-  const std::vector<Ring::Entry>& ring = ring_->ring();
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c
-  // (ketama_get_server) NOTE: The algorithm depends on using signed integers
-  // for lowp, highp, and first_index. Do not change them!
-  int64_t lowp = 0;
-  int64_t highp = ring.size();
-  int64_t first_index = 0;
-  while (true) {
-    first_index = (lowp + highp) / 2;
-    if (first_index == static_cast<int64_t>(ring.size())) {
-      first_index = 0;
-      break;
-    }
-    uint64_t midval = ring[first_index].hash;
-    uint64_t midval1 = first_index == 0 ? 0 : ring[first_index - 1].hash;
-    if (h <= midval && h > midval1) {
-      break;
-    }
-    if (midval < h) {
-      lowp = first_index + 1;
-    } else {
-      highp = first_index - 1;
-    }
-    if (lowp > highp) {
-      first_index = 0;
-      break;
-    }
-  }
+  const size_t first_index = ring_->Find(h);
+  RingHashSubchannelData* first_sd = ring_->subchannel(first_index);
   OrphanablePtr<SubchannelConnectionAttempter> subchannel_connection_attempter;
   auto ScheduleSubchannelConnectionAttempt =
       [&](RefCountedPtr<SubchannelInterface> subchannel) {
@@ -443,41 +777,37 @@ RingHash::PickResult RingHash::Picker::Pick(PickArgs args) {
         }
         subchannel_connection_attempter->AddSubchannel(std::move(subchannel));
       };
-  switch (ring[first_index].subchannel->GetConnectivityState()) {
+  switch (first_sd->GetConnectivityState()) {
     case GRPC_CHANNEL_READY:
-      return PickResult::Complete(
-          ring[first_index].subchannel->subchannel()->Ref());
+      return CompletePick(first_index);
     case GRPC_CHANNEL_IDLE:
-      ScheduleSubchannelConnectionAttempt(
-          ring[first_index].subchannel->subchannel()->Ref());
+      ScheduleSubchannelConnectionAttempt(first_sd->subchannel()->Ref());
       ABSL_FALLTHROUGH_INTENDED;
     case GRPC_CHANNEL_CONNECTING:
       return PickResult::Queue();
     default:  // GRPC_CHANNEL_TRANSIENT_FAILURE
       break;
   }
-  ScheduleSubchannelConnectionAttempt(
-      ring[first_index].subchannel->subchannel()->Ref());
+  ScheduleSubchannelConnectionAttempt(first_sd->subchannel()->Ref());
   // Loop through remaining subchannels to find one in READY.
   // On the way, we make sure the right set of connection attempts
   // will happen.
   bool found_second_subchannel = false;
   bool found_first_non_failed = false;
-  for (size_t i = 1; i < ring.size(); ++i) {
-    const Ring::Entry& entry = ring[(first_index + i) % ring.size()];
-    if (entry.subchannel == ring[first_index].subchannel) {
+  for (size_t i = 1; i < ring_->size(); ++i) {
+    const size_t position = (first_index + i) % ring_->size();
+    RingHashSubchannelData* sd = ring_->subchannel(position);
+    if (sd == first_sd) {
       continue;
     }
-    grpc_connectivity_state connectivity_state =
-        entry.subchannel->GetConnectivityState();
+    grpc_connectivity_state connectivity_state = sd->GetConnectivityState();
     if (connectivity_state == GRPC_CHANNEL_READY) {
-      return PickResult::Complete(entry.subchannel->subchannel()->Ref());
+      return CompletePick(position);
     }
     if (!found_second_subchannel) {
       switch (connectivity_state) {
         case GRPC_CHANNEL_IDLE:
-          ScheduleSubchannelConnectionAttempt(
-              entry.subchannel->subchannel()->Ref());
+          ScheduleSubchannelConnectionAttempt(sd->subchannel()->Ref());
           ABSL_FALLTHROUGH_INTENDED;
         case GRPC_CHANNEL_CONNECTING:
           return PickResult::Queue();
@@ -488,12 +818,10 @@ RingHash::PickResult RingHash::Picker::Pick(PickArgs args) {
     }
     if (!found_first_non_failed) {
       if (connectivity_state == GRPC_CHANNEL_TRANSIENT_FAILURE) {
-        ScheduleSubchannelConnectionAttempt(
-            entry.subchannel->subchannel()->Ref());
+        ScheduleSubchannelConnectionAttempt(sd->subchannel()->Ref());
       } else {
         if (connectivity_state == GRPC_CHANNEL_IDLE) {
-          ScheduleSubchannelConnectionAttempt(
-              entry.subchannel->subchannel()->Ref());
+          ScheduleSubchannelConnectionAttempt(sd->subchannel()->Ref());
         }
         found_first_non_failed = true;
       }
@@ -724,6 +1052,7 @@ void RingHash::ResetBackoffLocked() { subchannel_list_->ResetBackoffLocked(); }
 void RingHash::UpdateLocked(UpdateArgs args) {
   config_ = std::move(args.config);
   ServerAddressList addresses;
+  absl::Status status;
   if (args.addresses.ok()) {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_ring_hash_trace)) {
       gpr_log(GPR_INFO, "[RH %p] received update with %" PRIuPTR " addresses",
@@ -739,6 +1068,13 @@ void RingHash::UpdateLocked(UpdateArgs args) {
         addresses.emplace_back(std::move(address));
       }
     }
+    // A Maglev table needs an entry for each address.  Rather than silently
+    // dropping some of them, treat the config as invalid for this list.
+    if (config_->lookup_table() == RingHashLookupTable::kMaglev) {
+      status = ValidateMaglevTableSize(config_->maglev_table_size(),
+                                       addresses.size());
+      if (!status.ok()) addresses.clear();
+    }
   } else {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_ring_hash_trace)) {
       gpr_log(GPR_INFO, "[RH %p] received update with addresses error: %s",
@@ -752,10 +1088,12 @@ void RingHash::UpdateLocked(UpdateArgs args) {
       this, &grpc_lb_ring_hash_trace, std::move(addresses), *args.args);
   if (subchannel_list_->num_subchannels() == 0) {
     // If the new list is empty, immediately transition to TRANSIENT_FAILURE.
-    absl::Status status =
-        args.addresses.ok() ? absl::UnavailableError(absl::StrCat(
-                                  "empty address list: ", args.resolution_note))
-                            : args.addresses.status();
+    if (!args.addresses.ok()) {
+      status = args.addresses.status();
+    } else if (status.ok()) {
+      status = absl::UnavailableError(
+          absl::StrCat("empty address list: ", args.resolution_note));
+    }
     channel_control_helper()->UpdateState(
         GRPC_CHANNEL_TRANSIENT_FAILURE, status,
         absl::make_unique<TransientFailurePicker>(status));
@@ -784,10 +1122,17 @@ class RingHashFactory : public LoadBalancingPolicyFactory {
       const Json& json, grpc_error_handle* error) const override {
     size_t min_ring_size;
     size_t max_ring_size;
+    RingHashLookupTable lookup_table;
+    size_t maglev_table_size;
+    uint32_t hash_balance_factor;
     std::vector<grpc_error_handle> error_list;
-    ParseRingHashLbConfig(json, &min_ring_size, &max_ring_size, &error_list);
+    ParseRingHashLbConfig(json, &min_ring_size, &max_ring_size, &lookup_table,
+                          &maglev_table_size, &hash_balance_factor,
+                          &error_list);
     if (error_list.empty()) {
-      return MakeRefCounted<RingHashLbConfig>(min_ring_size, max_ring_size);
+      return MakeRefCounted<RingHashLbConfig>(min_ring_size, max_ring_size,
+                                              lookup_table, maglev_table_size,
+                                              hash_balance_factor);
     } else {
       *error = GRPC_ERROR_CREATE_FROM_VECTOR(
           "ring_hash_experimental LB policy config", &error_list);
@@ -19,19 +19,102 @@
 
 #include <grpc/support/port_platform.h>
 
+#include <stdint.h>
 #include <stdlib.h>
 
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+
 #include "src/core/lib/iomgr/error.h"
 #include "src/core/lib/json/json.h"
 
 namespace grpc_core {
 extern const char* kRequestRingHashAttribute;
 
+// How the addresses are laid out for lookup by request hash.
+enum class RingHashLookupTable {
+  // A ring of hashes sorted by value, searched in O(log n).
+  kRing,
+  // A Maglev lookup table (Eisenbud et al., NSDI 2016), indexed in O(1).
+  // It takes a fixed amount of memory, and when an address is added or
+  // removed only about its share of the table moves to other addresses.
+  kMaglev,
+};
+
 // Helper Parsing method to parse ring hash policy configs; for example, ring
-// hash size validity.
+// hash size validity.  hash_balance_factor is 0 if loads are not bounded.
 void ParseRingHashLbConfig(const Json& json, size_t* min_ring_size,
                            size_t* max_ring_size,
+                           RingHashLookupTable* lookup_table,
+                           size_t* maglev_table_size,
+                           uint32_t* hash_balance_factor,
                            std::vector<grpc_error_handle>* error_list);
+
+// The hash key of an address and its weight.
+struct RingHashAddressWeight {
+  std::string address;
+  uint32_t weight;
+};
+
+// An entry in a hash ring: a hash, and the index of the address owning the
+// part of the ring that ends there.
+struct RingHashEntry {
+  uint64_t hash;
+  uint32_t index;
+};
+
+// Returns a ring with between min_ring_size and max_ring_size entries,
+// sorted by hash, where each address has a number of entries proportional
+// to its weight.
+std::vector<RingHashEntry> MakeHashRing(
+    const std::vector<RingHashAddressWeight>& address_weights,
+    size_t min_ring_size, size_t max_ring_size);
+
+// Returns the position in ring of the entry that hash falls on.
+size_t FindInHashRing(const std::vector<RingHashEntry>& ring, uint64_t hash);
+
+// Returns a Maglev lookup table of table_size entries, each of which is the
+// index of an address, with addresses filling a share of the table
+// proportional to their weight.  table_size must be prime.  A hash is
+// looked up at position hash % table_size.
+std::vector<uint32_t> MakeMaglevTable(
+    const std::vector<RingHashAddressWeight>& address_weights,
+    size_t table_size);
+
+// Returns an error if a Maglev table of table_size entries is too small to
+// give each of num_addresses addresses an entry.
+absl::Status ValidateMaglevTableSize(size_t table_size, size_t num_addresses);
+
+// For bounded loads, returns for each address the share of the calls in
+// flight that it may have: hash_balance_factor percent of its share of the
+// weight of the READY addresses.  Addresses that are not READY get none,
+// unless no address is READY, in which case the weight of all of them is
+// shared out.
+std::vector<double> RingHashCapacityFactors(
+    const std::vector<uint32_t>& weights, const std::vector<bool>& ready,
+    uint32_t hash_balance_factor);
+
+// Returns whether an address with outstanding calls in flight, out of
+// total_outstanding on all addresses, may take one more call without going
+// over capacity_factor of them, rounded up.
+bool RingHashHasCapacity(uint32_t outstanding, uint32_t total_outstanding,
+                         double capacity_factor);
+
+// Returns position if has_capacity(position), or else the first position
+// after it in a ring or table of size entries, wrapping around, for which
+// has_capacity() is true.  If there is none, returns position.
+template <typename HasCapacityFn>
+size_t FindRingHashPositionWithCapacity(size_t position, size_t size,
+                                        HasCapacityFn has_capacity) {
+  if (has_capacity(position)) return position;
+  for (size_t i = 1; i < size; ++i) {
+    const size_t next = (position + i) % size;
+    if (has_capacity(next)) return next;
+  }
+  return position;
+}
 }  // namespace grpc_core
 
 #endif  // GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_RING_HASH_RING_HASH_H
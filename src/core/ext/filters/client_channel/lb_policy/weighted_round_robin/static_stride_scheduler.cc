@@ -0,0 +1,61 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/static_stride_scheduler.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace grpc_core {
+
+constexpr uint32_t StaticStrideScheduler::kMaxWeight;
+constexpr float StaticStrideScheduler::kMaxRatio;
+
+absl::optional<StaticStrideScheduler> StaticStrideScheduler::Make(
+    const std::vector<float>& weights) {
+  size_t num_positive = 0;
+  double sum = 0;
+  for (float weight : weights) {
+    if (weight > 0) {
+      ++num_positive;
+      sum += weight;
+    }
+  }
+  if (num_positive < 2) return absl::nullopt;
+  const double mean = sum / num_positive;
+  const double min_weight = mean / kMaxRatio;
+  const double max_weight = mean * kMaxRatio;
+  double max = 0;
+  for (float weight : weights) {
+    if (weight > 0) max = std::max(max, std::min<double>(weight, max_weight));
+  }
+  const double scale = kMaxWeight / max;
+  std::vector<uint16_t> scaled;
+  scaled.reserve(weights.size());
+  for (float weight : weights) {
+    const double clamped =
+        weight > 0 ? std::min(std::max<double>(weight, min_weight), max_weight)
+                   : mean;
+    scaled.push_back(static_cast<uint16_t>(
+        std::max(1.0, std::min<double>(round(clamped * scale), kMaxWeight))));
+  }
+  return StaticStrideScheduler(std::move(scaled));
+}
+
+}  // namespace grpc_core
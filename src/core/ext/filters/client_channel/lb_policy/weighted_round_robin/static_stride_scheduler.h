@@ -0,0 +1,83 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_WEIGHTED_ROUND_ROBIN_STATIC_STRIDE_SCHEDULER_H
+#define GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_WEIGHTED_ROUND_ROBIN_STATIC_STRIDE_SCHEDULER_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "absl/types/optional.h"
+
+namespace grpc_core {
+
+// Picks items in proportion to fixed weights, with stride scheduling over
+// a static array of weights. The scheduler itself is immutable: picks are
+// driven by a sequence number supplied by the caller, so that pickers can
+// call Pick() concurrently without locks.
+//
+// Each sequence number maps to an item, as in round robin, and to a
+// generation, which is how many times round robin went around the list.
+// An item with weight w is picked in w out of every kMaxWeight generations,
+// at generations spread evenly apart; otherwise the next sequence number
+// is tried. Weights are clamped to within kMaxRatio of their mean, so each
+// pick tries at most kMaxRatio items on average.
+class StaticStrideScheduler {
+ public:
+  static constexpr uint32_t kMaxWeight = 0xFFFF;
+  static constexpr float kMaxRatio = 10;
+
+  // Returns nullopt if fewer than two of the weights are positive, in which
+  // case plain round robin is as good. Items with no weight get the mean
+  // weight.
+  static absl::optional<StaticStrideScheduler> Make(
+      const std::vector<float>& weights);
+
+  // Returns the index of the item to pick. next_sequence() returns the
+  // next number of a sequence that the caller increments.
+  template <typename NextSequenceFn>
+  size_t Pick(NextSequenceFn next_sequence) const {
+    while (true) {
+      const uint64_t sequence = next_sequence();
+      const size_t index = sequence % weights_.size();
+      const uint64_t generation = sequence / weights_.size();
+      const uint64_t weight = weights_[index];
+      // Offsetting each item by half a cycle from the one before keeps
+      // items of equal weight from being picked in the same generations.
+      const uint64_t offset = index * (kMaxWeight / 2);
+      if ((weight * generation + offset) % kMaxWeight >= kMaxWeight - weight) {
+        return index;
+      }
+    }
+  }
+
+  // The weights, scaled to at most kMaxWeight.
+  const std::vector<uint16_t>& weights() const { return weights_; }
+
+ private:
+  explicit StaticStrideScheduler(std::vector<uint16_t> weights)
+      : weights_(std::move(weights)) {}
+
+  std::vector<uint16_t> weights_;
+};
+
+}  // namespace grpc_core
+
+#endif  // GRPC_CORE_EXT_FILTERS_CLIENT_CHANNEL_LB_POLICY_WEIGHTED_ROUND_ROBIN_STATIC_STRIDE_SCHEDULER_H
@@ -0,0 +1,471 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <grpc/support/port_platform.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/types/optional.h"
+
+#include "src/core/ext/filters/client_channel/lb_policy/ready_subchannel_list.h"
+#include "src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/static_stride_scheduler.h"
+#include "src/core/ext/filters/client_channel/lb_policy_registry.h"
+#include "src/core/ext/filters/client_channel/subchannel.h"
+#include "src/core/lib/address_utils/sockaddr_utils.h"
+#include "src/core/lib/channel/channel_args.h"
+#include "src/core/lib/debug/trace.h"
+#include "src/core/lib/gprpp/per_cpu.h"
+#include "src/core/lib/gprpp/ref_counted.h"
+#include "src/core/lib/gprpp/ref_counted_ptr.h"
+#include "src/core/lib/gprpp/sync.h"
+#include "src/core/lib/iomgr/exec_ctx.h"
+#include "src/core/lib/iomgr/timer.h"
+#include "src/core/lib/json/json_util.h"
+#include "src/core/lib/transport/connectivity_state.h"
+
+namespace grpc_core {
+
+TraceFlag grpc_lb_weighted_round_robin_trace(false, "weighted_round_robin");
+
+namespace {
+
+//
+// weighted_round_robin LB policy
+//
+
+constexpr char kWeightedRoundRobin[] = "weighted_round_robin_experimental";
+
+constexpr grpc_millis kDefaultBlackoutPeriod = 10 * GPR_MS_PER_SEC;
+constexpr grpc_millis kDefaultWeightExpirationPeriod = 180 * GPR_MS_PER_SEC;
+constexpr grpc_millis kDefaultWeightUpdatePeriod = GPR_MS_PER_SEC;
+constexpr grpc_millis kMinWeightUpdatePeriod = 100;
+
+class WeightedRoundRobinConfig : public LoadBalancingPolicy::Config {
+ public:
+  WeightedRoundRobinConfig(grpc_millis blackout_period,
+                           grpc_millis weight_expiration_period,
+                           grpc_millis weight_update_period)
+      : blackout_period_(blackout_period),
+        weight_expiration_period_(weight_expiration_period),
+        weight_update_period_(weight_update_period) {}
+
+  const char* name() const override { return kWeightedRoundRobin; }
+
+  // How long an endpoint must have been reporting load before its weight
+  // is used, so that a newly started backend isn't flooded on the strength
+  // of the few calls it has seen.
+  grpc_millis blackout_period() const { return blackout_period_; }
+  // How long the weight of an endpoint that stopped reporting load is kept.
+  grpc_millis weight_expiration_period() const {
+    return weight_expiration_period_;
+  }
+  // How often pickers are rebuilt with the latest weights.  Load reports are
+  // also averaged over about this long.
+  grpc_millis weight_update_period() const { return weight_update_period_; }
+
+ private:
+  grpc_millis blackout_period_;
+  grpc_millis weight_expiration_period_;
+  grpc_millis weight_update_period_;
+};
+
+// The weight of an endpoint, derived from the load reports sent by the
+// backend in the trailing metadata of calls.  Shared by the subchannels for
+// the endpoint in all subchannel lists, by pickers and by calls.
+class EndpointWeight : public RefCounted<EndpointWeight> {
+ public:
+  // Folds the load report of a call that just finished into the weight.
+  void MaybeUpdateWeight(double qps, double cpu_utilization,
+                         grpc_millis smoothing_period) {
+    // Without either, the report says nothing about how much more load the
+    // backend can take.
+    if (qps <= 0 || cpu_utilization <= 0) return;
+    const double weight = qps / cpu_utilization;
+    const grpc_millis now = ExecCtx::Get()->Now();
+    MutexLock lock(&mu_);
+    if (non_empty_since_ == GRPC_MILLIS_INF_FUTURE) {
+      non_empty_since_ = now;
+      weight_ = weight;
+    } else {
+      // Exponential moving average, so that the weight doesn't follow each
+      // report but tracks changes within about smoothing_period.
+      const double elapsed = std::max<grpc_millis>(now - last_update_time_, 1);
+      const double alpha = 1 - exp(-elapsed / smoothing_period);
+      weight_ += alpha * (weight - weight_);
+    }
+    last_update_time_ = now;
+  }
+
+  // Returns the weight to use, or 0 if it isn't known yet or is stale.
+  float GetWeight(grpc_millis now, grpc_millis blackout_period,
+                  grpc_millis weight_expiration_period) {
+    MutexLock lock(&mu_);
+    if (non_empty_since_ == GRPC_MILLIS_INF_FUTURE) return 0;
+    // If the backend stopped reporting, start over, blackout period
+    // included, once it reports again.
+    if (now - last_update_time_ >= weight_expiration_period) {
+      non_empty_since_ = GRPC_MILLIS_INF_FUTURE;
+      return 0;
+    }
+    if (now - non_empty_since_ < blackout_period) return 0;
+    return static_cast<float>(weight_);
+  }
+
+ private:
+  Mutex mu_;
+  double weight_ ABSL_GUARDED_BY(mu_) = 0;
+  grpc_millis non_empty_since_ ABSL_GUARDED_BY(mu_) = GRPC_MILLIS_INF_FUTURE;
+  grpc_millis last_update_time_ ABSL_GUARDED_BY(mu_) = GRPC_MILLIS_INF_PAST;
+};
+
+// Data for a particular subchannel in a subchannel list.
+// This subclass adds the following functionality:
+// - Holds the weight of the subchannel's endpoint.
+class WeightedRoundRobinSubchannelData
+    : public ReadySubchannelData<WeightedRoundRobinSubchannelData> {
+ public:
+  WeightedRoundRobinSubchannelData(
+      SubchannelList<ReadySubchannelList<WeightedRoundRobinSubchannelData>,
+                     WeightedRoundRobinSubchannelData>* subchannel_list,
+      const ServerAddress& address,
+      RefCountedPtr<SubchannelInterface> subchannel);
+
+  const RefCountedPtr<EndpointWeight>& weight() const { return weight_; }
+
+ private:
+  const RefCountedPtr<EndpointWeight> weight_;
+};
+
+class WeightedRoundRobin
+    : public ReadySubchannelPolicy<WeightedRoundRobinSubchannelData> {
+ public:
+  explicit WeightedRoundRobin(Args args);
+
+  const char* name() const override { return kWeightedRoundRobin; }
+
+  void UpdateLocked(UpdateArgs args) override;
+
+  // Returns the weight of the endpoint at address, which must be in the
+  // latest update.
+  RefCountedPtr<EndpointWeight> GetWeightLocked(const ServerAddress& address);
+
+ private:
+  class Picker : public SubchannelPicker {
+   public:
+    Picker(WeightedRoundRobin* parent, SubchannelListType* subchannel_list);
+
+    PickResult Pick(PickArgs args) override;
+
+   private:
+    class SubchannelCallTracker;
+
+    struct Entry {
+      RefCountedPtr<SubchannelInterface> subchannel;
+      RefCountedPtr<EndpointWeight> weight;
+    };
+    using EntryVector = absl::InlinedVector<Entry, 10>;
+
+    static EntryVector ReadySubchannels(SubchannelListType* subchannel_list);
+
+    static absl::optional<StaticStrideScheduler> MakeScheduler(
+        const EntryVector& subchannels, const WeightedRoundRobinConfig& config);
+
+    // Using pointer value only, no ref held -- do not dereference!
+    WeightedRoundRobin* parent_;
+
+    const grpc_millis weight_update_period_;
+    const EntryVector subchannels_;
+    // Unset until at least two endpoints have weights, in which case picks
+    // fall back to plain round robin.
+    const absl::optional<StaticStrideScheduler> scheduler_;
+    PerCpuRoundRobinIndex index_;
+  };
+
+  void ShutdownLocked() override;
+
+  std::unique_ptr<SubchannelPicker> MakePickerLocked(
+      SubchannelListType* subchannel_list) override {
+    return absl::make_unique<Picker>(this, subchannel_list);
+  }
+
+  void StartWeightUpdateTimerLocked();
+  static void OnWeightUpdateTimer(void* arg, grpc_error_handle error);
+  void OnWeightUpdateTimerLocked(grpc_error_handle error);
+
+  RefCountedPtr<WeightedRoundRobinConfig> config_;
+
+  // The weights of the endpoints in the latest update, by address.
+  std::map<std::string, RefCountedPtr<EndpointWeight>> endpoint_weights_;
+
+  // Rebuilds the picker from time to time, to pick up new weights.
+  grpc_timer weight_update_timer_;
+  grpc_closure on_weight_update_timer_;
+  bool weight_update_timer_pending_ = false;
+};
+
+//
+// WeightedRoundRobin::Picker::SubchannelCallTracker
+//
+
+class WeightedRoundRobin::Picker::SubchannelCallTracker
+    : public LoadBalancingPolicy::SubchannelCallTrackerInterface {
+ public:
+  SubchannelCallTracker(RefCountedPtr<EndpointWeight> weight,
+                        grpc_millis smoothing_period)
+      : weight_(std::move(weight)), smoothing_period_(smoothing_period) {}
+
+  void Start() override {}
+
+  void Finish(FinishArgs args) override {
+    const BackendMetricAccessor::BackendMetricData* backend_metric_data =
+        args.backend_metric_accessor->GetBackendMetricData();
+    if (backend_metric_data == nullptr) return;
+    weight_->MaybeUpdateWeight(
+        static_cast<double>(backend_metric_data->requests_per_second),
+        backend_metric_data->cpu_utilization, smoothing_period_);
+  }
+
+ private:
+  RefCountedPtr<EndpointWeight> weight_;
+  const grpc_millis smoothing_period_;
+};
+
+//
+// WeightedRoundRobin::Picker
+//
+
+WeightedRoundRobin::Picker::EntryVector
+WeightedRoundRobin::Picker::ReadySubchannels(
+    SubchannelListType* subchannel_list) {
+  EntryVector subchannels;
+  for (size_t i = 0; i < subchannel_list->num_subchannels(); ++i) {
+    WeightedRoundRobinSubchannelData* sd = subchannel_list->subchannel(i);
+    if (sd->connectivity_state() == GRPC_CHANNEL_READY) {
+      subchannels.push_back({sd->subchannel()->Ref(), sd->weight()});
+    }
+  }
+  return subchannels;
+}
+
+absl::optional<StaticStrideScheduler>
+WeightedRoundRobin::Picker::MakeScheduler(
+    const EntryVector& subchannels, const WeightedRoundRobinConfig& config) {
+  const grpc_millis now = ExecCtx::Get()->Now();
+  std::vector<float> weights;
+  weights.reserve(subchannels.size());
+  for (const Entry& entry : subchannels) {
+    weights.push_back(entry.weight->GetWeight(
+        now, config.blackout_period(), config.weight_expiration_period()));
+  }
+  return StaticStrideScheduler::Make(weights);
+}
+
+WeightedRoundRobin::Picker::Picker(WeightedRoundRobin* parent,
+                                   SubchannelListType* subchannel_list)
+    : parent_(parent),
+      weight_update_period_(parent->config_->weight_update_period()),
+      subchannels_(ReadySubchannels(subchannel_list)),
+      scheduler_(MakeScheduler(subchannels_, *parent->config_)),
+      index_(subchannels_.size()) {
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_weighted_round_robin_trace)) {
+    gpr_log(GPR_INFO,
+            "[WRR %p picker %p] created picker from subchannel_list=%p "
+            "with %" PRIuPTR " READY subchannels, %s",
+            parent_, this, subchannel_list, subchannels_.size(),
+            scheduler_.has_value() ? "weighted" : "not weighted yet");
+    if (scheduler_.has_value()) {
+      for (size_t i = 0; i < subchannels_.size(); ++i) {
+        gpr_log(GPR_INFO, "[WRR %p picker %p] subchannel %p: weight %u",
+                parent_, this, subchannels_[i].subchannel.get(),
+                scheduler_->weights()[i]);
+      }
+    }
+  }
+}
+
+WeightedRoundRobin::PickResult WeightedRoundRobin::Picker::Pick(
+    PickArgs /*args*/) {
+  // Picks may run concurrently on many CPUs, each of which goes around the
+  // list from its own cursor.
+  const unsigned cpu = ExecCtx::Get()->starting_cpu();
+  const size_t index =
+      scheduler_.has_value()
+          ? scheduler_->Pick([this, cpu]() { return index_.NextSequence(cpu); })
+          : index_.Next(cpu);
+  const Entry& entry = subchannels_[index];
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_lb_weighted_round_robin_trace)) {
+    gpr_log(GPR_INFO,
+            "[WRR %p picker %p] returning index %" PRIuPTR ", subchannel=%p",
+            parent_, this, index, entry.subchannel.get());
+  }
+  return PickResult::Complete(entry.subchannel,
+                              absl::make_unique<SubchannelCallTracker>(
+                                  entry.weight, weight_update_period_));
+}
+
+//
+// WeightedRoundRobin
+//
+
+WeightedRoundRobin::WeightedRoundRobin(Args args)
+    : ReadySubchannelPolicy(std::move(args),
+                            &grpc_lb_weighted_round_robin_trace) {
+  GRPC_CLOSURE_INIT(&on_weight_update_timer_, OnWeightUpdateTimer, this,
+                    grpc_schedule_on_exec_ctx);
+}
+
+void WeightedRoundRobin::ShutdownLocked() {
+  if (weight_update_timer_pending_) {
+    grpc_timer_cancel(&weight_update_timer_);
+    weight_update_timer_pending_ = false;
+  }
+  ReadySubchannelPolicy::ShutdownLocked();
+}
+
+RefCountedPtr<EndpointWeight> WeightedRoundRobin::GetWeightLocked(
+    const ServerAddress& address) {
+  auto it = endpoint_weights_.find(
+      grpc_sockaddr_to_string(&address.address(), false));
+  GPR_ASSERT(it != endpoint_weights_.end());
+  return it->second;
+}
+
+void WeightedRoundRobin::StartWeightUpdateTimerLocked() {
+  Ref(DEBUG_LOCATION, "WeightUpdateTimer").release();
+  grpc_timer_init(&weight_update_timer_,
+                  ExecCtx::Get()->Now() + config_->weight_update_period(),
+                  &on_weight_update_timer_);
+  weight_update_timer_pending_ = true;
+}
+
+void WeightedRoundRobin::OnWeightUpdateTimer(void* arg,
+                                             grpc_error_handle error) {
+  WeightedRoundRobin* self = static_cast<WeightedRoundRobin*>(arg);
+  (void)GRPC_ERROR_REF(error);  // ref owned by lambda
+  self->work_serializer()->Run(
+      [self, error]() { self->OnWeightUpdateTimerLocked(error); },
+      DEBUG_LOCATION);
+}
+
+void WeightedRoundRobin::OnWeightUpdateTimerLocked(grpc_error_handle error) {
+  if (error == GRPC_ERROR_NONE && weight_update_timer_pending_ &&
+      !shutdown()) {
+    weight_update_timer_pending_ = false;
+    // Only READY pickers use weights.
+    if (subchannel_list() != nullptr && subchannel_list()->num_ready() > 0) {
+      subchannel_list()->MaybeUpdatePolicyConnectivityStateLocked();
+    }
+    StartWeightUpdateTimerLocked();
+  }
+  Unref(DEBUG_LOCATION, "WeightUpdateTimer");
+  GRPC_ERROR_UNREF(error);
+}
+
+//
+// WeightedRoundRobinSubchannelData
+//
+
+WeightedRoundRobinSubchannelData::WeightedRoundRobinSubchannelData(
+    SubchannelList<ReadySubchannelList<WeightedRoundRobinSubchannelData>,
+                   WeightedRoundRobinSubchannelData>* subchannel_list,
+    const ServerAddress& address,
+    RefCountedPtr<SubchannelInterface> subchannel)
+    : ReadySubchannelData(subchannel_list, address, std::move(subchannel)),
+      weight_(static_cast<WeightedRoundRobin*>(subchannel_list->policy())
+                  ->GetWeightLocked(address)) {}
+
+void WeightedRoundRobin::UpdateLocked(UpdateArgs args) {
+  config_ = std::move(args.config);
+  // Keep the weights of the endpoints that are still there.  Those of the
+  // others live on as long as the subchannels and calls using them.  On an
+  // address error, the current subchannel list, if any, is kept along with
+  // the weights.
+  if (args.addresses.ok()) {
+    std::map<std::string, RefCountedPtr<EndpointWeight>> endpoint_weights;
+    for (const ServerAddress& address : *args.addresses) {
+      std::string key = grpc_sockaddr_to_string(&address.address(), false);
+      auto it = endpoint_weights_.find(key);
+      endpoint_weights[std::move(key)] = it != endpoint_weights_.end()
+                                             ? it->second
+                                             : MakeRefCounted<EndpointWeight>();
+    }
+    endpoint_weights_ = std::move(endpoint_weights);
+  }
+  ReadySubchannelPolicy::UpdateLocked(std::move(args));
+  if (!weight_update_timer_pending_) StartWeightUpdateTimerLocked();
+}
+
+//
+// factory
+//
+
+class WeightedRoundRobinFactory : public LoadBalancingPolicyFactory {
+ public:
+  OrphanablePtr<LoadBalancingPolicy> CreateLoadBalancingPolicy(
+      LoadBalancingPolicy::Args args) const override {
+    return MakeOrphanable<WeightedRoundRobin>(std::move(args));
+  }
+
+  const char* name() const override { return kWeightedRoundRobin; }
+
+  RefCountedPtr<LoadBalancingPolicy::Config> ParseLoadBalancingConfig(
+      const Json& json, grpc_error_handle* error) const override {
+    std::vector<grpc_error_handle> error_list;
+    grpc_millis blackout_period = kDefaultBlackoutPeriod;
+    grpc_millis weight_expiration_period = kDefaultWeightExpirationPeriod;
+    grpc_millis weight_update_period = kDefaultWeightUpdatePeriod;
+    if (json.type() != Json::Type::OBJECT) {
+      error_list.push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+          "weighted_round_robin_experimental should be of type object"));
+    } else {
+      ParseJsonObjectFieldAsDuration(json.object_value(), "blackoutPeriod",
+                                     &blackout_period, &error_list,
+                                     /*required=*/false);
+      ParseJsonObjectFieldAsDuration(
+          json.object_value(), "weightExpirationPeriod",
+          &weight_expiration_period, &error_list, /*required=*/false);
+      ParseJsonObjectFieldAsDuration(json.object_value(), "weightUpdatePeriod",
+                                     &weight_update_period, &error_list,
+                                     /*required=*/false);
+      weight_update_period =
+          std::max(weight_update_period, kMinWeightUpdatePeriod);
+    }
+    if (!error_list.empty()) {
+      *error = GRPC_ERROR_CREATE_FROM_VECTOR(
+          "weighted_round_robin_experimental LB policy config", &error_list);
+      return nullptr;
+    }
+    return MakeRefCounted<WeightedRoundRobinConfig>(
+        blackout_period, weight_expiration_period, weight_update_period);
+  }
+};
+
+}  // namespace
+
+void GrpcLbPolicyWeightedRoundRobinInit() {
+  LoadBalancingPolicyRegistry::Builder::RegisterLoadBalancingPolicyFactory(
+      absl::make_unique<WeightedRoundRobinFactory>());
+}
+
+void GrpcLbPolicyWeightedRoundRobinShutdown() {}
+
+}  // namespace grpc_core
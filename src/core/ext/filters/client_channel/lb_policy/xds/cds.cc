@@ -410,6 +410,10 @@ void CdsLb::OnClusterChanged(const std::string& name,
           {"min_ring_size", cluster_data.min_ring_size},
           {"max_ring_size", cluster_data.max_ring_size},
       };
+    } else if (cluster_data.lb_policy == "LEAST_REQUEST") {
+      xds_lb_policy["LEAST_REQUEST"] = Json::Object{
+          {"choice_count", cluster_data.choice_count},
+      };
     } else {
       xds_lb_policy["ROUND_ROBIN"] = Json::Object();
     }
@@ -28,6 +28,7 @@
 #include "src/core/ext/filters/client_channel/lb_policy.h"
 #include "src/core/ext/filters/client_channel/lb_policy/address_filtering.h"
 #include "src/core/ext/filters/client_channel/lb_policy/child_policy_handler.h"
+#include "src/core/ext/filters/client_channel/lb_policy/least_request/least_request.h"
 #include "src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.h"
 #include "src/core/ext/filters/client_channel/lb_policy/xds/xds.h"
 #include "src/core/ext/filters/client_channel/lb_policy/xds/xds_channel_args.h"
@@ -807,7 +808,15 @@ XdsClusterResolverLb::CreateChildPolicyConfigLocked() {
                          .discovery_mechanism->override_child_policy();
     } else {
       const auto& xds_lb_policy = config_->xds_lb_policy().object_value();
-      if (xds_lb_policy.find("ROUND_ROBIN") != xds_lb_policy.end()) {
+      auto least_request_it = xds_lb_policy.find("LEAST_REQUEST");
+      if (xds_lb_policy.find("ROUND_ROBIN") != xds_lb_policy.end() ||
+          least_request_it != xds_lb_policy.end()) {
+        // Both policies pick endpoints within each locality.
+        Json endpoint_picking_policy =
+            least_request_it != xds_lb_policy.end()
+                ? Json::Object{{"least_request_experimental",
+                                least_request_it->second}}
+                : Json::Object{{"round_robin", Json::Object()}};
         const auto& localities = priority_list_[priority].localities;
         Json::Object weighted_targets;
         for (const auto& p : localities) {
@@ -828,12 +837,7 @@ XdsClusterResolverLb::CreateChildPolicyConfigLocked() {
           weighted_targets[locality_name->AsHumanReadableString()] =
               Json::Object{
                   {"weight", locality.lb_weight},
-                  {"childPolicy",
-                   Json::Array{
-                       Json::Object{
-                           {"round_robin", Json::Object()},
-                       },
-                   }},
+                  {"childPolicy", Json::Array{endpoint_picking_policy}},
               };
         }
         // Construct locality-picking policy.
@@ -1112,8 +1116,20 @@ class XdsClusterResolverLbFactory : public LoadBalancingPolicyFactory {
             xds_lb_policy = array[i];
             size_t min_ring_size;
             size_t max_ring_size;
+            RingHashLookupTable lookup_table;
+            size_t maglev_table_size;
+            uint32_t hash_balance_factor;
             ParseRingHashLbConfig(policy_it->second, &min_ring_size,
-                                  &max_ring_size, &error_list);
+                                  &max_ring_size, &lookup_table,
+                                  &maglev_table_size, &hash_balance_factor,
+                                  &error_list);
+          }
+          policy_it = policy.find("LEAST_REQUEST");
+          if (policy_it != policy.end()) {
+            xds_lb_policy = array[i];
+            uint32_t choice_count;
+            ParseLeastRequestLbConfig(policy_it->second, &choice_count,
+                                      &error_list);
           }
         }
       }
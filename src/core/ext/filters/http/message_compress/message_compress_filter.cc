@@ -21,8 +21,16 @@
 #include "src/core/ext/filters/http/message_compress/message_compress_filter.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
 #include "absl/types/optional.h"
 
 #include <grpc/compression.h>
@@ -31,10 +39,13 @@
 #include <grpc/support/log.h>
 
 #include "src/core/lib/channel/channel_args.h"
+#include "src/core/lib/compression/compression_dictionary.h"
 #include "src/core/lib/compression/compression_internal.h"
 #include "src/core/lib/compression/message_compress.h"
 #include "src/core/lib/gpr/string.h"
 #include "src/core/lib/gprpp/manual_constructor.h"
+#include "src/core/lib/gprpp/sync.h"
+#include "src/core/lib/iomgr/executor.h"
 #include "src/core/lib/profiling/timers.h"
 #include "src/core/lib/slice/slice_internal.h"
 #include "src/core/lib/slice/slice_string_helpers.h"
@@ -42,12 +53,27 @@
 
 namespace {
 
+// Default for GRPC_COMPRESSION_CHANNEL_PARALLEL_THRESHOLD.
+constexpr int kDefaultParallelCompressionThreshold = 4 * 1024 * 1024;
+// Size of the blocks that large messages are compressed in.
+constexpr size_t kParallelCompressionBlockSize = 1024 * 1024;
+
 class ChannelData {
  public:
   explicit ChannelData(grpc_channel_element_args* args) {
-    // Get the enabled and the default algorithms from channel args.
+    // Get the enabled and the default algorithms from channel args. Never
+    // advertise or use an algorithm this binary was built without.
     enabled_compression_algorithms_ =
-        grpc_core::CompressionAlgorithmSet::FromChannelArgs(args->channel_args);
+        grpc_core::CompressionAlgorithmSet::FromChannelArgs(args->channel_args)
+            .Intersect(grpc_core::CompressionAlgorithmSet::Supported());
+    zstd_level_ = grpc_channel_args_find_integer(
+        args->channel_args, GRPC_COMPRESSION_CHANNEL_ZSTD_LEVEL,
+        {0, INT_MIN, INT_MAX});
+    per_call_contexts_ = grpc_channel_args_find_bool(
+        args->channel_args, GRPC_COMPRESSION_CHANNEL_PER_CALL_CONTEXTS, false);
+    parallel_compression_threshold_ = grpc_channel_args_find_integer(
+        args->channel_args, GRPC_COMPRESSION_CHANNEL_PARALLEL_THRESHOLD,
+        {kDefaultParallelCompressionThreshold, 0, INT_MAX});
     default_compression_algorithm_ =
         grpc_core::DefaultCompressionAlgorithmFromChannelArgs(
             args->channel_args)
@@ -76,23 +102,103 @@ class ChannelData {
     return enabled_compression_algorithms_;
   }
 
+  int zstd_level() const { return zstd_level_; }
+
+  bool per_call_contexts() const { return per_call_contexts_; }
+
+  // Whether the server advertised the compression dictionary with the given id
+  // on an earlier call of this channel.
+  bool PeerHoldsDictionary(uint32_t id) {
+    grpc_core::MutexLock lock(&peer_dictionaries_mu_);
+    return std::find(peer_dictionaries_.begin(), peer_dictionaries_.end(),
+                     id) != peer_dictionaries_.end();
+  }
+
+  void SetPeerHoldsDictionary(uint32_t id) {
+    grpc_core::MutexLock lock(&peer_dictionaries_mu_);
+    if (std::find(peer_dictionaries_.begin(), peer_dictionaries_.end(), id) ==
+        peer_dictionaries_.end()) {
+      peer_dictionaries_.push_back(id);
+    }
+  }
+
+  // Whether a message of the given length should be compressed in parallel.
+  bool CompressInParallel(grpc_compression_algorithm algorithm,
+                          size_t length) const {
+    return parallel_compression_threshold_ > 0 &&
+           length >= static_cast<size_t>(parallel_compression_threshold_) &&
+           grpc_core::BlockMessageCompressor::Supports(algorithm);
+  }
+
  private:
   /** The default, channel-level, compression algorithm */
   grpc_compression_algorithm default_compression_algorithm_;
   /** Enabled compression algorithms */
   grpc_core::CompressionAlgorithmSet enabled_compression_algorithms_;
+  /** Compression level for GRPC_COMPRESS_ZSTD */
+  int zstd_level_;
+  /** Whether calls keep their compression contexts between messages */
+  bool per_call_contexts_;
+  /** Size from which messages are compressed in parallel, or 0 */
+  int parallel_compression_threshold_;
+  /** Ids of the dictionaries the server has advertised (clients only) */
+  grpc_core::Mutex peer_dictionaries_mu_;
+  absl::InlinedVector<uint32_t, 2> peer_dictionaries_
+      ABSL_GUARDED_BY(peer_dictionaries_mu_);
+};
+
+// State of a message being compressed in parallel.
+struct ParallelCompression {
+  // Compresses one block on the executor.
+  struct Job {
+    ParallelCompression* parallel_compression;
+    size_t block;
+    grpc_closure closure;
+  };
+
+  ParallelCompression(grpc_call_element* elem,
+                      grpc_compression_algorithm algorithm,
+                      grpc_slice_buffer* input)
+      : elem(elem),
+        compressor(algorithm, input, kParallelCompressionBlockSize),
+        jobs(compressor.num_blocks()),
+        pending_jobs(compressor.num_blocks()) {}
+
+  grpc_call_element* const elem;
+  grpc_core::BlockMessageCompressor compressor;
+  std::vector<Job> jobs;
+  std::atomic<size_t> pending_jobs;
 };
 
 class CallData {
  public:
   CallData(grpc_call_element* elem, const grpc_call_element_args& args)
-      : call_combiner_(args.call_combiner) {
-    ChannelData* channeld = static_cast<ChannelData*>(elem->channel_data);
+      : call_combiner_(args.call_combiner),
+        channeld_(static_cast<ChannelData*>(elem->channel_data)) {
     // The call's message compression algorithm is set to channel's default
     // setting. It can be overridden later by initial metadata.
-    if (GPR_LIKELY(channeld->enabled_compression_algorithms().IsSet(
-            channeld->default_compression_algorithm()))) {
-      compression_algorithm_ = channeld->default_compression_algorithm();
+    if (GPR_LIKELY(channeld_->enabled_compression_algorithms().IsSet(
+            channeld_->default_compression_algorithm()))) {
+      compression_algorithm_ = channeld_->default_compression_algorithm();
+    }
+    if (channeld_->enabled_compression_algorithms().IsSet(GRPC_COMPRESS_ZSTD)) {
+      is_client_ = !GRPC_SLICE_IS_EMPTY(args.path);
+      if (is_client_) {
+        // Clients advertise the dictionary registered for the method, and use
+        // it once the server has advertised it too.
+        dictionary_ = grpc_core::CompressionDictionaryRegistry::ForMethod(
+            grpc_core::StringViewFromSlice(args.path));
+        use_dictionary_ = dictionary_ != nullptr &&
+                          channeld_->PeerHoldsDictionary(dictionary_->id());
+      }
+      // Servers learn the dictionary the client advertises, and clients
+      // whether the server holds theirs.
+      if (!is_client_ || (dictionary_ != nullptr && !use_dictionary_)) {
+        intercept_recv_initial_metadata_ = true;
+        GRPC_CLOSURE_INIT(&on_recv_initial_metadata_ready_,
+                          OnRecvInitialMetadataReady, this,
+                          grpc_schedule_on_exec_ctx);
+      }
     }
     GRPC_CLOSURE_INIT(&start_send_message_batch_in_call_combiner_,
                       StartSendMessageBatch, elem, grpc_schedule_on_exec_ctx);
@@ -114,6 +220,7 @@ class CallData {
 
   void ProcessSendInitialMetadata(grpc_call_element* elem,
                                   grpc_metadata_batch* initial_metadata);
+  static void OnRecvInitialMetadataReady(void* arg, grpc_error_handle error);
 
   // Methods for processing a send_message batch
   static void StartSendMessageBatch(void* elem_arg, grpc_error_handle unused);
@@ -121,6 +228,10 @@ class CallData {
   grpc_error_handle PullSliceFromSendMessage();
   void ContinueReadingSendMessage(grpc_call_element* elem);
   void FinishSendMessage(grpc_call_element* elem);
+  void StartParallelCompression(grpc_call_element* elem);
+  static void CompressBlock(void* arg, grpc_error_handle unused);
+  void SendCompressedMessage(grpc_call_element* elem, bool did_compress,
+                             grpc_slice_buffer* compressed);
   void SendMessageBatchContinue(grpc_call_element* elem);
   static void FailSendMessageBatchInCallCombiner(void* calld_arg,
                                                  grpc_error_handle error);
@@ -128,7 +239,18 @@ class CallData {
   static void SendMessageOnComplete(void* calld_arg, grpc_error_handle error);
 
   grpc_core::CallCombiner* call_combiner_;
+  ChannelData* const channeld_;
   grpc_compression_algorithm compression_algorithm_ = GRPC_COMPRESS_NONE;
+  // Dictionary for GRPC_COMPRESS_ZSTD that this side holds, if any.
+  grpc_core::RefCountedPtr<grpc_core::CompressionDictionary> dictionary_;
+  // Whether the peer holds dictionary_ too, so that messages are primed with
+  // it.
+  bool use_dictionary_ = false;
+  bool is_client_ = false;
+  bool intercept_recv_initial_metadata_ = false;
+  grpc_metadata_batch* recv_initial_metadata_ = nullptr;
+  grpc_closure on_recv_initial_metadata_ready_;
+  grpc_closure* original_recv_initial_metadata_ready_ = nullptr;
   grpc_error_handle cancel_error_ = GRPC_ERROR_NONE;
   grpc_transport_stream_op_batch* send_message_batch_ = nullptr;
   bool seen_initial_metadata_ = false;
@@ -139,6 +261,10 @@ class CallData {
    * Keep them at the bottom of the struct, so they don't pollute the
    * cache-lines. */
   grpc_slice_buffer slices_; /**< Buffers up input slices to be compressed */
+  // Compression contexts kept between messages, if enabled on the channel.
+  grpc_core::MessageCompressionContexts compression_contexts_;
+  // State of the message being compressed in parallel, if any.
+  std::unique_ptr<ParallelCompression> parallel_compression_;
   // Allocate space for the replacement stream
   std::aligned_storage<sizeof(grpc_core::SliceBufferByteStream),
                        alignof(grpc_core::SliceBufferByteStream)>::type
@@ -179,11 +305,21 @@ void CallData::ProcessSendInitialMetadata(
   compression_algorithm_ =
       initial_metadata->Take(grpc_core::GrpcInternalEncodingRequest())
           .value_or(channeld->default_compression_algorithm());
+  if (GPR_UNLIKELY(!grpc_core::CompressionAlgorithmSet::Supported().IsSet(
+          compression_algorithm_))) {
+    gpr_log(GPR_ERROR,
+            "compression algorithm %d not supported by this build: sending "
+            "uncompressed",
+            static_cast<int>(compression_algorithm_));
+    compression_algorithm_ = GRPC_COMPRESS_NONE;
+  }
   switch (compression_algorithm_) {
     case GRPC_COMPRESS_NONE:
       break;
     case GRPC_COMPRESS_DEFLATE:
     case GRPC_COMPRESS_GZIP:
+    case GRPC_COMPRESS_ZSTD:
+    case GRPC_COMPRESS_LZ4:
       InitializeState(elem);
       initial_metadata->Set(grpc_core::GrpcEncodingMetadata(),
                             compression_algorithm_);
@@ -194,6 +330,40 @@ void CallData::ProcessSendInitialMetadata(
   // Convey supported compression algorithms.
   initial_metadata->Set(grpc_core::GrpcAcceptEncodingMetadata(),
                         channeld->enabled_compression_algorithms());
+  // Advertise the dictionary, so that the peer can use it too, and say whether
+  // this side's messages are primed with it.
+  if (dictionary_ != nullptr) {
+    initial_metadata->Set(grpc_core::GrpcAcceptEncodingDictionaryMetadata(),
+                          dictionary_->id());
+    if (compression_algorithm_ != GRPC_COMPRESS_ZSTD) use_dictionary_ = false;
+    if (use_dictionary_) {
+      initial_metadata->Set(grpc_core::GrpcEncodingDictionaryMetadata(),
+                            dictionary_->id());
+    }
+  }
+}
+
+void CallData::OnRecvInitialMetadataReady(void* arg, grpc_error_handle error) {
+  CallData* calld = static_cast<CallData*>(arg);
+  if (error == GRPC_ERROR_NONE) {
+    auto id = calld->recv_initial_metadata_->get(
+        grpc_core::GrpcAcceptEncodingDictionaryMetadata());
+    if (!calld->is_client_) {
+      // Only the initial metadata has been received: nothing was sent yet.
+      if (id.has_value()) {
+        calld->dictionary_ =
+            grpc_core::CompressionDictionaryRegistry::ForId(*id);
+        calld->use_dictionary_ = calld->dictionary_ != nullptr;
+      }
+    } else if (id.has_value() && *id == calld->dictionary_->id()) {
+      // This call's messages are already on their way unprimed: the
+      // following calls of the channel will use the dictionary.
+      calld->channeld_->SetPeerHoldsDictionary(*id);
+    }
+  }
+  grpc_closure* closure = calld->original_recv_initial_metadata_ready_;
+  calld->original_recv_initial_metadata_ready_ = nullptr;
+  grpc_core::Closure::Run(DEBUG_LOCATION, closure, GRPC_ERROR_REF(error));
 }
 
 void CallData::SendMessageOnComplete(void* calld_arg, grpc_error_handle error) {
@@ -214,17 +384,79 @@ void CallData::SendMessageBatchContinue(grpc_call_element* elem) {
 
 void CallData::FinishSendMessage(grpc_call_element* elem) {
   GPR_DEBUG_ASSERT(compression_algorithm_ != GRPC_COMPRESS_NONE);
+  ChannelData* channeld = static_cast<ChannelData*>(elem->channel_data);
+  // Large messages would hold up this thread, and whatever else it serves,
+  // for a long time.
+  if (channeld->CompressInParallel(compression_algorithm_, slices_.length)) {
+    StartParallelCompression(elem);
+    return;
+  }
   // Compress the data if appropriate.
   grpc_slice_buffer tmp;
   grpc_slice_buffer_init(&tmp);
+  const bool zstd = compression_algorithm_ == GRPC_COMPRESS_ZSTD;
+  bool did_compress = grpc_msg_compress_with_dictionary(
+      compression_algorithm_, zstd ? channeld->zstd_level() : 0,
+      zstd && use_dictionary_ ? dictionary_.get() : nullptr, &slices_, &tmp,
+      channeld->per_call_contexts() ? &compression_contexts_ : nullptr);
+  SendCompressedMessage(elem, did_compress, &tmp);
+}
+
+void CallData::StartParallelCompression(grpc_call_element* elem) {
+  parallel_compression_ = absl::make_unique<ParallelCompression>(
+      elem, compression_algorithm_, &slices_);
+  const size_t num_jobs = parallel_compression_->jobs.size();
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_compression_trace)) {
+    gpr_log(GPR_INFO,
+            "Compressing %" PRIuPTR " bytes in %" PRIuPTR
+            " blocks in parallel",
+            slices_.length, num_jobs);
+  }
+  for (size_t i = 0; i < num_jobs; i++) {
+    ParallelCompression::Job* job = &parallel_compression_->jobs[i];
+    job->parallel_compression = parallel_compression_.get();
+    job->block = i;
+    GRPC_CLOSURE_INIT(&job->closure, CompressBlock, job, nullptr);
+  }
+  // The last job to finish sends the message on, and may do so before this
+  // loop returns: do not touch parallel_compression_ after starting it.
+  ParallelCompression::Job* jobs = parallel_compression_->jobs.data();
+  for (size_t i = 0; i < num_jobs; i++) {
+    grpc_core::Executor::Run(&jobs[i].closure, GRPC_ERROR_NONE,
+                             grpc_core::ExecutorType::DEFAULT,
+                             grpc_core::ExecutorJobType::LONG);
+  }
+}
+
+void CallData::CompressBlock(void* arg, grpc_error_handle /*unused*/) {
+  auto* job = static_cast<ParallelCompression::Job*>(arg);
+  ParallelCompression* parallel_compression = job->parallel_compression;
+  parallel_compression->compressor.CompressBlock(job->block);
+  if (parallel_compression->pending_jobs.fetch_sub(
+          1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  grpc_call_element* elem = parallel_compression->elem;
+  CallData* calld = static_cast<CallData*>(elem->call_data);
+  grpc_slice_buffer tmp;
+  grpc_slice_buffer_init(&tmp);
+  bool did_compress = parallel_compression->compressor.Finish(&tmp);
+  calld->parallel_compression_.reset();
+  calld->SendCompressedMessage(elem, did_compress, &tmp);
+}
+
+// Sends the message on, as compressed (if did_compress) or as it was
+// otherwise. Destroys compressed.
+void CallData::SendCompressedMessage(grpc_call_element* elem,
+                                     bool did_compress,
+                                     grpc_slice_buffer* compressed) {
   uint32_t send_flags =
       send_message_batch_->payload->send_message.send_message->flags();
-  bool did_compress = grpc_msg_compress(compression_algorithm_, &slices_, &tmp);
   if (did_compress) {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_compression_trace)) {
       const char* algo_name;
       const size_t before_size = slices_.length;
-      const size_t after_size = tmp.length;
+      const size_t after_size = compressed->length;
       const float savings_ratio = 1.0f - static_cast<float>(after_size) /
                                              static_cast<float>(before_size);
       GPR_ASSERT(
@@ -234,7 +466,7 @@ void CallData::FinishSendMessage(grpc_call_element* elem) {
               " bytes (%.2f%% savings)",
               algo_name, before_size, after_size, 100 * savings_ratio);
     }
-    grpc_slice_buffer_swap(&slices_, &tmp);
+    grpc_slice_buffer_swap(&slices_, compressed);
     send_flags |= GRPC_WRITE_INTERNAL_COMPRESS;
   } else {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_compression_trace)) {
@@ -247,7 +479,7 @@ void CallData::FinishSendMessage(grpc_call_element* elem) {
               algo_name, slices_.length);
     }
   }
-  grpc_slice_buffer_destroy_internal(&tmp);
+  grpc_slice_buffer_destroy_internal(compressed);
   // Swap out the original byte stream with our new one and send the
   // batch down.
   new (&replacement_stream_)
@@ -369,6 +601,15 @@ void CallData::CompressStartTransportStreamOpBatch(
         batch, GRPC_ERROR_REF(cancel_error_), call_combiner_);
     return;
   }
+  // Intercept recv_initial_metadata to learn the peer's dictionary.
+  if (batch->recv_initial_metadata && intercept_recv_initial_metadata_) {
+    recv_initial_metadata_ =
+        batch->payload->recv_initial_metadata.recv_initial_metadata;
+    original_recv_initial_metadata_ready_ =
+        batch->payload->recv_initial_metadata.recv_initial_metadata_ready;
+    batch->payload->recv_initial_metadata.recv_initial_metadata_ready =
+        &on_recv_initial_metadata_ready_;
+  }
   // Handle send_initial_metadata.
   if (batch->send_initial_metadata) {
     GPR_ASSERT(!seen_initial_metadata_);
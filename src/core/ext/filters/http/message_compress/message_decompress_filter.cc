@@ -33,6 +33,7 @@
 
 #include "src/core/ext/filters/message_size/message_size_filter.h"
 #include "src/core/lib/channel/channel_args.h"
+#include "src/core/lib/compression/compression_dictionary.h"
 #include "src/core/lib/compression/compression_internal.h"
 #include "src/core/lib/compression/message_compress.h"
 #include "src/core/lib/gpr/string.h"
@@ -45,19 +46,25 @@ namespace {
 class ChannelData {
  public:
   explicit ChannelData(const grpc_channel_element_args* args)
-      : max_recv_size_(GetMaxRecvSizeFromChannelArgs(args->channel_args)) {}
+      : max_recv_size_(GetMaxRecvSizeFromChannelArgs(args->channel_args)),
+        per_call_contexts_(grpc_channel_args_find_bool(
+            args->channel_args, GRPC_COMPRESSION_CHANNEL_PER_CALL_CONTEXTS,
+            false)) {}
 
   int max_recv_size() const { return max_recv_size_; }
+  bool per_call_contexts() const { return per_call_contexts_; }
 
  private:
   int max_recv_size_;
+  bool per_call_contexts_;
 };
 
 class CallData {
  public:
   CallData(const grpc_call_element_args& args, const ChannelData* chand)
       : call_combiner_(args.call_combiner),
-        max_recv_message_length_(chand->max_recv_size()) {
+        max_recv_message_length_(chand->max_recv_size()),
+        per_call_contexts_(chand->per_call_contexts()) {
     // Initialize state for recv_initial_metadata_ready callback
     GRPC_CLOSURE_INIT(&on_recv_initial_metadata_ready_,
                       OnRecvInitialMetadataReady, this,
@@ -113,6 +120,13 @@ class CallData {
   bool seen_recv_message_ready_ = false;
   int max_recv_message_length_;
   grpc_compression_algorithm algorithm_ = GRPC_COMPRESS_NONE;
+  // Dictionary the peer primes GRPC_COMPRESS_ZSTD with, if any. It is null
+  // if the peer announced dictionary_id_ but we do not hold it.
+  uint32_t dictionary_id_ = 0;
+  RefCountedPtr<CompressionDictionary> dictionary_;
+  // Decompression contexts kept between messages, if enabled on the channel.
+  bool per_call_contexts_;
+  MessageCompressionContexts decompression_contexts_;
   grpc_closure on_recv_message_ready_;
   grpc_closure* original_recv_message_ready_ = nullptr;
   grpc_closure on_recv_message_next_done_;
@@ -137,6 +151,15 @@ void CallData::OnRecvInitialMetadataReady(void* arg, grpc_error_handle error) {
     calld->algorithm_ =
         calld->recv_initial_metadata_->get(GrpcEncodingMetadata())
             .value_or(GRPC_COMPRESS_NONE);
+    if (calld->algorithm_ == GRPC_COMPRESS_ZSTD) {
+      calld->dictionary_id_ =
+          calld->recv_initial_metadata_->get(GrpcEncodingDictionaryMetadata())
+              .value_or(0);
+      if (calld->dictionary_id_ != 0) {
+        calld->dictionary_ =
+            CompressionDictionaryRegistry::ForId(calld->dictionary_id_);
+      }
+    }
   }
   calld->MaybeResumeOnRecvMessageReady();
   calld->MaybeResumeOnRecvTrailingMetadataReady();
@@ -237,8 +260,18 @@ void CallData::OnRecvMessageNextDone(void* arg, grpc_error_handle error) {
 void CallData::FinishRecvMessage() {
   grpc_slice_buffer decompressed_slices;
   grpc_slice_buffer_init(&decompressed_slices);
-  if (grpc_msg_decompress(algorithm_, &recv_slices_, &decompressed_slices) ==
-      0) {
+  if (GPR_UNLIKELY(dictionary_id_ != 0 && dictionary_ == nullptr)) {
+    GPR_DEBUG_ASSERT(error_ == GRPC_ERROR_NONE);
+    error_ = grpc_error_set_int(
+        GRPC_ERROR_CREATE_FROM_CPP_STRING(absl::StrFormat(
+            "Compression dictionary %u is not registered", dictionary_id_)),
+        GRPC_ERROR_INT_GRPC_STATUS, GRPC_STATUS_UNIMPLEMENTED);
+    grpc_slice_buffer_destroy_internal(&decompressed_slices);
+  } else if (grpc_msg_decompress_with_dictionary(
+                 algorithm_, dictionary_.get(), &recv_slices_,
+                 &decompressed_slices,
+                 per_call_contexts_ ? &decompression_contexts_ : nullptr) ==
+             0) {
     GPR_DEBUG_ASSERT(error_ == GRPC_ERROR_NONE);
     error_ = GRPC_ERROR_CREATE_FROM_CPP_STRING(
         absl::StrCat("Unexpected error decompressing data for algorithm with "
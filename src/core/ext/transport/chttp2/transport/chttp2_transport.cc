@@ -397,6 +397,7 @@ static bool read_channel_args(grpc_chttp2_transport* t,
             absl::StrFormat("%s %s", get_vtable()->name, t->peer_string),
             grpc_core::channelz::SocketNode::Security::GetFromChannelArgs(
                 channel_args));
+    grpc_endpoint_set_channelz_socket_node(t->ep, t->channelz_socket.get());
   }
   return enable_bdp;
 }
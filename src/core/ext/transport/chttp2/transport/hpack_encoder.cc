@@ -23,10 +23,12 @@
 #include <assert.h>
 #include <string.h>
 
+#include <algorithm>
 #include <cstdint>
 
 #include "src/core/ext/transport/chttp2/transport/hpack_constants.h"
 #include "src/core/ext/transport/chttp2/transport/hpack_encoder_table.h"
+#include "src/core/ext/transport/chttp2/transport/hpack_huffman_encoder.h"
 
 /* This is here for grpc_is_binary_header
  * TODO(murgatroid99): Remove this
@@ -50,6 +52,9 @@ namespace {
 
 constexpr size_t kDataFrameHeaderSize = 9;
 
+// Size of the blocks that longer huffman compressed strings are carved from.
+constexpr size_t kHuffmanScratchBlockSize = 4096;
+
 } /* namespace */
 
 /* fills p (which is expected to be kDataFrameHeaderSize bytes long)
@@ -167,6 +172,7 @@ void HPackCompressor::Framer::EmitIndexed(uint32_t elem_index) {
   w.Write(0x80, AddTiny(w.length()));
 }
 
+namespace hpack_encoder_detail {
 struct WireValue {
   WireValue(uint8_t huffman_prefix, bool insert_null_before_wire_value,
             Slice slice)
@@ -179,6 +185,9 @@ struct WireValue {
   const bool insert_null_before_wire_value;
   const size_t length;
 };
+}  // namespace hpack_encoder_detail
+
+using hpack_encoder_detail::WireValue;
 
 static WireValue GetWireValue(Slice value, bool true_binary_enabled,
                               bool is_bin_hdr) {
@@ -193,12 +202,46 @@ static WireValue GetWireValue(Slice value, bool true_binary_enabled,
                            value.c_slice())));
     }
   } else {
-    /* TODO(ctiller): opportunistically compress non-binary headers */
     GRPC_STATS_INC_HPACK_SEND_UNCOMPRESSED();
     return WireValue(0x00, false, std::move(value));
   }
 }
 
+// Huffman compress value when that makes it strictly shorter, otherwise send
+// it as is.
+// Compressed strings that fit inline in a grpc_slice are encoded straight into
+// one; longer ones are carved out of a scratch block shared by every header
+// block this compressor produces, so neither costs an allocation per literal.
+WireValue HPackCompressor::Framer::NonBinaryWireValue(Slice value) {
+  const size_t length = value.length();
+  if (length >= 2) {
+    // Huffman is only worthwhile if it saves at least one byte: bound the
+    // encoder by that so it can give up as soon as it's lost.
+    const size_t max_output = length - 1;
+    if (max_output <= GRPC_SLICE_INLINED_SIZE) {
+      grpc_slice inlined;
+      inlined.refcount = nullptr;
+      const size_t n = HPackHuffmanEncoder::Encode(
+          value.data(), length, inlined.data.inlined.bytes, max_output);
+      if (n != 0) {
+        GRPC_STATS_INC_HPACK_SEND_HUFFMAN();
+        inlined.data.inlined.length = static_cast<uint8_t>(n);
+        return WireValue(0x80, false, Slice(inlined));
+      }
+    } else {
+      const size_t n = HPackHuffmanEncoder::Encode(
+          value.data(), length, compressor_->ReserveScratch(max_output),
+          max_output);
+      if (n != 0) {
+        GRPC_STATS_INC_HPACK_SEND_HUFFMAN();
+        return WireValue(0x80, false, compressor_->CommitScratch(n));
+      }
+    }
+  }
+  GRPC_STATS_INC_HPACK_SEND_UNCOMPRESSED();
+  return WireValue(0x00, false, std::move(value));
+}
+
 struct DefinitelyInterned {
   static bool IsBinary(grpc_slice key) {
     return grpc_is_refcounted_slice_binary_header(key);
@@ -238,47 +281,48 @@ class BinaryStringValue {
 
 class NonBinaryStringValue {
  public:
-  explicit NonBinaryStringValue(Slice value)
-      : value_(std::move(value)), len_val_(value_.length()) {}
+  explicit NonBinaryStringValue(WireValue value)
+      : wire_value_(std::move(value)), len_val_(wire_value_.length) {}
 
   size_t prefix_length() const { return len_val_.length(); }
 
-  void WritePrefix(uint8_t* prefix_data) { len_val_.Write(0x00, prefix_data); }
+  void WritePrefix(uint8_t* prefix_data) {
+    len_val_.Write(wire_value_.huffman_prefix, prefix_data);
+  }
 
-  Slice data() { return std::move(value_); }
+  Slice data() { return std::move(wire_value_.data); }
 
  private:
-  Slice value_;
+  WireValue wire_value_;
   VarintWriter<1> len_val_;
 };
 
 class StringKey {
  public:
-  explicit StringKey(Slice key)
-      : key_(std::move(key)), len_key_(key_.length()) {}
+  explicit StringKey(WireValue key)
+      : key_(std::move(key)), len_key_(key_.length) {}
 
   size_t prefix_length() const { return 1 + len_key_.length(); }
 
   void WritePrefix(uint8_t type, uint8_t* data) {
     data[0] = type;
-    len_key_.Write(0x00, data + 1);
+    len_key_.Write(key_.huffman_prefix, data + 1);
   }
 
-  Slice key() { return std::move(key_); }
+  Slice key() { return std::move(key_.data); }
 
  private:
-  Slice key_;
+  WireValue key_;
   VarintWriter<1> len_key_;
 };
 
 void HPackCompressor::Framer::EmitLitHdrWithNonBinaryStringKeyIncIdx(
     Slice key_slice, Slice value_slice) {
   GRPC_STATS_INC_HPACK_SEND_LITHDR_INCIDX_V();
-  GRPC_STATS_INC_HPACK_SEND_UNCOMPRESSED();
-  StringKey key(std::move(key_slice));
+  StringKey key(NonBinaryWireValue(std::move(key_slice)));
   key.WritePrefix(0x40, AddTiny(key.prefix_length()));
   Add(key.key());
-  NonBinaryStringValue emit(std::move(value_slice));
+  NonBinaryStringValue emit(NonBinaryWireValue(std::move(value_slice)));
   emit.WritePrefix(AddTiny(emit.prefix_length()));
   Add(emit.data());
 }
@@ -286,8 +330,7 @@ void HPackCompressor::Framer::EmitLitHdrWithNonBinaryStringKeyIncIdx(
 void HPackCompressor::Framer::EmitLitHdrWithBinaryStringKeyNotIdx(
     Slice key_slice, Slice value_slice) {
   GRPC_STATS_INC_HPACK_SEND_LITHDR_NOTIDX_V();
-  GRPC_STATS_INC_HPACK_SEND_UNCOMPRESSED();
-  StringKey key(std::move(key_slice));
+  StringKey key(NonBinaryWireValue(std::move(key_slice)));
   key.WritePrefix(0x00, AddTiny(key.prefix_length()));
   Add(key.key());
   BinaryStringValue emit(std::move(value_slice), use_true_binary_metadata_);
@@ -298,8 +341,7 @@ void HPackCompressor::Framer::EmitLitHdrWithBinaryStringKeyNotIdx(
 void HPackCompressor::Framer::EmitLitHdrWithBinaryStringKeyIncIdx(
     Slice key_slice, Slice value_slice) {
   GRPC_STATS_INC_HPACK_SEND_LITHDR_INCIDX_V();
-  GRPC_STATS_INC_HPACK_SEND_UNCOMPRESSED();
-  StringKey key(std::move(key_slice));
+  StringKey key(NonBinaryWireValue(std::move(key_slice)));
   key.WritePrefix(0x40, AddTiny(key.prefix_length()));
   Add(key.key());
   BinaryStringValue emit(std::move(value_slice), use_true_binary_metadata_);
@@ -322,15 +364,120 @@ void HPackCompressor::Framer::EmitLitHdrWithBinaryStringKeyNotIdx(
 void HPackCompressor::Framer::EmitLitHdrWithNonBinaryStringKeyNotIdx(
     Slice key_slice, Slice value_slice) {
   GRPC_STATS_INC_HPACK_SEND_LITHDR_NOTIDX_V();
-  GRPC_STATS_INC_HPACK_SEND_UNCOMPRESSED();
-  StringKey key(std::move(key_slice));
+  StringKey key(NonBinaryWireValue(std::move(key_slice)));
   key.WritePrefix(0x00, AddTiny(key.prefix_length()));
   Add(key.key());
-  NonBinaryStringValue emit(std::move(value_slice));
+  NonBinaryStringValue emit(NonBinaryWireValue(std::move(value_slice)));
   emit.WritePrefix(AddTiny(emit.prefix_length()));
   Add(emit.data());
 }
 
+namespace {
+
+// Pre-encoded "literal header field with incremental indexing"
+// representations of the metadata nearly every RPC carries. Built once per
+// process and shared by every compressor, so a connection's first emission of
+// one of these (later ones are indexed) is a copy of prepared bytes rather
+// than a fresh encode.
+class PreEncodedLiterals {
+ public:
+  static const PreEncodedLiterals& Get() {
+    static const PreEncodedLiterals* const literals = new PreEncodedLiterals();
+    return *literals;
+  }
+
+  absl::string_view te_trailers() const { return te_trailers_; }
+  absl::string_view content_type_application_grpc() const {
+    return content_type_application_grpc_;
+  }
+  absl::string_view grpc_status(uint32_t code) const {
+    GPR_DEBUG_ASSERT(code < GPR_ARRAY_SIZE(grpc_status_));
+    return grpc_status_[code];
+  }
+  absl::string_view grpc_encoding(grpc_compression_algorithm value) const {
+    GPR_DEBUG_ASSERT(value < GRPC_COMPRESS_ALGORITHMS_COUNT);
+    return grpc_encoding_[value];
+  }
+
+ private:
+  // HPACK static table index of content-type.
+  static constexpr uint32_t kContentTypeStaticIndex = 31;
+  // Must cover HPackCompressor::kNumCachedGrpcStatusValues.
+  static constexpr uint32_t kNumGrpcStatusValues = 16;
+
+  PreEncodedLiterals() {
+    te_trailers_ = LiteralWithNewName("te", "trailers");
+    content_type_application_grpc_ =
+        LiteralWithIndexedName(kContentTypeStaticIndex, "application/grpc");
+    for (uint32_t i = 0; i < kNumGrpcStatusValues; i++) {
+      grpc_status_[i] = LiteralWithNewName(
+          GrpcStatusMetadata::key(), Slice::FromInt64(i).as_string_view());
+    }
+    for (int i = 0; i < GRPC_COMPRESS_ALGORITHMS_COUNT; i++) {
+      grpc_encoding_[i] = LiteralWithNewName(
+          GrpcEncodingMetadata::key(),
+          GrpcEncodingMetadata::Encode(static_cast<grpc_compression_algorithm>(i))
+              .as_string_view());
+    }
+  }
+
+  // Append a string literal, huffman compressed if that makes it shorter.
+  static void AppendString(absl::string_view value, std::string* out) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(value.data());
+    std::vector<uint8_t> compressed(value.size());
+    const size_t n =
+        value.size() < 2 ? 0
+                         : HPackHuffmanEncoder::Encode(data, value.size(),
+                                                       compressed.data(),
+                                                       value.size() - 1);
+    const bool huffman = n != 0;
+    const size_t length = huffman ? n : value.size();
+    VarintWriter<1> len(length);
+    uint8_t prefix[8];
+    len.Write(huffman ? 0x80 : 0x00, prefix);
+    out->append(reinterpret_cast<const char*>(prefix), len.length());
+    if (huffman) {
+      out->append(reinterpret_cast<const char*>(compressed.data()), n);
+    } else {
+      out->append(value.data(), value.size());
+    }
+  }
+
+  static std::string LiteralWithNewName(absl::string_view key,
+                                        absl::string_view value) {
+    std::string out(1, '\x40');
+    AppendString(key, &out);
+    AppendString(value, &out);
+    return out;
+  }
+
+  static std::string LiteralWithIndexedName(uint32_t key_index,
+                                            absl::string_view value) {
+    VarintWriter<2> key(key_index);
+    uint8_t prefix[8];
+    key.Write(0x40, prefix);
+    std::string out(reinterpret_cast<const char*>(prefix), key.length());
+    AppendString(value, &out);
+    return out;
+  }
+
+  std::string te_trailers_;
+  std::string content_type_application_grpc_;
+  std::string grpc_status_[kNumGrpcStatusValues];
+  std::string grpc_encoding_[GRPC_COMPRESS_ALGORITHMS_COUNT];
+};
+
+}  // namespace
+
+void HPackCompressor::Framer::EmitPreEncodedLiteral(absl::string_view bytes) {
+  GRPC_STATS_INC_HPACK_SEND_PRE_ENCODED();
+  if (bytes.size() <= GRPC_SLICE_INLINED_SIZE) {
+    memcpy(AddTiny(bytes.size()), bytes.data(), bytes.size());
+  } else {
+    Add(Slice::FromStaticBuffer(bytes.data(), bytes.size()));
+  }
+}
+
 void HPackCompressor::Framer::AdvertiseTableSizeChange() {
   VarintWriter<3> w(compressor_->table_.max_size());
   w.Write(0x20, AddTiny(w.length()));
@@ -402,8 +549,8 @@ void HPackCompressor::Framer::Encode(HttpAuthorityMetadata,
 
 void HPackCompressor::Framer::Encode(TeMetadata, TeMetadata::ValueType value) {
   GPR_ASSERT(value == TeMetadata::ValueType::kTrailers);
-  EncodeAlwaysIndexed(
-      &compressor_->te_index_, "te", Slice::FromStaticString("trailers"),
+  EncodeAlwaysIndexedPreEncoded(
+      &compressor_->te_index_, PreEncodedLiterals::Get().te_trailers(),
       2 /* te */ + 8 /* trailers */ + hpack_constants::kEntryOverhead);
 }
 
@@ -413,10 +560,11 @@ void HPackCompressor::Framer::Encode(ContentTypeMetadata,
     gpr_log(GPR_ERROR, "Not encoding bad content-type header");
     return;
   }
-  EncodeAlwaysIndexed(&compressor_->content_type_index_, "content-type",
-                      Slice::FromStaticString("application/grpc"),
-                      12 /* content-type */ + 16 /* application/grpc */ +
-                          hpack_constants::kEntryOverhead);
+  EncodeAlwaysIndexedPreEncoded(
+      &compressor_->content_type_index_,
+      PreEncodedLiterals::Get().content_type_application_grpc(),
+      12 /* content-type */ + 16 /* application/grpc */ +
+          hpack_constants::kEntryOverhead);
 }
 
 void HPackCompressor::Framer::Encode(HttpSchemeMetadata,
@@ -510,6 +658,16 @@ void HPackCompressor::Framer::EncodeAlwaysIndexed(uint32_t* index,
   }
 }
 
+void HPackCompressor::Framer::EncodeAlwaysIndexedPreEncoded(
+    uint32_t* index, absl::string_view pre_encoded, uint32_t transport_length) {
+  if (compressor_->table_.ConvertableToDynamicIndex(*index)) {
+    EmitIndexed(compressor_->table_.DynamicIndex(*index));
+  } else {
+    *index = compressor_->table_.AllocateIndex(transport_length);
+    EmitPreEncodedLiteral(pre_encoded);
+  }
+}
+
 void HPackCompressor::Framer::EncodeIndexedKeyWithBinaryValue(
     uint32_t* index, absl::string_view key, Slice value) {
   if (compressor_->table_.ConvertableToDynamicIndex(*index)) {
@@ -587,7 +745,7 @@ void HPackCompressor::Framer::Encode(GrpcStatusMetadata,
       key.length() + value.length() + hpack_constants::kEntryOverhead;
   if (index != nullptr) {
     *index = compressor_->table_.AllocateIndex(transport_length);
-    EmitLitHdrWithNonBinaryStringKeyIncIdx(std::move(key), std::move(value));
+    EmitPreEncodedLiteral(PreEncodedLiterals::Get().grpc_status(code));
   } else {
     EmitLitHdrWithNonBinaryStringKeyNotIdx(std::move(key), std::move(value));
   }
@@ -609,8 +767,7 @@ void HPackCompressor::Framer::Encode(GrpcEncodingMetadata,
       key.length() + encoded_value.length() + hpack_constants::kEntryOverhead;
   if (index != nullptr) {
     *index = compressor_->table_.AllocateIndex(transport_length);
-    EmitLitHdrWithNonBinaryStringKeyIncIdx(std::move(key),
-                                           std::move(encoded_value));
+    EmitPreEncodedLiteral(PreEncodedLiterals::Get().grpc_encoding(value));
   } else {
     EmitLitHdrWithNonBinaryStringKeyNotIdx(std::move(key),
                                            std::move(encoded_value));
@@ -638,6 +795,29 @@ void HPackCompressor::Framer::Encode(GrpcAcceptEncodingMetadata,
                                          std::move(encoded_value));
 }
 
+HPackCompressor::~HPackCompressor() {
+  grpc_slice_unref_internal(huffman_scratch_);
+}
+
+uint8_t* HPackCompressor::ReserveScratch(size_t max_length) {
+  if (GRPC_SLICE_LENGTH(huffman_scratch_) - huffman_scratch_used_ <
+      max_length) {
+    // Slices committed from the previous block keep it alive.
+    grpc_slice_unref_internal(huffman_scratch_);
+    huffman_scratch_ =
+        GRPC_SLICE_MALLOC(std::max(max_length, kHuffmanScratchBlockSize));
+    huffman_scratch_used_ = 0;
+  }
+  return GRPC_SLICE_START_PTR(huffman_scratch_) + huffman_scratch_used_;
+}
+
+Slice HPackCompressor::CommitScratch(size_t length) {
+  Slice out(grpc_slice_sub(huffman_scratch_, huffman_scratch_used_,
+                           huffman_scratch_used_ + length));
+  huffman_scratch_used_ += length;
+  return out;
+}
+
 void HPackCompressor::SetMaxUsableSize(uint32_t max_table_size) {
   max_usable_size_ = max_table_size;
   SetMaxTableSize(std::min(table_.max_size(), max_table_size));
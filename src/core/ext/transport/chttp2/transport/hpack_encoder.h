@@ -35,12 +35,19 @@ extern grpc_core::TraceFlag grpc_http_trace;
 
 namespace grpc_core {
 
+namespace hpack_encoder_detail {
+struct WireValue;
+}  // namespace hpack_encoder_detail
+
 class HPackCompressor {
   class SliceIndex;
 
  public:
   HPackCompressor() = default;
-  ~HPackCompressor() = default;
+  ~HPackCompressor();
+
+  HPackCompressor(const HPackCompressor&) = delete;
+  HPackCompressor& operator=(const HPackCompressor&) = delete;
 
   // Maximum table size we'll actually use.
   static constexpr uint32_t kMaxTableSize = 1024 * 1024;
@@ -135,9 +142,16 @@ class HPackCompressor {
                                              Slice value_slice);
     void EmitLitHdrWithNonBinaryStringKeyNotIdx(Slice key_slice,
                                                 Slice value_slice);
+    // Emit a literal taken verbatim from the process wide pre-encoded cache.
+    void EmitPreEncodedLiteral(absl::string_view bytes);
+
+    hpack_encoder_detail::WireValue NonBinaryWireValue(Slice value);
 
     void EncodeAlwaysIndexed(uint32_t* index, absl::string_view key,
                              Slice value, uint32_t transport_length);
+    void EncodeAlwaysIndexedPreEncoded(uint32_t* index,
+                                       absl::string_view pre_encoded,
+                                       uint32_t transport_length);
     void EncodeIndexedKeyWithBinaryValue(uint32_t* index, absl::string_view key,
                                          Slice value);
 
@@ -159,6 +173,13 @@ class HPackCompressor {
   };
 
  private:
+  // Reserve max_length writable bytes of scratch space for a huffman
+  // compressed string.
+  uint8_t* ReserveScratch(size_t max_length);
+  // Commit the first length bytes of the last reservation, returning them as
+  // a slice that shares the scratch block.
+  Slice CommitScratch(size_t length);
+
   static constexpr size_t kNumFilterValues = 64;
   static constexpr uint32_t kNumCachedGrpcStatusValues = 16;
 
@@ -212,6 +233,13 @@ class HPackCompressor {
   SliceIndex path_index_;
   SliceIndex authority_index_;
   std::vector<PreviousTimeout> previous_timeouts_;
+  // Block that huffman compressed strings are carved from; outlives any one
+  // header block so its allocation is amortized across many of them. The
+  // slices handed out share its refcount, so only the bytes past
+  // huffman_scratch_used_ are ever written.
+  grpc_slice huffman_scratch_ = grpc_empty_slice();
+  // Bytes of huffman_scratch_ already handed out.
+  size_t huffman_scratch_used_ = 0;
 };
 
 }  // namespace grpc_core
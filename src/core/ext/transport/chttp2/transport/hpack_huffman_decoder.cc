@@ -0,0 +1,221 @@
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/ext/transport/chttp2/transport/hpack_huffman_decoder.h"
+
+#include <algorithm>
+
+#include <grpc/support/log.h>
+
+#include "src/core/ext/transport/chttp2/transport/huffsyms.h"
+
+namespace grpc_core {
+
+namespace {
+
+// Longest code in the HPACK huffman table (EOS, and a handful of control
+// characters).
+constexpr int kMaxCodeLength = 30;
+constexpr uint32_t kLookupSize = 1u << HPackHuffmanDecoder::kLookupBits;
+constexpr uint32_t kLookupMask = kLookupSize - 1;
+constexpr int kEosSymbol = 256;
+
+// One entry of the primary lookup table.
+// len0 == 0 indicates that the first code is longer than kLookupBits and
+// must be resolved with the canonical search; len_both == 0 indicates that
+// only sym0 is complete within the lookup window.
+struct LookupEntry {
+  uint8_t sym0;
+  uint8_t sym1;
+  uint8_t len0;
+  uint8_t len_both;
+};
+
+struct DecodeTables {
+  DecodeTables();
+
+  LookupEntry lookup[kLookupSize];
+  // Canonical code description for the slow path, indexed by code length:
+  // codes of a given length are contiguous, starting at first_code, and map
+  // to symbols[offset...offset+count).
+  uint32_t first_code[kMaxCodeLength + 1];
+  uint32_t count[kMaxCodeLength + 1];
+  uint32_t offset[kMaxCodeLength + 1];
+  uint16_t symbols[GRPC_CHTTP2_NUM_HUFFSYMS];
+};
+
+DecodeTables::DecodeTables() {
+  // Canonical (length, code) ordering of all symbols.
+  for (uint16_t i = 0; i < GRPC_CHTTP2_NUM_HUFFSYMS; i++) symbols[i] = i;
+  std::sort(symbols, symbols + GRPC_CHTTP2_NUM_HUFFSYMS,
+            [](uint16_t a, uint16_t b) {
+              const grpc_chttp2_huffsym& sa = grpc_chttp2_huffsyms[a];
+              const grpc_chttp2_huffsym& sb = grpc_chttp2_huffsyms[b];
+              if (sa.length != sb.length) return sa.length < sb.length;
+              return sa.bits < sb.bits;
+            });
+  for (int len = 0; len <= kMaxCodeLength; len++) {
+    first_code[len] = 0;
+    count[len] = 0;
+    offset[len] = 0;
+  }
+  for (uint32_t i = 0; i < GRPC_CHTTP2_NUM_HUFFSYMS; i++) {
+    const grpc_chttp2_huffsym& sym = grpc_chttp2_huffsyms[symbols[i]];
+    GPR_ASSERT(sym.length <= kMaxCodeLength);
+    if (count[sym.length] == 0) {
+      first_code[sym.length] = sym.bits;
+      offset[sym.length] = i;
+    }
+    GPR_ASSERT(sym.bits == first_code[sym.length] + count[sym.length]);
+    count[sym.length]++;
+  }
+
+  // Single symbol resolution of each lookup window.
+  struct Single {
+    uint8_t sym;
+    uint8_t len;
+  };
+  std::vector<Single> single(kLookupSize, Single{0, 0});
+  for (int i = 0; i < kEosSymbol; i++) {
+    const grpc_chttp2_huffsym& sym = grpc_chttp2_huffsyms[i];
+    if (sym.length > HPackHuffmanDecoder::kLookupBits) continue;
+    const int pad = HPackHuffmanDecoder::kLookupBits - sym.length;
+    const uint32_t base = sym.bits << pad;
+    for (uint32_t j = 0; j < (1u << pad); j++) {
+      single[base + j] = Single{static_cast<uint8_t>(i),
+                                static_cast<uint8_t>(sym.length)};
+    }
+  }
+  // Pair up with whatever second symbol completes in the remaining bits.
+  for (uint32_t w = 0; w < kLookupSize; w++) {
+    LookupEntry& e = lookup[w];
+    e = LookupEntry{single[w].sym, 0, single[w].len, 0};
+    if (e.len0 == 0) continue;
+    const Single& next = single[(w << e.len0) & kLookupMask];
+    if (next.len != 0 &&
+        next.len <= HPackHuffmanDecoder::kLookupBits - e.len0) {
+      e.sym1 = next.sym;
+      e.len_both = e.len0 + next.len;
+    }
+  }
+}
+
+const DecodeTables& GetDecodeTables() {
+  static const DecodeTables* const tables = new DecodeTables();
+  return *tables;
+}
+
+inline uint64_t LoadBigEndian64(const uint8_t* p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+  return v;
+}
+
+// Resolve a code longer than kLookupBits from the top of bits.
+// Returns the symbol and sets *length, or sets *length to 0 if no code
+// matches.
+inline int DecodeLongCode(const DecodeTables& tables, uint64_t bits,
+                          int* length) {
+  for (int len = HPackHuffmanDecoder::kLookupBits + 1; len <= kMaxCodeLength;
+       len++) {
+    const uint32_t code = static_cast<uint32_t>(bits >> (64 - len));
+    const uint32_t index = code - tables.first_code[len];
+    if (index < tables.count[len]) {
+      *length = len;
+      return tables.symbols[tables.offset[len] + index];
+    }
+  }
+  *length = 0;
+  return kEosSymbol;
+}
+
+}  // namespace
+
+void HPackHuffmanDecoder::Decode(const uint8_t* input, size_t length,
+                                 std::vector<uint8_t>* output) {
+  const DecodeTables& tables = GetDecodeTables();
+  const uint8_t* p = input;
+  const uint8_t* const end = input + length;
+  // Every code is at least five bits long, which bounds the output size.
+  const size_t start = output->size();
+  output->resize(start + length * 8 / 5);
+  uint8_t* out = output->data() + start;
+  // Pending input bits, msb first; only the top nbits are meaningful.
+  uint64_t bits = 0;
+  int nbits = 0;
+  auto consume = [&bits, &nbits](int n) {
+    bits <<= n;
+    nbits -= n;
+  };
+
+  // Bulk path: refill eight bytes at a time and decode while any code is
+  // guaranteed to be fully buffered.
+  while (end - p >= 8) {
+    bits |= LoadBigEndian64(p) >> nbits;
+    p += (63 - nbits) >> 3;
+    nbits |= 56;
+    while (nbits >= kMaxCodeLength) {
+      const LookupEntry& e =
+          tables.lookup[bits >> (64 - HPackHuffmanDecoder::kLookupBits)];
+      if (GPR_LIKELY(e.len0 != 0)) {
+        *out++ = e.sym0;
+        if (e.len_both != 0) {
+          *out++ = e.sym1;
+          consume(e.len_both);
+        } else {
+          consume(e.len0);
+        }
+      } else {
+        int len;
+        const int sym = DecodeLongCode(tables, bits, &len);
+        if (sym != kEosSymbol) *out++ = static_cast<uint8_t>(sym);
+        consume(len);
+      }
+    }
+  }
+
+  // Tail: byte at a time refill, checking each code against the bits that
+  // remain; anything left over is padding.
+  while (true) {
+    while (nbits <= 56 && p != end) {
+      bits |= static_cast<uint64_t>(*p++) << (56 - nbits);
+      nbits += 8;
+    }
+    if (nbits == 0) break;
+    const LookupEntry& e =
+        tables.lookup[bits >> (64 - HPackHuffmanDecoder::kLookupBits)];
+    if (e.len0 != 0) {
+      if (e.len0 > nbits) break;
+      *out++ = e.sym0;
+      if (e.len_both != 0 && e.len_both <= nbits) {
+        *out++ = e.sym1;
+        consume(e.len_both);
+      } else {
+        consume(e.len0);
+      }
+    } else {
+      int len;
+      const int sym = DecodeLongCode(tables, bits, &len);
+      if (len == 0 || len > nbits) break;
+      if (sym != kEosSymbol) *out++ = static_cast<uint8_t>(sym);
+      consume(len);
+    }
+  }
+
+  output->resize(out - output->data());
+}
+
+}  // namespace grpc_core
@@ -0,0 +1,50 @@
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GRPC_CORE_EXT_TRANSPORT_CHTTP2_TRANSPORT_HPACK_HUFFMAN_DECODER_H
+#define GRPC_CORE_EXT_TRANSPORT_CHTTP2_TRANSPORT_HPACK_HUFFMAN_DECODER_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace grpc_core {
+
+// Decoder for the HPACK static huffman code (RFC 7541 appendix B).
+//
+// Input is consumed up to eight bytes at a time through a 64 bit bit-buffer,
+// and symbols are resolved through a table indexed by the next kLookupBits
+// bits of input. Each table entry yields up to two complete symbols, which
+// covers nearly all of printable ASCII in a single lookup. The (rare) codes
+// longer than kLookupBits fall back to a canonical-code search.
+class HPackHuffmanDecoder {
+ public:
+  // Number of input bits resolved by one table lookup.
+  static constexpr int kLookupBits = 11;
+
+  // Decode length bytes starting at input, appending the decoded bytes to
+  // *output.
+  // Like the nibble decoder this replaces, decoding is lenient: an EOS symbol
+  // is dropped, and trailing bits that don't form a complete code are treated
+  // as padding.
+  static void Decode(const uint8_t* input, size_t length,
+                     std::vector<uint8_t>* output);
+};
+
+}  // namespace grpc_core
+
+#endif  // GRPC_CORE_EXT_TRANSPORT_CHTTP2_TRANSPORT_HPACK_HUFFMAN_DECODER_H
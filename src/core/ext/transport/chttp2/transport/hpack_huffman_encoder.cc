@@ -0,0 +1,73 @@
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/ext/transport/chttp2/transport/hpack_huffman_encoder.h"
+
+#include "src/core/ext/transport/chttp2/transport/huffsyms.h"
+
+namespace grpc_core {
+
+namespace {
+
+inline void StoreBigEndian64(uint64_t v, uint8_t* p) {
+  for (int i = 7; i >= 0; i--) {
+    p[i] = static_cast<uint8_t>(v);
+    v >>= 8;
+  }
+}
+
+}  // namespace
+
+size_t HPackHuffmanEncoder::Encode(const uint8_t* input, size_t length,
+                                   uint8_t* output, size_t max_output) {
+  uint8_t* out = output;
+  uint8_t* const out_end = output + max_output;
+  // Pending output bits, msb first; only the top nbits are meaningful.
+  uint64_t bits = 0;
+  int nbits = 0;
+  for (size_t i = 0; i < length; i++) {
+    const grpc_chttp2_huffsym& sym = grpc_chttp2_huffsyms[input[i]];
+    const uint64_t code = sym.bits;
+    const int len = static_cast<int>(sym.length);
+    if (nbits + len <= 64) {
+      bits |= code << (64 - nbits - len);
+      nbits += len;
+      continue;
+    }
+    // Accumulator full: top it up with the head of this code, store it, and
+    // carry the remainder of the code into the next word.
+    const int fit = 64 - nbits;
+    bits |= code >> (len - fit);
+    if (out_end - out < 8) return 0;
+    StoreBigEndian64(bits, out);
+    out += 8;
+    nbits = len - fit;
+    bits = code << (64 - nbits);
+  }
+  // Flush the final partial word, padding with the msb's of EOS (all ones).
+  if (nbits > 0) {
+    if (nbits < 64) bits |= ~uint64_t{0} >> nbits;
+    const int nbytes = (nbits + 7) / 8;
+    if (out_end - out < nbytes) return 0;
+    for (int i = 0; i < nbytes; i++) {
+      *out++ = static_cast<uint8_t>(bits >> 56);
+      bits <<= 8;
+    }
+  }
+  return out - output;
+}
+
+}  // namespace grpc_core
@@ -0,0 +1,43 @@
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GRPC_CORE_EXT_TRANSPORT_CHTTP2_TRANSPORT_HPACK_HUFFMAN_ENCODER_H
+#define GRPC_CORE_EXT_TRANSPORT_CHTTP2_TRANSPORT_HPACK_HUFFMAN_ENCODER_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace grpc_core {
+
+// Encoder for the HPACK static huffman code (RFC 7541 appendix B).
+//
+// Codes are packed into a 64 bit accumulator which is stored to the output
+// eight bytes at a time.
+class HPackHuffmanEncoder {
+ public:
+  // Huffman encode length bytes from input into output, writing at most
+  // max_output bytes.
+  // Returns the number of bytes written, or 0 if the encoding needs more than
+  // max_output bytes - in which case encoding stops as soon as that is known,
+  // so passing max_output < length doubles as a single pass "is huffman
+  // worthwhile" check.
+  static size_t Encode(const uint8_t* input, size_t length, uint8_t* output,
+                       size_t max_output);
+};
+
+}  // namespace grpc_core
+
+#endif  // GRPC_CORE_EXT_TRANSPORT_CHTTP2_TRANSPORT_HPACK_HUFFMAN_ENCODER_H
@@ -176,6 +176,7 @@ typedef enum {
 struct grpc_chttp2_stream_list {
   grpc_chttp2_stream* head;
   grpc_chttp2_stream* tail;
+  size_t count;
 };
 struct grpc_chttp2_stream_link {
   grpc_chttp2_stream* next;
@@ -343,6 +344,11 @@ struct grpc_chttp2_transport {
 
   /** data to write now */
   grpc_slice_buffer outbuf;
+  /** congestion state of the endpoint, used to size writes; refreshed at most
+      every kSendInfoRefreshInterval (see writing.cc) */
+  grpc_endpoint_send_info send_info = {};
+  bool have_send_info = false;
+  grpc_millis next_send_info_refresh = GRPC_MILLIS_INF_PAST;
   /** hpack encoding */
   grpc_core::HPackCompressor hpack_compressor;
   /** is this a client? */
@@ -672,6 +678,17 @@ grpc_chttp2_begin_write_result grpc_chttp2_begin_write(
     grpc_chttp2_transport* t);
 void grpc_chttp2_end_write(grpc_chttp2_transport* t, grpc_error_handle error);
 
+/** How many bytes a single write should aim to carry. This is 1 MiB unless
+    the connection signals that more can be sent at once: a congestion window
+    (twice \a send_info's cwnd_bytes) or pacing rate reported by the kernel,
+    or failing that \a bdp_estimate, and enough room for each of
+    \a num_writable_streams to get a frame of \a max_frame_size into the
+    write. Signals only ever raise the target, up to 4 MiB. \a send_info is
+    null and \a bdp_estimate is 0 when unknown. */
+uint32_t grpc_chttp2_target_write_size(
+    const grpc_endpoint_send_info* send_info, int64_t bdp_estimate,
+    size_t num_writable_streams, uint32_t max_frame_size);
+
 /** Process one slice of incoming data; return 1 if the connection is still
     viable after reading, or 0 if the connection should be torn down */
 grpc_error_handle grpc_chttp2_perform_read(grpc_chttp2_transport* t,
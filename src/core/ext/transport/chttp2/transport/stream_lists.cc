@@ -65,6 +65,7 @@ static bool stream_list_pop(grpc_chttp2_transport* t,
       t->lists[id].tail = nullptr;
     }
     s->included[id] = 0;
+    t->lists[id].count--;
   }
   *stream = s;
   if (s && GRPC_TRACE_FLAG_ENABLED(grpc_trace_http2_stream_state)) {
@@ -78,6 +79,7 @@ static void stream_list_remove(grpc_chttp2_transport* t, grpc_chttp2_stream* s,
                                grpc_chttp2_stream_list_id id) {
   GPR_ASSERT(s->included[id]);
   s->included[id] = 0;
+  t->lists[id].count--;
   if (s->links[id].prev) {
     s->links[id].prev->links[id].next = s->links[id].next;
   } else {
@@ -120,6 +122,7 @@ static void stream_list_add_tail(grpc_chttp2_transport* t,
     t->lists[id].head = s;
   }
   t->lists[id].tail = s;
+  t->lists[id].count++;
   s->included[id] = 1;
   if (GRPC_TRACE_FLAG_ENABLED(grpc_trace_http2_stream_state)) {
     gpr_log(GPR_INFO, "%p[%d][%s]: add to %s", t, s->id,
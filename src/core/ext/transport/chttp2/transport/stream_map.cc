@@ -20,158 +20,159 @@
 
 #include "src/core/ext/transport/chttp2/transport/stream_map.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <grpc/support/alloc.h>
 #include <grpc/support/log.h>
 
+static grpc_chttp2_stream_map_entry* alloc_entries(size_t capacity) {
+  return static_cast<grpc_chttp2_stream_map_entry*>(
+      gpr_zalloc(capacity * sizeof(grpc_chttp2_stream_map_entry)));
+}
+
+static void set_capacity(grpc_chttp2_stream_map* map, size_t capacity) {
+  map->capacity = capacity;
+  map->capacity_log2 = 0;
+  while ((size_t{1} << map->capacity_log2) < capacity) map->capacity_log2++;
+}
+
+/* fibonacci hashing: take the top capacity_log2 bits of key * 2^32/phi */
+static size_t home_slot(const grpc_chttp2_stream_map* map, uint32_t key) {
+  return static_cast<uint32_t>(key * 2654435769u) >> (32 - map->capacity_log2);
+}
+
 void grpc_chttp2_stream_map_init(grpc_chttp2_stream_map* map,
                                  size_t initial_capacity) {
   GPR_DEBUG_ASSERT(initial_capacity > 1);
-  map->keys =
-      static_cast<uint32_t*>(gpr_malloc(sizeof(uint32_t) * initial_capacity));
-  map->values =
-      static_cast<void**>(gpr_malloc(sizeof(void*) * initial_capacity));
+  size_t capacity = 2;
+  while (capacity < initial_capacity) capacity *= 2;
+  set_capacity(map, capacity);
+  map->entries = alloc_entries(capacity);
   map->count = 0;
-  map->free = 0;
-  map->capacity = initial_capacity;
+  map->min_capacity = capacity;
+  map->last_key = 0;
 }
 
 void grpc_chttp2_stream_map_destroy(grpc_chttp2_stream_map* map) {
-  gpr_free(map->keys);
-  gpr_free(map->values);
+  gpr_free(map->entries);
 }
 
-static size_t compact(uint32_t* keys, void** values, size_t count) {
-  size_t i, out;
+/* insert into a slot known to be free of key; does not update count */
+static void insert(grpc_chttp2_stream_map* map, uint32_t key, void* value) {
+  const size_t mask = map->capacity - 1;
+  size_t i = home_slot(map, key);
+  while (map->entries[i].value != nullptr) i = (i + 1) & mask;
+  map->entries[i].key = key;
+  map->entries[i].value = value;
+}
 
-  for (i = 0, out = 0; i < count; i++) {
-    if (values[i]) {
-      keys[out] = keys[i];
-      values[out] = values[i];
-      out++;
+static void resize(grpc_chttp2_stream_map* map, size_t capacity) {
+  grpc_chttp2_stream_map_entry* old_entries = map->entries;
+  const size_t old_capacity = map->capacity;
+  set_capacity(map, capacity);
+  map->entries = alloc_entries(capacity);
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old_entries[i].value != nullptr) {
+      insert(map, old_entries[i].key, old_entries[i].value);
     }
   }
-
-  return out;
+  gpr_free(old_entries);
 }
 
 void grpc_chttp2_stream_map_add(grpc_chttp2_stream_map* map, uint32_t key,
                                 void* value) {
-  size_t count = map->count;
-  size_t capacity = map->capacity;
-  uint32_t* keys = map->keys;
-  void** values = map->values;
-
-  // The first assertion ensures that the table is monotonically increasing.
-  GPR_ASSERT(count == 0 || keys[count - 1] < key);
+  // Ensures that keys are monotonically increasing, which also means the key
+  // cannot already be present.
+  GPR_ASSERT(map->count == 0 || map->last_key < key);
   GPR_DEBUG_ASSERT(value);
-  // Asserting that the key is not already in the map can be a debug assertion.
-  // Why: we're already checking that the map elements are monotonically
-  // increasing. If we re-add a key, i.e. if the key is already present, then
-  // either it is the most recently added key in the map (in which case the
-  // first assertion fails due to key == last_key) or there is a more recently
-  // added (larger) key at the end of the map: in which case the first assertion
-  // still fails due to key < last_key.
   GPR_DEBUG_ASSERT(grpc_chttp2_stream_map_find(map, key) == nullptr);
 
-  if (count == capacity) {
-    if (map->free > capacity / 4) {
-      count = compact(keys, values, count);
-      map->free = 0;
-    } else {
-      /* resize when less than 25% of the table is free, because compaction
-         won't help much */
-      map->capacity = capacity = 2 * capacity;
-      map->keys = keys = static_cast<uint32_t*>(
-          gpr_realloc(keys, capacity * sizeof(uint32_t)));
-      map->values = values =
-          static_cast<void**>(gpr_realloc(values, capacity * sizeof(void*)));
-    }
+  /* keep the load factor at or below 3/4 so probe sequences stay short and
+     there is always a free slot to terminate them */
+  if ((map->count + 1) * 4 > map->capacity * 3) {
+    resize(map, map->capacity * 2);
   }
-
-  keys[count] = key;
-  values[count] = value;
-  map->count = count + 1;
+  insert(map, key, value);
+  map->count++;
+  map->last_key = key;
 }
 
-template <bool strict_find>
-static void** find(grpc_chttp2_stream_map* map, uint32_t key) {
-  size_t min_idx = 0;
-  size_t max_idx = map->count;
-  size_t mid_idx;
-  uint32_t* keys = map->keys;
-  void** values = map->values;
-  uint32_t mid_key;
-
-  GPR_DEBUG_ASSERT(!strict_find || max_idx > 0);
-  if (!strict_find && max_idx == 0) return nullptr;
-
-  while (min_idx < max_idx) {
-    /* find the midpoint, avoiding overflow */
-    mid_idx = min_idx + ((max_idx - min_idx) / 2);
-    mid_key = keys[mid_idx];
-
-    if (mid_key < key) {
-      min_idx = mid_idx + 1;
-    } else if (mid_key > key) {
-      max_idx = mid_idx;
-    } else /* mid_key == key */
-    {
-      return &values[mid_idx];
-    }
+static grpc_chttp2_stream_map_entry* find(grpc_chttp2_stream_map* map,
+                                          uint32_t key) {
+  const size_t mask = map->capacity - 1;
+  for (size_t i = home_slot(map, key);; i = (i + 1) & mask) {
+    grpc_chttp2_stream_map_entry* entry = &map->entries[i];
+    if (entry->value == nullptr) return nullptr;
+    if (entry->key == key) return entry;
   }
-
-  GPR_DEBUG_ASSERT(!strict_find);
-  return nullptr;
 }
 
 void* grpc_chttp2_stream_map_delete(grpc_chttp2_stream_map* map, uint32_t key) {
-  void** pvalue = find<true>(map, key);
-  GPR_DEBUG_ASSERT(pvalue != nullptr);
-  void* out = *pvalue;
-  GPR_DEBUG_ASSERT(out != nullptr);
-  *pvalue = nullptr;
-  map->free++;
-  /* recognize complete emptyness and ensure we can skip
-     defragmentation later */
-  if (map->free == map->count) {
-    map->free = map->count = 0;
+  grpc_chttp2_stream_map_entry* entry = find(map, key);
+  GPR_DEBUG_ASSERT(entry != nullptr);
+  if (entry == nullptr) return nullptr;
+  void* out = entry->value;
+  /* backward shift deletion: pull later members of the probe sequence into
+     the hole unless doing so would move them before their home slot */
+  const size_t mask = map->capacity - 1;
+  size_t hole = static_cast<size_t>(entry - map->entries);
+  for (size_t i = (hole + 1) & mask; map->entries[i].value != nullptr;
+       i = (i + 1) & mask) {
+    const size_t home = home_slot(map, map->entries[i].key);
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      map->entries[hole] = map->entries[i];
+      hole = i;
+    }
+  }
+  map->entries[hole].key = 0;
+  map->entries[hole].value = nullptr;
+  map->count--;
+  if (map->capacity > map->min_capacity && map->count * 8 < map->capacity) {
+    resize(map, map->capacity / 2);
   }
   GPR_DEBUG_ASSERT(grpc_chttp2_stream_map_find(map, key) == nullptr);
   return out;
 }
 
 void* grpc_chttp2_stream_map_find(grpc_chttp2_stream_map* map, uint32_t key) {
-  void** pvalue = find<false>(map, key);
-  return pvalue != nullptr ? *pvalue : nullptr;
+  grpc_chttp2_stream_map_entry* entry = find(map, key);
+  return entry != nullptr ? entry->value : nullptr;
 }
 
 size_t grpc_chttp2_stream_map_size(grpc_chttp2_stream_map* map) {
-  return map->count - map->free;
+  return map->count;
 }
 
 void* grpc_chttp2_stream_map_rand(grpc_chttp2_stream_map* map) {
-  if (map->count == map->free) {
+  if (map->count == 0) {
     return nullptr;
   }
-  if (map->free != 0) {
-    map->count = compact(map->keys, map->values, map->count);
-    map->free = 0;
-    GPR_ASSERT(map->count > 0);
-  }
-  return map->values[(static_cast<size_t>(rand())) % map->count];
+  /* first populated slot at or after a random one: not exactly uniform, but
+     good enough for picking a victim stream */
+  const size_t mask = map->capacity - 1;
+  size_t i = static_cast<size_t>(rand()) & mask;
+  while (map->entries[i].value == nullptr) i = (i + 1) & mask;
+  return map->entries[i].value;
 }
 
 void grpc_chttp2_stream_map_for_each(grpc_chttp2_stream_map* map,
                                      void (*f)(void* user_data, uint32_t key,
                                                void* value),
                                      void* user_data) {
-  size_t i;
-
-  for (i = 0; i < map->count; i++) {
-    if (map->values[i]) {
-      f(user_data, map->keys[i], map->values[i]);
-    }
+  /* snapshot the keys first: f may delete entries, which moves others around
+     the table */
+  std::vector<uint32_t> keys;
+  keys.reserve(map->count);
+  for (size_t i = 0; i < map->capacity; i++) {
+    if (map->entries[i].value != nullptr) keys.push_back(map->entries[i].key);
+  }
+  std::sort(keys.begin(), keys.end());
+  for (uint32_t key : keys) {
+    void* value = grpc_chttp2_stream_map_find(map, key);
+    if (value != nullptr) f(user_data, key, value);
   }
 }
@@ -25,16 +25,32 @@
 
 /* Data structure to map a uint32_t to a data object (represented by a void*)
 
-   Represented as a sorted array of keys, and a corresponding array of values.
-   Lookups are performed with binary search.
+   Represented as an open addressing hash table with linear probing, with keys
+   and values stored side by side so that a lookup usually touches a single
+   cache line. Stream ids are spread over the table with a multiplicative
+   (fibonacci) hash, which scatters the arithmetic sequences of odd or even ids
+   http2 produces evenly, so probe sequences stay short.
+   Deletion shifts later entries of the probe sequence back (no tombstones), and
+   the table grows when more than 3/4 full and shrinks when less than 1/8 full,
+   so memory stays proportional to the number of live streams.
    Adds are restricted to strictly higher keys than previously seen (this is
    guaranteed by http2). */
+struct grpc_chttp2_stream_map_entry {
+  uint32_t key;
+  void* value; /* nullptr for an empty slot */
+};
 struct grpc_chttp2_stream_map {
-  uint32_t* keys;
-  void** values;
+  grpc_chttp2_stream_map_entry* entries;
+  /* number of populated entries */
   size_t count;
-  size_t free;
+  /* number of slots in entries: always a power of two */
   size_t capacity;
+  /* the table never shrinks below this many slots */
+  size_t min_capacity;
+  /* log2(capacity) */
+  uint32_t capacity_log2;
+  /* largest key ever added */
+  uint32_t last_key;
 };
 void grpc_chttp2_stream_map_init(grpc_chttp2_stream_map* map,
                                  size_t initial_capacity);
@@ -58,7 +74,8 @@ void* grpc_chttp2_stream_map_rand(grpc_chttp2_stream_map* map);
 /* How many (populated) entries are in the stream map? */
 size_t grpc_chttp2_stream_map_size(grpc_chttp2_stream_map* map);
 
-/* Callback on each stream */
+/* Callback on each stream, in increasing key order. f may delete entries from
+   the map (including the one it is called for). */
 void grpc_chttp2_stream_map_for_each(grpc_chttp2_stream_map* map,
                                      void (*f)(void* user_data, uint32_t key,
                                                void* value),
@@ -20,12 +20,15 @@
 
 #include <limits.h>
 
+#include <algorithm>
+
 #include <grpc/support/log.h>
 
 #include "src/core/ext/transport/chttp2/transport/chttp2_transport.h"
 #include "src/core/ext/transport/chttp2/transport/context_list.h"
 #include "src/core/ext/transport/chttp2/transport/internal.h"
 #include "src/core/lib/debug/stats.h"
+#include "src/core/lib/gpr/useful.h"
 #include "src/core/lib/profiling/timers.h"
 #include "src/core/lib/slice/slice_internal.h"
 #include "src/core/lib/transport/http2_errors.h"
@@ -180,9 +183,47 @@ static void report_stall(grpc_chttp2_transport* t, grpc_chttp2_stream* s,
   }
 }
 
-/* How many bytes would we like to put on the wire during a single syscall */
-static uint32_t target_write_size(grpc_chttp2_transport* /*t*/) {
-  return 1024 * 1024;
+/* How many bytes we would like to put on the wire during a single syscall
+   when the connection gives us nothing better to go on, and how far
+   connection signals may raise that */
+static constexpr uint64_t kDefaultTargetWriteSize = 1024 * 1024;
+static constexpr uint64_t kMaxTargetWriteSize = 4 * 1024 * 1024;
+/* At the connection's pacing rate, a single write should drain in about this
+   long */
+static constexpr uint64_t kTargetWriteDrainTimeUs = 1000;
+/* How often to refresh the endpoint's congestion state */
+static constexpr grpc_millis kSendInfoRefreshInterval = 100;
+
+static void maybe_refresh_send_info(grpc_chttp2_transport* t) {
+  grpc_millis now = grpc_core::ExecCtx::Get()->Now();
+  if (now < t->next_send_info_refresh) return;
+  t->next_send_info_refresh = now + kSendInfoRefreshInterval;
+  t->have_send_info = grpc_endpoint_get_send_info(t->ep, &t->send_info);
+}
+
+uint32_t grpc_chttp2_target_write_size(
+    const grpc_endpoint_send_info* send_info, int64_t bdp_estimate,
+    size_t num_writable_streams, uint32_t max_frame_size) {
+  uint64_t target = kDefaultTargetWriteSize;
+  if (send_info != nullptr && send_info->cwnd_bytes > 0) {
+    target = std::max(target, 2 * static_cast<uint64_t>(send_info->cwnd_bytes));
+    target = std::max(target, send_info->pacing_rate *
+                                  kTargetWriteDrainTimeUs / GPR_US_PER_SEC);
+  } else if (bdp_estimate > 0) {
+    target = std::max(target, static_cast<uint64_t>(bdp_estimate));
+  }
+  target = std::max(target, num_writable_streams * max_frame_size);
+  return static_cast<uint32_t>(std::min(target, kMaxTargetWriteSize));
+}
+
+static uint32_t target_write_size(grpc_chttp2_transport* t,
+                                  size_t num_writable_streams) {
+  maybe_refresh_send_info(t);
+  grpc_core::BdpEstimator* bdp_est = t->flow_control->bdp_estimator();
+  return grpc_chttp2_target_write_size(
+      t->have_send_info ? &t->send_info : nullptr,
+      bdp_est != nullptr ? bdp_est->EstimateBdp() : 0, num_writable_streams,
+      t->settings[GRPC_PEER_SETTINGS][GRPC_CHTTP2_SETTINGS_MAX_FRAME_SIZE]);
 }
 
 namespace {
@@ -291,7 +332,11 @@ class WriteContext {
   }
 
   grpc_chttp2_stream* NextStream() {
-    if (t_->outbuf.length > target_write_size(t_)) {
+    if (target_write_size_ == 0) {
+      target_write_size_ = target_write_size(
+          t_, t_->lists[GRPC_CHTTP2_LIST_WRITABLE].count);
+    }
+    if (t_->outbuf.length > target_write_size_) {
       result_.partial = true;
       return nullptr;
     }
@@ -327,6 +372,9 @@ class WriteContext {
   int initial_metadata_writes_ = 0;
   int trailing_metadata_writes_ = 0;
   int message_writes_ = 0;
+  /* computed on the first call to NextStream(), once streams that are no
+     longer stalled have been made writable */
+  uint32_t target_write_size_ = 0;
   grpc_chttp2_begin_write_result result_ = {false, false, false};
 };
 
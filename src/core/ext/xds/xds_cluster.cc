@@ -18,6 +18,8 @@
 
 #include "src/core/ext/xds/xds_cluster.h"
 
+#include <algorithm>
+
 #include "absl/container/inlined_vector.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -78,6 +80,8 @@ std::string XdsClusterResource::ToString() const {
   if (lb_policy == "RING_HASH") {
     contents.push_back(absl::StrCat("min_ring_size=", min_ring_size));
     contents.push_back(absl::StrCat("max_ring_size=", max_ring_size));
+  } else if (lb_policy == "LEAST_REQUEST") {
+    contents.push_back(absl::StrCat("choice_count=", choice_count));
   }
   contents.push_back(
       absl::StrFormat("max_concurrent_requests=%d", max_concurrent_requests));
@@ -216,6 +220,16 @@ bool XdsAggregateAndLogicalDnsClusterEnabled() {
   return parse_succeeded && parsed_value;
 }
 
+// Check to see if the least_request LB policy is enabled, this will be
+// removed once the policy is fully integration-tested and enabled by default.
+bool XdsLeastRequestEnabled() {
+  char* value = gpr_getenv("GRPC_XDS_EXPERIMENTAL_ENABLE_LEAST_REQUEST");
+  bool parsed_value;
+  bool parse_succeeded = gpr_parse_bool_value(value, &parsed_value);
+  gpr_free(value);
+  return parse_succeeded && parsed_value;
+}
+
 grpc_error_handle CdsResourceParse(
     const XdsEncodingContext& context,
     const envoy_config_cluster_v3_Cluster* cluster, bool /*is_v2*/,
@@ -345,6 +359,28 @@ grpc_error_handle CdsResourceParse(
             "ring hash lb config has invalid hash function."));
       }
     }
+  } else if (XdsLeastRequestEnabled() &&
+             envoy_config_cluster_v3_Cluster_lb_policy(cluster) ==
+                 envoy_config_cluster_v3_Cluster_LEAST_REQUEST) {
+    cds_update->lb_policy = "LEAST_REQUEST";
+    // Record least request lb config
+    auto* least_request_config =
+        envoy_config_cluster_v3_Cluster_least_request_lb_config(cluster);
+    if (least_request_config != nullptr) {
+      const google_protobuf_UInt32Value* choice_count =
+          envoy_config_cluster_v3_Cluster_LeastRequestLbConfig_choice_count(
+              least_request_config);
+      if (choice_count != nullptr) {
+        cds_update->choice_count =
+            google_protobuf_UInt32Value_value(choice_count);
+        if (cds_update->choice_count < 2) {
+          errors.push_back(GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+              "choice_count must be at least 2."));
+        }
+        // The LB policy never uses more than 10 choices.
+        cds_update->choice_count = std::min(cds_update->choice_count, 10u);
+      }
+    }
   } else {
     errors.push_back(
         GRPC_ERROR_CREATE_FROM_STATIC_STRING("LB policy is not supported."));
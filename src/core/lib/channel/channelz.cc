@@ -475,6 +475,11 @@ SocketNode::SocketNode(std::string local, std::string remote, std::string name,
       remote_(std::move(remote)),
       security_(std::move(security)) {}
 
+void SocketNode::SetOption(const std::string& name, std::string value) {
+  MutexLock lock(&options_mu_);
+  options_[name] = std::move(value);
+}
+
 void SocketNode::RecordStreamStartedFromLocal() {
   streams_started_.fetch_add(1, std::memory_order_relaxed);
   last_local_stream_created_cycle_.store(gpr_get_cycle_counter(),
@@ -555,6 +560,19 @@ Json SocketNode::RenderJson() {
   if (keepalives_sent != 0) {
     data["keepAlivesSent"] = std::to_string(keepalives_sent);
   }
+  {
+    MutexLock lock(&options_mu_);
+    if (!options_.empty()) {
+      Json::Array options;
+      for (const auto& option : options_) {
+        options.push_back(Json::Object{
+            {"name", option.first},
+            {"value", option.second},
+        });
+      }
+      data["option"] = std::move(options);
+    }
+  }
   // Create and fill the parent object.
   Json::Object object = {
       {"ref",
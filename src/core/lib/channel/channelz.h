@@ -22,6 +22,7 @@
 #include <grpc/support/port_platform.h>
 
 #include <atomic>
+#include <map>
 #include <set>
 #include <string>
 
@@ -321,6 +322,11 @@ class SocketNode : public BaseNode {
     keepalives_sent_.fetch_add(1, std::memory_order_relaxed);
   }
 
+  // Sets a socket option reported in the socket's data (e.g. the current
+  // state of an endpoint-level tuning heuristic). Setting an option that was
+  // already set replaces its value.
+  void SetOption(const std::string& name, std::string value);
+
   const std::string& remote() { return remote_; }
 
  private:
@@ -337,6 +343,8 @@ class SocketNode : public BaseNode {
   std::string local_;
   std::string remote_;
   RefCountedPtr<Security> const security_;
+  Mutex options_mu_;
+  std::map<std::string, std::string> options_ ABSL_GUARDED_BY(options_mu_);
 };
 
 // Handles channelz bookkeeping for listen sockets
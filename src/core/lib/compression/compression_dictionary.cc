@@ -0,0 +1,240 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/lib/compression/compression_dictionary.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+
+#ifdef GRPC_HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+#include "src/core/lib/gpr/murmur_hash.h"
+#include "src/core/lib/gprpp/rcu.h"
+
+namespace grpc_core {
+
+//
+// CompressionDictionary
+//
+
+RefCountedPtr<CompressionDictionary> CompressionDictionary::Create(
+    std::string data) {
+#ifdef GRPC_HAVE_ZSTD
+  uint32_t id = ZSTD_getDictID_fromDict(data.data(), data.size());
+  if (id == 0) {
+    // Raw content: zstd does not record an id for it, so make one up that is
+    // stable across processes holding the same content.
+    id = gpr_murmur_hash3(data.data(), data.size(), 0);
+    if (id == 0) id = 1;
+  }
+  ZSTD_DDict* ddict = ZSTD_createDDict(data.data(), data.size());
+  if (ddict == nullptr) return nullptr;
+  return RefCountedPtr<CompressionDictionary>(
+      new CompressionDictionary(std::move(data), id, ddict));
+#else
+  (void)data;
+  return nullptr;
+#endif
+}
+
+CompressionDictionary::CompressionDictionary(std::string data, uint32_t id,
+                                             ZSTD_DDict_s* ddict)
+    : data_(std::move(data)), id_(id), ddict_(ddict) {}
+
+CompressionDictionary::~CompressionDictionary() {
+#ifdef GRPC_HAVE_ZSTD
+  ZSTD_freeDDict(ddict_);
+  for (const auto& p : cdicts_) ZSTD_freeCDict(p.second);
+#endif
+}
+
+const ZSTD_CDict_s* CompressionDictionary::CompressionDictionaryForLevel(
+    int level) {
+#ifdef GRPC_HAVE_ZSTD
+  MutexLock lock(&mu_);
+  // Almost always holds a single entry: the level is per channel.
+  for (const auto& p : cdicts_) {
+    if (p.first == level) return p.second;
+  }
+  ZSTD_CDict* cdict = ZSTD_createCDict(data_.data(), data_.size(), level);
+  if (cdict != nullptr) cdicts_.emplace_back(level, cdict);
+  return cdict;
+#else
+  (void)level;
+  return nullptr;
+#endif
+}
+
+absl::StatusOr<std::string> TrainCompressionDictionary(
+    const std::vector<std::string>& samples, size_t max_size) {
+#ifdef GRPC_HAVE_ZSTD
+  std::string buffer;
+  std::vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (const std::string& sample : samples) {
+    if (sample.empty()) continue;
+    buffer.append(sample);
+    sizes.push_back(sample.size());
+  }
+  std::string dictionary(max_size, '\0');
+  size_t size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(),
+                                      buffer.data(), sizes.data(),
+                                      static_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(size)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("training compression dictionary from %u samples: %s",
+                        sizes.size(), ZDICT_getErrorName(size)));
+  }
+  dictionary.resize(size);
+  return dictionary;
+#else
+  (void)samples;
+  (void)max_size;
+  return absl::UnimplementedError(
+      "compression dictionaries require gRPC to be built with zstd");
+#endif
+}
+
+//
+// CompressionDictionaryRegistry
+//
+
+namespace {
+
+// An immutable view of the registrations. Lookups read the current snapshot
+// without locking; registrations, which are rare and usually happen at
+// startup, publish a modified copy.
+struct RegistrySnapshot {
+  absl::flat_hash_map<std::string, RefCountedPtr<CompressionDictionary>>
+      by_method;
+  // Dictionaries stay here after their method is registered again, since
+  // peers may still be using them.
+  absl::flat_hash_map<uint32_t, RefCountedPtr<CompressionDictionary>> by_id;
+};
+
+struct Registry {
+  // Serializes registrations and the reclamation of the snapshots they
+  // replace.
+  Mutex mu;
+  // Whether current is set, so that lookups skip the read guard in the
+  // common case where nothing is registered.
+  std::atomic<bool> has_registrations{false};
+  // Replaced snapshots are destroyed once no lookup can still be reading
+  // them, by the last such lookup.
+  RcuPointer<const RegistrySnapshot> current{[this] {
+    MutexLock lock(&mu);
+    current.Reclaim();
+  }};
+};
+
+Registry* GetRegistry() {
+  static Registry* registry = new Registry();
+  return registry;
+}
+
+}  // namespace
+
+absl::StatusOr<uint32_t> CompressionDictionaryRegistry::Register(
+    absl::string_view method, std::string dictionary) {
+  if (method.empty() || method[0] != '/') {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("invalid method name '%s'", method));
+  }
+  if (dictionary.empty()) {
+    return absl::InvalidArgumentError("empty compression dictionary");
+  }
+  RefCountedPtr<CompressionDictionary> dict =
+      CompressionDictionary::Create(std::move(dictionary));
+  if (dict == nullptr) {
+    return absl::UnimplementedError(
+        "compression dictionaries require gRPC to be built with zstd");
+  }
+  Registry* registry = GetRegistry();
+  MutexLock lock(&registry->mu);
+  const RegistrySnapshot* current = registry->current.get();
+  auto snapshot = current == nullptr
+                      ? absl::make_unique<RegistrySnapshot>()
+                      : absl::make_unique<RegistrySnapshot>(*current);
+  auto it = snapshot->by_id.find(dict->id());
+  if (it == snapshot->by_id.end()) {
+    snapshot->by_id.emplace(dict->id(), dict);
+  } else if (it->second->data() != dict->data()) {
+    return absl::AlreadyExistsError(absl::StrFormat(
+        "a different compression dictionary with id %u is already registered",
+        dict->id()));
+  } else {
+    dict = it->second;
+  }
+  const uint32_t id = dict->id();
+  snapshot->by_method[std::string(method)] = std::move(dict);
+  registry->current.Publish(std::move(snapshot));
+  registry->has_registrations.store(true, std::memory_order_release);
+  registry->current.Reclaim();
+  return id;
+}
+
+RefCountedPtr<CompressionDictionary> CompressionDictionaryRegistry::ForMethod(
+    absl::string_view path) {
+  Registry* registry = GetRegistry();
+  if (!registry->has_registrations.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  RcuPointer<const RegistrySnapshot>::ReadGuard snapshot(&registry->current);
+  if (snapshot.get() == nullptr) return nullptr;
+  auto it = snapshot->by_method.find(path);
+  if (it != snapshot->by_method.end()) return it->second;
+  // Fall back to the registration for the whole service.
+  size_t slash = path.rfind('/');
+  if (slash == 0 || slash == absl::string_view::npos) return nullptr;
+  it = snapshot->by_method.find(path.substr(0, slash + 1));
+  if (it != snapshot->by_method.end()) return it->second;
+  return nullptr;
+}
+
+RefCountedPtr<CompressionDictionary> CompressionDictionaryRegistry::ForId(
+    uint32_t id) {
+  Registry* registry = GetRegistry();
+  if (!registry->has_registrations.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  RcuPointer<const RegistrySnapshot>::ReadGuard snapshot(&registry->current);
+  if (snapshot.get() == nullptr) return nullptr;
+  auto it = snapshot->by_id.find(id);
+  if (it != snapshot->by_id.end()) return it->second;
+  return nullptr;
+}
+
+void CompressionDictionaryRegistry::TestOnlyReset() {
+  Registry* registry = GetRegistry();
+  MutexLock lock(&registry->mu);
+  registry->has_registrations.store(false, std::memory_order_relaxed);
+  registry->current.Publish(nullptr);
+  registry->current.Reclaim();
+}
+
+}  // namespace grpc_core
@@ -0,0 +1,112 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef GRPC_CORE_LIB_COMPRESSION_COMPRESSION_DICTIONARY_H
+#define GRPC_CORE_LIB_COMPRESSION_COMPRESSION_DICTIONARY_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+#include "src/core/lib/gprpp/ref_counted.h"
+#include "src/core/lib/gprpp/ref_counted_ptr.h"
+#include "src/core/lib/gprpp/sync.h"
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace grpc_core {
+
+// A dictionary that primes GRPC_COMPRESS_ZSTD, so that small messages with a
+// layout shared by many messages compress well. Both peers must hold the same
+// dictionary: it is identified on the wire by id() in the
+// grpc-accept-encoding-dictionary and grpc-encoding-dictionary headers.
+class CompressionDictionary : public RefCounted<CompressionDictionary> {
+ public:
+  // Creates a dictionary from either a trained zstd dictionary, whose id is
+  // taken from its header, or raw content, whose id is derived from a hash of
+  // it. Returns nullptr if gRPC was built without zstd.
+  static RefCountedPtr<CompressionDictionary> Create(std::string data);
+
+  ~CompressionDictionary() override;
+
+  uint32_t id() const { return id_; }
+  absl::string_view data() const { return data_; }
+
+  // The dictionary digested for compression at the given zstd level, created
+  // on first use.
+  const ZSTD_CDict_s* CompressionDictionaryForLevel(int level);
+  // The dictionary digested for decompression.
+  const ZSTD_DDict_s* decompression_dictionary() const { return ddict_; }
+
+ private:
+  CompressionDictionary(std::string data, uint32_t id, ZSTD_DDict_s* ddict);
+
+  const std::string data_;
+  const uint32_t id_;
+  ZSTD_DDict_s* const ddict_;
+  Mutex mu_;
+  std::vector<std::pair<int, ZSTD_CDict_s*>> cdicts_ ABSL_GUARDED_BY(mu_);
+};
+
+// Trains a zstd dictionary of at most max_size bytes from samples, which
+// should be representative messages of the methods it will be registered for.
+// Fails if gRPC was built without zstd, or if there are too few samples.
+absl::StatusOr<std::string> TrainCompressionDictionary(
+    const std::vector<std::string>& samples, size_t max_size);
+
+// Process wide registry of compression dictionaries. A dictionary is
+// registered for a full method name ("/package.Service/Method") or for all
+// methods of a service ("/package.Service/").
+//
+// Each peer advertises the dictionary it holds for a call in
+// grpc-accept-encoding-dictionary, and primes its messages with a dictionary
+// only once the other peer has advertised it: servers from the client's
+// initial metadata, clients from the initial metadata the server returned on
+// an earlier call of the same channel. A primed call carries the dictionary id
+// in grpc-encoding-dictionary. Peers without dictionary support never see
+// primed messages.
+//
+// Lookups do not lock, and are meant to be made on every call.
+class CompressionDictionaryRegistry {
+ public:
+  // Registers dictionary for method, replacing any previous registration for
+  // it. Returns the dictionary id. Fails if gRPC was built without zstd, or
+  // if a different dictionary with the same id is already registered.
+  static absl::StatusOr<uint32_t> Register(absl::string_view method,
+                                           std::string dictionary);
+
+  // Returns the dictionary to use for a call to path, if any.
+  static RefCountedPtr<CompressionDictionary> ForMethod(absl::string_view path);
+  // Returns the registered dictionary with the given id, if any.
+  static RefCountedPtr<CompressionDictionary> ForId(uint32_t id);
+
+  // Drops all registrations.
+  static void TestOnlyReset();
+};
+
+}  // namespace grpc_core
+
+#endif /* GRPC_CORE_LIB_COMPRESSION_COMPRESSION_DICTIONARY_H */
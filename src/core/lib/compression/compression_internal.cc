@@ -46,6 +46,10 @@ const char* CompressionAlgorithmAsString(grpc_compression_algorithm algorithm) {
       return "deflate";
     case GRPC_COMPRESS_GZIP:
       return "gzip";
+    case GRPC_COMPRESS_ZSTD:
+      return "zstd";
+    case GRPC_COMPRESS_LZ4:
+      return "lz4";
     case GRPC_COMPRESS_ALGORITHMS_COUNT:
     default:
       return nullptr;
@@ -60,6 +64,10 @@ absl::optional<grpc_compression_algorithm> ParseCompressionAlgorithm(
     return GRPC_COMPRESS_DEFLATE;
   } else if (algorithm == "gzip") {
     return GRPC_COMPRESS_GZIP;
+  } else if (algorithm == "zstd") {
+    return GRPC_COMPRESS_ZSTD;
+  } else if (algorithm == "lz4") {
+    return GRPC_COMPRESS_LZ4;
   } else {
     return absl::nullopt;
   }
@@ -89,8 +97,10 @@ CompressionAlgorithmSet::CompressionAlgorithmForLevel(
   absl::InlinedVector<grpc_compression_algorithm,
                       GRPC_COMPRESS_ALGORITHMS_COUNT>
       algos;
-  for (auto algo : {GRPC_COMPRESS_GZIP, GRPC_COMPRESS_DEFLATE}) {
-    if (set_.is_set(algo)) {
+  const CompressionAlgorithmSet supported = Supported();
+  for (auto algo : {GRPC_COMPRESS_LZ4, GRPC_COMPRESS_GZIP,
+                    GRPC_COMPRESS_DEFLATE, GRPC_COMPRESS_ZSTD}) {
+    if (set_.is_set(algo) && supported.IsSet(algo)) {
       algos.push_back(algo);
     }
   }
@@ -139,6 +149,18 @@ CompressionAlgorithmSet CompressionAlgorithmSet::FromChannelArgs(
   return set;
 }
 
+CompressionAlgorithmSet CompressionAlgorithmSet::Supported() {
+  CompressionAlgorithmSet set{GRPC_COMPRESS_NONE, GRPC_COMPRESS_DEFLATE,
+                              GRPC_COMPRESS_GZIP};
+#ifdef GRPC_HAVE_ZSTD
+  set.Set(GRPC_COMPRESS_ZSTD);
+#endif
+#ifdef GRPC_HAVE_LZ4
+  set.Set(GRPC_COMPRESS_LZ4);
+#endif
+  return set;
+}
+
 CompressionAlgorithmSet::CompressionAlgorithmSet() = default;
 
 CompressionAlgorithmSet::CompressionAlgorithmSet(
@@ -165,6 +187,17 @@ void CompressionAlgorithmSet::Set(grpc_compression_algorithm algorithm) {
   }
 }
 
+CompressionAlgorithmSet CompressionAlgorithmSet::Intersect(
+    const CompressionAlgorithmSet& other) const {
+  CompressionAlgorithmSet set;
+  for (size_t i = 0; i < GRPC_COMPRESS_ALGORITHMS_COUNT; i++) {
+    if (set_.is_set(i) && other.set_.is_set(i)) {
+      set.set_.set(i);
+    }
+  }
+  return set;
+}
+
 std::string CompressionAlgorithmSet::ToString() const {
   absl::InlinedVector<const char*, GRPC_COMPRESS_ALGORITHMS_COUNT> segments;
   for (size_t i = 0; i < GRPC_COMPRESS_ALGORITHMS_COUNT; i++) {
@@ -57,6 +57,9 @@ class CompressionAlgorithmSet {
   static CompressionAlgorithmSet FromChannelArgs(const grpc_channel_args* args);
   // Parse a string of comma-separated compression algorithms.
   static CompressionAlgorithmSet FromString(absl::string_view str);
+  // The algorithms this binary can compress and decompress: zstd and LZ4 are
+  // only available when built with GRPC_HAVE_ZSTD and GRPC_HAVE_LZ4.
+  static CompressionAlgorithmSet Supported();
   // Construct an empty set.
   CompressionAlgorithmSet();
   // Construct from a std::initializer_list of grpc_compression_algorithm
@@ -71,6 +74,8 @@ class CompressionAlgorithmSet {
   bool IsSet(grpc_compression_algorithm algorithm) const;
   // Add algorithm to this set.
   void Set(grpc_compression_algorithm algorithm);
+  // Return the algorithms that are in both this set and other.
+  CompressionAlgorithmSet Intersect(const CompressionAlgorithmSet& other) const;
 
   // Return a comma separated string of the algorithms in this set.
   std::string ToString() const;
@@ -24,9 +24,22 @@
 
 #include <zlib.h>
 
+#include <algorithm>
+
+#ifdef GRPC_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef GRPC_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
 #include <grpc/support/alloc.h>
+#include <grpc/support/cpu.h>
 #include <grpc/support/log.h>
 
+#include "src/core/lib/compression/compression_dictionary.h"
+#include "src/core/lib/gpr/useful.h"
+#include "src/core/lib/gprpp/sync.h"
 #include "src/core/lib/slice/slice_internal.h"
 
 #define OUTPUT_BLOCK_SIZE 1024
@@ -91,20 +104,220 @@ static void* zalloc_gpr(void* /*opaque*/, unsigned int items,
 
 static void zfree_gpr(void* /*opaque*/, void* address) { gpr_free(address); }
 
+typedef grpc_core::MessageCompressionContexts Contexts;
+
+/* Upper bound on the number of context pool shards */
+#define MAX_CONTEXT_POOL_SHARDS 64u
+
+static z_stream* new_z_stream() {
+  z_stream* zs = static_cast<z_stream*>(gpr_zalloc(sizeof(*zs)));
+  zs->zalloc = zalloc_gpr;
+  zs->zfree = zfree_gpr;
+  return zs;
+}
+
+static void* create_context(Contexts::Kind kind) {
+  switch (kind) {
+    case Contexts::kDeflate:
+    case Contexts::kGzip: {
+      z_stream* zs = new_z_stream();
+      GPR_ASSERT(deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                              15 | (kind == Contexts::kGzip ? 16 : 0), 8,
+                              Z_DEFAULT_STRATEGY) == Z_OK);
+      return zs;
+    }
+    case Contexts::kRawDeflate: {
+      z_stream* zs = new_z_stream();
+      GPR_ASSERT(deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                              Z_DEFAULT_STRATEGY) == Z_OK);
+      return zs;
+    }
+    case Contexts::kInflate:
+    case Contexts::kGunzip: {
+      z_stream* zs = new_z_stream();
+      GPR_ASSERT(inflateInit2(zs, 15 | (kind == Contexts::kGunzip ? 16 : 0)) ==
+                 Z_OK);
+      return zs;
+    }
+#ifdef GRPC_HAVE_ZSTD
+    case Contexts::kZstdCompress: {
+      ZSTD_CCtx* cctx = ZSTD_createCCtx();
+      GPR_ASSERT(cctx != nullptr);
+      return cctx;
+    }
+    case Contexts::kZstdDecompress: {
+      ZSTD_DCtx* dctx = ZSTD_createDCtx();
+      GPR_ASSERT(dctx != nullptr);
+      return dctx;
+    }
+#endif
+#ifdef GRPC_HAVE_LZ4
+    case Contexts::kLz4Compress: {
+      LZ4F_cctx* cctx;
+      GPR_ASSERT(
+          !LZ4F_isError(LZ4F_createCompressionContext(&cctx, LZ4F_VERSION)));
+      return cctx;
+    }
+    case Contexts::kLz4Decompress: {
+      LZ4F_dctx* dctx;
+      GPR_ASSERT(
+          !LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)));
+      return dctx;
+    }
+#endif
+    default:
+      break;
+  }
+  GPR_UNREACHABLE_CODE(return nullptr);
+}
+
+/* Readies context for the next message, whatever became of the last one */
+static void reset_context(Contexts::Kind kind, void* context) {
+  switch (kind) {
+    case Contexts::kDeflate:
+    case Contexts::kGzip:
+    case Contexts::kRawDeflate:
+      deflateReset(static_cast<z_stream*>(context));
+      break;
+    case Contexts::kInflate:
+    case Contexts::kGunzip:
+      inflateReset(static_cast<z_stream*>(context));
+      break;
+#ifdef GRPC_HAVE_ZSTD
+    case Contexts::kZstdCompress:
+      /* also drops the level and dictionary, which are set per message */
+      ZSTD_CCtx_reset(static_cast<ZSTD_CCtx*>(context),
+                      ZSTD_reset_session_and_parameters);
+      break;
+    case Contexts::kZstdDecompress:
+      ZSTD_DCtx_reset(static_cast<ZSTD_DCtx*>(context),
+                      ZSTD_reset_session_and_parameters);
+      break;
+#endif
+#ifdef GRPC_HAVE_LZ4
+    case Contexts::kLz4Compress:
+      /* LZ4F_compressBegin starts afresh */
+      break;
+    case Contexts::kLz4Decompress:
+      LZ4F_resetDecompressionContext(static_cast<LZ4F_dctx*>(context));
+      break;
+#endif
+    default:
+      GPR_UNREACHABLE_CODE(break);
+  }
+}
+
+static void destroy_context(Contexts::Kind kind, void* context) {
+  switch (kind) {
+    case Contexts::kDeflate:
+    case Contexts::kGzip:
+    case Contexts::kRawDeflate:
+      deflateEnd(static_cast<z_stream*>(context));
+      gpr_free(context);
+      break;
+    case Contexts::kInflate:
+    case Contexts::kGunzip:
+      inflateEnd(static_cast<z_stream*>(context));
+      gpr_free(context);
+      break;
+#ifdef GRPC_HAVE_ZSTD
+    case Contexts::kZstdCompress:
+      ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(context));
+      break;
+    case Contexts::kZstdDecompress:
+      ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(context));
+      break;
+#endif
+#ifdef GRPC_HAVE_LZ4
+    case Contexts::kLz4Compress:
+      LZ4F_freeCompressionContext(static_cast<LZ4F_cctx*>(context));
+      break;
+    case Contexts::kLz4Decompress:
+      LZ4F_freeDecompressionContext(static_cast<LZ4F_dctx*>(context));
+      break;
+#endif
+    default:
+      GPR_UNREACHABLE_CODE(break);
+  }
+}
+
+namespace {
+
+/* Idle contexts, at most one of each kind per shard. Sharding by CPU keeps
+   contention on the locks low, and bounds the memory held by idle contexts
+   by the number of cores rather than by the number of calls or threads. */
+struct ContextPoolShard {
+  grpc_core::Mutex mu;
+  void* contexts[Contexts::kNumKinds] ABSL_GUARDED_BY(mu) = {};
+};
+
+struct ContextPool {
+  ContextPool()
+      : num_shards(grpc_core::Clamp(gpr_cpu_num_cores(), 1u,
+                                    MAX_CONTEXT_POOL_SHARDS)),
+        shards(new ContextPoolShard[num_shards]) {}
+
+  const unsigned num_shards;
+  ContextPoolShard* const shards;
+};
+
+}  // namespace
+
+static ContextPoolShard* context_pool_shard() {
+  static ContextPool* pool = new ContextPool();
+  return &pool->shards[gpr_cpu_current_cpu() % pool->num_shards];
+}
+
+static void return_context_to_pool(Contexts::Kind kind, void* context) {
+  ContextPoolShard* shard = context_pool_shard();
+  {
+    grpc_core::MutexLock lock(&shard->mu);
+    if (shard->contexts[kind] == nullptr) {
+      shard->contexts[kind] = context;
+      return;
+    }
+  }
+  destroy_context(kind, context);
+}
+
+/* Returns a context of the given kind ready for a new message, preferring the
+   one held by 'held' (if not null), then a pooled one */
+static void* take_context(Contexts::Kind kind, Contexts* held) {
+  void* context = held == nullptr ? nullptr : held->Take(kind);
+  if (context != nullptr) return context;
+  ContextPoolShard* shard = context_pool_shard();
+  {
+    grpc_core::MutexLock lock(&shard->mu);
+    context = shard->contexts[kind];
+    shard->contexts[kind] = nullptr;
+  }
+  return context != nullptr ? context : create_context(kind);
+}
+
+/* Gives back a context obtained from take_context */
+static void put_context(Contexts::Kind kind, void* context, Contexts* held) {
+  reset_context(kind, context);
+  if (held != nullptr && held->Put(kind, context)) return;
+  return_context_to_pool(kind, context);
+}
+
+grpc_core::MessageCompressionContexts::~MessageCompressionContexts() {
+  for (int i = 0; i < kNumKinds; i++) {
+    if (contexts_[i] != nullptr) {
+      return_context_to_pool(static_cast<Kind>(i), contexts_[i]);
+    }
+  }
+}
+
 static int zlib_compress(grpc_slice_buffer* input, grpc_slice_buffer* output,
-                         int gzip) {
-  z_stream zs;
+                         int gzip, Contexts* contexts) {
   int r;
   size_t i;
   size_t count_before = output->count;
   size_t length_before = output->length;
-  memset(&zs, 0, sizeof(zs));
-  zs.zalloc = zalloc_gpr;
-  zs.zfree = zfree_gpr;
-  r = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | (gzip ? 16 : 0),
-                   8, Z_DEFAULT_STRATEGY);
-  GPR_ASSERT(r == Z_OK);
-  r = zlib_body(&zs, input, output, deflate) && output->length < input->length;
+  const Contexts::Kind kind = gzip ? Contexts::kGzip : Contexts::kDeflate;
+  z_stream* zs = static_cast<z_stream*>(take_context(kind, contexts));
+  r = zlib_body(zs, input, output, deflate) && output->length < input->length;
   if (!r) {
     for (i = count_before; i < output->count; i++) {
       grpc_slice_unref_internal(output->slices[i]);
@@ -112,23 +325,19 @@ static int zlib_compress(grpc_slice_buffer* input, grpc_slice_buffer* output,
     output->count = count_before;
     output->length = length_before;
   }
-  deflateEnd(&zs);
+  put_context(kind, zs, contexts);
   return r;
 }
 
 static int zlib_decompress(grpc_slice_buffer* input, grpc_slice_buffer* output,
-                           int gzip) {
-  z_stream zs;
+                           int gzip, Contexts* contexts) {
   int r;
   size_t i;
   size_t count_before = output->count;
   size_t length_before = output->length;
-  memset(&zs, 0, sizeof(zs));
-  zs.zalloc = zalloc_gpr;
-  zs.zfree = zfree_gpr;
-  r = inflateInit2(&zs, 15 | (gzip ? 16 : 0));
-  GPR_ASSERT(r == Z_OK);
-  r = zlib_body(&zs, input, output, inflate);
+  const Contexts::Kind kind = gzip ? Contexts::kGunzip : Contexts::kInflate;
+  z_stream* zs = static_cast<z_stream*>(take_context(kind, contexts));
+  r = zlib_body(zs, input, output, inflate);
   if (!r) {
     for (i = count_before; i < output->count; i++) {
       grpc_slice_unref_internal(output->slices[i]);
@@ -136,10 +345,326 @@ static int zlib_decompress(grpc_slice_buffer* input, grpc_slice_buffer* output,
     output->count = count_before;
     output->length = length_before;
   }
-  inflateEnd(&zs);
+  put_context(kind, zs, contexts);
+  return r;
+}
+
+#if defined(GRPC_HAVE_ZSTD) || defined(GRPC_HAVE_LZ4)
+/* Drops the slices appended to output since it had count_before of them */
+static void truncate_output(grpc_slice_buffer* output, size_t count_before,
+                            size_t length_before) {
+  for (size_t i = count_before; i < output->count; i++) {
+    grpc_slice_unref_internal(output->slices[i]);
+  }
+  output->count = count_before;
+  output->length = length_before;
+}
+
+/* Appends the first 'used' bytes of outbuf to output, taking ownership of
+   outbuf */
+static void add_output_block(grpc_slice_buffer* output, grpc_slice outbuf,
+                             size_t used) {
+  if (used == 0) {
+    grpc_slice_unref_internal(outbuf);
+    return;
+  }
+  GPR_ASSERT(outbuf.refcount);
+  outbuf.data.refcounted.length = used;
+  grpc_slice_buffer_add_indexed(output, outbuf);
+}
+#endif
+
+#ifdef GRPC_HAVE_ZSTD
+static void zstd_next_block(grpc_slice_buffer* output, grpc_slice* outbuf,
+                            ZSTD_outBuffer* out) {
+  add_output_block(output, *outbuf, out->pos);
+  *outbuf = GRPC_SLICE_MALLOC(out->size);
+  out->dst = GRPC_SLICE_START_PTR(*outbuf);
+  out->pos = 0;
+}
+
+static int zstd_compress(grpc_slice_buffer* input, grpc_slice_buffer* output,
+                         int level, const ZSTD_CDict* cdict,
+                         Contexts* contexts) {
+  if (input->length == 0) return 0;
+  size_t count_before = output->count;
+  size_t length_before = output->length;
+  ZSTD_CCtx* cctx = static_cast<ZSTD_CCtx*>(
+      take_context(Contexts::kZstdCompress, contexts));
+  ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+  if (cdict != nullptr) ZSTD_CCtx_refCDict(cctx, cdict);
+  /* records the uncompressed size in the frame header, so that the receiver
+     can size its output */
+  ZSTD_CCtx_setPledgedSrcSize(cctx, input->length);
+  const size_t block_size =
+      grpc_core::Clamp(ZSTD_compressBound(input->length),
+                       static_cast<size_t>(OUTPUT_BLOCK_SIZE),
+                       ZSTD_CStreamOutSize());
+  grpc_slice outbuf = GRPC_SLICE_MALLOC(block_size);
+  ZSTD_outBuffer out = {GRPC_SLICE_START_PTR(outbuf), block_size, 0};
+  int r = 1;
+  for (size_t i = 0; r && i < input->count; i++) {
+    const bool last = i == input->count - 1;
+    ZSTD_inBuffer in = {GRPC_SLICE_START_PTR(input->slices[i]),
+                        GRPC_SLICE_LENGTH(input->slices[i]), 0};
+    size_t remaining;
+    do {
+      if (out.pos == out.size) {
+        zstd_next_block(output, &outbuf, &out);
+        /* no point in carrying on once compression no longer pays off */
+        if (output->length - length_before >= input->length) {
+          r = 0;
+          break;
+        }
+      }
+      remaining = ZSTD_compressStream2(cctx, &out, &in,
+                                       last ? ZSTD_e_end : ZSTD_e_continue);
+      if (ZSTD_isError(remaining)) {
+        gpr_log(GPR_INFO, "zstd error: %s", ZSTD_getErrorName(remaining));
+        r = 0;
+        break;
+      }
+    } while (last ? remaining != 0 : in.pos < in.size);
+  }
+  add_output_block(output, outbuf, out.pos);
+  r = r && output->length - length_before < input->length;
+  if (!r) truncate_output(output, count_before, length_before);
+  put_context(Contexts::kZstdCompress, cctx, contexts);
   return r;
 }
 
+static int zstd_decompress(grpc_slice_buffer* input,
+                           grpc_slice_buffer* output, const ZSTD_DDict* ddict,
+                           Contexts* contexts) {
+  size_t count_before = output->count;
+  size_t length_before = output->length;
+  ZSTD_DCtx* dctx = static_cast<ZSTD_DCtx*>(
+      take_context(Contexts::kZstdDecompress, contexts));
+  if (ddict != nullptr) ZSTD_DCtx_refDDict(dctx, ddict);
+  size_t block_size = ZSTD_DStreamOutSize();
+  if (input->count > 0) {
+    const unsigned long long content_size =
+        ZSTD_getFrameContentSize(GRPC_SLICE_START_PTR(input->slices[0]),
+                                 GRPC_SLICE_LENGTH(input->slices[0]));
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+        content_size != ZSTD_CONTENTSIZE_ERROR) {
+      block_size = std::max(
+          static_cast<size_t>(OUTPUT_BLOCK_SIZE),
+          static_cast<size_t>(std::min<unsigned long long>(
+              content_size, block_size)));
+    }
+  }
+  grpc_slice outbuf = GRPC_SLICE_MALLOC(block_size);
+  ZSTD_outBuffer out = {GRPC_SLICE_START_PTR(outbuf), block_size, 0};
+  /* 0 once a frame has been completely decoded and flushed */
+  size_t hint = 0;
+  int r = 1;
+  for (size_t i = 0; r && i < input->count; i++) {
+    ZSTD_inBuffer in = {GRPC_SLICE_START_PTR(input->slices[i]),
+                        GRPC_SLICE_LENGTH(input->slices[i]), 0};
+    while (in.pos < in.size) {
+      if (out.pos == out.size) zstd_next_block(output, &outbuf, &out);
+      hint = ZSTD_decompressStream(dctx, &out, &in);
+      if (ZSTD_isError(hint)) {
+        gpr_log(GPR_INFO, "zstd error: %s", ZSTD_getErrorName(hint));
+        r = 0;
+        break;
+      }
+    }
+  }
+  /* flush whatever the decoder still holds */
+  while (r && hint != 0) {
+    if (out.pos == out.size) zstd_next_block(output, &outbuf, &out);
+    ZSTD_inBuffer in = {nullptr, 0, 0};
+    size_t pos_before = out.pos;
+    hint = ZSTD_decompressStream(dctx, &out, &in);
+    if (ZSTD_isError(hint) || out.pos == pos_before) {
+      gpr_log(GPR_INFO, "zstd: Data error");
+      r = 0;
+    }
+  }
+  add_output_block(output, outbuf, out.pos);
+  if (!r) truncate_output(output, count_before, length_before);
+  put_context(Contexts::kZstdDecompress, dctx, contexts);
+  return r;
+}
+#endif /* GRPC_HAVE_ZSTD */
+
+#ifdef GRPC_HAVE_LZ4
+/* Input is fed to LZ4 one block (of this size) at a time */
+#define LZ4_INPUT_CHUNK_SIZE static_cast<size_t>(64 * 1024)
+#define LZ4_OUTPUT_BLOCK_SIZE (64 * 1024)
+
+/* Makes sure that outbuf has room for 'needed' more bytes after 'used',
+   moving on to a new block if it does not */
+static void lz4_reserve(grpc_slice_buffer* output, grpc_slice* outbuf,
+                        size_t* used, size_t needed, size_t block_size) {
+  if (GRPC_SLICE_LENGTH(*outbuf) - *used >= needed) return;
+  add_output_block(output, *outbuf, *used);
+  *outbuf = GRPC_SLICE_MALLOC(std::max(block_size, needed));
+  *used = 0;
+}
+
+/* Compresses the LZ4_INPUT_CHUNK_SIZE or fewer bytes at src */
+static int lz4_compress_chunk(LZ4F_cctx* cctx, const LZ4F_preferences_t* prefs,
+                              const uint8_t* src, size_t len,
+                              grpc_slice_buffer* output, grpc_slice* outbuf,
+                              size_t* used, size_t block_size) {
+  lz4_reserve(output, outbuf, used, LZ4F_compressBound(len, prefs),
+              block_size);
+  size_t n = LZ4F_compressUpdate(cctx, GRPC_SLICE_START_PTR(*outbuf) + *used,
+                                 GRPC_SLICE_LENGTH(*outbuf) - *used, src, len,
+                                 nullptr);
+  if (LZ4F_isError(n)) {
+    gpr_log(GPR_INFO, "lz4 error: %s", LZ4F_getErrorName(n));
+    return 0;
+  }
+  *used += n;
+  return 1;
+}
+
+static int lz4_compress(grpc_slice_buffer* input, grpc_slice_buffer* output,
+                        Contexts* contexts) {
+  if (input->length == 0) return 0;
+  size_t count_before = output->count;
+  size_t length_before = output->length;
+  LZ4F_cctx* cctx = static_cast<LZ4F_cctx*>(
+      take_context(Contexts::kLz4Compress, contexts));
+  LZ4F_preferences_t prefs;
+  memset(&prefs, 0, sizeof(prefs));
+  prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+  prefs.frameInfo.contentSize = input->length;
+  /* input is gathered into whole blocks here, so LZ4 need not buffer it */
+  prefs.autoFlush = 1;
+  const size_t block_size =
+      grpc_core::Clamp(LZ4F_compressFrameBound(input->length, &prefs),
+                       static_cast<size_t>(OUTPUT_BLOCK_SIZE),
+                       static_cast<size_t>(LZ4_OUTPUT_BLOCK_SIZE));
+  grpc_slice outbuf = GRPC_SLICE_MALLOC(block_size);
+  size_t used = 0;
+  int r = 1;
+  lz4_reserve(output, &outbuf, &used, LZ4F_HEADER_SIZE_MAX, block_size);
+  size_t n = LZ4F_compressBegin(cctx, GRPC_SLICE_START_PTR(outbuf) + used,
+                                GRPC_SLICE_LENGTH(outbuf) - used, &prefs);
+  if (LZ4F_isError(n)) {
+    gpr_log(GPR_INFO, "lz4 error: %s", LZ4F_getErrorName(n));
+    r = 0;
+  } else {
+    used += n;
+  }
+  /* Each block is compressed independently, so gather input that is split
+     into small slices into whole blocks first: otherwise the compression
+     ratio would depend on how the message happens to be sliced. */
+  uint8_t* staging = nullptr;
+  size_t staged = 0;
+  for (size_t i = 0; r && i < input->count; i++) {
+    const uint8_t* src = GRPC_SLICE_START_PTR(input->slices[i]);
+    size_t remaining = GRPC_SLICE_LENGTH(input->slices[i]);
+    while (r && remaining > 0) {
+      /* no point in carrying on once compression no longer pays off */
+      if (output->length - length_before >= input->length) {
+        r = 0;
+        break;
+      }
+      if (staged == 0 && remaining >= LZ4_INPUT_CHUNK_SIZE) {
+        r = lz4_compress_chunk(cctx, &prefs, src, LZ4_INPUT_CHUNK_SIZE, output,
+                               &outbuf, &used, block_size);
+        src += LZ4_INPUT_CHUNK_SIZE;
+        remaining -= LZ4_INPUT_CHUNK_SIZE;
+        continue;
+      }
+      if (staging == nullptr) {
+        staging = static_cast<uint8_t*>(gpr_malloc(LZ4_INPUT_CHUNK_SIZE));
+      }
+      const size_t n_copy = std::min(remaining, LZ4_INPUT_CHUNK_SIZE - staged);
+      memcpy(staging + staged, src, n_copy);
+      staged += n_copy;
+      src += n_copy;
+      remaining -= n_copy;
+      if (staged == LZ4_INPUT_CHUNK_SIZE) {
+        r = lz4_compress_chunk(cctx, &prefs, staging, staged, output, &outbuf,
+                               &used, block_size);
+        staged = 0;
+      }
+    }
+  }
+  if (r && staged > 0) {
+    r = lz4_compress_chunk(cctx, &prefs, staging, staged, output, &outbuf,
+                           &used, block_size);
+  }
+  gpr_free(staging);
+  if (r) {
+    lz4_reserve(output, &outbuf, &used, LZ4F_compressBound(0, &prefs),
+                block_size);
+    n = LZ4F_compressEnd(cctx, GRPC_SLICE_START_PTR(outbuf) + used,
+                         GRPC_SLICE_LENGTH(outbuf) - used, nullptr);
+    if (LZ4F_isError(n)) {
+      gpr_log(GPR_INFO, "lz4 error: %s", LZ4F_getErrorName(n));
+      r = 0;
+    } else {
+      used += n;
+    }
+  }
+  add_output_block(output, outbuf, used);
+  r = r && output->length - length_before < input->length;
+  if (!r) truncate_output(output, count_before, length_before);
+  put_context(Contexts::kLz4Compress, cctx, contexts);
+  return r;
+}
+
+static int lz4_decompress(grpc_slice_buffer* input, grpc_slice_buffer* output,
+                          Contexts* contexts) {
+  size_t count_before = output->count;
+  size_t length_before = output->length;
+  LZ4F_dctx* dctx = static_cast<LZ4F_dctx*>(
+      take_context(Contexts::kLz4Decompress, contexts));
+  const size_t block_size = grpc_core::Clamp(
+      4 * input->length, static_cast<size_t>(OUTPUT_BLOCK_SIZE),
+      static_cast<size_t>(LZ4_OUTPUT_BLOCK_SIZE));
+  grpc_slice outbuf = GRPC_SLICE_MALLOC(block_size);
+  size_t used = 0;
+  /* 0 once a frame has been completely decoded and flushed */
+  size_t hint = 0;
+  int r = 1;
+  for (size_t i = 0; r && i < input->count; i++) {
+    const uint8_t* src = GRPC_SLICE_START_PTR(input->slices[i]);
+    size_t remaining = GRPC_SLICE_LENGTH(input->slices[i]);
+    while (remaining > 0) {
+      lz4_reserve(output, &outbuf, &used, 1, block_size);
+      size_t dst_size = GRPC_SLICE_LENGTH(outbuf) - used;
+      size_t src_size = remaining;
+      hint = LZ4F_decompress(dctx, GRPC_SLICE_START_PTR(outbuf) + used,
+                             &dst_size, src, &src_size, nullptr);
+      if (LZ4F_isError(hint) || (dst_size == 0 && src_size == 0)) {
+        gpr_log(GPR_INFO, "lz4: Data error");
+        r = 0;
+        break;
+      }
+      used += dst_size;
+      src += src_size;
+      remaining -= src_size;
+    }
+  }
+  /* flush whatever the decoder still holds */
+  while (r && hint != 0) {
+    lz4_reserve(output, &outbuf, &used, 1, block_size);
+    size_t dst_size = GRPC_SLICE_LENGTH(outbuf) - used;
+    size_t src_size = 0;
+    hint = LZ4F_decompress(dctx, GRPC_SLICE_START_PTR(outbuf) + used,
+                           &dst_size, nullptr, &src_size, nullptr);
+    if (LZ4F_isError(hint) || dst_size == 0) {
+      gpr_log(GPR_INFO, "lz4: Data error");
+      r = 0;
+    }
+    used += dst_size;
+  }
+  add_output_block(output, outbuf, used);
+  if (!r) truncate_output(output, count_before, length_before);
+  put_context(Contexts::kLz4Decompress, dctx, contexts);
+  return r;
+}
+#endif /* GRPC_HAVE_LZ4 */
+
 static int copy(grpc_slice_buffer* input, grpc_slice_buffer* output) {
   size_t i;
   for (i = 0; i < input->count; i++) {
@@ -148,27 +673,63 @@ static int copy(grpc_slice_buffer* input, grpc_slice_buffer* output) {
   return 1;
 }
 
-static int compress_inner(grpc_compression_algorithm algorithm,
-                          grpc_slice_buffer* input, grpc_slice_buffer* output) {
+static int compress_inner(grpc_compression_algorithm algorithm, int level,
+                          grpc_core::CompressionDictionary* dictionary,
+                          grpc_slice_buffer* input, grpc_slice_buffer* output,
+                          Contexts* contexts) {
   switch (algorithm) {
     case GRPC_COMPRESS_NONE:
       /* the fallback path always needs to be send uncompressed: we simply
          rely on that here */
       return 0;
     case GRPC_COMPRESS_DEFLATE:
-      return zlib_compress(input, output, 0);
+      return zlib_compress(input, output, 0, contexts);
     case GRPC_COMPRESS_GZIP:
-      return zlib_compress(input, output, 1);
+      return zlib_compress(input, output, 1, contexts);
+    case GRPC_COMPRESS_ZSTD:
+#ifdef GRPC_HAVE_ZSTD
+      return zstd_compress(
+          input, output, level,
+          dictionary == nullptr
+              ? nullptr
+              : dictionary->CompressionDictionaryForLevel(level),
+          contexts);
+#else
+      break;
+#endif
+    case GRPC_COMPRESS_LZ4:
+#ifdef GRPC_HAVE_LZ4
+      return lz4_compress(input, output, contexts);
+#else
+      break;
+#endif
     case GRPC_COMPRESS_ALGORITHMS_COUNT:
       break;
   }
+  (void)level;
+  (void)dictionary;
+  (void)contexts;
   gpr_log(GPR_ERROR, "invalid compression algorithm %d", algorithm);
   return 0;
 }
 
 int grpc_msg_compress(grpc_compression_algorithm algorithm,
                       grpc_slice_buffer* input, grpc_slice_buffer* output) {
-  if (!compress_inner(algorithm, input, output)) {
+  return grpc_msg_compress_with_level(algorithm, 0, input, output);
+}
+
+int grpc_msg_compress_with_level(grpc_compression_algorithm algorithm,
+                                 int level, grpc_slice_buffer* input,
+                                 grpc_slice_buffer* output) {
+  return grpc_msg_compress_with_dictionary(algorithm, level, nullptr, input,
+                                           output);
+}
+
+int grpc_msg_compress_with_dictionary(
+    grpc_compression_algorithm algorithm, int level,
+    grpc_core::CompressionDictionary* dictionary, grpc_slice_buffer* input,
+    grpc_slice_buffer* output, Contexts* contexts) {
+  if (!compress_inner(algorithm, level, dictionary, input, output, contexts)) {
     copy(input, output);
     return 0;
   }
@@ -177,16 +738,214 @@ int grpc_msg_compress(grpc_compression_algorithm algorithm,
 
 int grpc_msg_decompress(grpc_compression_algorithm algorithm,
                         grpc_slice_buffer* input, grpc_slice_buffer* output) {
+  return grpc_msg_decompress_with_dictionary(algorithm, nullptr, input,
+                                             output);
+}
+
+int grpc_msg_decompress_with_dictionary(
+    grpc_compression_algorithm algorithm,
+    const grpc_core::CompressionDictionary* dictionary,
+    grpc_slice_buffer* input, grpc_slice_buffer* output, Contexts* contexts) {
   switch (algorithm) {
     case GRPC_COMPRESS_NONE:
       return copy(input, output);
     case GRPC_COMPRESS_DEFLATE:
-      return zlib_decompress(input, output, 0);
+      return zlib_decompress(input, output, 0, contexts);
     case GRPC_COMPRESS_GZIP:
-      return zlib_decompress(input, output, 1);
+      return zlib_decompress(input, output, 1, contexts);
+    case GRPC_COMPRESS_ZSTD:
+#ifdef GRPC_HAVE_ZSTD
+      return zstd_decompress(input, output,
+                             dictionary == nullptr
+                                 ? nullptr
+                                 : dictionary->decompression_dictionary(),
+                             contexts);
+#else
+      break;
+#endif
+    case GRPC_COMPRESS_LZ4:
+#ifdef GRPC_HAVE_LZ4
+      return lz4_decompress(input, output, contexts);
+#else
+      break;
+#endif
     case GRPC_COMPRESS_ALGORITHMS_COUNT:
       break;
   }
+  (void)dictionary;
+  (void)contexts;
   gpr_log(GPR_ERROR, "invalid compression algorithm %d", algorithm);
   return 0;
 }
+
+/* Deflate's window: the most input a block can refer back to */
+#define BLOCK_DICTIONARY_SIZE static_cast<size_t>(32 * 1024)
+
+/* Calls fn(start, length) for each contiguous piece of the 'length' bytes of
+   input starting at 'offset' */
+template <typename F>
+static void for_each_input_piece(grpc_slice_buffer* input, size_t offset,
+                                 size_t length, F fn) {
+  for (size_t i = 0; length > 0 && i < input->count; i++) {
+    const size_t slice_length = GRPC_SLICE_LENGTH(input->slices[i]);
+    if (offset >= slice_length) {
+      offset -= slice_length;
+      continue;
+    }
+    const size_t n = std::min(slice_length - offset, length);
+    fn(GRPC_SLICE_START_PTR(input->slices[i]) + offset, n);
+    offset = 0;
+    length -= n;
+  }
+}
+
+/* Runs deflate with 'flush' until it has consumed zs's input (and, unless
+   flush is Z_NO_FLUSH, produced all the matching output) */
+static int deflate_block_input(z_stream* zs, int flush,
+                               grpc_slice_buffer* output, grpc_slice* outbuf) {
+  int r;
+  do {
+    if (zs->avail_out == 0) {
+      grpc_slice_buffer_add_indexed(output, *outbuf);
+      *outbuf = GRPC_SLICE_MALLOC(OUTPUT_BLOCK_SIZE);
+      zs->avail_out = static_cast<uInt> GRPC_SLICE_LENGTH(*outbuf);
+      zs->next_out = GRPC_SLICE_START_PTR(*outbuf);
+    }
+    r = deflate(zs, flush);
+    if (r < 0 && r != Z_BUF_ERROR /* not fatal */) {
+      gpr_log(GPR_INFO, "zlib error (%d)", r);
+      return 0;
+    }
+  } while (zs->avail_out == 0);
+  return zs->avail_in == 0 && (flush != Z_FINISH || r == Z_STREAM_END);
+}
+
+namespace grpc_core {
+
+bool BlockMessageCompressor::Supports(grpc_compression_algorithm algorithm) {
+  return algorithm == GRPC_COMPRESS_DEFLATE || algorithm == GRPC_COMPRESS_GZIP;
+}
+
+BlockMessageCompressor::BlockMessageCompressor(
+    grpc_compression_algorithm algorithm, grpc_slice_buffer* input,
+    size_t block_size)
+    : gzip_(algorithm == GRPC_COMPRESS_GZIP),
+      input_(input),
+      blocks_(std::max<size_t>(
+          1, (input->length + block_size - 1) / block_size)) {
+  GPR_ASSERT(Supports(algorithm));
+  GPR_ASSERT(block_size > 0);
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    blocks_[i].offset = i * block_size;
+    blocks_[i].length = std::min(block_size, input->length - i * block_size);
+    grpc_slice_buffer_init(&blocks_[i].output);
+  }
+}
+
+BlockMessageCompressor::~BlockMessageCompressor() {
+  for (Block& block : blocks_) {
+    grpc_slice_buffer_destroy_internal(&block.output);
+  }
+}
+
+void BlockMessageCompressor::CompressBlock(size_t i) {
+  Block& block = blocks_[i];
+  const bool last = i == blocks_.size() - 1;
+  z_stream* zs =
+      static_cast<z_stream*>(take_context(Contexts::kRawDeflate, nullptr));
+  /* Priming the block with the input before it lets it refer back to it,
+     as it would in a stream compressed in one go */
+  if (block.offset > 0) {
+    const size_t dictionary_length =
+        std::min(block.offset, BLOCK_DICTIONARY_SIZE);
+    uint8_t dictionary[BLOCK_DICTIONARY_SIZE];
+    uint8_t* p = dictionary;
+    for_each_input_piece(input_, block.offset - dictionary_length,
+                         dictionary_length,
+                         [&p](const uint8_t* start, size_t length) {
+                           memcpy(p, start, length);
+                           p += length;
+                         });
+    deflateSetDictionary(zs, dictionary,
+                         static_cast<uInt>(dictionary_length));
+  }
+  uLong check = gzip_ ? crc32(0, nullptr, 0) : adler32(0, nullptr, 0);
+  grpc_slice outbuf = GRPC_SLICE_MALLOC(OUTPUT_BLOCK_SIZE);
+  zs->avail_out = static_cast<uInt> GRPC_SLICE_LENGTH(outbuf);
+  zs->next_out = GRPC_SLICE_START_PTR(outbuf);
+  bool ok = true;
+  for_each_input_piece(
+      input_, block.offset, block.length,
+      [&](const uint8_t* start, size_t length) {
+        GPR_ASSERT(length <= ~static_cast<uInt>(0));
+        check = gzip_ ? crc32(check, start, static_cast<uInt>(length))
+                      : adler32(check, start, static_cast<uInt>(length));
+        if (!ok) return;
+        zs->next_in = const_cast<Bytef*>(start);
+        zs->avail_in = static_cast<uInt>(length);
+        ok = deflate_block_input(zs, Z_NO_FLUSH, &block.output, &outbuf);
+      });
+  /* A sync flush ends the block on a byte boundary, so that the next block
+     can follow it directly */
+  ok = ok && deflate_block_input(zs, last ? Z_FINISH : Z_SYNC_FLUSH,
+                                 &block.output, &outbuf);
+  outbuf.data.refcounted.length -= zs->avail_out;
+  grpc_slice_buffer_add_indexed(&block.output, outbuf);
+  put_context(Contexts::kRawDeflate, zs, nullptr);
+  block.check = static_cast<uint32_t>(check);
+  block.ok = ok;
+}
+
+int BlockMessageCompressor::Finish(grpc_slice_buffer* output) {
+  size_t compressed_length = 0;
+  bool ok = true;
+  uLong check = blocks_[0].check;
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    ok = ok && blocks_[i].ok;
+    compressed_length += blocks_[i].output.length;
+    if (i > 0) {
+      check = gzip_ ? crc32_combine(check, blocks_[i].check,
+                                    static_cast<z_off_t>(blocks_[i].length))
+                    : adler32_combine(check, blocks_[i].check,
+                                      static_cast<z_off_t>(blocks_[i].length));
+    }
+  }
+  /* header and trailer */
+  compressed_length += gzip_ ? 18 : 6;
+  if (!ok || compressed_length >= input_->length) {
+    copy(input_, output);
+    return 0;
+  }
+  if (gzip_) {
+    /* no name, no mtime, unknown OS */
+    static const uint8_t kGzipHeader[] = {0x1f, 0x8b, 8, 0, 0,
+                                          0,    0,    0, 0, 0xff};
+    grpc_slice_buffer_add(output, grpc_slice_from_static_buffer(
+                                      kGzipHeader, sizeof(kGzipHeader)));
+  } else {
+    /* 32KiB window, default level */
+    static const uint8_t kZlibHeader[] = {0x78, 0x9c};
+    grpc_slice_buffer_add(output, grpc_slice_from_static_buffer(
+                                      kZlibHeader, sizeof(kZlibHeader)));
+  }
+  for (Block& block : blocks_) {
+    grpc_slice_buffer_move_into(&block.output, output);
+  }
+  grpc_slice trailer = GRPC_SLICE_MALLOC(gzip_ ? 8 : 4);
+  uint8_t* p = GRPC_SLICE_START_PTR(trailer);
+  if (gzip_) {
+    const uint32_t size = static_cast<uint32_t>(input_->length);
+    for (int i = 0; i < 4; i++) {
+      p[i] = static_cast<uint8_t>(check >> (8 * i));
+      p[4 + i] = static_cast<uint8_t>(size >> (8 * i));
+    }
+  } else {
+    for (int i = 0; i < 4; i++) {
+      p[i] = static_cast<uint8_t>(check >> (8 * (3 - i)));
+    }
+  }
+  grpc_slice_buffer_add(output, trailer);
+  return 1;
+}
+
+}  // namespace grpc_core
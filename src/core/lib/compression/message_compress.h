@@ -21,20 +21,146 @@
 
 #include <grpc/support/port_platform.h>
 
+#include <stdint.h>
+
+#include <vector>
+
 #include <grpc/slice_buffer.h>
 
+#include "src/core/lib/compression/compression_dictionary.h"
 #include "src/core/lib/compression/compression_internal.h"
 
+namespace grpc_core {
+
+// Compression library state that is reused from one message to the next.
+// Setting up a context is not cheap (zlib allocates ~256KiB to deflate), so
+// contexts are pooled per CPU, and a call may also hold on to the ones it has
+// used for its lifetime. Contexts are reset between messages: every message
+// is still compressed independently, and the wire format is unchanged.
+// Not thread safe.
+class MessageCompressionContexts {
+ public:
+  enum Kind {
+    kDeflate,
+    kGzip,
+    kInflate,
+    kGunzip,
+    // Headerless deflate, used by BlockMessageCompressor.
+    kRawDeflate,
+    kZstdCompress,
+    kZstdDecompress,
+    kLz4Compress,
+    kLz4Decompress,
+    kNumKinds,
+  };
+
+  MessageCompressionContexts() = default;
+  // Returns the held contexts to the pool.
+  ~MessageCompressionContexts();
+
+  MessageCompressionContexts(const MessageCompressionContexts&) = delete;
+  MessageCompressionContexts& operator=(const MessageCompressionContexts&) =
+      delete;
+
+  // Takes the held context of the given kind, if any.
+  void* Take(Kind kind) {
+    void* context = contexts_[kind];
+    contexts_[kind] = nullptr;
+    return context;
+  }
+  // Holds context, unless one of its kind is already held. Returns true if
+  // it did.
+  bool Put(Kind kind, void* context) {
+    if (contexts_[kind] != nullptr) return false;
+    contexts_[kind] = context;
+    return true;
+  }
+
+ private:
+  void* contexts_[kNumKinds] = {};
+};
+
+// Compresses a large message with GRPC_COMPRESS_DEFLATE or GRPC_COMPRESS_GZIP
+// as independently deflated blocks, so that the blocks can be compressed
+// concurrently. As in pigz, each block is primed with the 32KiB of input that
+// precedes it, and the blocks are stitched into a single zlib or gzip stream,
+// which peers decompress like any other message.
+class BlockMessageCompressor {
+ public:
+  // Whether messages compressed with algorithm can be split into blocks.
+  static bool Supports(grpc_compression_algorithm algorithm);
+
+  // input must outlive the compressor, and must not change meanwhile.
+  BlockMessageCompressor(grpc_compression_algorithm algorithm,
+                         grpc_slice_buffer* input, size_t block_size);
+  ~BlockMessageCompressor();
+
+  BlockMessageCompressor(const BlockMessageCompressor&) = delete;
+  BlockMessageCompressor& operator=(const BlockMessageCompressor&) = delete;
+
+  size_t num_blocks() const { return blocks_.size(); }
+
+  // Compresses the block'th block. Different blocks may be compressed
+  // concurrently, from any thread.
+  void CompressBlock(size_t block);
+
+  // Once every block has been compressed, behaves as grpc_msg_compress:
+  // appends the compressed message to output and returns 1, or appends the
+  // uncompressed input and returns 0 if compression did not pay off.
+  int Finish(grpc_slice_buffer* output);
+
+ private:
+  struct Block {
+    size_t offset = 0;
+    size_t length = 0;
+    // crc32 (gzip) or adler32 (deflate) of the block's input.
+    uint32_t check = 0;
+    bool ok = false;
+    grpc_slice_buffer output;
+  };
+
+  const bool gzip_;
+  grpc_slice_buffer* const input_;
+  std::vector<Block> blocks_;
+};
+
+}  // namespace grpc_core
+
 /* compress 'input' to 'output' using 'algorithm'.
    On success, appends compressed slices to output and returns 1.
    On failure, appends uncompressed slices to output and returns 0. */
 int grpc_msg_compress(grpc_compression_algorithm algorithm,
                       grpc_slice_buffer* input, grpc_slice_buffer* output);
 
+/* as grpc_msg_compress, with an algorithm specific compression 'level'.
+   Only GRPC_COMPRESS_ZSTD honours it: 0 selects the algorithm's default. */
+int grpc_msg_compress_with_level(grpc_compression_algorithm algorithm,
+                                 int level, grpc_slice_buffer* input,
+                                 grpc_slice_buffer* output);
+
+/* as grpc_msg_compress_with_level, priming GRPC_COMPRESS_ZSTD with
+   'dictionary', which may be null. Other algorithms ignore it.
+   If 'contexts' is not null, compression contexts are taken from and kept in
+   it rather than the shared pool. */
+int grpc_msg_compress_with_dictionary(
+    grpc_compression_algorithm algorithm, int level,
+    grpc_core::CompressionDictionary* dictionary, grpc_slice_buffer* input,
+    grpc_slice_buffer* output,
+    grpc_core::MessageCompressionContexts* contexts = nullptr);
+
 /* decompress 'input' to 'output' using 'algorithm'.
    On success, appends slices to output and returns 1.
    On failure, output is unchanged, and returns 0. */
 int grpc_msg_decompress(grpc_compression_algorithm algorithm,
                         grpc_slice_buffer* input, grpc_slice_buffer* output);
 
+/* as grpc_msg_decompress, for input compressed with
+   grpc_msg_compress_with_dictionary. 'dictionary' and 'contexts' may be
+   null. */
+int grpc_msg_decompress_with_dictionary(
+    grpc_compression_algorithm algorithm,
+    const grpc_core::CompressionDictionary* dictionary,
+    grpc_slice_buffer* input, grpc_slice_buffer* output,
+    grpc_core::MessageCompressionContexts* contexts = nullptr);
+
 #endif /* GRPC_CORE_LIB_COMPRESSION_MESSAGE_COMPRESS_H */
@@ -29,6 +29,7 @@
 const char* grpc_stats_counter_name[GRPC_STATS_COUNTER_COUNT] = {
     "client_calls_created",
     "server_calls_created",
+    "call_arena_overflows",
     "cqs_created",
     "client_channels_created",
     "client_subchannels_created",
@@ -48,6 +49,7 @@ const char* grpc_stats_counter_name[GRPC_STATS_COUNTER_COUNT] = {
     "syscall_read",
     "tcp_backup_pollers_created",
     "tcp_backup_poller_polls",
+    "tcp_read_zerocopy",
     "http2_op_batches",
     "http2_op_cancel",
     "http2_op_send_initial_metadata",
@@ -106,6 +108,7 @@ const char* grpc_stats_counter_name[GRPC_STATS_COUNTER_COUNT] = {
     "hpack_send_huffman",
     "hpack_send_binary",
     "hpack_send_binary_base64",
+    "hpack_send_pre_encoded",
     "combiner_locks_initiated",
     "combiner_locks_scheduled_items",
     "combiner_locks_scheduled_final_items",
@@ -129,6 +132,8 @@ const char* grpc_stats_counter_name[GRPC_STATS_COUNTER_COUNT] = {
 const char* grpc_stats_counter_doc[GRPC_STATS_COUNTER_COUNT] = {
     "Number of client side calls created by this process",
     "Number of server side calls created by this process",
+    "Number of calls whose arena outgrew its initial size and allocated "
+    "additional zones",
     "Number of completion queues created",
     "Number of client channels created",
     "Number of client subchannels created",
@@ -147,7 +152,8 @@ const char* grpc_stats_counter_doc[GRPC_STATS_COUNTER_COUNT] = {
     "polling wakeup (only valid for epoll1 right now)",
     "How many times could a polling wakeup be satisfied by keeping the waking "
     "thread awake? (only valid for epoll1 right now)",
-    "Number of epoll_ctl calls made (only valid for epollex right now)",
+    "Number of epoll_ctl calls made, or io_uring poll request submissions "
+    "(only valid for epollex and io_uring right now)",
     "Number of epoll_ctl calls skipped because the fd was cached as already "
     "being added.  (only valid for epollex right now)",
     "Number of times histogram increments went through the slow (binary "
@@ -157,6 +163,8 @@ const char* grpc_stats_counter_doc[GRPC_STATS_COUNTER_COUNT] = {
     "Number of read syscalls (or equivalent - eg recvmsg) made by this process",
     "Number of times a backup poller has been created (this can be expensive)",
     "Number of polls performed on the backup poller",
+    "Number of reads that mapped receive buffer pages with "
+    "TCP_ZEROCOPY_RECEIVE instead of copying",
     "Number of batches received by HTTP2 transport",
     "Number of cancelations received by HTTP2 transport",
     "Number of batches containing send initial metadata",
@@ -224,6 +232,8 @@ const char* grpc_stats_counter_doc[GRPC_STATS_COUNTER_COUNT] = {
     "Number of huffman encoded strings sent in metadata",
     "Number of binary strings received in metadata",
     "Number of binary strings received encoded in base64 in metadata",
+    "Number of HPACK literal headers sent from the process wide pre-encoded "
+    "cache",
     "Number of combiner lock entries by process (first items queued to a "
     "combiner)",
     "Number of items scheduled against combiner locks",
@@ -30,6 +30,7 @@
 typedef enum {
   GRPC_STATS_COUNTER_CLIENT_CALLS_CREATED,
   GRPC_STATS_COUNTER_SERVER_CALLS_CREATED,
+  GRPC_STATS_COUNTER_CALL_ARENA_OVERFLOWS,
   GRPC_STATS_COUNTER_CQS_CREATED,
   GRPC_STATS_COUNTER_CLIENT_CHANNELS_CREATED,
   GRPC_STATS_COUNTER_CLIENT_SUBCHANNELS_CREATED,
@@ -49,6 +50,7 @@ typedef enum {
   GRPC_STATS_COUNTER_SYSCALL_READ,
   GRPC_STATS_COUNTER_TCP_BACKUP_POLLERS_CREATED,
   GRPC_STATS_COUNTER_TCP_BACKUP_POLLER_POLLS,
+  GRPC_STATS_COUNTER_TCP_READ_ZEROCOPY,
   GRPC_STATS_COUNTER_HTTP2_OP_BATCHES,
   GRPC_STATS_COUNTER_HTTP2_OP_CANCEL,
   GRPC_STATS_COUNTER_HTTP2_OP_SEND_INITIAL_METADATA,
@@ -107,6 +109,7 @@ typedef enum {
   GRPC_STATS_COUNTER_HPACK_SEND_HUFFMAN,
   GRPC_STATS_COUNTER_HPACK_SEND_BINARY,
   GRPC_STATS_COUNTER_HPACK_SEND_BINARY_BASE64,
+  GRPC_STATS_COUNTER_HPACK_SEND_PRE_ENCODED,
   GRPC_STATS_COUNTER_COMBINER_LOCKS_INITIATED,
   GRPC_STATS_COUNTER_COMBINER_LOCKS_SCHEDULED_ITEMS,
   GRPC_STATS_COUNTER_COMBINER_LOCKS_SCHEDULED_FINAL_ITEMS,
@@ -182,6 +185,8 @@ typedef enum {
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_CLIENT_CALLS_CREATED)
 #define GRPC_STATS_INC_SERVER_CALLS_CREATED() \
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_SERVER_CALLS_CREATED)
+#define GRPC_STATS_INC_CALL_ARENA_OVERFLOWS() \
+  GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_CALL_ARENA_OVERFLOWS)
 #define GRPC_STATS_INC_CQS_CREATED() \
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_CQS_CREATED)
 #define GRPC_STATS_INC_CLIENT_CHANNELS_CREATED() \
@@ -220,6 +225,8 @@ typedef enum {
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_TCP_BACKUP_POLLERS_CREATED)
 #define GRPC_STATS_INC_TCP_BACKUP_POLLER_POLLS() \
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_TCP_BACKUP_POLLER_POLLS)
+#define GRPC_STATS_INC_TCP_READ_ZEROCOPY() \
+  GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_TCP_READ_ZEROCOPY)
 #define GRPC_STATS_INC_HTTP2_OP_BATCHES() \
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_HTTP2_OP_BATCHES)
 #define GRPC_STATS_INC_HTTP2_OP_CANCEL() \
@@ -357,6 +364,8 @@ typedef enum {
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_HPACK_SEND_BINARY)
 #define GRPC_STATS_INC_HPACK_SEND_BINARY_BASE64() \
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_HPACK_SEND_BINARY_BASE64)
+#define GRPC_STATS_INC_HPACK_SEND_PRE_ENCODED() \
+  GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_HPACK_SEND_PRE_ENCODED)
 #define GRPC_STATS_INC_COMBINER_LOCKS_INITIATED() \
   GRPC_STATS_INC_COUNTER(GRPC_STATS_COUNTER_COMBINER_LOCKS_INITIATED)
 #define GRPC_STATS_INC_COMBINER_LOCKS_SCHEDULED_ITEMS() \
@@ -438,6 +447,7 @@ void grpc_stats_inc_server_cqs_checked(int value);
 #else
 #define GRPC_STATS_INC_CLIENT_CALLS_CREATED()
 #define GRPC_STATS_INC_SERVER_CALLS_CREATED()
+#define GRPC_STATS_INC_CALL_ARENA_OVERFLOWS()
 #define GRPC_STATS_INC_CQS_CREATED()
 #define GRPC_STATS_INC_CLIENT_CHANNELS_CREATED()
 #define GRPC_STATS_INC_CLIENT_SUBCHANNELS_CREATED()
@@ -457,6 +467,7 @@ void grpc_stats_inc_server_cqs_checked(int value);
 #define GRPC_STATS_INC_SYSCALL_READ()
 #define GRPC_STATS_INC_TCP_BACKUP_POLLERS_CREATED()
 #define GRPC_STATS_INC_TCP_BACKUP_POLLER_POLLS()
+#define GRPC_STATS_INC_TCP_READ_ZEROCOPY()
 #define GRPC_STATS_INC_HTTP2_OP_BATCHES()
 #define GRPC_STATS_INC_HTTP2_OP_CANCEL()
 #define GRPC_STATS_INC_HTTP2_OP_SEND_INITIAL_METADATA()
@@ -515,6 +526,7 @@ void grpc_stats_inc_server_cqs_checked(int value);
 #define GRPC_STATS_INC_HPACK_SEND_HUFFMAN()
 #define GRPC_STATS_INC_HPACK_SEND_BINARY()
 #define GRPC_STATS_INC_HPACK_SEND_BINARY_BASE64()
+#define GRPC_STATS_INC_HPACK_SEND_PRE_ENCODED()
 #define GRPC_STATS_INC_COMBINER_LOCKS_INITIATED()
 #define GRPC_STATS_INC_COMBINER_LOCKS_SCHEDULED_ITEMS()
 #define GRPC_STATS_INC_COMBINER_LOCKS_SCHEDULED_FINAL_ITEMS()
@@ -1,5 +1,6 @@
 client_calls_created_per_iteration:FLOAT,
 server_calls_created_per_iteration:FLOAT,
+call_arena_overflows_per_iteration:FLOAT,
 cqs_created_per_iteration:FLOAT,
 client_channels_created_per_iteration:FLOAT,
 client_subchannels_created_per_iteration:FLOAT,
@@ -19,6 +20,7 @@ syscall_write_per_iteration:FLOAT,
 syscall_read_per_iteration:FLOAT,
 tcp_backup_pollers_created_per_iteration:FLOAT,
 tcp_backup_poller_polls_per_iteration:FLOAT,
+tcp_read_zerocopy_per_iteration:FLOAT,
 http2_op_batches_per_iteration:FLOAT,
 http2_op_cancel_per_iteration:FLOAT,
 http2_op_send_initial_metadata_per_iteration:FLOAT,
@@ -77,6 +79,7 @@ hpack_send_uncompressed_per_iteration:FLOAT,
 hpack_send_huffman_per_iteration:FLOAT,
 hpack_send_binary_per_iteration:FLOAT,
 hpack_send_binary_base64_per_iteration:FLOAT,
+hpack_send_pre_encoded_per_iteration:FLOAT,
 combiner_locks_initiated_per_iteration:FLOAT,
 combiner_locks_scheduled_items_per_iteration:FLOAT,
 combiner_locks_scheduled_final_items_per_iteration:FLOAT,
@@ -0,0 +1,140 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef GRPC_CORE_LIB_GPRPP_MPMCQ_H
+#define GRPC_CORE_LIB_GPRPP_MPMCQ_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+
+#include <grpc/support/log.h>
+
+namespace grpc_core {
+
+// Bounded multiple-producer multiple-consumer lock free queue of pointers,
+// based upon the implementation from Dmitry Vyukov here:
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// Each cell carries a sequence number telling whether it is ready to be
+// written or read on the current lap around the ring, so producers and
+// consumers each claim a cell with a single compare-and-swap.
+template <typename T>
+class MultiProducerMultiConsumerQueue {
+ public:
+  // capacity must be a power of two.
+  explicit MultiProducerMultiConsumerQueue(size_t capacity)
+      : mask_(capacity - 1), cells_(new Cell[capacity]) {
+    GPR_ASSERT(capacity >= 2 && (capacity & mask_) == 0);
+    for (size_t i = 0; i < capacity; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MultiProducerMultiConsumerQueue(const MultiProducerMultiConsumerQueue&) =
+      delete;
+  MultiProducerMultiConsumerQueue& operator=(
+      const MultiProducerMultiConsumerQueue&) = delete;
+
+  // Push an item
+  // Thread safe - can be called from multiple threads concurrently
+  // Returns false, leaving the queue unchanged, if it is full.
+  bool TryPush(T* item) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->item = item;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pop an item (returns NULL if the queue is empty, or if the oldest item is
+  // still being pushed)
+  // Thread safe - can be called from multiple threads concurrently
+  T* TryPop() {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return nullptr;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T* item = cell->item;
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return item;
+  }
+
+  // The number of items pushed and not yet popped, counting pushes that are
+  // still in progress. Only a hint when other threads push or pop
+  // concurrently.
+  size_t ApproximateSize() const {
+    const size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    const size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T* item;
+  };
+
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+  // make sure producers and consumers don't share a cacheline
+  union {
+    char enqueue_padding_[GPR_CACHELINE_SIZE];
+    std::atomic<size_t> enqueue_pos_{0};
+  };
+  union {
+    char dequeue_padding_[GPR_CACHELINE_SIZE];
+    std::atomic<size_t> dequeue_pos_{0};
+  };
+};
+
+}  // namespace grpc_core
+
+#endif /* GRPC_CORE_LIB_GPRPP_MPMCQ_H */
@@ -0,0 +1,149 @@
+//
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef GRPC_CORE_LIB_GPRPP_PER_CPU_H
+#define GRPC_CORE_LIB_GPRPP_PER_CPU_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <memory>
+
+#include <grpc/support/cpu.h>
+#include <grpc/support/log.h>
+
+#include "src/core/lib/gpr/useful.h"
+
+namespace grpc_core {
+
+// One T per CPU, up to kMaxShards, each on cachelines of its own so that
+// threads running on different CPUs and updating their own shard don't
+// bounce a shared cacheline. The shards are value-initialized.
+template <typename T>
+class PerCpu {
+ public:
+  static constexpr size_t kMaxShards = 64;
+
+  PerCpu() : PerCpu(gpr_cpu_num_cores()) {}
+  // num_shards is clamped to [1, kMaxShards].
+  explicit PerCpu(size_t num_shards)
+      : num_shards_(Clamp(num_shards, size_t(1), kMaxShards)),
+        shards_(new Shard[num_shards_]()) {}
+
+  PerCpu(const PerCpu&) = delete;
+  PerCpu& operator=(const PerCpu&) = delete;
+
+  // The shard for cpu, which is the CPU the caller runs on, or any stable
+  // approximation of it such as ExecCtx::starting_cpu(). CPUs beyond size()
+  // share shards.
+  T& ForCpu(unsigned cpu) { return shards_[cpu % num_shards_].value; }
+  const T& ForCpu(unsigned cpu) const {
+    return shards_[cpu % num_shards_].value;
+  }
+
+  // Access to all the shards, for initializing or summing them.
+  size_t size() const { return num_shards_; }
+  T& operator[](size_t i) { return shards_[i].value; }
+  const T& operator[](size_t i) const { return shards_[i].value; }
+
+ private:
+  struct Shard {
+    T value;
+    char padding[GPR_CACHELINE_SIZE];
+  };
+
+  const size_t num_shards_;
+  const std::unique_ptr<Shard[]> shards_;
+};
+
+template <typename T>
+constexpr size_t PerCpu<T>::kMaxShards;
+
+// Hands out indexes into a list of items in round robin order, for callers
+// such as LB pickers that run concurrently on many CPUs.
+//
+// All picks start out advancing a single cursor, so callers that pick one at
+// a time get the items strictly in order, whichever CPU they run on. Once
+// concurrent picks have collided on that cursor kContentionThreshold times,
+// each CPU switches to a cursor of its own, so that picks on different CPUs
+// don't bounce a shared cacheline. The cursors start at a random offset,
+// spread evenly around the list.
+//
+// Each cursor goes around the whole list in order, so no item is ever handed
+// out more than num_cursors() times more often than any other.
+class PerCpuRoundRobinIndex {
+ public:
+  // num_items must be positive.
+  explicit PerCpuRoundRobinIndex(size_t num_items)
+      : num_items_(num_items),
+        cursors_(num_items == 1 ? 1 : gpr_cpu_num_cores()) {
+    GPR_ASSERT(num_items > 0);
+    // For discussion on why we generate a random starting index,
+    // see https://github.com/grpc/grpc-go/issues/2580.
+    // TODO(roth): rand(3) is not thread-safe.  This should be replaced with
+    // something better as part of https://github.com/grpc/grpc/issues/17891.
+    const size_t start = static_cast<size_t>(rand());
+    for (size_t i = 0; i < cursors_.size(); i++) {
+      cursors_[i].store(start + i * num_items_ / cursors_.size(),
+                        std::memory_order_relaxed);
+    }
+  }
+
+  PerCpuRoundRobinIndex(const PerCpuRoundRobinIndex&) = delete;
+  PerCpuRoundRobinIndex& operator=(const PerCpuRoundRobinIndex&) = delete;
+
+  // cpu is the CPU the caller runs on, or any stable approximation of it
+  // such as ExecCtx::starting_cpu().
+  size_t Next(unsigned cpu) { return NextSequence(cpu) % num_items_; }
+
+  // Returns the position of the cursor in use and advances it, for callers
+  // that also need to know how many times the cursor went around the list.
+  size_t NextSequence(unsigned cpu) {
+    if (!per_cpu_.load(std::memory_order_relaxed)) {
+      std::atomic<size_t>& next = cursors_[0];
+      size_t sequence = next.load(std::memory_order_relaxed);
+      if (next.compare_exchange_strong(sequence, sequence + 1,
+                                       std::memory_order_relaxed)) {
+        return sequence;
+      }
+      // Another pick advanced the cursor in between.
+      if (collisions_.fetch_add(1, std::memory_order_relaxed) + 1 >=
+          kContentionThreshold) {
+        per_cpu_.store(true, std::memory_order_relaxed);
+      }
+      return next.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Threads running on the same CPU may still share a cursor.
+    return cursors_.ForCpu(cpu).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t num_cursors() const { return cursors_.size(); }
+
+ private:
+  static constexpr size_t kContentionThreshold = 16;
+
+  const size_t num_items_;
+  PerCpu<std::atomic<size_t>> cursors_;
+  std::atomic<size_t> collisions_{0};
+  std::atomic<bool> per_cpu_{false};
+};
+
+}  // namespace grpc_core
+
+#endif  // GRPC_CORE_LIB_GPRPP_PER_CPU_H
@@ -0,0 +1,172 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef GRPC_CORE_LIB_GPRPP_RCU_H
+#define GRPC_CORE_LIB_GPRPP_RCU_H
+
+#include <grpc/support/port_platform.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <grpc/support/cpu.h>
+
+#include "src/core/lib/gprpp/per_cpu.h"
+
+namespace grpc_core {
+
+// An owned pointer that a single writer replaces from time to time and that
+// any number of threads read concurrently, in the style of read-copy-update:
+// readers neither lock nor write to any shared cacheline, and never wait.
+//
+// Readers access the value within a ReadGuard. A replaced value is retired
+// rather than destroyed, and is destroyed by Reclaim() only after all the
+// readers that may have seen it are gone. Reclamation tracks epochs: readers
+// count themselves in per-CPU counters of the epoch they entered in, and the
+// writer moves to the next epoch once the readers of the one before the
+// current epoch are gone. A value retired during epoch E can't be seen by
+// readers entering after epoch E + 1 starts, so it is destroyed once epoch
+// E + 2 starts.
+//
+// Publish(), Reclaim() and get() must be serialized by the caller, and values
+// are destroyed by Reclaim() only, so that the writer controls where that
+// happens. When retired values wait for readers to leave, the last of those
+// readers invokes the on_reclaim_wanted callback given at construction, which
+// should arrange for Reclaim() to be called soon.
+template <typename T>
+class RcuPointer {
+ public:
+  class ReadGuard {
+   public:
+    explicit ReadGuard(const RcuPointer* rcu) : rcu_(rcu) {
+      counter_ = rcu_->EnterRead(&epoch_);
+      value_ = rcu_->current_.load(std::memory_order_acquire);
+    }
+    ~ReadGuard() { rcu_->ExitRead(counter_, epoch_); }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    T* get() const { return value_; }
+    T& operator*() const { return *value_; }
+    T* operator->() const { return value_; }
+
+   private:
+    const RcuPointer* const rcu_;
+    std::atomic<intptr_t>* counter_;
+    uint64_t epoch_;
+    T* value_;
+  };
+
+  explicit RcuPointer(std::function<void()> on_reclaim_wanted)
+      : on_reclaim_wanted_(std::move(on_reclaim_wanted)) {}
+
+  // There must be no readers left.
+  ~RcuPointer() { delete current_.load(std::memory_order_relaxed); }
+
+  RcuPointer(const RcuPointer&) = delete;
+  RcuPointer& operator=(const RcuPointer&) = delete;
+
+  // The current value, for the writer, or for readers that hold a lock the
+  // writer holds when publishing.
+  T* get() const { return current_.load(std::memory_order_relaxed); }
+
+  // Makes value the current one, and retires the previous value. New
+  // readers see value once this returns.
+  void Publish(std::unique_ptr<T> value) {
+    T* old = current_.exchange(value.release(), std::memory_order_seq_cst);
+    if (old != nullptr) {
+      retired_.emplace_back(epoch_.load(std::memory_order_relaxed),
+                            std::unique_ptr<T>(old));
+    }
+  }
+
+  // Destroys the retired values that readers can no longer hold.
+  void Reclaim() {
+    while (!retired_.empty()) {
+      const uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+      size_t kept = 0;
+      for (auto& entry : retired_) {
+        if (entry.first + 2 > epoch) retired_[kept++] = std::move(entry);
+      }
+      retired_.resize(kept);
+      if (retired_.empty()) break;
+      // Tell the readers to call for us before checking whether they are
+      // gone, so that either we see the last one leave or it sees this.
+      reclaim_wanted_.store(true, std::memory_order_seq_cst);
+      if (ReadersIn((epoch + 1) & 1) != 0) return;
+      epoch_.store(epoch + 1, std::memory_order_seq_cst);
+    }
+    reclaim_wanted_.store(false, std::memory_order_relaxed);
+  }
+
+ private:
+  // Readers per epoch parity.
+  struct Readers {
+    std::atomic<intptr_t> count[2];
+  };
+
+  std::atomic<intptr_t>* EnterRead(uint64_t* epoch) const {
+    Readers& readers = readers_.ForCpu(gpr_cpu_current_cpu());
+    while (true) {
+      *epoch = epoch_.load(std::memory_order_seq_cst);
+      std::atomic<intptr_t>* counter = &readers.count[*epoch & 1];
+      counter->fetch_add(1, std::memory_order_seq_cst);
+      // If the epoch moved on before we were counted, the writer may have
+      // missed us: count ourselves in the new epoch instead.
+      if (epoch_.load(std::memory_order_seq_cst) == *epoch) return counter;
+      ExitRead(counter, *epoch);
+    }
+  }
+
+  void ExitRead(std::atomic<intptr_t>* counter, uint64_t epoch) const {
+    counter->fetch_sub(1, std::memory_order_seq_cst);
+    // Only readers of a past epoch hold the writer back.
+    if (epoch != epoch_.load(std::memory_order_seq_cst) &&
+        reclaim_wanted_.load(std::memory_order_seq_cst) &&
+        reclaim_wanted_.exchange(false, std::memory_order_acq_rel)) {
+      on_reclaim_wanted_();
+    }
+  }
+
+  intptr_t ReadersIn(size_t parity) const {
+    intptr_t readers = 0;
+    for (size_t i = 0; i < readers_.size(); i++) {
+      readers += readers_[i].count[parity].load(std::memory_order_seq_cst);
+    }
+    return readers;
+  }
+
+  std::atomic<T*> current_{nullptr};
+  std::atomic<uint64_t> epoch_{0};
+  mutable PerCpu<Readers> readers_;
+  mutable std::atomic<bool> reclaim_wanted_{false};
+  const std::function<void()> on_reclaim_wanted_;
+  // Retired values, along with the epoch in which they were retired.
+  std::vector<std::pair<uint64_t, std::unique_ptr<T>>> retired_;
+};
+
+}  // namespace grpc_core
+
+#endif /* GRPC_CORE_LIB_GPRPP_RCU_H */
@@ -20,6 +20,16 @@
 
 #include "src/core/lib/iomgr/endpoint.h"
 
+#include "src/core/lib/iomgr/port.h"
+
+#ifdef GRPC_LINUX_ERRQUEUE
+#include <netinet/in.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "src/core/lib/iomgr/internal_errqueue.h"
+#endif
+
 grpc_core::TraceFlag grpc_tcp_trace(false, "tcp");
 
 void grpc_endpoint_read(grpc_endpoint* ep, grpc_slice_buffer* slices,
@@ -62,6 +72,36 @@ absl::string_view grpc_endpoint_get_local_address(grpc_endpoint* ep) {
 
 int grpc_endpoint_get_fd(grpc_endpoint* ep) { return ep->vtable->get_fd(ep); }
 
+bool grpc_endpoint_get_send_info(grpc_endpoint* ep,
+                                 grpc_endpoint_send_info* info) {
+#ifdef GRPC_LINUX_ERRQUEUE
+  int fd = grpc_endpoint_get_fd(ep);
+  if (fd < 0) return false;
+  grpc_core::tcp_info tcpi;
+  memset(&tcpi, 0, sizeof(tcpi));
+  tcpi.length = offsetof(grpc_core::tcp_info, length);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &tcpi, &tcpi.length) != 0) {
+    return false;
+  }
+  if (tcpi.length <= offsetof(grpc_core::tcp_info, tcpi_pacing_rate)) {
+    return false;
+  }
+  info->cwnd_bytes = tcpi.tcpi_snd_cwnd * tcpi.tcpi_snd_mss;
+  info->pacing_rate =
+      tcpi.tcpi_pacing_rate == UINT64_MAX ? 0 : tcpi.tcpi_pacing_rate;
+  return true;
+#else
+  (void)ep;
+  (void)info;
+  return false;
+#endif
+}
+
 bool grpc_endpoint_can_track_err(grpc_endpoint* ep) {
   return ep->vtable->can_track_err(ep);
 }
+
+void grpc_endpoint_set_channelz_socket_node(
+    grpc_endpoint* ep, grpc_core::channelz::SocketNode* node) {
+  ep->vtable->set_channelz_socket_node(ep, node);
+}
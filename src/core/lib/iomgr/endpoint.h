@@ -30,6 +30,12 @@
 #include "src/core/lib/iomgr/pollset.h"
 #include "src/core/lib/iomgr/pollset_set.h"
 
+namespace grpc_core {
+namespace channelz {
+class SocketNode;
+}  // namespace channelz
+}  // namespace grpc_core
+
 /* An endpoint caps a streaming channel between two communicating processes.
    Examples may be: a tcp socket, <stdin+stdout>, or some shared memory. */
 
@@ -50,6 +56,8 @@ struct grpc_endpoint_vtable {
   absl::string_view (*get_local_address)(grpc_endpoint* ep);
   int (*get_fd)(grpc_endpoint* ep);
   bool (*can_track_err)(grpc_endpoint* ep);
+  void (*set_channelz_socket_node)(grpc_endpoint* ep,
+                                   grpc_core::channelz::SocketNode* node);
 };
 
 /* When data is available on the connection, calls the callback with slices.
@@ -68,6 +76,21 @@ absl::string_view grpc_endpoint_get_local_address(grpc_endpoint* ep);
  */
 int grpc_endpoint_get_fd(grpc_endpoint* ep);
 
+/* Congestion state of the connection underneath an endpoint, as reported by
+   the kernel. */
+struct grpc_endpoint_send_info {
+  /* Bytes the sender may have in flight: congestion window times MSS. */
+  uint32_t cwnd_bytes;
+  /* Pacing rate in bytes per second, or 0 if the connection is not paced. */
+  uint64_t pacing_rate;
+};
+
+/* Fill \a info for \a ep. Returns false if \a ep is not backed by a TCP
+   socket, or the platform does not expose this information (only Linux
+   does). This costs a syscall, so callers should cache the result. */
+bool grpc_endpoint_get_send_info(grpc_endpoint* ep,
+                                 grpc_endpoint_send_info* info);
+
 /* Write slices out to the socket.
 
    If the connection is ready for more data after the end of the call, it
@@ -100,6 +123,12 @@ void grpc_endpoint_delete_from_pollset_set(grpc_endpoint* ep,
 
 bool grpc_endpoint_can_track_err(grpc_endpoint* ep);
 
+/* Lets \a ep report socket level state (such as the decisions made by its
+   tuning heuristics) as options of the channelz socket \a node. The endpoint
+   takes its own reference to \a node. */
+void grpc_endpoint_set_channelz_socket_node(
+    grpc_endpoint* ep, grpc_core::channelz::SocketNode* node);
+
 struct grpc_endpoint {
   const grpc_endpoint_vtable* vtable;
 };
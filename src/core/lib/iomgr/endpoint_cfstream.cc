@@ -304,6 +304,9 @@ int CFStreamGetFD(grpc_endpoint* ep) { return 0; }
 
 bool CFStreamCanTrackErr(grpc_endpoint* ep) { return false; }
 
+void CFStreamSetChannelzSocketNode(grpc_endpoint* ep,
+                                   grpc_core::channelz::SocketNode* node) {}
+
 void CFStreamAddToPollset(grpc_endpoint* ep, grpc_pollset* pollset) {}
 void CFStreamAddToPollsetSet(grpc_endpoint* ep, grpc_pollset_set* pollset) {}
 void CFStreamDeleteFromPollsetSet(grpc_endpoint* ep,
@@ -319,7 +322,8 @@ static const grpc_endpoint_vtable vtable = {CFStreamRead,
                                             CFStreamGetPeer,
                                             CFStreamGetLocalAddress,
                                             CFStreamGetFD,
-                                            CFStreamCanTrackErr};
+                                            CFStreamCanTrackErr,
+                                            CFStreamSetChannelzSocketNode};
 
 grpc_endpoint* grpc_cfstream_endpoint_create(CFReadStreamRef read_stream,
                                              CFWriteStreamRef write_stream,
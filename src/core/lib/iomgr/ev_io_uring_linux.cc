@@ -0,0 +1,1716 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <grpc/support/port_platform.h>
+
+#include <grpc/support/log.h>
+
+#include "src/core/lib/iomgr/port.h"
+
+/* This polling engine is only relevant on linux kernels supporting io_uring
+   multishot poll requests */
+#ifdef GRPC_LINUX_IO_URING
+#include <errno.h>
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+
+#include <grpc/support/alloc.h>
+#include <grpc/support/cpu.h>
+
+#include "src/core/lib/debug/stats.h"
+#include "src/core/lib/gpr/string.h"
+#include "src/core/lib/gpr/tls.h"
+#include "src/core/lib/gpr/useful.h"
+#include "src/core/lib/gprpp/manual_constructor.h"
+#include "src/core/lib/iomgr/block_annotate.h"
+#include "src/core/lib/iomgr/ev_io_uring_linux.h"
+#include "src/core/lib/iomgr/ev_posix.h"
+#include "src/core/lib/iomgr/iomgr_internal.h"
+#include "src/core/lib/iomgr/lockfree_event.h"
+#include "src/core/lib/iomgr/wakeup_fd_posix.h"
+#include "src/core/lib/profiling/timers.h"
+
+static grpc_wakeup_fd global_wakeup_fd;
+
+/*******************************************************************************
+ * Singleton io_uring related fields
+ */
+
+#define MAX_URING_EVENTS 100
+#define MAX_URING_EVENTS_HANDLED_PER_ITERATION 1
+#define URING_ENTRIES 256
+
+/* Every fd (and the global wakeup fd) is watched by a single multishot
+   IORING_OP_POLL_ADD request. Its user_data points at a poll_token, which
+   outlives the grpc_fd's use of the request: tokens are only freed once the
+   request's final completion (one without IORING_CQE_F_MORE) is reaped, so a
+   completion can always be mapped back to its token safely. A request that
+   fails while its fd is in use is not re-armed; its token stays live until
+   the fd is orphaned, and is then retired by the completion of a NOP. */
+struct poll_token {
+  /* nullptr for the global wakeup fd */
+  grpc_fd* fd;
+  int wrapped_fd;
+  bool track_err;
+  /* set (under g_uring.sq_mu) when the owning grpc_fd is orphaned */
+  gpr_atm orphaned;
+  /* set (under g_uring.sq_mu) when the poll request failed before the fd was
+     orphaned */
+  bool failed;
+  poll_token* next;
+  poll_token* prev;
+};
+
+/* A reaped completion */
+struct uring_event {
+  poll_token* token;
+  int32_t res;
+  uint32_t flags;
+};
+
+/* NOTE ON SYNCHRONIZATION:
+ * - The completion queue, and events/num_events/cursor, are only accessed by
+ *   the designated poller, as with the epoll set in ev_epoll1_linux.cc. Hence
+ *   there is no need for any locks to protect them.
+ * - num_events and cursor fields have to be of atomic type to provide memory
+ *   visibility guarantees only. i.e In case of multiple pollers, the designated
+ *   polling thread keeps changing; the thread that wrote these values may be
+ *   different from the thread reading the values
+ * - The submission queue, and the list of live tokens, are shared by every
+ *   thread creating or orphaning fds and are protected by sq_mu.
+ */
+typedef struct uring {
+  int ring_fd;
+
+  gpr_mu sq_mu;
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned sq_mask;
+  unsigned* sq_array;
+  unsigned* sq_flags;
+  struct io_uring_sqe* sqes;
+  /* tokens with a poll request that has not yet delivered its final
+     completion */
+  poll_token* live_tokens;
+  /* tokens whose request has finished, but which may still be referenced by
+     unprocessed entries of events. Only accessed by the designated poller. */
+  poll_token* dead_tokens;
+
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned cq_mask;
+  struct io_uring_cqe* cqes;
+
+  void* sq_ring;
+  size_t sq_ring_size;
+  void* cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+
+  /* The completions reaped by the last call to do_uring_wait() */
+  uring_event events[MAX_URING_EVENTS];
+
+  /* The number of events after the last call to do_uring_wait() */
+  gpr_atm num_events;
+
+  /* Index of the first event in events that has to be processed. This field is
+   * only valid if num_events > 0 */
+  gpr_atm cursor;
+} uring;
+
+/* The global singleton io_uring */
+static uring g_uring;
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params* p) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit,
+                              unsigned min_complete, unsigned flags,
+                              const void* arg, size_t argsz) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                  min_complete, flags, arg, argsz));
+}
+
+static void uring_unmap() {
+  if (g_uring.sqes != nullptr) {
+    munmap(g_uring.sqes, g_uring.sqes_size);
+    g_uring.sqes = nullptr;
+  }
+  if (g_uring.cq_ring != nullptr && g_uring.cq_ring != g_uring.sq_ring) {
+    munmap(g_uring.cq_ring, g_uring.cq_ring_size);
+  }
+  g_uring.cq_ring = nullptr;
+  if (g_uring.sq_ring != nullptr) {
+    munmap(g_uring.sq_ring, g_uring.sq_ring_size);
+    g_uring.sq_ring = nullptr;
+  }
+}
+
+/* Must be called *only* once */
+static bool uring_init() {
+  memset(&g_uring, 0, sizeof(g_uring));
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  g_uring.ring_fd = sys_io_uring_setup(URING_ENTRIES, &params);
+  if (g_uring.ring_fd < 0) {
+    gpr_log(GPR_ERROR, "io_uring_setup unavailable: %s", strerror(errno));
+    return false;
+  }
+  /* EXT_ARG (5.11) is needed for timed waits; RSRC_TAGS shipped in the same
+     release (5.13) as multishot poll requests, which have no feature bit of
+     their own. */
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0 ||
+      (params.features & IORING_FEAT_RSRC_TAGS) == 0) {
+    gpr_log(GPR_ERROR, "io_uring lacks multishot poll support");
+    close(g_uring.ring_fd);
+    g_uring.ring_fd = -1;
+    return false;
+  }
+
+  g_uring.sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  g_uring.cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    g_uring.sq_ring_size = g_uring.cq_ring_size =
+        std::max(g_uring.sq_ring_size, g_uring.cq_ring_size);
+  }
+  g_uring.sq_ring =
+      mmap(nullptr, g_uring.sq_ring_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, g_uring.ring_fd, IORING_OFF_SQ_RING);
+  if (g_uring.sq_ring == MAP_FAILED) {
+    g_uring.sq_ring = nullptr;
+  } else if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    g_uring.cq_ring = g_uring.sq_ring;
+  } else {
+    g_uring.cq_ring =
+        mmap(nullptr, g_uring.cq_ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, g_uring.ring_fd, IORING_OFF_CQ_RING);
+    if (g_uring.cq_ring == MAP_FAILED) g_uring.cq_ring = nullptr;
+  }
+  g_uring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  g_uring.sqes = static_cast<struct io_uring_sqe*>(
+      mmap(nullptr, g_uring.sqes_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, g_uring.ring_fd, IORING_OFF_SQES));
+  if (g_uring.sqes == MAP_FAILED) g_uring.sqes = nullptr;
+  if (g_uring.sq_ring == nullptr || g_uring.cq_ring == nullptr ||
+      g_uring.sqes == nullptr) {
+    gpr_log(GPR_ERROR, "io_uring mmap failed: %s", strerror(errno));
+    uring_unmap();
+    close(g_uring.ring_fd);
+    g_uring.ring_fd = -1;
+    return false;
+  }
+
+  char* sq = static_cast<char*>(g_uring.sq_ring);
+  g_uring.sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  g_uring.sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  g_uring.sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  g_uring.sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  g_uring.sq_flags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+  char* cq = static_cast<char*>(g_uring.cq_ring);
+  g_uring.cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  g_uring.cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  g_uring.cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  g_uring.cqes =
+      reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  gpr_mu_init(&g_uring.sq_mu);
+  gpr_log(GPR_INFO, "grpc io_uring fd: %d", g_uring.ring_fd);
+  gpr_atm_no_barrier_store(&g_uring.num_events, 0);
+  gpr_atm_no_barrier_store(&g_uring.cursor, 0);
+  return true;
+}
+
+/* uring_init() MUST be called before calling this. */
+static void uring_shutdown() {
+  if (g_uring.ring_fd >= 0) {
+    uring_unmap();
+    /* closing the ring cancels every outstanding request */
+    close(g_uring.ring_fd);
+    g_uring.ring_fd = -1;
+    for (poll_token** list : {&g_uring.live_tokens, &g_uring.dead_tokens}) {
+      while (*list != nullptr) {
+        poll_token* token = *list;
+        *list = token->next;
+        gpr_free(token);
+      }
+    }
+    gpr_mu_destroy(&g_uring.sq_mu);
+  }
+}
+
+/* Queue a submission queue entry. g_uring.sq_mu must be held, and
+   uring_submit_locked() called before releasing it. */
+static struct io_uring_sqe* uring_get_sqe_locked(unsigned* pending) {
+  unsigned head = __atomic_load_n(g_uring.sq_head, __ATOMIC_ACQUIRE);
+  unsigned tail = *g_uring.sq_tail + *pending;
+  if (tail - head > g_uring.sq_mask) return nullptr;
+  unsigned index = tail & g_uring.sq_mask;
+  struct io_uring_sqe* sqe = &g_uring.sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  g_uring.sq_array[index] = index;
+  ++*pending;
+  return sqe;
+}
+
+/* Entries published to the submission queue that the kernel has not consumed
+   yet */
+static unsigned uring_unsubmitted() {
+  return __atomic_load_n(g_uring.sq_tail, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(g_uring.sq_head, __ATOMIC_ACQUIRE);
+}
+
+/* Publish the pending entries, and submit them along with any left over by an
+   earlier short submission. */
+static void uring_submit_locked(unsigned pending) {
+  if (pending != 0) {
+    __atomic_store_n(g_uring.sq_tail, *g_uring.sq_tail + pending,
+                     __ATOMIC_RELEASE);
+  }
+  unsigned to_submit;
+  while ((to_submit = uring_unsubmitted()) != 0) {
+    GRPC_STATS_INC_SYSCALL_EPOLL_CTL();
+    int r = sys_io_uring_enter(g_uring.ring_fd, to_submit, 0, 0, nullptr, 0);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) {
+      /* The entries stay queued, and are submitted again by the next call,
+         at the latest once the poller has reaped completions (the kernel
+         refuses submissions with EBUSY while the completion queue is
+         overflowing). */
+      if (r < 0 && errno != EBUSY && errno != EAGAIN) {
+        gpr_log(GPR_ERROR, "io_uring_enter failed: %s", strerror(errno));
+      }
+      return;
+    }
+  }
+}
+
+static void prep_poll_add(struct io_uring_sqe* sqe, poll_token* token) {
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = token->wrapped_fd;
+  sqe->poll32_events = EPOLLIN | EPOLLOUT | EPOLLET;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = reinterpret_cast<uint64_t>(token);
+}
+
+/* Arm a multishot poll request for token. g_uring.sq_mu must be held. */
+static void uring_arm_locked(poll_token* token, unsigned* pending) {
+  struct io_uring_sqe* sqe = uring_get_sqe_locked(pending);
+  if (sqe == nullptr) {
+    uring_submit_locked(*pending);
+    *pending = 0;
+    sqe = uring_get_sqe_locked(pending);
+  }
+  prep_poll_add(sqe, token);
+}
+
+static poll_token* uring_watch(grpc_fd* fd, int wrapped_fd, bool track_err) {
+  poll_token* token =
+      static_cast<poll_token*>(gpr_malloc(sizeof(poll_token)));
+  token->fd = fd;
+  token->wrapped_fd = wrapped_fd;
+  token->track_err = track_err;
+  gpr_atm_no_barrier_store(&token->orphaned, 0);
+  token->failed = false;
+  token->prev = nullptr;
+  gpr_mu_lock(&g_uring.sq_mu);
+  token->next = g_uring.live_tokens;
+  if (token->next != nullptr) token->next->prev = token;
+  g_uring.live_tokens = token;
+  unsigned pending = 0;
+  uring_arm_locked(token, &pending);
+  uring_submit_locked(pending);
+  gpr_mu_unlock(&g_uring.sq_mu);
+  return token;
+}
+
+/* Cancel token's poll request. The token itself is freed when the request's
+   final completion is reaped, or, if the request has already failed, the
+   completion of a NOP standing in for it. */
+static void uring_unwatch(poll_token* token) {
+  gpr_mu_lock(&g_uring.sq_mu);
+  gpr_atm_no_barrier_store(&token->orphaned, 1);
+  unsigned pending = 0;
+  struct io_uring_sqe* sqe = uring_get_sqe_locked(&pending);
+  if (sqe == nullptr) {
+    /* the queue is full of entries left by short submissions: flush them */
+    uring_submit_locked(pending);
+    sqe = uring_get_sqe_locked(&pending);
+  }
+  if (sqe == nullptr) {
+    gpr_log(GPR_ERROR, "io_uring submission queue full");
+  } else {
+    if (token->failed) {
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = reinterpret_cast<uint64_t>(token);
+    } else {
+      sqe->opcode = IORING_OP_POLL_REMOVE;
+      sqe->fd = -1;
+      sqe->addr = reinterpret_cast<uint64_t>(token);
+      sqe->user_data = 0;
+    }
+    uring_submit_locked(pending);
+  }
+  gpr_mu_unlock(&g_uring.sq_mu);
+}
+
+/* Called for a request's final completion: re-arm the request if it ended
+   while its fd is still in use (e.g. on completion queue overflow), keep the
+   token if the request failed (process_uring_events() reports the failure to
+   the fd), otherwise retire the token. g_uring.sq_mu must be held. */
+static void uring_request_done_locked(poll_token* token, int32_t res,
+                                      unsigned* pending) {
+  if (!gpr_atm_no_barrier_load(&token->orphaned)) {
+    if (res >= 0) {
+      uring_arm_locked(token, pending);
+    } else {
+      gpr_log(GPR_ERROR, "io_uring poll request for fd %d failed: %s",
+              token->wrapped_fd, strerror(-res));
+      token->failed = true;
+    }
+    return;
+  }
+  if (token->prev != nullptr) {
+    token->prev->next = token->next;
+  } else {
+    g_uring.live_tokens = token->next;
+  }
+  if (token->next != nullptr) token->next->prev = token->prev;
+  token->prev = nullptr;
+  token->next = g_uring.dead_tokens;
+  g_uring.dead_tokens = token;
+}
+
+/*******************************************************************************
+ * Fd Declarations
+ */
+
+/* Only used when GRPC_ENABLE_FORK_SUPPORT=1 */
+struct grpc_fork_fd_list {
+  grpc_fd* fd;
+  grpc_fd* next;
+  grpc_fd* prev;
+};
+
+struct grpc_fd {
+  int fd;
+
+  grpc_core::ManualConstructor<grpc_core::LockfreeEvent> read_closure;
+  grpc_core::ManualConstructor<grpc_core::LockfreeEvent> write_closure;
+  grpc_core::ManualConstructor<grpc_core::LockfreeEvent> error_closure;
+
+  struct grpc_fd* freelist_next;
+
+  /* the poll request watching fd */
+  poll_token* token;
+
+  grpc_iomgr_object iomgr_object;
+
+  /* Only used when GRPC_ENABLE_FORK_SUPPORT=1 */
+  grpc_fork_fd_list* fork_fd_list;
+};
+
+static void fd_global_init(void);
+static void fd_global_shutdown(void);
+
+/*******************************************************************************
+ * Pollset Declarations
+ */
+
+typedef enum { UNKICKED, KICKED, DESIGNATED_POLLER } kick_state;
+
+static const char* kick_state_string(kick_state st) {
+  switch (st) {
+    case UNKICKED:
+      return "UNKICKED";
+    case KICKED:
+      return "KICKED";
+    case DESIGNATED_POLLER:
+      return "DESIGNATED_POLLER";
+  }
+  GPR_UNREACHABLE_CODE(return "UNKNOWN");
+}
+
+struct grpc_pollset_worker {
+  kick_state state;
+  int kick_state_mutator;  // which line of code last changed kick state
+  bool initialized_cv;
+  grpc_pollset_worker* next;
+  grpc_pollset_worker* prev;
+  gpr_cv cv;
+  grpc_closure_list schedule_on_end_work;
+};
+
+#define SET_KICK_STATE(worker, kick_state)   \
+  do {                                       \
+    (worker)->state = (kick_state);          \
+    (worker)->kick_state_mutator = __LINE__; \
+  } while (false)
+
+#define MAX_NEIGHBORHOODS 1024u
+
+typedef struct pollset_neighborhood {
+  union {
+    char pad[GPR_CACHELINE_SIZE];
+    struct {
+      gpr_mu mu;
+      grpc_pollset* active_root;
+    };
+  };
+} pollset_neighborhood;
+
+struct grpc_pollset {
+  gpr_mu mu;
+  pollset_neighborhood* neighborhood;
+  bool reassigning_neighborhood;
+  grpc_pollset_worker* root_worker;
+  bool kicked_without_poller;
+
+  /* Set to true if the pollset is observed to have no workers available to
+     poll */
+  bool seen_inactive;
+  bool shutting_down;             /* Is the pollset shutting down ? */
+  grpc_closure* shutdown_closure; /* Called after shutdown is complete */
+
+  /* Number of workers who are *about-to* attach themselves to the pollset
+   * worker list */
+  int begin_refs;
+
+  grpc_pollset* next;
+  grpc_pollset* prev;
+};
+
+/*******************************************************************************
+ * Pollset-set Declarations
+ */
+
+struct grpc_pollset_set {
+  char unused;
+};
+
+/*******************************************************************************
+ * Common helpers
+ */
+
+static bool append_error(grpc_error_handle* composite, grpc_error_handle error,
+                         const char* desc) {
+  if (error == GRPC_ERROR_NONE) return true;
+  if (*composite == GRPC_ERROR_NONE) {
+    *composite = GRPC_ERROR_CREATE_FROM_COPIED_STRING(desc);
+  }
+  *composite = grpc_error_add_child(*composite, error);
+  return false;
+}
+
+/*******************************************************************************
+ * Fd Definitions
+ */
+
+/* We need to keep a freelist not because of any concerns of malloc performance
+ * but instead so that implementations with multiple threads in (for example)
+ * epoll_wait deal with the race between pollset removal and incoming poll
+ * notifications.
+ *
+ * The problem is that the poller ultimately holds a reference to this
+ * object, so it is very difficult to know when is safe to free it, at least
+ * without some expensive synchronization.
+ *
+ * If we keep the object freelisted, in the worst case losing this race just
+ * becomes a spurious read notification on a reused fd.
+ */
+
+/* The alarm system needs to be able to wakeup 'some poller' sometimes
+ * (specifically when a new alarm needs to be triggered earlier than the next
+ * alarm 'epoch'). This wakeup_fd gives us something to alert on when such a
+ * case occurs. */
+
+static grpc_fd* fd_freelist = nullptr;
+static gpr_mu fd_freelist_mu;
+
+/* Only used when GRPC_ENABLE_FORK_SUPPORT=1 */
+static grpc_fd* fork_fd_list_head = nullptr;
+static gpr_mu fork_fd_list_mu;
+
+static void fd_global_init(void) { gpr_mu_init(&fd_freelist_mu); }
+
+static void fd_global_shutdown(void) {
+  // TODO(guantaol): We don't have a reasonable explanation about this
+  // lock()/unlock() pattern. It can be a valid barrier if there is at most one
+  // pending lock() at this point. Otherwise, there is still a possibility of
+  // use-after-free race. Need to reason about the code and/or clean it up.
+  gpr_mu_lock(&fd_freelist_mu);
+  gpr_mu_unlock(&fd_freelist_mu);
+  while (fd_freelist != nullptr) {
+    grpc_fd* fd = fd_freelist;
+    fd_freelist = fd_freelist->freelist_next;
+    gpr_free(fd);
+  }
+  gpr_mu_destroy(&fd_freelist_mu);
+}
+
+static void fork_fd_list_add_grpc_fd(grpc_fd* fd) {
+  if (grpc_core::Fork::Enabled()) {
+    gpr_mu_lock(&fork_fd_list_mu);
+    fd->fork_fd_list =
+        static_cast<grpc_fork_fd_list*>(gpr_malloc(sizeof(grpc_fork_fd_list)));
+    fd->fork_fd_list->next = fork_fd_list_head;
+    fd->fork_fd_list->prev = nullptr;
+    if (fork_fd_list_head != nullptr) {
+      fork_fd_list_head->fork_fd_list->prev = fd;
+    }
+    fork_fd_list_head = fd;
+    gpr_mu_unlock(&fork_fd_list_mu);
+  }
+}
+
+static void fork_fd_list_remove_grpc_fd(grpc_fd* fd) {
+  if (grpc_core::Fork::Enabled()) {
+    gpr_mu_lock(&fork_fd_list_mu);
+    if (fork_fd_list_head == fd) {
+      fork_fd_list_head = fd->fork_fd_list->next;
+    }
+    if (fd->fork_fd_list->prev != nullptr) {
+      fd->fork_fd_list->prev->fork_fd_list->next = fd->fork_fd_list->next;
+    }
+    if (fd->fork_fd_list->next != nullptr) {
+      fd->fork_fd_list->next->fork_fd_list->prev = fd->fork_fd_list->prev;
+    }
+    gpr_free(fd->fork_fd_list);
+    gpr_mu_unlock(&fork_fd_list_mu);
+  }
+}
+
+static grpc_fd* fd_create(int fd, const char* name, bool track_err) {
+  grpc_fd* new_fd = nullptr;
+
+  gpr_mu_lock(&fd_freelist_mu);
+  if (fd_freelist != nullptr) {
+    new_fd = fd_freelist;
+    fd_freelist = fd_freelist->freelist_next;
+  }
+  gpr_mu_unlock(&fd_freelist_mu);
+
+  if (new_fd == nullptr) {
+    new_fd = static_cast<grpc_fd*>(gpr_malloc(sizeof(grpc_fd)));
+    new_fd->read_closure.Init();
+    new_fd->write_closure.Init();
+    new_fd->error_closure.Init();
+  }
+  new_fd->fd = fd;
+  new_fd->read_closure->InitEvent();
+  new_fd->write_closure->InitEvent();
+  new_fd->error_closure->InitEvent();
+
+  new_fd->freelist_next = nullptr;
+
+  std::string fd_name = absl::StrCat(name, " fd=", fd);
+  grpc_iomgr_register_object(&new_fd->iomgr_object, fd_name.c_str());
+  fork_fd_list_add_grpc_fd(new_fd);
+#ifndef NDEBUG
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_trace_fd_refcount)) {
+    gpr_log(GPR_DEBUG, "FD %d %p create %s", fd, new_fd, fd_name.c_str());
+  }
+#endif
+
+  /* track_err is kept in the token to avoid synchronization issues when
+   * accessing it after receiving an event. Accessing fd would be a data race
+   * there because the fd might have been returned to the free list at that
+   * point. */
+  new_fd->token = uring_watch(new_fd, fd, track_err);
+
+  return new_fd;
+}
+
+static int fd_wrapped_fd(grpc_fd* fd) { return fd->fd; }
+
+/* if 'releasing_fd' is true, it means that we are going to detach the internal
+ * fd from grpc_fd structure (i.e which means we should not be calling
+ * shutdown() syscall on that fd) */
+static void fd_shutdown_internal(grpc_fd* fd, grpc_error_handle why,
+                                 bool releasing_fd) {
+  if (fd->read_closure->SetShutdown(GRPC_ERROR_REF(why))) {
+    if (!releasing_fd) {
+      shutdown(fd->fd, SHUT_RDWR);
+    }
+    fd->write_closure->SetShutdown(GRPC_ERROR_REF(why));
+    fd->error_closure->SetShutdown(GRPC_ERROR_REF(why));
+  }
+  GRPC_ERROR_UNREF(why);
+}
+
+/* Might be called multiple times */
+static void fd_shutdown(grpc_fd* fd, grpc_error_handle why) {
+  fd_shutdown_internal(fd, why, false);
+}
+
+static void fd_orphan(grpc_fd* fd, grpc_closure* on_done, int* release_fd,
+                      const char* reason) {
+  grpc_error_handle error = GRPC_ERROR_NONE;
+  bool is_release_fd = (release_fd != nullptr);
+
+  if (!fd->read_closure->IsShutdown()) {
+    fd_shutdown_internal(fd, GRPC_ERROR_CREATE_FROM_COPIED_STRING(reason),
+                         is_release_fd);
+  }
+
+  /* The poll request holds its own reference to the file, so it must be
+     cancelled whether or not fd->fd is closed below. */
+  uring_unwatch(fd->token);
+  fd->token = nullptr;
+
+  /* If release_fd is not NULL, we should be relinquishing control of the file
+     descriptor fd->fd (but we still own the grpc_fd structure). */
+  if (is_release_fd) {
+    *release_fd = fd->fd;
+  } else {
+    close(fd->fd);
+  }
+
+  grpc_core::ExecCtx::Run(DEBUG_LOCATION, on_done, GRPC_ERROR_REF(error));
+
+  grpc_iomgr_unregister_object(&fd->iomgr_object);
+  fork_fd_list_remove_grpc_fd(fd);
+  fd->read_closure->DestroyEvent();
+  fd->write_closure->DestroyEvent();
+  fd->error_closure->DestroyEvent();
+
+  gpr_mu_lock(&fd_freelist_mu);
+  fd->freelist_next = fd_freelist;
+  fd_freelist = fd;
+  gpr_mu_unlock(&fd_freelist_mu);
+}
+
+static bool fd_is_shutdown(grpc_fd* fd) {
+  return fd->read_closure->IsShutdown();
+}
+
+static void fd_notify_on_read(grpc_fd* fd, grpc_closure* closure) {
+  fd->read_closure->NotifyOn(closure);
+}
+
+static void fd_notify_on_write(grpc_fd* fd, grpc_closure* closure) {
+  fd->write_closure->NotifyOn(closure);
+}
+
+static void fd_notify_on_error(grpc_fd* fd, grpc_closure* closure) {
+  fd->error_closure->NotifyOn(closure);
+}
+
+static void fd_become_readable(grpc_fd* fd) { fd->read_closure->SetReady(); }
+
+static void fd_become_writable(grpc_fd* fd) { fd->write_closure->SetReady(); }
+
+static void fd_has_errors(grpc_fd* fd) { fd->error_closure->SetReady(); }
+
+/*******************************************************************************
+ * Pollset Definitions
+ */
+
+static GPR_THREAD_LOCAL(grpc_pollset*) g_current_thread_pollset;
+static GPR_THREAD_LOCAL(grpc_pollset_worker*) g_current_thread_worker;
+
+/* The designated poller */
+static gpr_atm g_active_poller;
+
+static pollset_neighborhood* g_neighborhoods;
+static size_t g_num_neighborhoods;
+
+/* Return true if first in list */
+static bool worker_insert(grpc_pollset* pollset, grpc_pollset_worker* worker) {
+  if (pollset->root_worker == nullptr) {
+    pollset->root_worker = worker;
+    worker->next = worker->prev = worker;
+    return true;
+  } else {
+    worker->next = pollset->root_worker;
+    worker->prev = worker->next->prev;
+    worker->next->prev = worker;
+    worker->prev->next = worker;
+    return false;
+  }
+}
+
+/* Return true if last in list */
+typedef enum { EMPTIED, NEW_ROOT, REMOVED } worker_remove_result;
+
+static worker_remove_result worker_remove(grpc_pollset* pollset,
+                                          grpc_pollset_worker* worker) {
+  if (worker == pollset->root_worker) {
+    if (worker == worker->next) {
+      pollset->root_worker = nullptr;
+      return EMPTIED;
+    } else {
+      pollset->root_worker = worker->next;
+      worker->prev->next = worker->next;
+      worker->next->prev = worker->prev;
+      return NEW_ROOT;
+    }
+  } else {
+    worker->prev->next = worker->next;
+    worker->next->prev = worker->prev;
+    return REMOVED;
+  }
+}
+
+static size_t choose_neighborhood(void) {
+  return static_cast<size_t>(gpr_cpu_current_cpu()) % g_num_neighborhoods;
+}
+
+static grpc_error_handle pollset_global_init(void) {
+  gpr_atm_no_barrier_store(&g_active_poller, 0);
+  global_wakeup_fd.read_fd = -1;
+  grpc_error_handle err = grpc_wakeup_fd_init(&global_wakeup_fd);
+  if (err != GRPC_ERROR_NONE) return err;
+  uring_watch(nullptr, global_wakeup_fd.read_fd, false);
+  g_num_neighborhoods =
+      grpc_core::Clamp(gpr_cpu_num_cores(), 1u, MAX_NEIGHBORHOODS);
+  g_neighborhoods = static_cast<pollset_neighborhood*>(
+      gpr_zalloc(sizeof(*g_neighborhoods) * g_num_neighborhoods));
+  for (size_t i = 0; i < g_num_neighborhoods; i++) {
+    gpr_mu_init(&g_neighborhoods[i].mu);
+  }
+  return GRPC_ERROR_NONE;
+}
+
+static void pollset_global_shutdown(void) {
+  if (global_wakeup_fd.read_fd != -1) grpc_wakeup_fd_destroy(&global_wakeup_fd);
+  for (size_t i = 0; i < g_num_neighborhoods; i++) {
+    gpr_mu_destroy(&g_neighborhoods[i].mu);
+  }
+  gpr_free(g_neighborhoods);
+}
+
+static void pollset_init(grpc_pollset* pollset, gpr_mu** mu) {
+  gpr_mu_init(&pollset->mu);
+  *mu = &pollset->mu;
+  pollset->neighborhood = &g_neighborhoods[choose_neighborhood()];
+  pollset->reassigning_neighborhood = false;
+  pollset->root_worker = nullptr;
+  pollset->kicked_without_poller = false;
+  pollset->seen_inactive = true;
+  pollset->shutting_down = false;
+  pollset->shutdown_closure = nullptr;
+  pollset->begin_refs = 0;
+  pollset->next = pollset->prev = nullptr;
+}
+
+static void pollset_destroy(grpc_pollset* pollset) {
+  gpr_mu_lock(&pollset->mu);
+  if (!pollset->seen_inactive) {
+    pollset_neighborhood* neighborhood = pollset->neighborhood;
+    gpr_mu_unlock(&pollset->mu);
+  retry_lock_neighborhood:
+    gpr_mu_lock(&neighborhood->mu);
+    gpr_mu_lock(&pollset->mu);
+    if (!pollset->seen_inactive) {
+      if (pollset->neighborhood != neighborhood) {
+        gpr_mu_unlock(&neighborhood->mu);
+        neighborhood = pollset->neighborhood;
+        gpr_mu_unlock(&pollset->mu);
+        goto retry_lock_neighborhood;
+      }
+      pollset->prev->next = pollset->next;
+      pollset->next->prev = pollset->prev;
+      if (pollset == pollset->neighborhood->active_root) {
+        pollset->neighborhood->active_root =
+            pollset->next == pollset ? nullptr : pollset->next;
+      }
+    }
+    gpr_mu_unlock(&pollset->neighborhood->mu);
+  }
+  gpr_mu_unlock(&pollset->mu);
+  gpr_mu_destroy(&pollset->mu);
+}
+
+static grpc_error_handle pollset_kick_all(grpc_pollset* pollset) {
+  GPR_TIMER_SCOPE("pollset_kick_all", 0);
+  grpc_error_handle error = GRPC_ERROR_NONE;
+  if (pollset->root_worker != nullptr) {
+    grpc_pollset_worker* worker = pollset->root_worker;
+    do {
+      GRPC_STATS_INC_POLLSET_KICK();
+      switch (worker->state) {
+        case KICKED:
+          GRPC_STATS_INC_POLLSET_KICKED_AGAIN();
+          break;
+        case UNKICKED:
+          SET_KICK_STATE(worker, KICKED);
+          if (worker->initialized_cv) {
+            GRPC_STATS_INC_POLLSET_KICK_WAKEUP_CV();
+            gpr_cv_signal(&worker->cv);
+          }
+          break;
+        case DESIGNATED_POLLER:
+          GRPC_STATS_INC_POLLSET_KICK_WAKEUP_FD();
+          SET_KICK_STATE(worker, KICKED);
+          append_error(&error, grpc_wakeup_fd_wakeup(&global_wakeup_fd),
+                       "pollset_kick_all");
+          break;
+      }
+
+      worker = worker->next;
+    } while (worker != pollset->root_worker);
+  }
+  // TODO(sreek): Check if we need to set 'kicked_without_poller' to true here
+  // in the else case
+  return error;
+}
+
+static void pollset_maybe_finish_shutdown(grpc_pollset* pollset) {
+  if (pollset->shutdown_closure != nullptr && pollset->root_worker == nullptr &&
+      pollset->begin_refs == 0) {
+    GPR_TIMER_MARK("pollset_finish_shutdown", 0);
+    grpc_core::ExecCtx::Run(DEBUG_LOCATION, pollset->shutdown_closure,
+                            GRPC_ERROR_NONE);
+    pollset->shutdown_closure = nullptr;
+  }
+}
+
+static void pollset_shutdown(grpc_pollset* pollset, grpc_closure* closure) {
+  GPR_TIMER_SCOPE("pollset_shutdown", 0);
+  GPR_ASSERT(pollset->shutdown_closure == nullptr);
+  GPR_ASSERT(!pollset->shutting_down);
+  pollset->shutdown_closure = closure;
+  pollset->shutting_down = true;
+  GRPC_LOG_IF_ERROR("pollset_shutdown", pollset_kick_all(pollset));
+  pollset_maybe_finish_shutdown(pollset);
+}
+
+static int poll_deadline_to_millis_timeout(grpc_millis millis) {
+  if (millis == GRPC_MILLIS_INF_FUTURE) return -1;
+  grpc_millis delta = millis - grpc_core::ExecCtx::Get()->Now();
+  if (delta > INT_MAX) {
+    return INT_MAX;
+  } else if (delta < 0) {
+    return 0;
+  } else {
+    return static_cast<int>(delta);
+  }
+}
+
+/* Process the completions reaped by do_uring_wait() function.
+   - g_uring.cursor points to the index of the first event to be processed
+   - This function then processes up-to MAX_URING_EVENTS_HANDLED_PER_ITERATION
+     and updates the g_uring.cursor
+
+   NOTE ON SYNCRHONIZATION: Similar to do_uring_wait(), this function is only
+   called by g_active_poller thread. So there is no need for synchronization
+   when accessing g_uring.events */
+static grpc_error_handle process_uring_events(grpc_pollset* /*pollset*/) {
+  GPR_TIMER_SCOPE("process_uring_events", 0);
+
+  static const char* err_desc = "process_events";
+  grpc_error_handle error = GRPC_ERROR_NONE;
+  long num_events = gpr_atm_acq_load(&g_uring.num_events);
+  long cursor = gpr_atm_acq_load(&g_uring.cursor);
+  for (int idx = 0;
+       (idx < MAX_URING_EVENTS_HANDLED_PER_ITERATION) && cursor != num_events;
+       idx++) {
+    long c = cursor++;
+    uring_event* ev = &g_uring.events[c];
+    poll_token* token = ev->token;
+    if (ev->res < 0) {
+      /* the fd will not be polled anymore: fail its pending and future
+         notifications */
+      grpc_error_handle poll_error =
+          GRPC_OS_ERROR(-ev->res, "io_uring poll request");
+      if (token->fd == nullptr) {
+        append_error(&error, poll_error, err_desc);
+      } else {
+        fd_shutdown(token->fd, poll_error);
+      }
+      continue;
+    }
+    uint32_t events = static_cast<uint32_t>(ev->res);
+
+    if (token->fd == nullptr) {
+      append_error(&error, grpc_wakeup_fd_consume_wakeup(&global_wakeup_fd),
+                   err_desc);
+    } else {
+      grpc_fd* fd = token->fd;
+      bool track_err = token->track_err;
+      bool cancel = (events & EPOLLHUP) != 0;
+      bool error = (events & EPOLLERR) != 0;
+      bool read_ev = (events & (EPOLLIN | EPOLLPRI)) != 0;
+      bool write_ev = (events & EPOLLOUT) != 0;
+      bool err_fallback = error && !track_err;
+
+      if (error && !err_fallback) {
+        fd_has_errors(fd);
+      }
+
+      if (read_ev || cancel || err_fallback) {
+        fd_become_readable(fd);
+      }
+
+      if (write_ev || cancel || err_fallback) {
+        fd_become_writable(fd);
+      }
+    }
+  }
+  gpr_atm_rel_store(&g_uring.cursor, cursor);
+  return error;
+}
+
+/* Copy completions out of the completion queue into g_uring.events, handling
+   the final completion of each request as it goes. Returns the number of
+   events stored. */
+static int reap_uring_completions() {
+  /* every event of the previous batch has been processed by now */
+  while (g_uring.dead_tokens != nullptr) {
+    poll_token* token = g_uring.dead_tokens;
+    g_uring.dead_tokens = token->next;
+    gpr_free(token);
+  }
+  unsigned head = *g_uring.cq_head;
+  unsigned tail = __atomic_load_n(g_uring.cq_tail, __ATOMIC_ACQUIRE);
+  unsigned pending = 0;
+  bool locked = false;
+  int n = 0;
+  for (; head != tail && n < MAX_URING_EVENTS; head++) {
+    const struct io_uring_cqe* cqe = &g_uring.cqes[head & g_uring.cq_mask];
+    poll_token* token = reinterpret_cast<poll_token*>(cqe->user_data);
+    /* completions of poll removal requests */
+    if (token == nullptr) continue;
+    /* events for fds that are being orphaned are dropped; other events,
+       including one that arrives with a request's final completion, are
+       processed as usual */
+    if (!gpr_atm_no_barrier_load(&token->orphaned)) {
+      g_uring.events[n].token = token;
+      g_uring.events[n].res = cqe->res;
+      g_uring.events[n].flags = cqe->flags;
+      n++;
+    }
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+      if (!locked) {
+        gpr_mu_lock(&g_uring.sq_mu);
+        locked = true;
+      }
+      uring_request_done_locked(token, cqe->res, &pending);
+    }
+  }
+  __atomic_store_n(g_uring.cq_head, head, __ATOMIC_RELEASE);
+  if (!locked && uring_unsubmitted() != 0) {
+    gpr_mu_lock(&g_uring.sq_mu);
+    locked = true;
+  }
+  if (locked) {
+    /* re-arm requests in a single batch, along with any entries an earlier
+       submission left behind */
+    uring_submit_locked(pending);
+    gpr_mu_unlock(&g_uring.sq_mu);
+  }
+  return n;
+}
+
+/* Wait for completions and store them in g_uring.events field. This does not
+   "process" any of the events yet; that is done in process_uring_events().
+   *See process_uring_events() function for more details.
+
+   NOTE ON SYNCHRONIZATION: At any point of time, only the g_active_poller
+   (i.e the designated poller thread) will be calling this function. So there is
+   no need for any synchronization when accesing the completion queue */
+static grpc_error_handle do_uring_wait(grpc_pollset* ps, grpc_millis deadline) {
+  GPR_TIMER_SCOPE("do_uring_wait", 0);
+
+  /* completions that are already queued need no system call */
+  int r = reap_uring_completions();
+  if (r == 0) {
+    int timeout = poll_deadline_to_millis_timeout(deadline);
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (timeout >= 0) {
+      ts.tv_sec = timeout / GPR_MS_PER_SEC;
+      ts.tv_nsec = (timeout % GPR_MS_PER_SEC) * GPR_NS_PER_MS;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    if (timeout != 0) {
+      GRPC_SCHEDULING_START_BLOCKING_REGION;
+    }
+    int e;
+    do {
+      GRPC_STATS_INC_SYSCALL_POLL();
+      e = sys_io_uring_enter(g_uring.ring_fd, 0, timeout == 0 ? 0 : 1,
+                             IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                             &arg, sizeof(arg));
+    } while (e < 0 && errno == EINTR);
+    if (timeout != 0) {
+      GRPC_SCHEDULING_END_BLOCKING_REGION;
+    }
+    if (e < 0 && errno != ETIME && errno != EBUSY) {
+      return GRPC_OS_ERROR(errno, "io_uring_enter");
+    }
+    r = reap_uring_completions();
+  }
+
+  GRPC_STATS_INC_POLL_EVENTS_RETURNED(r);
+
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+    gpr_log(GPR_INFO, "ps: %p poll got %d events", ps, r);
+  }
+
+  gpr_atm_rel_store(&g_uring.num_events, r);
+  gpr_atm_rel_store(&g_uring.cursor, 0);
+
+  return GRPC_ERROR_NONE;
+}
+
+static bool begin_worker(grpc_pollset* pollset, grpc_pollset_worker* worker,
+                         grpc_pollset_worker** worker_hdl,
+                         grpc_millis deadline) {
+  GPR_TIMER_SCOPE("begin_worker", 0);
+  if (worker_hdl != nullptr) *worker_hdl = worker;
+  worker->initialized_cv = false;
+  SET_KICK_STATE(worker, UNKICKED);
+  worker->schedule_on_end_work = (grpc_closure_list)GRPC_CLOSURE_LIST_INIT;
+  pollset->begin_refs++;
+
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+    gpr_log(GPR_INFO, "PS:%p BEGIN_STARTS:%p", pollset, worker);
+  }
+
+  if (pollset->seen_inactive) {
+    // pollset has been observed to be inactive, we need to move back to the
+    // active list
+    bool is_reassigning = false;
+    if (!pollset->reassigning_neighborhood) {
+      is_reassigning = true;
+      pollset->reassigning_neighborhood = true;
+      pollset->neighborhood = &g_neighborhoods[choose_neighborhood()];
+    }
+    pollset_neighborhood* neighborhood = pollset->neighborhood;
+    gpr_mu_unlock(&pollset->mu);
+  // pollset unlocked: state may change (even worker->kick_state)
+  retry_lock_neighborhood:
+    gpr_mu_lock(&neighborhood->mu);
+    gpr_mu_lock(&pollset->mu);
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+      gpr_log(GPR_INFO, "PS:%p BEGIN_REORG:%p kick_state=%s is_reassigning=%d",
+              pollset, worker, kick_state_string(worker->state),
+              is_reassigning);
+    }
+    if (pollset->seen_inactive) {
+      if (neighborhood != pollset->neighborhood) {
+        gpr_mu_unlock(&neighborhood->mu);
+        neighborhood = pollset->neighborhood;
+        gpr_mu_unlock(&pollset->mu);
+        goto retry_lock_neighborhood;
+      }
+
+      /* In the brief time we released the pollset locks above, the worker MAY
+         have been kicked. In this case, the worker should get out of this
+         pollset ASAP and hence this should neither add the pollset to
+         neighborhood nor mark the pollset as active.
+
+         On a side note, the only way a worker's kick state could have changed
+         at this point is if it were "kicked specifically". Since the worker has
+         not added itself to the pollset yet (by calling worker_insert()), it is
+         not visible in the "kick any" path yet */
+      if (worker->state == UNKICKED) {
+        pollset->seen_inactive = false;
+        if (neighborhood->active_root == nullptr) {
+          neighborhood->active_root = pollset->next = pollset->prev = pollset;
+          /* Make this the designated poller if there isn't one already */
+          if (worker->state == UNKICKED &&
+              gpr_atm_no_barrier_cas(&g_active_poller, 0,
+                                     reinterpret_cast<gpr_atm>(worker))) {
+            SET_KICK_STATE(worker, DESIGNATED_POLLER);
+          }
+        } else {
+          pollset->next = neighborhood->active_root;
+          pollset->prev = pollset->next->prev;
+          pollset->next->prev = pollset->prev->next = pollset;
+        }
+      }
+    }
+    if (is_reassigning) {
+      GPR_ASSERT(pollset->reassigning_neighborhood);
+      pollset->reassigning_neighborhood = false;
+    }
+    gpr_mu_unlock(&neighborhood->mu);
+  }
+
+  worker_insert(pollset, worker);
+  pollset->begin_refs--;
+  if (worker->state == UNKICKED && !pollset->kicked_without_poller) {
+    GPR_ASSERT(gpr_atm_no_barrier_load(&g_active_poller) != (gpr_atm)worker);
+    worker->initialized_cv = true;
+    gpr_cv_init(&worker->cv);
+    while (worker->state == UNKICKED && !pollset->shutting_down) {
+      if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+        gpr_log(GPR_INFO, "PS:%p BEGIN_WAIT:%p kick_state=%s shutdown=%d",
+                pollset, worker, kick_state_string(worker->state),
+                pollset->shutting_down);
+      }
+
+      if (gpr_cv_wait(&worker->cv, &pollset->mu,
+                      grpc_millis_to_timespec(deadline, GPR_CLOCK_MONOTONIC)) &&
+          worker->state == UNKICKED) {
+        /* If gpr_cv_wait returns true (i.e a timeout), pretend that the worker
+           received a kick */
+        SET_KICK_STATE(worker, KICKED);
+      }
+    }
+    grpc_core::ExecCtx::Get()->InvalidateNow();
+  }
+
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+    gpr_log(GPR_INFO,
+            "PS:%p BEGIN_DONE:%p kick_state=%s shutdown=%d "
+            "kicked_without_poller: %d",
+            pollset, worker, kick_state_string(worker->state),
+            pollset->shutting_down, pollset->kicked_without_poller);
+  }
+
+  /* We release pollset lock in this function at a couple of places:
+   *   1. Briefly when assigning pollset to a neighborhood
+   *   2. When doing gpr_cv_wait()
+   * It is possible that 'kicked_without_poller' was set to true during (1) and
+   * 'shutting_down' is set to true during (1) or (2). If either of them is
+   * true, this worker cannot do polling */
+  /* TODO(sreek): Perhaps there is a better way to handle kicked_without_poller
+   * case; especially when the worker is the DESIGNATED_POLLER */
+
+  if (pollset->kicked_without_poller) {
+    pollset->kicked_without_poller = false;
+    return false;
+  }
+
+  return worker->state == DESIGNATED_POLLER && !pollset->shutting_down;
+}
+
+static bool check_neighborhood_for_available_poller(
+    pollset_neighborhood* neighborhood) {
+  GPR_TIMER_SCOPE("check_neighborhood_for_available_poller", 0);
+  bool found_worker = false;
+  do {
+    grpc_pollset* inspect = neighborhood->active_root;
+    if (inspect == nullptr) {
+      break;
+    }
+    gpr_mu_lock(&inspect->mu);
+    GPR_ASSERT(!inspect->seen_inactive);
+    grpc_pollset_worker* inspect_worker = inspect->root_worker;
+    if (inspect_worker != nullptr) {
+      do {
+        switch (inspect_worker->state) {
+          case UNKICKED:
+            if (gpr_atm_no_barrier_cas(
+                    &g_active_poller, 0,
+                    reinterpret_cast<gpr_atm>(inspect_worker))) {
+              if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+                gpr_log(GPR_INFO, " .. choose next poller to be %p",
+                        inspect_worker);
+              }
+              SET_KICK_STATE(inspect_worker, DESIGNATED_POLLER);
+              if (inspect_worker->initialized_cv) {
+                GPR_TIMER_MARK("signal worker", 0);
+                GRPC_STATS_INC_POLLSET_KICK_WAKEUP_CV();
+                gpr_cv_signal(&inspect_worker->cv);
+              }
+            } else {
+              if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+                gpr_log(GPR_INFO, " .. beaten to choose next poller");
+              }
+            }
+            // even if we didn't win the cas, there's a worker, we can stop
+            found_worker = true;
+            break;
+          case KICKED:
+            break;
+          case DESIGNATED_POLLER:
+            found_worker = true;  // ok, so someone else found the worker, but
+                                  // we'll accept that
+            break;
+        }
+        inspect_worker = inspect_worker->next;
+      } while (!found_worker && inspect_worker != inspect->root_worker);
+    }
+    if (!found_worker) {
+      if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+        gpr_log(GPR_INFO, " .. mark pollset %p inactive", inspect);
+      }
+      inspect->seen_inactive = true;
+      if (inspect == neighborhood->active_root) {
+        neighborhood->active_root =
+            inspect->next == inspect ? nullptr : inspect->next;
+      }
+      inspect->next->prev = inspect->prev;
+      inspect->prev->next = inspect->next;
+      inspect->next = inspect->prev = nullptr;
+    }
+    gpr_mu_unlock(&inspect->mu);
+  } while (!found_worker);
+  return found_worker;
+}
+
+static void end_worker(grpc_pollset* pollset, grpc_pollset_worker* worker,
+                       grpc_pollset_worker** worker_hdl) {
+  GPR_TIMER_SCOPE("end_worker", 0);
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+    gpr_log(GPR_INFO, "PS:%p END_WORKER:%p", pollset, worker);
+  }
+  if (worker_hdl != nullptr) *worker_hdl = nullptr;
+  /* Make sure we appear kicked */
+  SET_KICK_STATE(worker, KICKED);
+  grpc_closure_list_move(&worker->schedule_on_end_work,
+                         grpc_core::ExecCtx::Get()->closure_list());
+  if (gpr_atm_no_barrier_load(&g_active_poller) ==
+      reinterpret_cast<gpr_atm>(worker)) {
+    if (worker->next != worker && worker->next->state == UNKICKED) {
+      if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+        gpr_log(GPR_INFO, " .. choose next poller to be peer %p", worker);
+      }
+      GPR_ASSERT(worker->next->initialized_cv);
+      gpr_atm_no_barrier_store(&g_active_poller, (gpr_atm)worker->next);
+      SET_KICK_STATE(worker->next, DESIGNATED_POLLER);
+      GRPC_STATS_INC_POLLSET_KICK_WAKEUP_CV();
+      gpr_cv_signal(&worker->next->cv);
+      if (grpc_core::ExecCtx::Get()->HasWork()) {
+        gpr_mu_unlock(&pollset->mu);
+        grpc_core::ExecCtx::Get()->Flush();
+        gpr_mu_lock(&pollset->mu);
+      }
+    } else {
+      gpr_atm_no_barrier_store(&g_active_poller, 0);
+      size_t poller_neighborhood_idx =
+          static_cast<size_t>(pollset->neighborhood - g_neighborhoods);
+      gpr_mu_unlock(&pollset->mu);
+      bool found_worker = false;
+      bool scan_state[MAX_NEIGHBORHOODS];
+      for (size_t i = 0; !found_worker && i < g_num_neighborhoods; i++) {
+        pollset_neighborhood* neighborhood =
+            &g_neighborhoods[(poller_neighborhood_idx + i) %
+                             g_num_neighborhoods];
+        if (gpr_mu_trylock(&neighborhood->mu)) {
+          found_worker = check_neighborhood_for_available_poller(neighborhood);
+          gpr_mu_unlock(&neighborhood->mu);
+          scan_state[i] = true;
+        } else {
+          scan_state[i] = false;
+        }
+      }
+      for (size_t i = 0; !found_worker && i < g_num_neighborhoods; i++) {
+        if (scan_state[i]) continue;
+        pollset_neighborhood* neighborhood =
+            &g_neighborhoods[(poller_neighborhood_idx + i) %
+                             g_num_neighborhoods];
+        gpr_mu_lock(&neighborhood->mu);
+        found_worker = check_neighborhood_for_available_poller(neighborhood);
+        gpr_mu_unlock(&neighborhood->mu);
+      }
+      grpc_core::ExecCtx::Get()->Flush();
+      gpr_mu_lock(&pollset->mu);
+    }
+  } else if (grpc_core::ExecCtx::Get()->HasWork()) {
+    gpr_mu_unlock(&pollset->mu);
+    grpc_core::ExecCtx::Get()->Flush();
+    gpr_mu_lock(&pollset->mu);
+  }
+  if (worker->initialized_cv) {
+    gpr_cv_destroy(&worker->cv);
+  }
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+    gpr_log(GPR_INFO, " .. remove worker");
+  }
+  if (EMPTIED == worker_remove(pollset, worker)) {
+    pollset_maybe_finish_shutdown(pollset);
+  }
+  GPR_ASSERT(gpr_atm_no_barrier_load(&g_active_poller) != (gpr_atm)worker);
+}
+
+/* pollset->po.mu lock must be held by the caller before calling this.
+   The function pollset_work() may temporarily release the lock (pollset->po.mu)
+   during the course of its execution but it will always re-acquire the lock and
+   ensure that it is held by the time the function returns */
+static grpc_error_handle pollset_work(grpc_pollset* ps,
+                                      grpc_pollset_worker** worker_hdl,
+                                      grpc_millis deadline) {
+  GPR_TIMER_SCOPE("pollset_work", 0);
+  grpc_pollset_worker worker;
+  grpc_error_handle error = GRPC_ERROR_NONE;
+  static const char* err_desc = "pollset_work";
+  if (ps->kicked_without_poller) {
+    ps->kicked_without_poller = false;
+    return GRPC_ERROR_NONE;
+  }
+
+  if (begin_worker(ps, &worker, worker_hdl, deadline)) {
+    g_current_thread_pollset = ps;
+    g_current_thread_worker = &worker;
+    GPR_ASSERT(!ps->shutting_down);
+    GPR_ASSERT(!ps->seen_inactive);
+
+    gpr_mu_unlock(&ps->mu); /* unlock */
+    /* This is the designated polling thread at this point and should ideally do
+       polling. However, if there are unprocessed events left from a previous
+       call to do_uring_wait(), skip waiting in this iteration and process the
+       pending events.
+
+       The reason for decoupling do_uring_wait and process_uring_events is to
+       better distribute the work (i.e handling events) across multiple threads
+
+       process_uring_events() returns very quickly: It just queues the work on
+       exec_ctx but does not execute it (the actual exectution or more
+       accurately grpc_core::ExecCtx::Get()->Flush() happens in end_worker()
+       AFTER selecting a designated poller). So we are not waiting long periods
+       without a designated poller */
+    if (gpr_atm_acq_load(&g_uring.cursor) ==
+        gpr_atm_acq_load(&g_uring.num_events)) {
+      append_error(&error, do_uring_wait(ps, deadline), err_desc);
+    }
+    append_error(&error, process_uring_events(ps), err_desc);
+
+    gpr_mu_lock(&ps->mu); /* lock */
+
+    g_current_thread_worker = nullptr;
+  } else {
+    g_current_thread_pollset = ps;
+  }
+  end_worker(ps, &worker, worker_hdl);
+
+  g_current_thread_pollset = nullptr;
+  return error;
+}
+
+static grpc_error_handle pollset_kick(grpc_pollset* pollset,
+                                      grpc_pollset_worker* specific_worker) {
+  GPR_TIMER_SCOPE("pollset_kick", 0);
+  GRPC_STATS_INC_POLLSET_KICK();
+  grpc_error_handle ret_err = GRPC_ERROR_NONE;
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+    std::vector<std::string> log;
+    log.push_back(absl::StrFormat(
+        "PS:%p KICK:%p curps=%p curworker=%p root=%p", pollset, specific_worker,
+        static_cast<void*>(g_current_thread_pollset),
+        static_cast<void*>(g_current_thread_worker), pollset->root_worker));
+    if (pollset->root_worker != nullptr) {
+      log.push_back(absl::StrFormat(
+          " {kick_state=%s next=%p {kick_state=%s}}",
+          kick_state_string(pollset->root_worker->state),
+          pollset->root_worker->next,
+          kick_state_string(pollset->root_worker->next->state)));
+    }
+    if (specific_worker != nullptr) {
+      log.push_back(absl::StrFormat(" worker_kick_state=%s",
+                                    kick_state_string(specific_worker->state)));
+    }
+    gpr_log(GPR_DEBUG, "%s", absl::StrJoin(log, "").c_str());
+  }
+
+  if (specific_worker == nullptr) {
+    if (g_current_thread_pollset != pollset) {
+      grpc_pollset_worker* root_worker = pollset->root_worker;
+      if (root_worker == nullptr) {
+        GRPC_STATS_INC_POLLSET_KICKED_WITHOUT_POLLER();
+        pollset->kicked_without_poller = true;
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+          gpr_log(GPR_INFO, " .. kicked_without_poller");
+        }
+        goto done;
+      }
+      grpc_pollset_worker* next_worker = root_worker->next;
+      if (root_worker->state == KICKED) {
+        GRPC_STATS_INC_POLLSET_KICKED_AGAIN();
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+          gpr_log(GPR_INFO, " .. already kicked %p", root_worker);
+        }
+        SET_KICK_STATE(root_worker, KICKED);
+        goto done;
+      } else if (next_worker->state == KICKED) {
+        GRPC_STATS_INC_POLLSET_KICKED_AGAIN();
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+          gpr_log(GPR_INFO, " .. already kicked %p", next_worker);
+        }
+        SET_KICK_STATE(next_worker, KICKED);
+        goto done;
+      } else if (root_worker == next_worker &&  // only try and wake up a poller
+                                                // if there is no next worker
+                 root_worker ==
+                     reinterpret_cast<grpc_pollset_worker*>(
+                         gpr_atm_no_barrier_load(&g_active_poller))) {
+        GRPC_STATS_INC_POLLSET_KICK_WAKEUP_FD();
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+          gpr_log(GPR_INFO, " .. kicked %p", root_worker);
+        }
+        SET_KICK_STATE(root_worker, KICKED);
+        ret_err = grpc_wakeup_fd_wakeup(&global_wakeup_fd);
+        goto done;
+      } else if (next_worker->state == UNKICKED) {
+        GRPC_STATS_INC_POLLSET_KICK_WAKEUP_CV();
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+          gpr_log(GPR_INFO, " .. kicked %p", next_worker);
+        }
+        GPR_ASSERT(next_worker->initialized_cv);
+        SET_KICK_STATE(next_worker, KICKED);
+        gpr_cv_signal(&next_worker->cv);
+        goto done;
+      } else if (next_worker->state == DESIGNATED_POLLER) {
+        if (root_worker->state != DESIGNATED_POLLER) {
+          if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+            gpr_log(
+                GPR_INFO,
+                " .. kicked root non-poller %p (initialized_cv=%d) (poller=%p)",
+                root_worker, root_worker->initialized_cv, next_worker);
+          }
+          SET_KICK_STATE(root_worker, KICKED);
+          if (root_worker->initialized_cv) {
+            GRPC_STATS_INC_POLLSET_KICK_WAKEUP_CV();
+            gpr_cv_signal(&root_worker->cv);
+          }
+          goto done;
+        } else {
+          GRPC_STATS_INC_POLLSET_KICK_WAKEUP_FD();
+          if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+            gpr_log(GPR_INFO, " .. non-root poller %p (root=%p)", next_worker,
+                    root_worker);
+          }
+          SET_KICK_STATE(next_worker, KICKED);
+          ret_err = grpc_wakeup_fd_wakeup(&global_wakeup_fd);
+          goto done;
+        }
+      } else {
+        GRPC_STATS_INC_POLLSET_KICKED_AGAIN();
+        GPR_ASSERT(next_worker->state == KICKED);
+        SET_KICK_STATE(next_worker, KICKED);
+        goto done;
+      }
+    } else {
+      GRPC_STATS_INC_POLLSET_KICK_OWN_THREAD();
+      if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+        gpr_log(GPR_INFO, " .. kicked while waking up");
+      }
+      goto done;
+    }
+
+    GPR_UNREACHABLE_CODE(goto done);
+  }
+
+  if (specific_worker->state == KICKED) {
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+      gpr_log(GPR_INFO, " .. specific worker already kicked");
+    }
+    goto done;
+  } else if (g_current_thread_worker == specific_worker) {
+    GRPC_STATS_INC_POLLSET_KICK_OWN_THREAD();
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+      gpr_log(GPR_INFO, " .. mark %p kicked", specific_worker);
+    }
+    SET_KICK_STATE(specific_worker, KICKED);
+    goto done;
+  } else if (specific_worker ==
+             reinterpret_cast<grpc_pollset_worker*>(
+                 gpr_atm_no_barrier_load(&g_active_poller))) {
+    GRPC_STATS_INC_POLLSET_KICK_WAKEUP_FD();
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+      gpr_log(GPR_INFO, " .. kick active poller");
+    }
+    SET_KICK_STATE(specific_worker, KICKED);
+    ret_err = grpc_wakeup_fd_wakeup(&global_wakeup_fd);
+    goto done;
+  } else if (specific_worker->initialized_cv) {
+    GRPC_STATS_INC_POLLSET_KICK_WAKEUP_CV();
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+      gpr_log(GPR_INFO, " .. kick waiting worker");
+    }
+    SET_KICK_STATE(specific_worker, KICKED);
+    gpr_cv_signal(&specific_worker->cv);
+    goto done;
+  } else {
+    GRPC_STATS_INC_POLLSET_KICKED_AGAIN();
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_polling_trace)) {
+      gpr_log(GPR_INFO, " .. kick non-waiting worker");
+    }
+    SET_KICK_STATE(specific_worker, KICKED);
+    goto done;
+  }
+done:
+  return ret_err;
+}
+
+static void pollset_add_fd(grpc_pollset* /*pollset*/, grpc_fd* /*fd*/) {}
+
+/*******************************************************************************
+ * Pollset-set Definitions
+ */
+
+static grpc_pollset_set* pollset_set_create(void) {
+  return reinterpret_cast<grpc_pollset_set*>(static_cast<intptr_t>(0xdeafbeef));
+}
+
+static void pollset_set_destroy(grpc_pollset_set* /*pss*/) {}
+
+static void pollset_set_add_fd(grpc_pollset_set* /*pss*/, grpc_fd* /*fd*/) {}
+
+static void pollset_set_del_fd(grpc_pollset_set* /*pss*/, grpc_fd* /*fd*/) {}
+
+static void pollset_set_add_pollset(grpc_pollset_set* /*pss*/,
+                                    grpc_pollset* /*ps*/) {}
+
+static void pollset_set_del_pollset(grpc_pollset_set* /*pss*/,
+                                    grpc_pollset* /*ps*/) {}
+
+static void pollset_set_add_pollset_set(grpc_pollset_set* /*bag*/,
+                                        grpc_pollset_set* /*item*/) {}
+
+static void pollset_set_del_pollset_set(grpc_pollset_set* /*bag*/,
+                                        grpc_pollset_set* /*item*/) {}
+
+/*******************************************************************************
+ * Event engine binding
+ */
+
+static bool is_any_background_poller_thread(void) { return false; }
+
+static void shutdown_background_closure(void) {}
+
+static bool add_closure_to_background_poller(grpc_closure* /*closure*/,
+                                             grpc_error_handle /*error*/) {
+  return false;
+}
+
+static void shutdown_engine(void) {
+  fd_global_shutdown();
+  pollset_global_shutdown();
+  uring_shutdown();
+  if (grpc_core::Fork::Enabled()) {
+    gpr_mu_destroy(&fork_fd_list_mu);
+    grpc_core::Fork::SetResetChildPollingEngineFunc(nullptr);
+  }
+}
+
+static const grpc_event_engine_vtable vtable = {
+    sizeof(grpc_pollset),
+    true,
+    false,
+
+    fd_create,
+    fd_wrapped_fd,
+    fd_orphan,
+    fd_shutdown,
+    fd_notify_on_read,
+    fd_notify_on_write,
+    fd_notify_on_error,
+    fd_become_readable,
+    fd_become_writable,
+    fd_has_errors,
+    fd_is_shutdown,
+
+    pollset_init,
+    pollset_shutdown,
+    pollset_destroy,
+    pollset_work,
+    pollset_kick,
+    pollset_add_fd,
+
+    pollset_set_create,
+    pollset_set_destroy,
+    pollset_set_add_pollset,
+    pollset_set_del_pollset,
+    pollset_set_add_pollset_set,
+    pollset_set_del_pollset_set,
+    pollset_set_add_fd,
+    pollset_set_del_fd,
+
+    is_any_background_poller_thread,
+    shutdown_background_closure,
+    shutdown_engine,
+    add_closure_to_background_poller,
+};
+
+/* Called by the child process's post-fork handler to close open fds, including
+ * the global io_uring fd. This allows gRPC to shutdown in the child process
+ * without interfering with connections or RPCs ongoing in the parent. */
+static void reset_event_manager_on_fork() {
+  gpr_mu_lock(&fork_fd_list_mu);
+  while (fork_fd_list_head != nullptr) {
+    close(fork_fd_list_head->fd);
+    fork_fd_list_head->fd = -1;
+    fork_fd_list_head = fork_fd_list_head->fork_fd_list->next;
+  }
+  gpr_mu_unlock(&fork_fd_list_mu);
+  shutdown_engine();
+  grpc_init_io_uring_linux(true);
+}
+
+/* It is possible that the headers have io_uring but the running kernel doesn't
+ * (or has it disabled, e.g. by seccomp or the io_uring_disabled sysctl).
+ * uring_init() checks for support, so the next polling engine can be picked if
+ * it isn't available */
+const grpc_event_engine_vtable* grpc_init_io_uring_linux(
+    bool explicit_request) {
+  /* Only used when asked for by name (GRPC_POLL_STRATEGY=io_uring) */
+  if (!explicit_request) {
+    return nullptr;
+  }
+
+  if (!grpc_has_wakeup_fd()) {
+    gpr_log(GPR_ERROR, "Skipping io_uring because of no wakeup fd.");
+    return nullptr;
+  }
+
+  if (!uring_init()) {
+    return nullptr;
+  }
+
+  fd_global_init();
+
+  if (!GRPC_LOG_IF_ERROR("pollset_global_init", pollset_global_init())) {
+    fd_global_shutdown();
+    uring_shutdown();
+    return nullptr;
+  }
+
+  if (grpc_core::Fork::Enabled()) {
+    gpr_mu_init(&fork_fd_list_mu);
+    grpc_core::Fork::SetResetChildPollingEngineFunc(
+        reset_event_manager_on_fork);
+  }
+  return &vtable;
+}
+
+#else /* defined(GRPC_LINUX_IO_URING) */
+#if defined(GRPC_POSIX_SOCKET_EV)
+#include "src/core/lib/iomgr/ev_io_uring_linux.h"
+/* If GRPC_LINUX_IO_URING is not defined, it means io_uring is not available.
+ * Return NULL */
+const grpc_event_engine_vtable* grpc_init_io_uring_linux(
+    bool /*explicit_request*/) {
+  return nullptr;
+}
+#endif /* defined(GRPC_POSIX_SOCKET_EV) */
+#endif /* !defined(GRPC_LINUX_IO_URING) */
@@ -139,6 +139,9 @@ int endpoint_get_fd(grpc_endpoint* /* ep */) { return -1; }
 
 bool endpoint_can_track_err(grpc_endpoint* /* ep */) { return false; }
 
+void endpoint_set_channelz_socket_node(
+    grpc_endpoint* /* ep */, grpc_core::channelz::SocketNode* /* node */) {}
+
 grpc_endpoint_vtable grpc_event_engine_endpoint_vtable = {
     endpoint_read,
     endpoint_write,
@@ -150,7 +153,8 @@ grpc_endpoint_vtable grpc_event_engine_endpoint_vtable = {
     endpoint_get_peer,
     endpoint_get_local_address,
     endpoint_get_fd,
-    endpoint_can_track_err};
+    endpoint_can_track_err,
+    endpoint_set_channelz_socket_node};
 
 }  // namespace
 
@@ -0,0 +1,380 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/lib/iomgr/executor/work_stealing_threadpool.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "src/core/lib/gpr/tls.h"
+#include "src/core/lib/gprpp/mpmcq.h"
+
+namespace grpc_core {
+
+namespace {
+
+// Capacity of each worker's local run queue. Must be a power of two.
+constexpr size_t kLocalQueueSize = 256;
+// Maximum number of closures moved from the injection queue to a local run
+// queue at once.
+constexpr size_t kMaxInjectedBatch = 32;
+// Maximum number of consecutive closures run from the LIFO slot before
+// looking at the local run queue, so that closures that keep scheduling each
+// other cannot starve it.
+constexpr int kMaxLifoRunsInARow = 16;
+// A worker with local work still moves closures from the injection queue to
+// its run queue once every this many closures, so that closures added from
+// outside of the pool cannot be starved by closures added from inside of it.
+constexpr int kInjectionPollInterval = 61;
+// Number of rounds an idle worker looks for work before parking.
+constexpr int kSpinRounds = 32;
+
+}  // namespace
+
+class WorkStealingThreadPool::Worker {
+ public:
+  Worker(WorkStealingThreadPool* pool, int index)
+      : pool_(pool),
+        rand_state_(static_cast<uint32_t>(index + 1) * 0x9e3779b9u),
+        run_queue_(kLocalQueueSize) {
+    thd_ = Thread(
+        pool->thd_name_,
+        [](void* th) { static_cast<Worker*>(th)->Run(); }, this, nullptr,
+        pool->thread_options_);
+  }
+
+  void Start() { thd_.Start(); }
+  void Join() { thd_.Join(); }
+
+  // Returns the worker running on the current thread, if any.
+  static Worker* Current() { return current_; }
+  WorkStealingThreadPool* pool() const { return pool_; }
+
+  // Adds a closure from this worker's own thread.
+  void AddLocal(grpc_completion_queue_functor* closure) {
+    grpc_completion_queue_functor* prev = lifo_slot_.exchange(closure);
+    if (prev != nullptr && !PushQueue(prev)) pool_->Inject(prev);
+    pool_->MaybeWakeWorker();
+  }
+
+  // Local run queue, in FIFO order. This worker is its only producer, and
+  // both this worker and thieves consume from it. PushQueue must only be
+  // called from this worker's own thread; returns false if the queue is full.
+  bool PushQueue(grpc_completion_queue_functor* closure) {
+    return run_queue_.TryPush(closure);
+  }
+  grpc_completion_queue_functor* PopQueue() { return run_queue_.TryPop(); }
+  size_t num_queued() const { return run_queue_.ApproximateSize(); }
+
+  int num_pending() const {
+    return static_cast<int>(num_queued()) +
+           (lifo_slot_.load(std::memory_order_relaxed) != nullptr ? 1 : 0);
+  }
+
+ private:
+  void Run();
+  // Returns the next closure to run, or nullptr once the pool is shut down.
+  grpc_completion_queue_functor* NextClosure();
+  // Looks for work outside of this worker's own queues. The LIFO slots of
+  // other workers are only raided if steal_lifo_slots is set, to leave their
+  // owners a chance to run them first.
+  grpc_completion_queue_functor* FindWork(bool steal_lifo_slots);
+  // Takes one closure from victim's run queue, and moves up to half of the
+  // remaining ones to this worker's run queue.
+  grpc_completion_queue_functor* StealFrom(Worker* victim);
+  grpc_completion_queue_functor* Spin();
+  grpc_completion_queue_functor* Park();
+  uint32_t NextRandom() {
+    rand_state_ ^= rand_state_ << 13;
+    rand_state_ ^= rand_state_ >> 17;
+    rand_state_ ^= rand_state_ << 5;
+    return rand_state_;
+  }
+
+  static GPR_THREAD_LOCAL(Worker*) current_;
+
+  WorkStealingThreadPool* const pool_;
+  Thread thd_;
+  std::atomic<grpc_completion_queue_functor*> lifo_slot_{nullptr};
+  // Only accessed from this worker's own thread.
+  int lifo_runs_ = 0;
+  int ticks_ = 0;
+  uint32_t rand_state_;
+
+  MultiProducerMultiConsumerQueue<grpc_completion_queue_functor> run_queue_;
+};
+
+GPR_THREAD_LOCAL(WorkStealingThreadPool::Worker*)
+WorkStealingThreadPool::Worker::current_{nullptr};
+
+void WorkStealingThreadPool::Worker::Run() {
+  current_ = this;
+  grpc_completion_queue_functor* closure;
+  while ((closure = NextClosure()) != nullptr) {
+    closure->functor_run(closure, closure->internal_success);
+  }
+  current_ = nullptr;
+}
+
+grpc_completion_queue_functor* WorkStealingThreadPool::Worker::NextClosure() {
+  grpc_completion_queue_functor* closure;
+  // The closure most recently added from this thread is likely to touch the
+  // same data as the one that just ran.
+  if (lifo_runs_ < kMaxLifoRunsInARow) {
+    closure = lifo_slot_.exchange(nullptr);
+    if (closure != nullptr) {
+      ++lifo_runs_;
+      return closure;
+    }
+  }
+  lifo_runs_ = 0;
+  if (++ticks_ % kInjectionPollInterval == 0) {
+    pool_->MoveInjected(this, kMaxInjectedBatch);
+  }
+  closure = PopQueue();
+  if (closure != nullptr) return closure;
+  closure = lifo_slot_.exchange(nullptr);
+  if (closure != nullptr) return closure;
+  closure = FindWork(/*steal_lifo_slots=*/false);
+  if (closure != nullptr) return closure;
+  closure = Spin();
+  if (closure != nullptr) return closure;
+  return Park();
+}
+
+grpc_completion_queue_functor* WorkStealingThreadPool::Worker::FindWork(
+    bool steal_lifo_slots) {
+  grpc_completion_queue_functor* closure;
+  if (pool_->MoveInjected(this, kMaxInjectedBatch)) {
+    closure = PopQueue();
+    if (closure != nullptr) return closure;
+  }
+  const int n = pool_->num_threads_;
+  const int start = static_cast<int>(NextRandom() % n);
+  for (int i = 0; i < n; ++i) {
+    Worker* victim = pool_->workers_[(start + i) % n];
+    if (victim == this) continue;
+    closure = StealFrom(victim);
+    if (closure != nullptr) return closure;
+  }
+  if (!steal_lifo_slots) return nullptr;
+  for (int i = 0; i < n; ++i) {
+    Worker* victim = pool_->workers_[(start + i) % n];
+    if (victim == this) continue;
+    closure = victim->lifo_slot_.exchange(nullptr);
+    if (closure != nullptr) return closure;
+  }
+  return nullptr;
+}
+
+grpc_completion_queue_functor* WorkStealingThreadPool::Worker::StealFrom(
+    Worker* victim) {
+  grpc_completion_queue_functor* closure = victim->PopQueue();
+  if (closure == nullptr) return nullptr;
+  for (size_t n = victim->num_queued() / 2; n > 0; --n) {
+    grpc_completion_queue_functor* stolen = victim->PopQueue();
+    if (stolen == nullptr) break;
+    if (!PushQueue(stolen)) pool_->Inject(stolen);
+  }
+  return closure;
+}
+
+grpc_completion_queue_functor* WorkStealingThreadPool::Worker::Spin() {
+  // Spinning workers burn CPU, so allow at most half of the pool to spin.
+  if (2 * pool_->num_spinning_.load(std::memory_order_relaxed) >=
+      std::max(pool_->num_threads_, 2)) {
+    return nullptr;
+  }
+  pool_->num_spinning_.fetch_add(1);
+  grpc_completion_queue_functor* closure = nullptr;
+  for (int i = 0; i < kSpinRounds && closure == nullptr; ++i) {
+    std::this_thread::yield();
+    closure = FindWork(/*steal_lifo_slots=*/false);
+  }
+  // Closures added while workers spin do not wake anybody up. If the last
+  // spinning worker found work, there may be more of it, so hand over the
+  // search to a parked worker.
+  if (pool_->num_spinning_.fetch_sub(1) == 1 &&
+      closure != nullptr) {
+    pool_->MaybeWakeWorker();
+  }
+  return closure;
+}
+
+grpc_completion_queue_functor* WorkStealingThreadPool::Worker::Park() {
+  MutexLock lock(&pool_->park_mu_);
+  // See MaybeWakeWorker() for the memory ordering.
+  pool_->num_parked_.fetch_add(1);
+  grpc_completion_queue_functor* closure;
+  while ((closure = FindWork(/*steal_lifo_slots=*/true)) == nullptr) {
+    // On shutdown, wait for the pool to drain: a worker still running a
+    // closure may add more.
+    if (pool_->shutdown_ &&
+        pool_->num_parked_.load(std::memory_order_relaxed) +
+                pool_->num_exited_ ==
+            pool_->num_threads_) {
+      ++pool_->num_exited_;
+      pool_->park_cv_.SignalAll();
+      break;
+    }
+    pool_->park_cv_.Wait(&pool_->park_mu_);
+  }
+  pool_->num_parked_.fetch_sub(1, std::memory_order_relaxed);
+  return closure;
+}
+
+void WorkStealingThreadPool::SharedThreadPoolConstructor() {
+  // All worker threads in thread pool must be joinable.
+  thread_options_.set_joinable(true);
+
+  // Create at least 1 worker thread.
+  if (num_threads_ <= 0) num_threads_ = 1;
+
+  // All workers must exist before any of them starts stealing.
+  workers_ = static_cast<Worker**>(gpr_zalloc(num_threads_ * sizeof(Worker*)));
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i] = new Worker(this, i);
+  }
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i]->Start();
+  }
+}
+
+size_t WorkStealingThreadPool::DefaultStackSize() {
+#if defined(__ANDROID__) || defined(__APPLE__)
+  return 1952 * 1024;
+#else
+  return 64 * 1024;
+#endif
+}
+
+void WorkStealingThreadPool::AssertHasNotBeenShutDown() {
+  // For debug checking purpose, using RELAXED order is sufficient.
+  GPR_DEBUG_ASSERT(!shut_down_.load(std::memory_order_relaxed));
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(int num_threads)
+    : num_threads_(num_threads) {
+  thd_name_ = "WorkStealingWorker";
+  thread_options_ = Thread::Options();
+  thread_options_.set_stack_size(DefaultStackSize());
+  SharedThreadPoolConstructor();
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(int num_threads,
+                                               const char* thd_name)
+    : num_threads_(num_threads), thd_name_(thd_name) {
+  thread_options_ = Thread::Options();
+  thread_options_.set_stack_size(DefaultStackSize());
+  SharedThreadPoolConstructor();
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    int num_threads, const char* thd_name,
+    const Thread::Options& thread_options)
+    : num_threads_(num_threads),
+      thd_name_(thd_name),
+      thread_options_(thread_options) {
+  if (thread_options_.stack_size() == 0) {
+    thread_options_.set_stack_size(DefaultStackSize());
+  }
+  SharedThreadPoolConstructor();
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  // For debug checking purpose, using RELAXED order is sufficient.
+  shut_down_.store(true, std::memory_order_relaxed);
+
+  {
+    MutexLock lock(&park_mu_);
+    shutdown_ = true;
+    park_cv_.SignalAll();
+  }
+
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i]->Join();
+  }
+
+  for (int i = 0; i < num_threads_; ++i) {
+    delete workers_[i];
+  }
+  gpr_free(workers_);
+}
+
+void WorkStealingThreadPool::Add(grpc_completion_queue_functor* closure) {
+  Worker* worker = Worker::Current();
+  if (worker != nullptr && worker->pool() == this) {
+    worker->AddLocal(closure);
+    return;
+  }
+  AssertHasNotBeenShutDown();
+  Inject(closure);
+  MaybeWakeWorker();
+}
+
+void WorkStealingThreadPool::Inject(grpc_completion_queue_functor* closure) {
+  MutexLock lock(&injection_mu_);
+  injection_queue_.push_back(closure);
+  num_injected_.store(injection_queue_.size());
+}
+
+bool WorkStealingThreadPool::MoveInjected(Worker* worker, size_t max_batch) {
+  if (num_injected_.load() == 0) return false;
+  MutexLock lock(&injection_mu_);
+  // Take a fair share, leaving the rest for other workers.
+  size_t n = std::min(max_batch, injection_queue_.size() / num_threads_ + 1);
+  bool moved = false;
+  for (; n > 0 && !injection_queue_.empty(); --n) {
+    if (!worker->PushQueue(injection_queue_.front())) break;
+    injection_queue_.pop_front();
+    moved = true;
+  }
+  num_injected_.store(injection_queue_.size());
+  return moved;
+}
+
+void WorkStealingThreadPool::MaybeWakeWorker() {
+  // The new closure was published with a sequentially consistent store to
+  // num_injected_ or a LIFO slot. Together with the sequentially consistent
+  // accesses in Worker::Spin() and Worker::Park(), this guarantees that
+  // either a parking worker sees the closure, or this sees it parking.
+  if (num_spinning_.load() == 0 && num_parked_.load() > 0) {
+    MutexLock lock(&park_mu_);
+    park_cv_.Signal();
+  }
+}
+
+int WorkStealingThreadPool::num_pending_closures() const {
+  int count = static_cast<int>(num_injected_.load(std::memory_order_relaxed));
+  for (int i = 0; i < num_threads_; ++i) {
+    count += workers_[i]->num_pending();
+  }
+  return count;
+}
+
+int WorkStealingThreadPool::pool_capacity() const { return num_threads_; }
+
+const Thread::Options& WorkStealingThreadPool::thread_options() const {
+  return thread_options_;
+}
+
+const char* WorkStealingThreadPool::thread_name() const { return thd_name_; }
+
+}  // namespace grpc_core
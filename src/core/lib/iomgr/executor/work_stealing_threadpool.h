@@ -0,0 +1,124 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef GRPC_CORE_LIB_IOMGR_EXECUTOR_WORK_STEALING_THREADPOOL_H
+#define GRPC_CORE_LIB_IOMGR_EXECUTOR_WORK_STEALING_THREADPOOL_H
+
+#include <grpc/support/port_platform.h>
+
+#include <atomic>
+#include <deque>
+
+#include <grpc/grpc.h>
+
+#include "src/core/lib/gprpp/sync.h"
+#include "src/core/lib/gprpp/thd.h"
+#include "src/core/lib/iomgr/executor/threadpool.h"
+
+namespace grpc_core {
+
+// A fixed size thread pool that schedules closures by work stealing, rather
+// than through a single shared queue.
+//
+// Each worker owns a bounded local run queue and a single-entry LIFO slot.
+// Closures added from a worker thread of this pool go into that worker's LIFO
+// slot (displacing any previous occupant into its run queue), so a closure
+// that schedules a follow-up has the follow-up run next on the same thread
+// while its data is still in cache. Closures added from outside of the pool
+// go into a shared injection queue. A worker that runs out of local work
+// takes a batch from the injection queue, or steals half of another worker's
+// run queue. Idle workers spin for a bounded number of rounds looking for
+// work before parking, and only a bounded number of workers spin at once.
+//
+// Ordering guarantees are weaker than for ThreadPool: closures added from
+// outside of the pool are started in FIFO order only if the pool has a single
+// worker.
+class WorkStealingThreadPool : public ThreadPoolInterface {
+ public:
+  // Creates a thread pool with size of "num_threads", with default thread name
+  // "WorkStealingWorker" and all thread options set to default. If the given
+  // size is 0 or less, there will be 1 worker thread created inside pool.
+  explicit WorkStealingThreadPool(int num_threads);
+
+  // Same as WorkStealingThreadPool(int num_threads) constructor, except
+  // that it also sets "thd_name" as the name of all threads in the thread pool.
+  WorkStealingThreadPool(int num_threads, const char* thd_name);
+
+  // Same as WorkStealingThreadPool(int num_threads, const char* thd_name)
+  // constructor, except that is also set thread_options for threads.
+  // If the stack size field of the passed in Thread::Options is set to default
+  // value 0, the same default stack size as ThreadPool will be used.
+  WorkStealingThreadPool(int num_threads, const char* thd_name,
+                         const Thread::Options& thread_options);
+
+  // Waits for all pending closures to complete, then shuts down thread pool.
+  ~WorkStealingThreadPool() override;
+
+  // Adds given closure for execution. Never blocks.
+  void Add(grpc_completion_queue_functor* closure) override;
+
+  // Approximate, since closures move between queues concurrently.
+  int num_pending_closures() const override;
+  int pool_capacity() const override;
+  const Thread::Options& thread_options() const override;
+  const char* thread_name() const override;
+
+ private:
+  class Worker;
+
+  void SharedThreadPoolConstructor();
+  size_t DefaultStackSize();
+  void AssertHasNotBeenShutDown();
+
+  void Inject(grpc_completion_queue_functor* closure);
+  // Moves up to max_batch closures from the injection queue to the local run
+  // queue of worker. Returns false if nothing was moved.
+  bool MoveInjected(Worker* worker, size_t max_batch);
+  // Wakes up a parked worker, unless a spinning worker will find the new work
+  // anyway.
+  void MaybeWakeWorker();
+
+  int num_threads_ = 0;
+  const char* thd_name_ = nullptr;
+  Thread::Options thread_options_;
+  Worker** workers_ = nullptr;  // Array of worker threads
+
+  // Closures added from outside of the pool.
+  Mutex injection_mu_;
+  std::deque<grpc_completion_queue_functor*> injection_queue_
+      ABSL_GUARDED_BY(injection_mu_);
+  // Size of injection_queue_, to check for work without taking the lock.
+  std::atomic<size_t> num_injected_{0};
+
+  // Number of workers currently spinning looking for work.
+  std::atomic<int> num_spinning_{0};
+  // Number of workers parked (or about to park) on park_cv_.
+  std::atomic<int> num_parked_{0};
+  Mutex park_mu_;
+  CondVar park_cv_;
+  bool shutdown_ ABSL_GUARDED_BY(park_mu_) = false;
+  // Number of workers that have exited after shutdown.
+  int num_exited_ ABSL_GUARDED_BY(park_mu_) = 0;
+
+  std::atomic<bool> shut_down_{
+      false};  // Destructor has been called if set to true
+};
+
+}  // namespace grpc_core
+
+#endif /* GRPC_CORE_LIB_IOMGR_EXECUTOR_WORK_STEALING_THREADPOOL_H */
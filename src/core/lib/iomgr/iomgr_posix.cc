@@ -22,7 +22,12 @@
 
 #ifdef GRPC_POSIX_SOCKET_IOMGR
 
+#include <string.h>
+
+#include <grpc/support/log.h>
+
 #include "src/core/lib/debug/trace.h"
+#include "src/core/lib/gprpp/global_config.h"
 #include "src/core/lib/iomgr/ev_posix.h"
 #include "src/core/lib/iomgr/iomgr_internal.h"
 #include "src/core/lib/iomgr/resolve_address.h"
@@ -35,9 +40,25 @@
 extern grpc_tcp_server_vtable grpc_posix_tcp_server_vtable;
 extern grpc_tcp_client_vtable grpc_posix_tcp_client_vtable;
 extern grpc_timer_vtable grpc_generic_timer_vtable;
+extern grpc_timer_vtable grpc_wheel_timer_vtable;
 extern grpc_pollset_vtable grpc_posix_pollset_vtable;
 extern grpc_pollset_set_vtable grpc_posix_pollset_set_vtable;
 
+GPR_GLOBAL_CONFIG_DEFINE_STRING(
+    grpc_timer_impl, "generic",
+    "Declares which timer implementation to use: 'generic' (sharded heaps) or "
+    "'wheel' (per-CPU hierarchical timing wheels).")
+
+static grpc_timer_vtable* timer_impl() {
+  grpc_core::UniquePtr<char> value = GPR_GLOBAL_CONFIG_GET(grpc_timer_impl);
+  if (strcmp(value.get(), "wheel") == 0) return &grpc_wheel_timer_vtable;
+  if (strcmp(value.get(), "generic") != 0) {
+    gpr_log(GPR_ERROR, "Unknown timer implementation '%s', using generic",
+            value.get());
+  }
+  return &grpc_generic_timer_vtable;
+}
+
 static void iomgr_platform_init(void) {
   grpc_wakeup_fd_global_init();
   grpc_event_engine_init();
@@ -76,7 +97,7 @@ static grpc_iomgr_platform_vtable vtable = {
 void grpc_set_default_iomgr_platform() {
   grpc_set_tcp_client_impl(&grpc_posix_tcp_client_vtable);
   grpc_set_tcp_server_impl(&grpc_posix_tcp_server_vtable);
-  grpc_set_timer_impl(&grpc_generic_timer_vtable);
+  grpc_set_timer_impl(timer_impl());
   grpc_set_pollset_vtable(&grpc_posix_pollset_vtable);
   grpc_set_pollset_set_vtable(&grpc_posix_pollset_set_vtable);
   grpc_core::SetDNSResolver(grpc_core::NativeDNSResolver::GetOrCreate());
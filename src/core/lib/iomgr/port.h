@@ -56,6 +56,11 @@
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 0, 0)
 #define GRPC_LINUX_ERRQUEUE 1
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(4, 0, 0) */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0)
+/* io_uring multishot poll requests (used by the io_uring polling engine) are
+   available since 5.13. Kernel support is re-checked at runtime. */
+#define GRPC_LINUX_IO_URING 1
+#endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0) */
 #endif /* LINUX_VERSION_CODE */
 #define GRPC_LINUX_MULTIPOLL_WITH_EPOLL 1
 #define GRPC_POSIX_FORK 1
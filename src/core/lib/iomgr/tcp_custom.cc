@@ -308,6 +308,9 @@ static int endpoint_get_fd(grpc_endpoint* /*ep*/) { return -1; }
 
 static bool endpoint_can_track_err(grpc_endpoint* /*ep*/) { return false; }
 
+static void endpoint_set_channelz_socket_node(
+    grpc_endpoint* /*ep*/, grpc_core::channelz::SocketNode* /*node*/) {}
+
 static grpc_endpoint_vtable vtable = {endpoint_read,
                                       endpoint_write,
                                       endpoint_add_to_pollset,
@@ -318,7 +321,8 @@ static grpc_endpoint_vtable vtable = {endpoint_read,
                                       endpoint_get_peer,
                                       endpoint_get_local_address,
                                       endpoint_get_fd,
-                                      endpoint_can_track_err};
+                                      endpoint_can_track_err,
+                                      endpoint_set_channelz_socket_node};
 
 grpc_endpoint* custom_tcp_endpoint_create(grpc_custom_socket* socket,
                                           const char* peer_string) {
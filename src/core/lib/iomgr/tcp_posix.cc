@@ -35,9 +35,12 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#ifdef GRPC_LINUX_ERRQUEUE
+#include <sys/mman.h>
+#endif
 
 #include <algorithm>
-#include <unordered_map>
+#include <string>
 
 #include <grpc/slice.h>
 #include <grpc/support/alloc.h>
@@ -48,6 +51,7 @@
 
 #include "src/core/lib/address_utils/sockaddr_utils.h"
 #include "src/core/lib/channel/channel_args.h"
+#include "src/core/lib/channel/channelz.h"
 #include "src/core/lib/debug/stats.h"
 #include "src/core/lib/debug/trace.h"
 #include "src/core/lib/gpr/string.h"
@@ -58,6 +62,7 @@
 #include "src/core/lib/iomgr/executor.h"
 #include "src/core/lib/iomgr/socket_utils_posix.h"
 #include "src/core/lib/iomgr/tcp_posix.h"
+#include "src/core/lib/iomgr/tcp_zerocopy_send_ctx.h"
 #include "src/core/lib/profiling/timers.h"
 #include "src/core/lib/resource_quota/api.h"
 #include "src/core/lib/resource_quota/memory_quota.h"
@@ -88,277 +93,148 @@
 #define MSG_ZEROCOPY 0x4000000
 #endif
 
-#ifdef GRPC_MSG_IOVLEN_TYPE
-typedef GRPC_MSG_IOVLEN_TYPE msg_iovlen_type;
-#else
-typedef size_t msg_iovlen_type;
+// TCP zero copy receive socket option. As with MSG_ZEROCOPY, we define it here
+// in case the library headers predate it.
+#ifndef TCP_ZEROCOPY_RECEIVE
+#define TCP_ZEROCOPY_RECEIVE 35
+#endif
+
+// Set in a zerocopy completion when the kernel copied the data after all.
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
 #endif
 
 extern grpc_core::TraceFlag grpc_tcp_trace;
 
 namespace grpc_core {
 
-class TcpZerocopySendRecord {
- public:
-  TcpZerocopySendRecord() { grpc_slice_buffer_init(&buf_); }
-
-  ~TcpZerocopySendRecord() {
-    AssertEmpty();
-    grpc_slice_buffer_destroy_internal(&buf_);
-  }
-
-  // Given the slices that we wish to send, and the current offset into the
-  //   slice buffer (indicating which have already been sent), populate an iovec
-  //   array that will be used for a zerocopy enabled sendmsg().
-  msg_iovlen_type PopulateIovs(size_t* unwind_slice_idx,
-                               size_t* unwind_byte_idx, size_t* sending_length,
-                               iovec* iov);
-
-  // A sendmsg() may not be able to send the bytes that we requested at this
-  // time, returning EAGAIN (possibly due to backpressure). In this case,
-  // unwind the offset into the slice buffer so we retry sending these bytes.
-  void UnwindIfThrottled(size_t unwind_slice_idx, size_t unwind_byte_idx) {
-    out_offset_.byte_idx = unwind_byte_idx;
-    out_offset_.slice_idx = unwind_slice_idx;
-  }
-
-  // Update the offset into the slice buffer based on how much we wanted to sent
-  // vs. what sendmsg() actually sent (which may be lower, possibly due to
-  // backpressure).
-  void UpdateOffsetForBytesSent(size_t sending_length, size_t actually_sent);
-
-  // Indicates whether all underlying data has been sent or not.
-  bool AllSlicesSent() { return out_offset_.slice_idx == buf_.count; }
+constexpr int TcpZerocopySendCtx::kDefaultMaxSends;
+constexpr size_t TcpZerocopySendCtx::kDefaultSendBytesThreshold;
+constexpr int TcpZerocopySendCtx::kDefaultAdaptiveMaxSends;
+constexpr size_t TcpZerocopySendCtx::kMinSendBytesThreshold;
+constexpr size_t TcpZerocopySendCtx::kMaxSendBytesThreshold;
+constexpr size_t TcpZerocopySendCtx::kNoSendBytesThreshold;
+constexpr size_t TcpZerocopySendCtx::kMinCopySampleBytes;
+constexpr int TcpZerocopySendCtx::kRetuneCompletions;
+constexpr int TcpZerocopySendCtx::kProbeInterval;
 
-  // Reset this structure for a new tcp_write() with zerocopy.
-  void PrepareForSends(grpc_slice_buffer* slices_to_send) {
-    AssertEmpty();
-    out_offset_.slice_idx = 0;
-    out_offset_.byte_idx = 0;
-    grpc_slice_buffer_swap(slices_to_send, &buf_);
-    Ref();
-  }
-
-  // References: 1 reference per sendmsg(), and 1 for the tcp_write().
-  void Ref() { ref_.fetch_add(1, std::memory_order_relaxed); }
+#ifdef GRPC_LINUX_ERRQUEUE
+// The leading fields of the kernel's struct tcp_zerocopy_receive. Older
+// library headers only declare the first three, and the kernel accepts any
+// prefix of the structure.
+struct TcpZerocopyReceiveArgs {
+  uint64_t address;         // in: address of mapping
+  uint32_t length;          // in/out: number of bytes to map/mapped
+  uint32_t recv_skip_hint;  // out: bytes to copy before the next mappable one
+  uint32_t inq;             // out: bytes remaining in the receive queue
+  int32_t err;              // out: pending socket error
+};
 
-  // Unref: called when we get an error queue notification for a sendmsg(), if a
-  //  sendmsg() failed or when tcp_write() is done.
-  bool Unref() {
-    const intptr_t prior = ref_.fetch_sub(1, std::memory_order_acq_rel);
-    GPR_DEBUG_ASSERT(prior > 0);
-    if (prior == 1) {
-      AllSendsComplete();
-      return true;
-    }
-    return false;
+// Reference count for a slice holding receive buffer pages mapped by
+// TCP_ZEROCOPY_RECEIVE. The pages are unmapped, and the memory quota
+// reservation accounting for them is released, when the slice is destroyed.
+class TcpZerocopyReceiveSliceRefCount : public grpc_slice_refcount {
+ public:
+  TcpZerocopyReceiveSliceRefCount(void* address, size_t length,
+                                  MemoryAllocator::Reservation reservation)
+      : grpc_slice_refcount(Destroy),
+        address_(address),
+        length_(length),
+        reservation_(std::move(reservation)) {}
+
+  static grpc_slice MakeSlice(void* address, size_t length,
+                              MemoryAllocator::Reservation reservation) {
+    grpc_slice slice;
+    slice.refcount = new TcpZerocopyReceiveSliceRefCount(
+        address, length, std::move(reservation));
+    slice.data.refcounted.bytes = static_cast<uint8_t*>(address);
+    slice.data.refcounted.length = length;
+    return slice;
   }
 
  private:
-  struct OutgoingOffset {
-    size_t slice_idx = 0;
-    size_t byte_idx = 0;
-  };
-
-  void AssertEmpty() {
-    GPR_DEBUG_ASSERT(buf_.count == 0);
-    GPR_DEBUG_ASSERT(buf_.length == 0);
-    GPR_DEBUG_ASSERT(ref_.load(std::memory_order_relaxed) == 0);
+  static void Destroy(grpc_slice_refcount* p) {
+    auto* rc = static_cast<TcpZerocopyReceiveSliceRefCount*>(p);
+    munmap(rc->address_, rc->length_);
+    delete rc;
   }
 
-  // When all sendmsg() calls associated with this tcp_write() have been
-  // completed (ie. we have received the notifications for each sequence number
-  // for each sendmsg()) and all reference counts have been dropped, drop our
-  // reference to the underlying data since we no longer need it.
-  void AllSendsComplete() {
-    GPR_DEBUG_ASSERT(ref_.load(std::memory_order_relaxed) == 0);
-    grpc_slice_buffer_reset_and_unref_internal(&buf_);
-  }
-
-  grpc_slice_buffer buf_;
-  std::atomic<intptr_t> ref_{0};
-  OutgoingOffset out_offset_;
+  void* address_;
+  size_t length_;
+  MemoryAllocator::Reservation reservation_;
 };
+#endif /* GRPC_LINUX_ERRQUEUE */
 
-class TcpZerocopySendCtx {
+// Decides when reads should try mapping receive buffer pages with
+// TCP_ZEROCOPY_RECEIVE instead of copying them.
+class TcpZerocopyReceiveCtx {
  public:
-  static constexpr int kDefaultMaxSends = 4;
-  static constexpr size_t kDefaultSendBytesThreshold = 16 * 1024;  // 16KB
-
-  explicit TcpZerocopySendCtx(
-      int max_sends = kDefaultMaxSends,
-      size_t send_bytes_threshold = kDefaultSendBytesThreshold)
-      : max_sends_(max_sends),
-        free_send_records_size_(max_sends),
-        threshold_bytes_(send_bytes_threshold) {
-    send_records_ = static_cast<TcpZerocopySendRecord*>(
-        gpr_malloc(max_sends * sizeof(*send_records_)));
-    free_send_records_ = static_cast<TcpZerocopySendRecord**>(
-        gpr_malloc(max_sends * sizeof(*free_send_records_)));
-    if (send_records_ == nullptr || free_send_records_ == nullptr) {
-      gpr_free(send_records_);
-      gpr_free(free_send_records_);
-      gpr_log(GPR_INFO, "Disabling TCP TX zerocopy due to memory pressure.\n");
-      memory_limited_ = true;
-    } else {
-      for (int idx = 0; idx < max_sends_; ++idx) {
-        new (send_records_ + idx) TcpZerocopySendRecord();
-        free_send_records_[idx] = send_records_ + idx;
-      }
-    }
-  }
+  static constexpr size_t kDefaultRecvBytesThreshold = 128 * 1024;  // 128KB
+  // Upper bound on the bytes mapped by a single read.
+  static constexpr size_t kMaxMapBytes = 16 * 1024 * 1024;  // 16MB
+  // Upper bound on the number of reads skipped after a failed attempt.
+  static constexpr int kMaxBackoff = 64;
 
-  ~TcpZerocopySendCtx() {
-    if (send_records_ != nullptr) {
-      for (int idx = 0; idx < max_sends_; ++idx) {
-        send_records_[idx].~TcpZerocopySendRecord();
-      }
-    }
-    gpr_free(send_records_);
-    gpr_free(free_send_records_);
-  }
-
-  // True if we were unable to allocate the various bookkeeping structures at
-  // transport initialization time. If memory limited, we do not zerocopy.
-  bool memory_limited() const { return memory_limited_; }
-
-  // TCP send zerocopy maintains an implicit sequence number for every
-  // successful sendmsg() with zerocopy enabled; the kernel later gives us an
-  // error queue notification with this sequence number indicating that the
-  // underlying data buffers that we sent can now be released. Once that
-  // notification is received, we can release the buffers associated with this
-  // zerocopy send record. Here, we associate the sequence number with the data
-  // buffers that were sent with the corresponding call to sendmsg().
-  void NoteSend(TcpZerocopySendRecord* record) {
-    record->Ref();
-    AssociateSeqWithSendRecord(last_send_, record);
-    ++last_send_;
-  }
-
-  // If sendmsg() actually failed, though, we need to revert the sequence number
-  // that we speculatively bumped before calling sendmsg(). Note that we bump
-  // this sequence number and perform relevant bookkeeping (see: NoteSend())
-  // *before* calling sendmsg() since, if we called it *after* sendmsg(), then
-  // there is a possible race with the release notification which could occur on
-  // another thread before we do the necessary bookkeeping. Hence, calling
-  // NoteSend() *before* sendmsg() and implementing an undo function is needed.
-  void UndoSend() {
-    --last_send_;
-    if (ReleaseSendRecord(last_send_)->Unref()) {
-      // We should still be holding the ref taken by tcp_write().
-      GPR_DEBUG_ASSERT(0);
-    }
-  }
-
-  // Simply associate this send record (and the underlying sent data buffers)
-  // with the implicit sequence number for this zerocopy sendmsg().
-  void AssociateSeqWithSendRecord(uint32_t seq, TcpZerocopySendRecord* record) {
-    MutexLock guard(&lock_);
-    ctx_lookup_.emplace(seq, record);
-  }
-
-  // Get a send record for a send that we wish to do with zerocopy.
-  TcpZerocopySendRecord* GetSendRecord() {
-    MutexLock guard(&lock_);
-    return TryGetSendRecordLocked();
-  }
-
-  // A given send record corresponds to a single tcp_write() with zerocopy
-  // enabled. This can result in several sendmsg() calls to flush all of the
-  // data to wire. Each sendmsg() takes a reference on the
-  // TcpZerocopySendRecord, and corresponds to a single sequence number.
-  // ReleaseSendRecord releases a reference on TcpZerocopySendRecord for a
-  // single sequence number. This is called either when we receive the relevant
-  // error queue notification (saying that we can discard the underlying
-  // buffers for this sendmsg()) is received from the kernel - or, in case
-  // sendmsg() was unsuccessful to begin with.
-  TcpZerocopySendRecord* ReleaseSendRecord(uint32_t seq) {
-    MutexLock guard(&lock_);
-    return ReleaseSendRecordLocked(seq);
-  }
-
-  // After all the references to a TcpZerocopySendRecord are released, we can
-  // add it back to the pool (of size max_sends_). Note that we can only have
-  // max_sends_ tcp_write() instances with zerocopy enabled in flight at the
-  // same time.
-  void PutSendRecord(TcpZerocopySendRecord* record) {
-    GPR_DEBUG_ASSERT(record >= send_records_ &&
-                     record < send_records_ + max_sends_);
-    MutexLock guard(&lock_);
-    PutSendRecordLocked(record);
-  }
-
-  // Indicate that we are disposing of this zerocopy context. This indicator
-  // will prevent new zerocopy writes from being issued.
-  void Shutdown() { shutdown_.store(true, std::memory_order_release); }
-
-  // Indicates that there are no inflight tcp_write() instances with zerocopy
-  // enabled.
-  bool AllSendRecordsEmpty() {
-    MutexLock guard(&lock_);
-    return free_send_records_size_ == max_sends_;
-  }
+  explicit TcpZerocopyReceiveCtx(
+      size_t recv_bytes_threshold = kDefaultRecvBytesThreshold)
+      : threshold_bytes_(recv_bytes_threshold),
+        page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {}
 
   bool enabled() const { return enabled_; }
 
-  void set_enabled(bool enabled) {
-    GPR_DEBUG_ASSERT(!enabled || !memory_limited());
-    enabled_ = enabled;
-  }
+  void set_enabled(bool enabled) { enabled_ = enabled; }
 
-  // Only use zerocopy if we are sending at least this many bytes. The
-  // additional overhead of reading the error queue for notifications means that
-  // zerocopy is not useful for small transfers.
+  // Only try zerocopy when at least this many bytes are queued: mapping pages
+  // costs page table updates that only pay off for large reads.
   size_t threshold_bytes() const { return threshold_bytes_; }
 
- private:
-  TcpZerocopySendRecord* ReleaseSendRecordLocked(uint32_t seq) {
-    auto iter = ctx_lookup_.find(seq);
-    GPR_DEBUG_ASSERT(iter != ctx_lookup_.end());
-    TcpZerocopySendRecord* record = iter->second;
-    ctx_lookup_.erase(iter);
-    return record;
-  }
-
-  TcpZerocopySendRecord* TryGetSendRecordLocked() {
-    if (shutdown_.load(std::memory_order_acquire)) {
-      return nullptr;
+  // Number of bytes to try mapping, given the number of bytes queued on the
+  // socket, or 0 if this read should copy.
+  size_t MapLength(int inq) {
+    if (!enabled_ || inq <= 0 ||
+        static_cast<size_t>(inq) < std::max(threshold_bytes_, page_size_)) {
+      return 0;
     }
-    if (free_send_records_size_ == 0) {
-      return nullptr;
+    if (skip_attempts_ > 0) {
+      --skip_attempts_;
+      return 0;
     }
-    free_send_records_size_--;
-    return free_send_records_[free_send_records_size_];
+    size_t length = std::min(static_cast<size_t>(inq), kMaxMapBytes);
+    return length - length % page_size_;
   }
 
-  void PutSendRecordLocked(TcpZerocopySendRecord* record) {
-    GPR_DEBUG_ASSERT(free_send_records_size_ < max_sends_);
-    free_send_records_[free_send_records_size_] = record;
-    free_send_records_size_++;
+  // Record whether an attempt mapped anything. Payloads that don't land on
+  // page boundaries (e.g. with small MTUs, or without header split in the NIC)
+  // can never be mapped, so failed attempts back off exponentially.
+  void NoteAttempt(bool mapped) {
+    if (mapped) {
+      backoff_ = 1;
+    } else {
+      skip_attempts_ = backoff_;
+      backoff_ = std::min(2 * backoff_, kMaxBackoff);
+    }
   }
 
-  TcpZerocopySendRecord* send_records_;
-  TcpZerocopySendRecord** free_send_records_;
-  int max_sends_;
-  int free_send_records_size_;
-  Mutex lock_;
-  uint32_t last_send_ = 0;
-  std::atomic<bool> shutdown_{false};
+ private:
   bool enabled_ = false;
-  size_t threshold_bytes_ = kDefaultSendBytesThreshold;
-  std::unordered_map<uint32_t, TcpZerocopySendRecord*> ctx_lookup_;
-  bool memory_limited_ = false;
+  const size_t threshold_bytes_;
+  const size_t page_size_;
+  int backoff_ = 1;
+  int skip_attempts_ = 0;
 };
 
 }  // namespace grpc_core
 
+using grpc_core::TcpZerocopyReceiveCtx;
 using grpc_core::TcpZerocopySendCtx;
 using grpc_core::TcpZerocopySendRecord;
 
 namespace {
 struct grpc_tcp {
-  grpc_tcp(int max_sends, size_t send_bytes_threshold)
-      : tcp_zerocopy_send_ctx(max_sends, send_bytes_threshold) {}
+  grpc_tcp(int max_sends, size_t send_bytes_threshold, bool send_adaptive,
+           size_t recv_bytes_threshold)
+      : tcp_zerocopy_send_ctx(max_sends, send_bytes_threshold, send_adaptive),
+        tcp_zerocopy_receive_ctx(recv_bytes_threshold) {}
   grpc_endpoint base;
   grpc_fd* em_fd;
   int fd;
@@ -423,6 +299,7 @@ struct grpc_tcp {
                                       on errors anymore */
   TcpZerocopySendCtx tcp_zerocopy_send_ctx;
   TcpZerocopySendRecord* current_zerocopy_send = nullptr;
+  TcpZerocopyReceiveCtx tcp_zerocopy_receive_ctx;
 };
 
 struct backup_poller {
@@ -434,6 +311,11 @@ struct backup_poller {
 
 static void ZerocopyDisableAndWaitForRemaining(grpc_tcp* tcp);
 
+static int64_t monotonic_now_ns() {
+  gpr_timespec now = gpr_now(GPR_CLOCK_MONOTONIC);
+  return static_cast<int64_t>(now.tv_sec) * GPR_NS_PER_SEC + now.tv_nsec;
+}
+
 #define BACKUP_POLLER_POLLSET(b) ((grpc_pollset*)((b) + 1))
 
 static grpc_core::Mutex* g_backup_poller_mu = nullptr;
@@ -831,7 +713,96 @@ static void tcp_do_read(grpc_tcp* tcp) {
   TCP_UNREF(tcp, "read");
 }
 
+#ifdef GRPC_LINUX_ERRQUEUE
+/* Try to read the queued data by mapping receive buffer pages into a slice
+   rather than copying them. Returns false, having consumed nothing, if no page
+   could be mapped; the caller then falls back to tcp_do_read(). */
+static bool tcp_do_zerocopy_read(grpc_tcp* tcp) {
+  GPR_TIMER_SCOPE("tcp_do_zerocopy_read", 0);
+  const size_t map_length = tcp->tcp_zerocopy_receive_ctx.MapLength(tcp->inq);
+  if (map_length == 0) return false;
+  void* address = mmap(nullptr, map_length, PROT_READ, MAP_SHARED, tcp->fd, 0);
+  if (address == MAP_FAILED) {
+    gpr_log(GPR_ERROR, "Disabling TCP RX zerocopy: mmap failed: %s",
+            strerror(errno));
+    tcp->tcp_zerocopy_receive_ctx.set_enabled(false);
+    return false;
+  }
+  grpc_core::TcpZerocopyReceiveArgs zc;
+  memset(&zc, 0, sizeof(zc));
+  zc.address = reinterpret_cast<uintptr_t>(address);
+  zc.length = static_cast<uint32_t>(map_length);
+  socklen_t zc_len = sizeof(zc);
+  int err;
+  do {
+    GPR_TIMER_SCOPE("getsockopt(TCP_ZEROCOPY_RECEIVE)", 0);
+    GRPC_STATS_INC_SYSCALL_READ();
+    err = getsockopt(tcp->fd, IPPROTO_TCP, TCP_ZEROCOPY_RECEIVE, &zc, &zc_len);
+  } while (err < 0 && errno == EINTR);
+  if (err < 0 || zc.length == 0) {
+    if (err < 0 && errno != EAGAIN) {
+      gpr_log(GPR_ERROR, "Disabling TCP RX zerocopy: %s", strerror(errno));
+      tcp->tcp_zerocopy_receive_ctx.set_enabled(false);
+    }
+    munmap(address, map_length);
+    tcp->tcp_zerocopy_receive_ctx.NoteAttempt(false);
+    return false;
+  }
+  tcp->tcp_zerocopy_receive_ctx.NoteAttempt(true);
+  GRPC_STATS_INC_TCP_READ_ZEROCOPY();
+  GRPC_STATS_INC_TCP_READ_SIZE(zc.length);
+  if (zc.length < map_length) {
+    munmap(static_cast<char*>(address) + zc.length, map_length - zc.length);
+  }
+
+  /* The buffer space offered by the caller isn't needed for this read: keep it
+     for the next one. */
+  grpc_slice_buffer_move_into(tcp->incoming_buffer, &tcp->last_read_buffer);
+  grpc_slice_buffer_add(
+      tcp->incoming_buffer,
+      grpc_core::TcpZerocopyReceiveSliceRefCount::MakeSlice(
+          address, zc.length, tcp->memory_owner.MakeReservation(zc.length)));
+
+  /* Bytes that follow the mapped pages but end before the next page boundary
+     of the stream must be copied. Read them now so that the next read starts
+     at a mappable position. */
+  size_t copied = 0;
+  if (zc.recv_skip_hint > 0) {
+    grpc_slice slice = tcp->memory_owner.MakeSlice(
+        grpc_core::MemoryRequest(zc.recv_skip_hint));
+    ssize_t read_bytes;
+    do {
+      GRPC_STATS_INC_SYSCALL_READ();
+      read_bytes = recv(tcp->fd, GRPC_SLICE_START_PTR(slice),
+                        GRPC_SLICE_LENGTH(slice), 0);
+    } while (read_bytes < 0 && errno == EINTR);
+    if (read_bytes > 0) {
+      copied = static_cast<size_t>(read_bytes);
+      GRPC_STATS_INC_TCP_READ_SIZE(read_bytes);
+      grpc_slice_buffer_add(tcp->incoming_buffer,
+                            grpc_slice_sub_no_ref(slice, 0, copied));
+    } else {
+      /* Any error is reported by the next read. */
+      grpc_slice_unref_internal(slice);
+    }
+  }
+
+  if (zc_len >=
+      offsetof(grpc_core::TcpZerocopyReceiveArgs, inq) + sizeof(zc.inq)) {
+    tcp->inq = zc.inq > copied ? static_cast<int>(zc.inq - copied) : 0;
+  } else {
+    tcp->inq = 1;
+  }
+  call_read_cb(tcp, GRPC_ERROR_NONE);
+  TCP_UNREF(tcp, "read");
+  return true;
+}
+#endif /* GRPC_LINUX_ERRQUEUE */
+
 static void tcp_continue_read(grpc_tcp* tcp) {
+#ifdef GRPC_LINUX_ERRQUEUE
+  if (tcp_do_zerocopy_read(tcp)) return;
+#endif /* GRPC_LINUX_ERRQUEUE */
   if (tcp->incoming_buffer->length == 0 &&
       tcp->incoming_buffer->count < MAX_READ_IOVEC) {
     if (GRPC_TRACE_FLAG_ENABLED(grpc_tcp_trace)) {
@@ -942,13 +913,18 @@ static TcpZerocopySendRecord* tcp_get_send_zerocopy_record(
   TcpZerocopySendRecord* zerocopy_send_record = nullptr;
   const bool use_zerocopy =
       tcp->tcp_zerocopy_send_ctx.enabled() &&
-      tcp->tcp_zerocopy_send_ctx.threshold_bytes() < buf->length;
+      (tcp->tcp_zerocopy_send_ctx.threshold_bytes() < buf->length ||
+       tcp->tcp_zerocopy_send_ctx.ShouldProbe(buf->length));
   if (use_zerocopy) {
     zerocopy_send_record = tcp->tcp_zerocopy_send_ctx.GetSendRecord();
     if (zerocopy_send_record == nullptr) {
       process_errors(tcp);
       zerocopy_send_record = tcp->tcp_zerocopy_send_ctx.GetSendRecord();
     }
+    if (zerocopy_send_record == nullptr &&
+        tcp->tcp_zerocopy_send_ctx.GrowInflightLimit()) {
+      zerocopy_send_record = tcp->tcp_zerocopy_send_ctx.GetSendRecord();
+    }
     if (zerocopy_send_record != nullptr) {
       zerocopy_send_record->PrepareForSends(buf);
       GPR_DEBUG_ASSERT(buf->count == 0);
@@ -1015,14 +991,17 @@ static bool tcp_write_with_timestamps(grpc_tcp* tcp, struct msghdr* msg,
 static void UnrefMaybePutZerocopySendRecord(grpc_tcp* tcp,
                                             TcpZerocopySendRecord* record,
                                             uint32_t seq, const char* tag);
-// Reads \a cmsg to process zerocopy control messages.
-static void process_zerocopy(grpc_tcp* tcp, struct cmsghdr* cmsg) {
+// Reads \a cmsg to process zerocopy control messages. \a start_ns is when
+// reading the notification began, for the adaptive heuristics.
+static void process_zerocopy(grpc_tcp* tcp, struct cmsghdr* cmsg,
+                             int64_t start_ns) {
   GPR_DEBUG_ASSERT(cmsg);
   auto serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cmsg));
   GPR_DEBUG_ASSERT(serr->ee_errno == 0);
   GPR_DEBUG_ASSERT(serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY);
   const uint32_t lo = serr->ee_info;
   const uint32_t hi = serr->ee_data;
+  const bool copied = (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
   for (uint32_t seq = lo; seq <= hi; ++seq) {
     // TODO(arjunroy): It's likely that lo and hi refer to zerocopy sequence
     // numbers that are generated by a single call to grpc_endpoint_write; ie.
@@ -1033,6 +1012,11 @@ static void process_zerocopy(grpc_tcp* tcp, struct cmsghdr* cmsg) {
     GPR_DEBUG_ASSERT(record);
     UnrefMaybePutZerocopySendRecord(tcp, record, seq, "CALLBACK RCVD");
   }
+  if (tcp->tcp_zerocopy_send_ctx.adaptive()) {
+    const uint32_t count = hi - lo + 1;
+    tcp->tcp_zerocopy_send_ctx.NoteCompletions(
+        count, copied ? count : 0, monotonic_now_ns() - start_ns);
+  }
 }
 
 // Whether the cmsg received from error queue is of the IPv4 or IPv6 levels.
@@ -1136,6 +1120,8 @@ static bool process_errors(grpc_tcp* tcp) {
   int r, saved_errno;
   while (true) {
     msg.msg_controllen = sizeof(aligned_buf.rbuf);
+    const int64_t start_ns =
+        tcp->tcp_zerocopy_send_ctx.adaptive() ? monotonic_now_ns() : 0;
     do {
       r = recvmsg(tcp->fd, &msg, MSG_ERRQUEUE);
       saved_errno = errno;
@@ -1159,7 +1145,7 @@ static bool process_errors(grpc_tcp* tcp) {
     for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg && cmsg->cmsg_len;
          cmsg = CMSG_NXTHDR(&msg, cmsg)) {
       if (CmsgIsZeroCopy(*cmsg)) {
-        process_zerocopy(tcp, cmsg);
+        process_zerocopy(tcp, cmsg, start_ns);
         seen = true;
         processed_err = true;
       } else if (cmsg->cmsg_level == SOL_SOCKET &&
@@ -1338,7 +1324,13 @@ static bool do_tcp_flush_zerocopy(grpc_tcp* tcp, TcpZerocopySendRecord* record,
       msg.msg_controllen = 0;
       GRPC_STATS_INC_TCP_WRITE_SIZE(sending_length);
       GRPC_STATS_INC_TCP_WRITE_IOV_SIZE(iov_size);
+      const int64_t start_ns =
+          tcp->tcp_zerocopy_send_ctx.adaptive() ? monotonic_now_ns() : 0;
       sent_length = tcp_send(tcp->fd, &msg, MSG_ZEROCOPY);
+      if (start_ns != 0 && sent_length > 0) {
+        tcp->tcp_zerocopy_send_ctx.NoteZerocopySend(
+            static_cast<size_t>(sent_length), monotonic_now_ns() - start_ns);
+      }
     }
     if (sent_length < 0) {
       // If this particular send failed, drop ref taken earlier in this method.
@@ -1444,7 +1436,16 @@ static bool tcp_flush(grpc_tcp* tcp, grpc_error_handle* error) {
       GRPC_STATS_INC_TCP_WRITE_SIZE(sending_length);
       GRPC_STATS_INC_TCP_WRITE_IOV_SIZE(iov_size);
 
+      const int64_t start_ns =
+          tcp->tcp_zerocopy_send_ctx.adaptive() &&
+                  sending_length >= TcpZerocopySendCtx::kMinCopySampleBytes
+              ? monotonic_now_ns()
+              : 0;
       sent_length = tcp_send(tcp->fd, &msg);
+      if (start_ns != 0 && sent_length > 0) {
+        tcp->tcp_zerocopy_send_ctx.NoteCopySend(
+            static_cast<size_t>(sent_length), monotonic_now_ns() - start_ns);
+      }
     }
 
     if (sent_length < 0) {
@@ -1646,6 +1647,14 @@ static bool tcp_can_track_err(grpc_endpoint* ep) {
   return addr.sa_family == AF_INET || addr.sa_family == AF_INET6;
 }
 
+static void tcp_set_channelz_socket_node(
+    grpc_endpoint* ep, grpc_core::channelz::SocketNode* node) {
+  grpc_tcp* tcp = reinterpret_cast<grpc_tcp*>(ep);
+  if (node != nullptr) node->Ref().release();
+  tcp->tcp_zerocopy_send_ctx.SetChannelzSocketNode(
+      grpc_core::RefCountedPtr<grpc_core::channelz::SocketNode>(node));
+}
+
 static const grpc_endpoint_vtable vtable = {tcp_read,
                                             tcp_write,
                                             tcp_add_to_pollset,
@@ -1656,7 +1665,8 @@ static const grpc_endpoint_vtable vtable = {tcp_read,
                                             tcp_get_peer,
                                             tcp_get_local_address,
                                             tcp_get_fd,
-                                            tcp_can_track_err};
+                                            tcp_can_track_err,
+                                            tcp_set_channelz_socket_node};
 
 #define MAX_CHUNK_SIZE (32 * 1024 * 1024)
 
@@ -1670,8 +1680,15 @@ grpc_endpoint* grpc_tcp_create(grpc_fd* em_fd,
   bool tcp_tx_zerocopy_enabled = kZerocpTxEnabledDefault;
   int tcp_tx_zerocopy_send_bytes_thresh =
       grpc_core::TcpZerocopySendCtx::kDefaultSendBytesThreshold;
+  bool tcp_tx_zerocopy_send_bytes_thresh_set = false;
   int tcp_tx_zerocopy_max_simult_sends =
       grpc_core::TcpZerocopySendCtx::kDefaultMaxSends;
+  bool tcp_tx_zerocopy_max_simult_sends_set = false;
+  bool tcp_tx_zerocopy_adaptive = true;
+  bool tcp_tx_zerocopy_adaptive_set = false;
+  bool tcp_rx_zerocopy_enabled = false;
+  int tcp_rx_zerocopy_recv_bytes_thresh =
+      grpc_core::TcpZerocopyReceiveCtx::kDefaultRecvBytesThreshold;
   if (channel_args != nullptr) {
     for (size_t i = 0; i < channel_args->num_args; i++) {
       if (0 ==
@@ -1700,12 +1717,30 @@ grpc_endpoint* grpc_tcp_create(grpc_fd* em_fd,
             INT_MAX};
         tcp_tx_zerocopy_send_bytes_thresh =
             grpc_channel_arg_get_integer(&channel_args->args[i], options);
+        tcp_tx_zerocopy_send_bytes_thresh_set = true;
       } else if (0 == strcmp(channel_args->args[i].key,
                              GRPC_ARG_TCP_TX_ZEROCOPY_MAX_SIMULT_SENDS)) {
         grpc_integer_options options = {
             grpc_core::TcpZerocopySendCtx::kDefaultMaxSends, 0, INT_MAX};
         tcp_tx_zerocopy_max_simult_sends =
             grpc_channel_arg_get_integer(&channel_args->args[i], options);
+        tcp_tx_zerocopy_max_simult_sends_set = true;
+      } else if (0 == strcmp(channel_args->args[i].key,
+                             GRPC_ARG_TCP_TX_ZEROCOPY_ADAPTIVE)) {
+        tcp_tx_zerocopy_adaptive =
+            grpc_channel_arg_get_bool(&channel_args->args[i], true);
+        tcp_tx_zerocopy_adaptive_set = true;
+      } else if (0 == strcmp(channel_args->args[i].key,
+                             GRPC_ARG_TCP_RX_ZEROCOPY_ENABLED)) {
+        tcp_rx_zerocopy_enabled =
+            grpc_channel_arg_get_bool(&channel_args->args[i], false);
+      } else if (0 == strcmp(channel_args->args[i].key,
+                             GRPC_ARG_TCP_RX_ZEROCOPY_RECV_BYTES_THRESHOLD)) {
+        grpc_integer_options options = {
+            grpc_core::TcpZerocopyReceiveCtx::kDefaultRecvBytesThreshold, 0,
+            INT_MAX};
+        tcp_rx_zerocopy_recv_bytes_thresh =
+            grpc_channel_arg_get_integer(&channel_args->args[i], options);
       }
     }
   }
@@ -1716,8 +1751,21 @@ grpc_endpoint* grpc_tcp_create(grpc_fd* em_fd,
   tcp_read_chunk_size = grpc_core::Clamp(
       tcp_read_chunk_size, tcp_min_read_chunk_size, tcp_max_read_chunk_size);
 
-  grpc_tcp* tcp = new grpc_tcp(tcp_tx_zerocopy_max_simult_sends,
-                               tcp_tx_zerocopy_send_bytes_thresh);
+  // An explicitly configured send threshold is kept as is, unless adaptive
+  // tuning was also asked for explicitly.
+  if (tcp_tx_zerocopy_send_bytes_thresh_set && !tcp_tx_zerocopy_adaptive_set) {
+    tcp_tx_zerocopy_adaptive = false;
+  }
+  tcp_tx_zerocopy_adaptive =
+      tcp_tx_zerocopy_adaptive && tcp_tx_zerocopy_enabled;
+  if (tcp_tx_zerocopy_adaptive && !tcp_tx_zerocopy_max_simult_sends_set) {
+    tcp_tx_zerocopy_max_simult_sends =
+        grpc_core::TcpZerocopySendCtx::kDefaultAdaptiveMaxSends;
+  }
+
+  grpc_tcp* tcp = new grpc_tcp(
+      tcp_tx_zerocopy_max_simult_sends, tcp_tx_zerocopy_send_bytes_thresh,
+      tcp_tx_zerocopy_adaptive, tcp_rx_zerocopy_recv_bytes_thresh);
   tcp->base.vtable = &vtable;
   tcp->peer_string = std::string(peer_string);
   tcp->fd = grpc_fd_wrapped_fd(em_fd);
@@ -1796,6 +1844,17 @@ grpc_endpoint* grpc_tcp_create(grpc_fd* em_fd,
 #else
   tcp->inq_capable = false;
 #endif /* GRPC_HAVE_TCP_INQ */
+  if (tcp_rx_zerocopy_enabled) {
+#ifdef GRPC_LINUX_ERRQUEUE
+    /* Reads are sized for zerocopy from the queue length reported by
+       TCP_INQ. */
+    if (tcp->inq_capable) {
+      tcp->tcp_zerocopy_receive_ctx.set_enabled(true);
+    } else {
+      gpr_log(GPR_ERROR, "TCP RX zerocopy requires TCP_INQ support.");
+    }
+#endif
+  }
   /* Start being notified on errors if event engine can track errors. */
   if (grpc_event_engine_can_track_errors()) {
     /* Grab a ref to tcp so that we can safely access the tcp struct when
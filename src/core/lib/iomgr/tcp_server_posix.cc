@@ -37,6 +37,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#ifdef GPR_LINUX
+#include <linux/filter.h>
+#endif
+
 #include <string>
 
 #include "absl/strings/str_cat.h"
@@ -67,6 +71,9 @@ static grpc_error_handle tcp_server_create(grpc_closure* shutdown_complete,
   grpc_tcp_server* s = new grpc_tcp_server;
   s->so_reuseport = grpc_is_socket_reuse_port_supported();
   s->expand_wildcard_addrs = false;
+  s->pollset_by_incoming_cpu = false;
+  s->sharded_listeners = false;
+  s->reuseport_cpu_steering = false;
   for (size_t i = 0; i < (args == nullptr ? 0 : args->num_args); i++) {
     if (0 == strcmp(GRPC_ARG_ALLOW_REUSEPORT, args->args[i].key)) {
       if (args->args[i].type == GRPC_ARG_INTEGER) {
@@ -85,6 +92,31 @@ static grpc_error_handle tcp_server_create(grpc_closure* shutdown_complete,
         return GRPC_ERROR_CREATE_FROM_STATIC_STRING(
             GRPC_ARG_EXPAND_WILDCARD_ADDRS " must be an integer");
       }
+    } else if (0 == strcmp(GRPC_ARG_SERVER_CQ_AFFINITY, args->args[i].key)) {
+      if (args->args[i].type == GRPC_ARG_INTEGER) {
+        s->pollset_by_incoming_cpu = (args->args[i].value.integer != 0);
+      } else {
+        gpr_free(s);
+        return GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+            GRPC_ARG_SERVER_CQ_AFFINITY " must be an integer");
+      }
+    } else if (0 == strcmp(GRPC_ARG_SHARDED_LISTENERS, args->args[i].key)) {
+      if (args->args[i].type == GRPC_ARG_INTEGER) {
+        s->sharded_listeners = (args->args[i].value.integer != 0);
+      } else {
+        gpr_free(s);
+        return GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+            GRPC_ARG_SHARDED_LISTENERS " must be an integer");
+      }
+    } else if (0 ==
+               strcmp(GRPC_ARG_REUSEPORT_CPU_STEERING, args->args[i].key)) {
+      if (args->args[i].type == GRPC_ARG_INTEGER) {
+        s->reuseport_cpu_steering = (args->args[i].value.integer != 0);
+      } else {
+        gpr_free(s);
+        return GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+            GRPC_ARG_REUSEPORT_CPU_STEERING " must be an integer");
+      }
     }
   }
   gpr_ref_init(&s->refs, 1);
@@ -184,6 +216,27 @@ static void tcp_server_destroy(grpc_tcp_server* s) {
   }
 }
 
+/* Pick the pollset to poll a new connection from. */
+static grpc_pollset* choose_pollset(grpc_tcp_server* s, int fd) {
+#ifdef SO_INCOMING_CPU
+  if (s->pollset_by_incoming_cpu) {
+    /* The CPU whose receive queue the connection arrived on: keep its work
+       there, provided the pollsets are polled from the matching CPUs. */
+    int cpu;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0 &&
+        cpu >= 0) {
+      return (*s->pollsets)[static_cast<size_t>(cpu) % s->pollsets->size()];
+    }
+  }
+#else
+  (void)fd;
+#endif
+  return (*s->pollsets)[static_cast<size_t>(gpr_atm_no_barrier_fetch_add(
+                            &s->next_pollset_to_assign, 1)) %
+                        s->pollsets->size()];
+}
+
 /* event manager callback when reads are ready */
 static void on_read(void* arg, grpc_error_handle err) {
   grpc_tcp_listener* sp = static_cast<grpc_tcp_listener*>(arg);
@@ -256,10 +309,9 @@ static void on_read(void* arg, grpc_error_handle err) {
     std::string name = absl::StrCat("tcp-server-connection:", addr_str);
     grpc_fd* fdobj = grpc_fd_create(fd, name.c_str(), true);
 
-    read_notifier_pollset = (*(sp->server->pollsets))
-        [static_cast<size_t>(gpr_atm_no_barrier_fetch_add(
-             &sp->server->next_pollset_to_assign, 1)) %
-         sp->server->pollsets->size()];
+    read_notifier_pollset = sp->shard_pollset != nullptr
+                                ? sp->shard_pollset
+                                : choose_pollset(sp->server, fd);
 
     grpc_pollset_add_fd(read_notifier_pollset, fdobj);
 
@@ -395,6 +447,8 @@ static grpc_error_handle clone_port(grpc_tcp_listener* listener,
     sp->port = port;
     sp->port_index = listener->port_index;
     sp->fd_index = listener->fd_index + count - i;
+    /* set by tcp_server_start() with sharded listeners */
+    sp->shard_pollset = nullptr;
     GPR_ASSERT(sp->emfd);
     while (listener->server->tail->next != nullptr) {
       listener->server->tail = listener->server->tail->next;
@@ -404,6 +458,37 @@ static grpc_error_handle clone_port(grpc_tcp_listener* listener,
   return GRPC_ERROR_NONE;
 }
 
+/* Make the kernel hand each new connection on the port of \a listener to the
+   socket of its reuseport group with the index of the CPU receiving the
+   connection, modulo the number of sockets. */
+static grpc_error_handle attach_cpu_steering(grpc_tcp_listener* listener,
+                                             unsigned num_sockets) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  struct sock_filter code[] = {
+      /* A = current CPU */
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+       static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      /* A = A % num_sockets */
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, num_sockets},
+      /* return A */
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+  if (setsockopt(listener->fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                 sizeof(prog)) != 0) {
+    return GRPC_OS_ERROR(errno, "setsockopt(SO_ATTACH_REUSEPORT_CBPF)");
+  }
+  return GRPC_ERROR_NONE;
+#else
+  (void)listener;
+  (void)num_sockets;
+  return GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+      "SO_ATTACH_REUSEPORT_CBPF is not supported on this platform");
+#endif
+}
+
 static grpc_error_handle tcp_server_add_port(grpc_tcp_server* s,
                                              const grpc_resolved_address* addr,
                                              int* out_port) {
@@ -516,8 +601,20 @@ static void tcp_server_start(grpc_tcp_server* s,
         pollsets->size() > 1) {
       GPR_ASSERT(GRPC_LOG_IF_ERROR(
           "clone_port", clone_port(sp, (unsigned)(pollsets->size() - 1))));
+      if (s->sharded_listeners && s->reuseport_cpu_steering) {
+        GRPC_LOG_IF_ERROR(
+            "reuseport_cpu_steering",
+            attach_cpu_steering(sp, (unsigned)pollsets->size()));
+      }
       for (i = 0; i < pollsets->size(); i++) {
-        grpc_pollset_add_fd((*pollsets)[i], sp->emfd);
+        /* The original listener joined the reuseport group first, and is
+           followed by its clones in the reverse of the order they joined
+           it in: give the k-th socket of the group the k-th pollset, so that
+           CPU steering lands connections on CPU k in pollset k. */
+        grpc_pollset* pollset =
+            (*pollsets)[(pollsets->size() - i) % pollsets->size()];
+        if (s->sharded_listeners) sp->shard_pollset = pollset;
+        grpc_pollset_add_fd(pollset, sp->emfd);
         GRPC_CLOSURE_INIT(&sp->read_closure, on_read, sp,
                           grpc_schedule_on_exec_ctx);
         grpc_fd_notify_on_read(sp->emfd, &sp->read_closure);
@@ -602,10 +699,7 @@ class ExternalConnectionHandler : public grpc_core::TcpServerFdHandler {
     }
     std::string name = absl::StrCat("tcp-server-connection:", addr_str);
     grpc_fd* fdobj = grpc_fd_create(fd, name.c_str(), true);
-    read_notifier_pollset =
-        (*(s_->pollsets))[static_cast<size_t>(gpr_atm_no_barrier_fetch_add(
-                              &s_->next_pollset_to_assign, 1)) %
-                          s_->pollsets->size()];
+    read_notifier_pollset = choose_pollset(s_, fd);
     grpc_pollset_add_fd(read_notifier_pollset, fdobj);
     grpc_tcp_server_acceptor* acceptor =
         static_cast<grpc_tcp_server_acceptor*>(gpr_malloc(sizeof(*acceptor)));
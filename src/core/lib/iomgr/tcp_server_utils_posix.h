@@ -47,6 +47,9 @@ typedef struct grpc_tcp_listener {
      identified while iterating through 'next'. */
   struct grpc_tcp_listener* sibling;
   int is_sibling;
+  /* with sharded listeners, the pollset polling this listener and every
+     connection it accepts; otherwise null */
+  grpc_pollset* shard_pollset;
 } grpc_tcp_listener;
 
 /* the overall server */
@@ -71,6 +74,13 @@ struct grpc_tcp_server {
   bool so_reuseport = false;
   /* expand wildcard addresses to a list of all local addresses */
   bool expand_wildcard_addrs = false;
+  /* pick the pollset of a new connection from its SO_INCOMING_CPU */
+  bool pollset_by_incoming_cpu = false;
+  /* keep connections in the pollset of the reuseport listener that accepted
+     them */
+  bool sharded_listeners = false;
+  /* steer connections to reuseport listeners by the CPU receiving them */
+  bool reuseport_cpu_steering = false;
 
   /* linked list of server ports */
   grpc_tcp_listener* head = nullptr;
@@ -491,6 +491,9 @@ static int win_get_fd(grpc_endpoint* ep) { return -1; }
 
 static bool win_can_track_err(grpc_endpoint* ep) { return false; }
 
+static void win_set_channelz_socket_node(
+    grpc_endpoint* ep, grpc_core::channelz::SocketNode* node) {}
+
 static grpc_endpoint_vtable vtable = {win_read,
                                       win_write,
                                       win_add_to_pollset,
@@ -501,7 +504,8 @@ static grpc_endpoint_vtable vtable = {win_read,
                                       win_get_peer,
                                       win_get_local_address,
                                       win_get_fd,
-                                      win_can_track_err};
+                                      win_can_track_err,
+                                      win_set_channelz_socket_node};
 
 grpc_endpoint* grpc_tcp_create(grpc_winsocket* socket,
                                grpc_channel_args* channel_args,
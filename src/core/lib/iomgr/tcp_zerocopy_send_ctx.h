@@ -0,0 +1,492 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef GRPC_CORE_LIB_IOMGR_TCP_ZEROCOPY_SEND_CTX_H
+#define GRPC_CORE_LIB_IOMGR_TCP_ZEROCOPY_SEND_CTX_H
+
+#include <grpc/support/port_platform.h>
+
+#include "src/core/lib/iomgr/port.h"
+
+#ifdef GRPC_POSIX_SOCKET_TCP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+#include "absl/strings/str_format.h"
+
+#include <grpc/slice_buffer.h>
+#include <grpc/support/alloc.h>
+#include <grpc/support/log.h>
+
+#include "src/core/lib/channel/channelz.h"
+#include "src/core/lib/gprpp/ref_counted_ptr.h"
+#include "src/core/lib/gprpp/sync.h"
+#include "src/core/lib/slice/slice_internal.h"
+
+#ifdef GRPC_MSG_IOVLEN_TYPE
+typedef GRPC_MSG_IOVLEN_TYPE msg_iovlen_type;
+#else
+typedef size_t msg_iovlen_type;
+#endif
+
+namespace grpc_core {
+
+class TcpZerocopySendRecord {
+ public:
+  TcpZerocopySendRecord() { grpc_slice_buffer_init(&buf_); }
+
+  ~TcpZerocopySendRecord() {
+    AssertEmpty();
+    grpc_slice_buffer_destroy_internal(&buf_);
+  }
+
+  // Given the slices that we wish to send, and the current offset into the
+  //   slice buffer (indicating which have already been sent), populate an iovec
+  //   array that will be used for a zerocopy enabled sendmsg().
+  msg_iovlen_type PopulateIovs(size_t* unwind_slice_idx,
+                               size_t* unwind_byte_idx, size_t* sending_length,
+                               iovec* iov);
+
+  // A sendmsg() may not be able to send the bytes that we requested at this
+  // time, returning EAGAIN (possibly due to backpressure). In this case,
+  // unwind the offset into the slice buffer so we retry sending these bytes.
+  void UnwindIfThrottled(size_t unwind_slice_idx, size_t unwind_byte_idx) {
+    out_offset_.byte_idx = unwind_byte_idx;
+    out_offset_.slice_idx = unwind_slice_idx;
+  }
+
+  // Update the offset into the slice buffer based on how much we wanted to sent
+  // vs. what sendmsg() actually sent (which may be lower, possibly due to
+  // backpressure).
+  void UpdateOffsetForBytesSent(size_t sending_length, size_t actually_sent);
+
+  // Indicates whether all underlying data has been sent or not.
+  bool AllSlicesSent() { return out_offset_.slice_idx == buf_.count; }
+
+  // Reset this structure for a new tcp_write() with zerocopy.
+  void PrepareForSends(grpc_slice_buffer* slices_to_send) {
+    AssertEmpty();
+    out_offset_.slice_idx = 0;
+    out_offset_.byte_idx = 0;
+    grpc_slice_buffer_swap(slices_to_send, &buf_);
+    Ref();
+  }
+
+  // References: 1 reference per sendmsg(), and 1 for the tcp_write().
+  void Ref() { ref_.fetch_add(1, std::memory_order_relaxed); }
+
+  // Unref: called when we get an error queue notification for a sendmsg(), if a
+  //  sendmsg() failed or when tcp_write() is done.
+  bool Unref() {
+    const intptr_t prior = ref_.fetch_sub(1, std::memory_order_acq_rel);
+    GPR_DEBUG_ASSERT(prior > 0);
+    if (prior == 1) {
+      AllSendsComplete();
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  struct OutgoingOffset {
+    size_t slice_idx = 0;
+    size_t byte_idx = 0;
+  };
+
+  void AssertEmpty() {
+    GPR_DEBUG_ASSERT(buf_.count == 0);
+    GPR_DEBUG_ASSERT(buf_.length == 0);
+    GPR_DEBUG_ASSERT(ref_.load(std::memory_order_relaxed) == 0);
+  }
+
+  // When all sendmsg() calls associated with this tcp_write() have been
+  // completed (ie. we have received the notifications for each sequence number
+  // for each sendmsg()) and all reference counts have been dropped, drop our
+  // reference to the underlying data since we no longer need it.
+  void AllSendsComplete() {
+    GPR_DEBUG_ASSERT(ref_.load(std::memory_order_relaxed) == 0);
+    grpc_slice_buffer_reset_and_unref_internal(&buf_);
+  }
+
+  grpc_slice_buffer buf_;
+  std::atomic<intptr_t> ref_{0};
+  OutgoingOffset out_offset_;
+};
+
+class TcpZerocopySendCtx {
+ public:
+  static constexpr int kDefaultMaxSends = 4;
+  static constexpr size_t kDefaultSendBytesThreshold = 16 * 1024;  // 16KB
+  // Upper bound on simultaneous sends in adaptive mode, unless configured.
+  static constexpr int kDefaultAdaptiveMaxSends = 16;
+  // Range the adaptive threshold is kept within, while zerocopy pays off.
+  static constexpr size_t kMinSendBytesThreshold = 4 * 1024;      // 4KB
+  static constexpr size_t kMaxSendBytesThreshold = 1024 * 1024;  // 1MB
+  // Adaptive threshold meaning "only zerocopy to probe".
+  static constexpr size_t kNoSendBytesThreshold = SIZE_MAX;
+  // Copying sends smaller than this are too noisy to learn from.
+  static constexpr size_t kMinCopySampleBytes = 1024;
+  // Number of zerocopy completions between two retunes.
+  static constexpr int kRetuneCompletions = 32;
+  // One in this many eligible writes that would be copied uses zerocopy
+  // instead, to keep the zerocopy estimates current.
+  static constexpr int kProbeInterval = 16;
+
+  explicit TcpZerocopySendCtx(
+      int max_sends = kDefaultMaxSends,
+      size_t send_bytes_threshold = kDefaultSendBytesThreshold,
+      bool adaptive = false)
+      : max_sends_(max_sends),
+        free_send_records_size_(max_sends),
+        inflight_limit_(adaptive ? std::min(kDefaultMaxSends, max_sends)
+                                 : max_sends),
+        threshold_bytes_(send_bytes_threshold),
+        adaptive_(adaptive) {
+    send_records_ = static_cast<TcpZerocopySendRecord*>(
+        gpr_malloc(max_sends * sizeof(*send_records_)));
+    free_send_records_ = static_cast<TcpZerocopySendRecord**>(
+        gpr_malloc(max_sends * sizeof(*free_send_records_)));
+    if (send_records_ == nullptr || free_send_records_ == nullptr) {
+      gpr_free(send_records_);
+      gpr_free(free_send_records_);
+      gpr_log(GPR_INFO, "Disabling TCP TX zerocopy due to memory pressure.\n");
+      memory_limited_ = true;
+    } else {
+      for (int idx = 0; idx < max_sends_; ++idx) {
+        new (send_records_ + idx) TcpZerocopySendRecord();
+        free_send_records_[idx] = send_records_ + idx;
+      }
+    }
+  }
+
+  ~TcpZerocopySendCtx() {
+    if (send_records_ != nullptr) {
+      for (int idx = 0; idx < max_sends_; ++idx) {
+        send_records_[idx].~TcpZerocopySendRecord();
+      }
+    }
+    gpr_free(send_records_);
+    gpr_free(free_send_records_);
+  }
+
+  // True if we were unable to allocate the various bookkeeping structures at
+  // transport initialization time. If memory limited, we do not zerocopy.
+  bool memory_limited() const { return memory_limited_; }
+
+  // TCP send zerocopy maintains an implicit sequence number for every
+  // successful sendmsg() with zerocopy enabled; the kernel later gives us an
+  // error queue notification with this sequence number indicating that the
+  // underlying data buffers that we sent can now be released. Once that
+  // notification is received, we can release the buffers associated with this
+  // zerocopy send record. Here, we associate the sequence number with the data
+  // buffers that were sent with the corresponding call to sendmsg().
+  void NoteSend(TcpZerocopySendRecord* record) {
+    record->Ref();
+    AssociateSeqWithSendRecord(last_send_, record);
+    ++last_send_;
+  }
+
+  // If sendmsg() actually failed, though, we need to revert the sequence number
+  // that we speculatively bumped before calling sendmsg(). Note that we bump
+  // this sequence number and perform relevant bookkeeping (see: NoteSend())
+  // *before* calling sendmsg() since, if we called it *after* sendmsg(), then
+  // there is a possible race with the release notification which could occur on
+  // another thread before we do the necessary bookkeeping. Hence, calling
+  // NoteSend() *before* sendmsg() and implementing an undo function is needed.
+  void UndoSend() {
+    --last_send_;
+    if (ReleaseSendRecord(last_send_)->Unref()) {
+      // We should still be holding the ref taken by tcp_write().
+      GPR_DEBUG_ASSERT(0);
+    }
+  }
+
+  // Simply associate this send record (and the underlying sent data buffers)
+  // with the implicit sequence number for this zerocopy sendmsg().
+  void AssociateSeqWithSendRecord(uint32_t seq, TcpZerocopySendRecord* record) {
+    MutexLock guard(&lock_);
+    ctx_lookup_.emplace(seq, record);
+  }
+
+  // Get a send record for a send that we wish to do with zerocopy.
+  TcpZerocopySendRecord* GetSendRecord() {
+    MutexLock guard(&lock_);
+    return TryGetSendRecordLocked();
+  }
+
+  // A given send record corresponds to a single tcp_write() with zerocopy
+  // enabled. This can result in several sendmsg() calls to flush all of the
+  // data to wire. Each sendmsg() takes a reference on the
+  // TcpZerocopySendRecord, and corresponds to a single sequence number.
+  // ReleaseSendRecord releases a reference on TcpZerocopySendRecord for a
+  // single sequence number. This is called either when we receive the relevant
+  // error queue notification (saying that we can discard the underlying
+  // buffers for this sendmsg()) is received from the kernel - or, in case
+  // sendmsg() was unsuccessful to begin with.
+  TcpZerocopySendRecord* ReleaseSendRecord(uint32_t seq) {
+    MutexLock guard(&lock_);
+    return ReleaseSendRecordLocked(seq);
+  }
+
+  // After all the references to a TcpZerocopySendRecord are released, we can
+  // add it back to the pool (of size max_sends_). Note that we can only have
+  // max_sends_ tcp_write() instances with zerocopy enabled in flight at the
+  // same time.
+  void PutSendRecord(TcpZerocopySendRecord* record) {
+    GPR_DEBUG_ASSERT(record >= send_records_ &&
+                     record < send_records_ + max_sends_);
+    MutexLock guard(&lock_);
+    PutSendRecordLocked(record);
+  }
+
+  // Indicate that we are disposing of this zerocopy context. This indicator
+  // will prevent new zerocopy writes from being issued.
+  void Shutdown() { shutdown_.store(true, std::memory_order_release); }
+
+  // Indicates that there are no inflight tcp_write() instances with zerocopy
+  // enabled.
+  bool AllSendRecordsEmpty() {
+    MutexLock guard(&lock_);
+    return free_send_records_size_ == max_sends_;
+  }
+
+  bool enabled() const { return enabled_; }
+
+  void set_enabled(bool enabled) {
+    GPR_DEBUG_ASSERT(!enabled || !memory_limited());
+    enabled_ = enabled;
+  }
+
+  // Only use zerocopy if we are sending at least this many bytes. The
+  // additional overhead of reading the error queue for notifications means that
+  // zerocopy is not useful for small transfers.
+  size_t threshold_bytes() const {
+    return threshold_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // True if sends are being timed to adapt the threshold and in-flight limit.
+  bool adaptive() const { return adaptive_ && enabled_; }
+
+  // Adaptive mode only: whether a write of \a length bytes that is below the
+  // threshold should use zerocopy anyway, as a probe. Only called from the
+  // write path, which is serialized.
+  bool ShouldProbe(size_t length) {
+    if (!adaptive() || length < kMinSendBytesThreshold) return false;
+    if (--probe_countdown_ > 0) return false;
+    probe_countdown_ = kProbeInterval;
+    return true;
+  }
+
+  // Adaptive mode only: called when no send record could be had even after
+  // draining the error queue. Raises the in-flight limit (up to the number of
+  // records allocated), returning true if a record may now be available.
+  bool GrowInflightLimit() {
+    if (!adaptive()) return false;
+    bool grown = false;
+    {
+      MutexLock guard(&lock_);
+      if (inflight_limit_ < max_sends_) {
+        inflight_limit_ = std::min(2 * inflight_limit_, max_sends_);
+        grown = true;
+      }
+    }
+    if (grown) {
+      MutexLock guard(&tuning_mu_);
+      PublishLocked();
+    }
+    return grown;
+  }
+
+  // Adaptive mode: a sendmsg() without MSG_ZEROCOPY took \a ns to send
+  // \a bytes.
+  void NoteCopySend(size_t bytes, int64_t ns) {
+    if (bytes < kMinCopySampleBytes) return;
+    MutexLock guard(&tuning_mu_);
+    UpdateEwma(&copy_ns_per_byte_, static_cast<double>(ns) / bytes);
+  }
+
+  // Adaptive mode: a sendmsg() with MSG_ZEROCOPY took \a ns to send \a bytes.
+  void NoteZerocopySend(size_t bytes, int64_t ns) {
+    if (bytes == 0) return;
+    MutexLock guard(&tuning_mu_);
+    UpdateEwma(&zerocopy_ns_per_byte_, static_cast<double>(ns) / bytes);
+  }
+
+  // Adaptive mode: an error queue notification released \a count sequence
+  // numbers, of which the kernel ended up copying the data for \a copied,
+  // and took \a ns to receive and process.
+  void NoteCompletions(uint32_t count, uint32_t copied, int64_t ns) {
+    if (!adaptive() || count == 0) return;
+    MutexLock guard(&tuning_mu_);
+    UpdateEwma(&completion_ns_, static_cast<double>(ns) / count);
+    window_completions_ += count;
+    window_copied_ += copied;
+    if (window_completions_ >= kRetuneCompletions) RetuneLocked();
+  }
+
+  // Report the tuning state (and later changes to it) as options of \a node.
+  void SetChannelzSocketNode(RefCountedPtr<channelz::SocketNode> node) {
+    MutexLock guard(&tuning_mu_);
+    channelz_socket_ = std::move(node);
+    PublishLocked();
+  }
+
+ private:
+  static void UpdateEwma(double* estimate, double sample) {
+    *estimate = *estimate == 0 ? sample : *estimate + (sample - *estimate) / 8;
+  }
+
+  // A zerocopy send of n bytes costs about
+  //   n * zerocopy_ns_per_byte_ + completion_ns_,
+  // against n * copy_ns_per_byte_ when copying, so zerocopy pays off above
+  // completion_ns_ / (copy_ns_per_byte_ - zerocopy_ns_per_byte_) bytes. If
+  // the kernel had to copy most of the data anyway (no scatter-gather or
+  // checksum offload, or loopback), zerocopy only adds cost.
+  void RetuneLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(tuning_mu_) {
+    size_t threshold = threshold_bytes();
+    if (window_copied_ * 2 > window_completions_) {
+      threshold = kNoSendBytesThreshold;
+    } else if (copy_ns_per_byte_ > 0 && zerocopy_ns_per_byte_ > 0) {
+      const double saving = copy_ns_per_byte_ - zerocopy_ns_per_byte_;
+      if (saving > 0 && completion_ns_ / saving < kMaxSendBytesThreshold) {
+        threshold = std::max(kMinSendBytesThreshold,
+                             static_cast<size_t>(completion_ns_ / saving));
+      } else {
+        threshold = kMaxSendBytesThreshold;
+      }
+    }
+    threshold_bytes_.store(threshold, std::memory_order_relaxed);
+    last_window_completions_ = window_completions_;
+    last_window_copied_ = window_copied_;
+    window_completions_ = 0;
+    window_copied_ = 0;
+    {
+      // Give back in-flight headroom the connection did not use.
+      MutexLock guard(&lock_);
+      const int floor = std::min(kDefaultMaxSends, max_sends_);
+      if (peak_inflight_ * 2 <= inflight_limit_ && inflight_limit_ > floor) {
+        inflight_limit_ = std::max(inflight_limit_ / 2, floor);
+      }
+      peak_inflight_ = max_sends_ - free_send_records_size_;
+    }
+    PublishLocked();
+  }
+
+  void PublishLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(tuning_mu_) {
+    if (channelz_socket_ == nullptr) return;
+    const size_t threshold = threshold_bytes();
+    int inflight_limit;
+    {
+      MutexLock guard(&lock_);
+      inflight_limit = inflight_limit_;
+    }
+    if (!enabled_) {
+      channelz_socket_->SetOption("GRPC_TCP_TX_ZEROCOPY", "disabled");
+      return;
+    }
+    channelz_socket_->SetOption(
+        "GRPC_TCP_TX_ZEROCOPY",
+        !adaptive_ ? "enabled"
+                   : (threshold == kNoSendBytesThreshold ? "adaptive, probing"
+                                                         : "adaptive"));
+    channelz_socket_->SetOption("GRPC_TCP_TX_ZEROCOPY_SEND_BYTES_THRESHOLD",
+                                threshold == kNoSendBytesThreshold
+                                    ? "none"
+                                    : std::to_string(threshold));
+    channelz_socket_->SetOption("GRPC_TCP_TX_ZEROCOPY_MAX_SIMULT_SENDS",
+                                std::to_string(inflight_limit));
+    if (adaptive_) {
+      channelz_socket_->SetOption(
+          "GRPC_TCP_TX_ZEROCOPY_ESTIMATES",
+          absl::StrFormat("copy_ns_per_byte=%.3f zerocopy_ns_per_byte=%.3f "
+                          "completion_ns=%.0f kernel_copied=%d/%d",
+                          copy_ns_per_byte_, zerocopy_ns_per_byte_,
+                          completion_ns_, last_window_copied_,
+                          last_window_completions_));
+    }
+  }
+
+  TcpZerocopySendRecord* ReleaseSendRecordLocked(uint32_t seq) {
+    auto iter = ctx_lookup_.find(seq);
+    GPR_DEBUG_ASSERT(iter != ctx_lookup_.end());
+    TcpZerocopySendRecord* record = iter->second;
+    ctx_lookup_.erase(iter);
+    return record;
+  }
+
+  TcpZerocopySendRecord* TryGetSendRecordLocked() {
+    if (shutdown_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    const int inflight = max_sends_ - free_send_records_size_;
+    if (inflight >= inflight_limit_) {
+      return nullptr;
+    }
+    peak_inflight_ = std::max(peak_inflight_, inflight + 1);
+    free_send_records_size_--;
+    return free_send_records_[free_send_records_size_];
+  }
+
+  void PutSendRecordLocked(TcpZerocopySendRecord* record) {
+    GPR_DEBUG_ASSERT(free_send_records_size_ < max_sends_);
+    free_send_records_[free_send_records_size_] = record;
+    free_send_records_size_++;
+  }
+
+  TcpZerocopySendRecord* send_records_;
+  TcpZerocopySendRecord** free_send_records_;
+  int max_sends_;
+  int free_send_records_size_;
+  // Number of records that may be in flight at once; max_sends_ unless
+  // adaptive.
+  int inflight_limit_;
+  int peak_inflight_ = 0;
+  Mutex lock_;
+  uint32_t last_send_ = 0;
+  std::atomic<bool> shutdown_{false};
+  bool enabled_ = false;
+  std::atomic<size_t> threshold_bytes_{kDefaultSendBytesThreshold};
+  std::unordered_map<uint32_t, TcpZerocopySendRecord*> ctx_lookup_;
+  bool memory_limited_ = false;
+  const bool adaptive_;
+  int probe_countdown_ = kProbeInterval;
+  Mutex tuning_mu_;
+  double copy_ns_per_byte_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  double zerocopy_ns_per_byte_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  double completion_ns_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  int window_completions_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  int window_copied_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  int last_window_completions_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  int last_window_copied_ ABSL_GUARDED_BY(tuning_mu_) = 0;
+  RefCountedPtr<channelz::SocketNode> channelz_socket_
+      ABSL_GUARDED_BY(tuning_mu_);
+};
+
+}  // namespace grpc_core
+
+#endif /* GRPC_POSIX_SOCKET_TCP */
+
+#endif /* GRPC_CORE_LIB_IOMGR_TCP_ZEROCOPY_SEND_CTX_H */
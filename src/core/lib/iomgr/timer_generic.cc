@@ -332,7 +332,10 @@ static void note_deadline_change(timer_shard* shard) {
   }
 }
 
-void grpc_timer_init_unset(grpc_timer* timer) { timer->pending = false; }
+void grpc_timer_init_unset(grpc_timer* timer) {
+  timer->pending = false;
+  timer->heap_index = INVALID_HEAP_INDEX;
+}
 
 static void timer_init(grpc_timer* timer, grpc_millis deadline,
                        grpc_closure* closure) {
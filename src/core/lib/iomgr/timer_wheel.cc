@@ -0,0 +1,521 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Timer implementation based on hierarchical timing wheels.
+
+   Each shard is a four level wheel of 64 slots per level, with a resolution
+   of one millisecond at the lowest level and 64 times coarser at each level
+   above; timers further out than the top level reaches (~4.6 hours) wait in
+   an overflow list. Adding a timer links it into the slot its deadline falls
+   into, and cancelling unlinks it, both in constant time. As the wheel turns,
+   the timers in each higher level slot are cascaded down a level when the
+   lowest level comes around to them.
+
+   Timers are added to the shard of the CPU the caller is running on, so that
+   most adds and cancels take an uncontended lock, and the shard lower bounds
+   and the global earliest deadline are kept in atomics so that adds only
+   touch shared state when they become the earliest timer. */
+
+#include <grpc/support/port_platform.h>
+
+#include <inttypes.h>
+
+#include <atomic>
+
+#include <grpc/support/cpu.h>
+#include <grpc/support/log.h>
+#include <grpc/support/sync.h>
+
+#include "src/core/lib/debug/trace.h"
+#include "src/core/lib/gpr/spinlock.h"
+#include "src/core/lib/gpr/tls.h"
+#include "src/core/lib/gpr/useful.h"
+#include "src/core/lib/iomgr/exec_ctx.h"
+#include "src/core/lib/iomgr/timer.h"
+
+#define INVALID_HEAP_INDEX 0xffffffffu
+
+#define WHEEL_LEVELS 4
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1)
+/* Index of the overflow list, after the WHEEL_LEVELS * WHEEL_SLOTS slots. */
+#define WHEEL_OVERFLOW (WHEEL_LEVELS * WHEEL_SLOTS)
+/* Span of one slot of the top level: the overflow list is re-examined every
+   time the top level turns by one slot. */
+#define WHEEL_TOP_SLOT_SPAN \
+  (static_cast<grpc_millis>(1) << (WHEEL_SLOT_BITS * (WHEEL_LEVELS - 1)))
+
+#define MAX_SHARDS 64u
+
+extern grpc_core::TraceFlag grpc_timer_trace;
+extern grpc_core::TraceFlag grpc_timer_check_trace;
+
+namespace {
+
+struct wheel_shard {
+  gpr_mu mu;
+  /* The next tick to process: every timer with a deadline before this has
+     fired. */
+  grpc_millis base;
+  /* A lower bound on the deadline of the next timer due in this shard. */
+  std::atomic<grpc_millis> min_deadline;
+  size_t count;
+  /* Bit i of occupied[level] is set iff slots[level * WHEEL_SLOTS + i] is
+     non-empty. */
+  uint64_t occupied[WHEEL_LEVELS];
+  /* List sentinels for every slot, plus the overflow list. */
+  grpc_timer slots[WHEEL_OVERFLOW + 1];
+};
+
+}  // namespace
+
+static size_t g_num_shards;
+static wheel_shard* g_shards;
+static bool g_initialized;
+
+/* The deadline of the next timer due across all shards (or a lower bound on
+   it). */
+static std::atomic<grpc_millis> g_min_timer;
+
+/* Allow only one run_some_expired_timers at once */
+static gpr_spinlock g_checker_mu = GPR_SPINLOCK_STATIC_INITIALIZER;
+
+/* Thread local copy of g_min_timer, as last seen by this thread. This avoids
+   contention on a globally mutable cacheline in the common case. */
+static GPR_THREAD_LOCAL(grpc_millis) g_last_seen_min_timer;
+
+static int count_trailing_zeros(uint64_t x) {
+  return static_cast<int>(grpc_core::BitCount((x & (~x + 1)) - 1));
+}
+
+static void list_join(grpc_timer* head, grpc_timer* timer) {
+  timer->next = head;
+  timer->prev = head->prev;
+  timer->next->prev = timer->prev->next = timer;
+}
+
+static bool list_empty(grpc_timer* head) { return head->next == head; }
+
+/* Returns the slot of shard that a timer due at deadline belongs in. */
+static uint32_t slot_for_deadline(wheel_shard* shard, grpc_millis deadline) {
+  /* Overdue timers go in the slot for the next tick. */
+  if (deadline < shard->base) deadline = shard->base;
+  const uint64_t delta = static_cast<uint64_t>(deadline - shard->base);
+  for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+    if (delta < (uint64_t(1) << (WHEEL_SLOT_BITS * (level + 1)))) {
+      return level * WHEEL_SLOTS +
+             static_cast<uint32_t>((deadline >> (WHEEL_SLOT_BITS * level)) &
+                                   WHEEL_SLOT_MASK);
+    }
+  }
+  return WHEEL_OVERFLOW;
+}
+
+/* REQUIRES: shard->mu locked */
+static void add_to_wheel(wheel_shard* shard, grpc_timer* timer) {
+  const uint32_t slot = slot_for_deadline(shard, timer->deadline);
+  list_join(&shard->slots[slot], timer);
+  if (slot != WHEEL_OVERFLOW) {
+    shard->occupied[slot / WHEEL_SLOTS] |= uint64_t(1)
+                                           << (slot % WHEEL_SLOTS);
+  }
+}
+
+/* REQUIRES: shard->mu locked */
+static void remove_from_wheel(wheel_shard* shard, grpc_timer* timer) {
+  timer->next->prev = timer->prev;
+  timer->prev->next = timer->next;
+  /* If that emptied the slot, the only neighbour left is its sentinel. */
+  grpc_timer* neighbour = timer->next;
+  if (neighbour == timer->prev && neighbour >= shard->slots &&
+      neighbour < shard->slots + WHEEL_OVERFLOW) {
+    const size_t slot = static_cast<size_t>(neighbour - shard->slots);
+    shard->occupied[slot / WHEEL_SLOTS] &= ~(uint64_t(1)
+                                             << (slot % WHEEL_SLOTS));
+  }
+}
+
+/* Detaches every timer in slot, returning them as a null terminated list
+   linked through next.
+   REQUIRES: shard->mu locked */
+static grpc_timer* take_slot(wheel_shard* shard, uint32_t slot) {
+  grpc_timer* head = &shard->slots[slot];
+  if (list_empty(head)) return nullptr;
+  grpc_timer* first = head->next;
+  head->prev->next = nullptr;
+  head->next = head->prev = head;
+  if (slot != WHEEL_OVERFLOW) {
+    shard->occupied[slot / WHEEL_SLOTS] &= ~(uint64_t(1)
+                                             << (slot % WHEEL_SLOTS));
+  }
+  return first;
+}
+
+/* Moves the timers in slot to where they now belong relative to shard->base.
+   REQUIRES: shard->mu locked */
+static void cascade(wheel_shard* shard, uint32_t slot) {
+  grpc_timer* next;
+  for (grpc_timer* timer = take_slot(shard, slot); timer != nullptr;
+       timer = next) {
+    next = timer->next;
+    add_to_wheel(shard, timer);
+  }
+}
+
+/* Processes the tick at shard->base: cascades any higher level slots that
+   come due, then fires the timers in the lowest level slot. Returns the
+   number of timers fired.
+   REQUIRES: shard->mu locked */
+static size_t run_tick(wheel_shard* shard, grpc_error_handle error) {
+  const grpc_millis tick = shard->base;
+  for (uint32_t level = 1; level < WHEEL_LEVELS; level++) {
+    const uint32_t shift = WHEEL_SLOT_BITS * level;
+    if ((tick & ((static_cast<grpc_millis>(1) << shift) - 1)) != 0) break;
+    cascade(shard, level * WHEEL_SLOTS +
+                       static_cast<uint32_t>((tick >> shift) & WHEEL_SLOT_MASK));
+  }
+  if ((tick & (WHEEL_TOP_SLOT_SPAN - 1)) == 0) {
+    cascade(shard, WHEEL_OVERFLOW);
+  }
+  size_t n = 0;
+  grpc_timer* next;
+  for (grpc_timer* timer =
+           take_slot(shard, static_cast<uint32_t>(tick & WHEEL_SLOT_MASK));
+       timer != nullptr; timer = next) {
+    next = timer->next;
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_trace)) {
+      gpr_log(GPR_INFO, "TIMER %p: FIRE %" PRId64 "ms late", timer,
+              tick - timer->deadline);
+    }
+    timer->pending = false;
+    grpc_core::ExecCtx::Run(DEBUG_LOCATION, timer->closure,
+                            GRPC_ERROR_REF(error));
+    n++;
+  }
+  shard->count -= n;
+  return n;
+}
+
+/* Fires every timer in shard, whatever its deadline. Returns the number of
+   timers fired.
+   REQUIRES: shard->mu locked */
+static size_t fire_all(wheel_shard* shard, grpc_error_handle error) {
+  size_t n = 0;
+  for (uint32_t slot = 0; slot <= WHEEL_OVERFLOW; slot++) {
+    grpc_timer* next;
+    for (grpc_timer* timer = take_slot(shard, slot); timer != nullptr;
+         timer = next) {
+      next = timer->next;
+      timer->pending = false;
+      grpc_core::ExecCtx::Run(DEBUG_LOCATION, timer->closure,
+                              GRPC_ERROR_REF(error));
+      n++;
+    }
+  }
+  shard->count = 0;
+  return n;
+}
+
+/* Returns a lower bound on the deadline of the next timer due in shard: the
+   deadline itself if one is in the lowest level, or else the earliest time
+   at which an occupied higher level slot will be cascaded.
+   REQUIRES: shard->mu locked */
+static grpc_millis compute_min_deadline(wheel_shard* shard) {
+  if (shard->count == 0) return GRPC_MILLIS_INF_FUTURE;
+  const grpc_millis base = shard->base;
+  grpc_millis min_deadline = GRPC_MILLIS_INF_FUTURE;
+  for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+    const uint64_t occupied = shard->occupied[level];
+    if (occupied == 0) continue;
+    const uint32_t shift = WHEEL_SLOT_BITS * level;
+    const uint32_t current =
+        static_cast<uint32_t>((base >> shift) & WHEEL_SLOT_MASK);
+    /* Rotate so that bit 0 is the current slot. */
+    uint64_t rotated = current == 0 ? occupied
+                                    : (occupied >> current) |
+                                          (occupied << (WHEEL_SLOTS - current));
+    /* Above the lowest level, the current slot has already been cascaded
+       unless base is exactly at its start: anything in it belongs to the
+       next turn, and must not hide the other occupied slots. */
+    if (level > 0 &&
+        (base & ((static_cast<grpc_millis>(1) << shift) - 1)) != 0) {
+      rotated &= ~uint64_t(1);
+    }
+    const grpc_millis distance =
+        rotated == 0 ? WHEEL_SLOTS : count_trailing_zeros(rotated);
+    min_deadline =
+        std::min(min_deadline, level == 0 ? base + distance
+                                          : ((base >> shift) + distance)
+                                                << shift);
+  }
+  if (!list_empty(&shard->slots[WHEEL_OVERFLOW])) {
+    min_deadline = std::min(
+        min_deadline,
+        (base + WHEEL_TOP_SLOT_SPAN - 1) & ~(WHEEL_TOP_SLOT_SPAN - 1));
+  }
+  return min_deadline;
+}
+
+/* Turns the wheel up to and including now, firing every timer that comes
+   due. Returns the number of timers fired.
+   REQUIRES: shard->mu locked */
+static size_t advance(wheel_shard* shard, grpc_millis now,
+                      grpc_error_handle error) {
+  if (now == GRPC_MILLIS_INF_FUTURE) return fire_all(shard, error);
+  size_t n = 0;
+  while (shard->base <= now) {
+    /* Only the ticks that fire a timer or cascade an occupied slot need
+       processing: jump straight to the next one, however long the shard has
+       been idle. */
+    const grpc_millis next_tick = compute_min_deadline(shard);
+    if (next_tick > now) {
+      shard->base = now + 1;
+      break;
+    }
+    shard->base = next_tick;
+    n += run_tick(shard, error);
+    shard->base++;
+  }
+  return n;
+}
+
+/* Lowers g_min_timer to deadline if it is earlier. Returns true if it was. */
+static bool lower_min_timer(grpc_millis deadline) {
+  grpc_millis current = g_min_timer.load();
+  while (deadline < current) {
+    if (g_min_timer.compare_exchange_weak(current, deadline)) return true;
+  }
+  return false;
+}
+
+static void timer_list_init() {
+  g_num_shards = grpc_core::Clamp(gpr_cpu_num_cores(), 1u, MAX_SHARDS);
+  g_shards = new wheel_shard[g_num_shards];
+  const grpc_millis now = grpc_core::ExecCtx::Get()->Now();
+  for (size_t i = 0; i < g_num_shards; i++) {
+    wheel_shard* shard = &g_shards[i];
+    gpr_mu_init(&shard->mu);
+    shard->base = now;
+    shard->min_deadline.store(GRPC_MILLIS_INF_FUTURE);
+    shard->count = 0;
+    for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+      shard->occupied[level] = 0;
+    }
+    for (grpc_timer& head : shard->slots) {
+      head.next = head.prev = &head;
+    }
+  }
+  g_min_timer.store(GRPC_MILLIS_INF_FUTURE);
+  g_last_seen_min_timer = 0;
+  g_initialized = true;
+}
+
+static void timer_list_shutdown() {
+  grpc_error_handle error =
+      GRPC_ERROR_CREATE_FROM_STATIC_STRING("Timer list shutdown");
+  for (size_t i = 0; i < g_num_shards; i++) {
+    wheel_shard* shard = &g_shards[i];
+    gpr_mu_lock(&shard->mu);
+    fire_all(shard, error);
+    gpr_mu_unlock(&shard->mu);
+    gpr_mu_destroy(&shard->mu);
+  }
+  GRPC_ERROR_UNREF(error);
+  delete[] g_shards;
+  g_shards = nullptr;
+  g_initialized = false;
+}
+
+static void timer_init(grpc_timer* timer, grpc_millis deadline,
+                       grpc_closure* closure) {
+  timer->closure = closure;
+  timer->deadline = deadline;
+  timer->heap_index = INVALID_HEAP_INDEX;
+
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_trace)) {
+    gpr_log(GPR_INFO, "TIMER %p: SET %" PRId64 " now %" PRId64 " call %p[%p]",
+            timer, deadline, grpc_core::ExecCtx::Get()->Now(), closure,
+            closure->cb);
+  }
+
+  if (!g_initialized) {
+    timer->pending = false;
+    grpc_core::ExecCtx::Run(
+        DEBUG_LOCATION, timer->closure,
+        GRPC_ERROR_CREATE_FROM_STATIC_STRING(
+            "Attempt to create timer before initialization"));
+    return;
+  }
+
+  const uint32_t shard_index =
+      static_cast<uint32_t>(gpr_cpu_current_cpu() % g_num_shards);
+  wheel_shard* shard = &g_shards[shard_index];
+  /* Unlike the generic implementation, heap_index holds the timer's shard. */
+  timer->heap_index = shard_index;
+  gpr_mu_lock(&shard->mu);
+  timer->pending = true;
+  grpc_millis now = grpc_core::ExecCtx::Get()->Now();
+  if (deadline <= now) {
+    timer->pending = false;
+    grpc_core::ExecCtx::Run(DEBUG_LOCATION, timer->closure, GRPC_ERROR_NONE);
+    gpr_mu_unlock(&shard->mu);
+    /* early out */
+    return;
+  }
+  /* Shards are only advanced while they hold timers that come due, so an
+     empty one may have been idle for long. Nothing is pending in it: move its
+     base up to now, so that the timer lands in the slot its deadline is near
+     and advance() has no stale ticks to walk through. */
+  const bool was_empty = shard->count == 0;
+  if (was_empty && shard->base < now) shard->base = now;
+  add_to_wheel(shard, timer);
+  shard->count++;
+  /* An empty shard's lower bound may be left from a cancelled timer. */
+  const bool is_first_timer =
+      was_empty || deadline < shard->min_deadline.load();
+  if (is_first_timer) shard->min_deadline.store(deadline);
+  gpr_mu_unlock(&shard->mu);
+
+  /* Only the shard's new earliest timer can be the new global earliest. The
+     shard lower bound is published before g_min_timer is lowered, which pairs
+     with run_some_expired_timers re-reading the shard lower bounds after
+     publishing g_min_timer: one of the two always sees the other. */
+  if (is_first_timer && lower_min_timer(deadline)) {
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_trace)) {
+      gpr_log(GPR_INFO, "  .. shard %d: new min_timer=%" PRId64,
+              static_cast<int>(shard_index), deadline);
+    }
+    grpc_kick_poller();
+  }
+}
+
+static void timer_consume_kick(void) {
+  /* Force re-evaluation of last seen min */
+  g_last_seen_min_timer = 0;
+}
+
+static void timer_cancel(grpc_timer* timer) {
+  if (!g_initialized || timer->heap_index == INVALID_HEAP_INDEX) {
+    /* The timer list is gone, or the timer was never set. */
+    return;
+  }
+
+  wheel_shard* shard = &g_shards[timer->heap_index];
+  gpr_mu_lock(&shard->mu);
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_trace)) {
+    gpr_log(GPR_INFO, "TIMER %p: CANCEL pending=%s", timer,
+            timer->pending ? "true" : "false");
+  }
+
+  if (timer->pending) {
+    grpc_core::ExecCtx::Run(DEBUG_LOCATION, timer->closure,
+                            GRPC_ERROR_CANCELLED);
+    timer->pending = false;
+    remove_from_wheel(shard, timer);
+    shard->count--;
+  }
+  gpr_mu_unlock(&shard->mu);
+}
+
+static grpc_timer_check_result run_some_expired_timers(
+    grpc_millis now, grpc_millis* next, grpc_error_handle error) {
+  grpc_timer_check_result result = GRPC_TIMERS_NOT_CHECKED;
+
+  grpc_millis min_timer = g_min_timer.load(std::memory_order_relaxed);
+  g_last_seen_min_timer = min_timer;
+
+  if (now < min_timer) {
+    if (next != nullptr) *next = std::min(*next, min_timer);
+    GRPC_ERROR_UNREF(error);
+    return GRPC_TIMERS_CHECKED_AND_EMPTY;
+  }
+
+  if (gpr_spinlock_trylock(&g_checker_mu)) {
+    result = GRPC_TIMERS_CHECKED_AND_EMPTY;
+    grpc_millis new_min_timer = GRPC_MILLIS_INF_FUTURE;
+    for (size_t i = 0; i < g_num_shards; i++) {
+      wheel_shard* shard = &g_shards[i];
+      if (shard->min_deadline.load() <= now) {
+        gpr_mu_lock(&shard->mu);
+        const size_t n = advance(shard, now, error);
+        shard->min_deadline.store(compute_min_deadline(shard));
+        gpr_mu_unlock(&shard->mu);
+        if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_check_trace)) {
+          gpr_log(GPR_INFO, "  .. shard[%d] popped %" PRIdPTR,
+                  static_cast<int>(i), n);
+        }
+        if (n > 0) result = GRPC_TIMERS_FIRED;
+      }
+      new_min_timer = std::min(new_min_timer, shard->min_deadline.load());
+    }
+    g_min_timer.store(new_min_timer);
+    /* Pick up any timer that became a shard's earliest after that shard was
+       visited above. */
+    for (size_t i = 0; i < g_num_shards; i++) {
+      lower_min_timer(g_shards[i].min_deadline.load());
+    }
+    if (next != nullptr) *next = std::min(*next, g_min_timer.load());
+    gpr_spinlock_unlock(&g_checker_mu);
+  }
+
+  GRPC_ERROR_UNREF(error);
+
+  return result;
+}
+
+static grpc_timer_check_result timer_check(grpc_millis* next) {
+  grpc_millis now = grpc_core::ExecCtx::Get()->Now();
+
+  /* fetch from a thread-local first: this avoids contention on a globally
+     mutable cacheline in the common case */
+  grpc_millis min_timer = g_last_seen_min_timer;
+
+  if (now < min_timer) {
+    if (next != nullptr) {
+      *next = std::min(*next, min_timer);
+    }
+    if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_check_trace)) {
+      gpr_log(GPR_INFO, "TIMER CHECK SKIP: now=%" PRId64 " min_timer=%" PRId64,
+              now, min_timer);
+    }
+    return GRPC_TIMERS_CHECKED_AND_EMPTY;
+  }
+
+  grpc_error_handle shutdown_error =
+      now != GRPC_MILLIS_INF_FUTURE
+          ? GRPC_ERROR_NONE
+          : GRPC_ERROR_CREATE_FROM_STATIC_STRING("Shutting down timer system");
+
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_check_trace)) {
+    gpr_log(GPR_INFO,
+            "TIMER CHECK BEGIN: now=%" PRId64 " tls_min=%" PRId64
+            " glob_min=%" PRId64,
+            now, min_timer, g_min_timer.load(std::memory_order_relaxed));
+  }
+  grpc_timer_check_result r =
+      run_some_expired_timers(now, next, shutdown_error);
+  if (GRPC_TRACE_FLAG_ENABLED(grpc_timer_check_trace)) {
+    gpr_log(GPR_INFO, "TIMER CHECK END: r=%d", r);
+  }
+  return r;
+}
+
+grpc_timer_vtable grpc_wheel_timer_vtable = {
+    timer_init,      timer_cancel,        timer_check,
+    timer_list_init, timer_list_shutdown, timer_consume_kick};
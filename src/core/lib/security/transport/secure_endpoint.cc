@@ -418,6 +418,12 @@ static bool endpoint_can_track_err(grpc_endpoint* secure_ep) {
   return grpc_endpoint_can_track_err(ep->wrapped_ep);
 }
 
+static void endpoint_set_channelz_socket_node(
+    grpc_endpoint* secure_ep, grpc_core::channelz::SocketNode* node) {
+  secure_endpoint* ep = reinterpret_cast<secure_endpoint*>(secure_ep);
+  grpc_endpoint_set_channelz_socket_node(ep->wrapped_ep, node);
+}
+
 static const grpc_endpoint_vtable vtable = {endpoint_read,
                                             endpoint_write,
                                             endpoint_add_to_pollset,
@@ -428,7 +434,8 @@ static const grpc_endpoint_vtable vtable = {endpoint_read,
                                             endpoint_get_peer,
                                             endpoint_get_local_address,
                                             endpoint_get_fd,
-                                            endpoint_can_track_err};
+                                            endpoint_can_track_err,
+                                            endpoint_set_channelz_socket_node};
 
 grpc_endpoint* grpc_secure_endpoint_create(
     struct tsi_frame_protector* protector,
@@ -135,6 +135,7 @@ struct grpc_call {
       : arena(arena),
         cq(args.cq),
         channel(args.channel),
+        call_size_estimator(args.call_size_estimator),
         is_client(args.server_transport_data == nullptr),
         stream_op_payload(context) {}
 
@@ -153,6 +154,9 @@ struct grpc_call {
   grpc_completion_queue* cq;
   grpc_polling_entity pollent;
   grpc_channel* channel;
+  grpc_core::CallSizeEstimator* call_size_estimator;
+  // Size of the initial zone of arena.
+  size_t initial_arena_size = 0;
   gpr_cycle_counter start_time = gpr_get_cycle_counter();
   /* parent_call* */ gpr_atm parent_call_atm = 0;
   child_call* child = nullptr;
@@ -338,7 +342,13 @@ grpc_error_handle grpc_call_create(grpc_call_create_args* args,
   grpc_error_handle error = GRPC_ERROR_NONE;
   grpc_channel_stack* channel_stack =
       grpc_channel_get_channel_stack(args->channel);
-  size_t initial_size = grpc_channel_get_call_size_estimate(args->channel);
+  size_t initial_size = 0;
+  if (args->call_size_estimator != nullptr) {
+    initial_size = args->call_size_estimator->CallSizeEstimate();
+  }
+  if (initial_size == 0) {
+    initial_size = grpc_channel_get_call_size_estimate(args->channel);
+  }
   GRPC_STATS_INC_CALL_INITIAL_SIZE(initial_size);
   size_t call_and_stack_size =
       GPR_ROUND_UP_TO_ALIGNMENT_SIZE(sizeof(grpc_call)) +
@@ -351,6 +361,7 @@ grpc_error_handle grpc_call_create(grpc_call_create_args* args,
                                         &*args->channel->allocator);
   arena = arena_with_call.first;
   call = new (arena_with_call.second) grpc_call(arena, *args);
+  call->initial_arena_size = initial_size;
   *out_call = call;
   grpc_slice path = grpc_empty_slice();
   if (call->is_client) {
@@ -514,8 +525,17 @@ static void release_call(void* call, grpc_error_handle /*error*/) {
   grpc_call* c = static_cast<grpc_call*>(call);
   grpc_channel* channel = c->channel;
   grpc_core::Arena* arena = c->arena;
+  grpc_core::CallSizeEstimator* call_size_estimator = c->call_size_estimator;
+  size_t initial_arena_size = c->initial_arena_size;
   c->~grpc_call();
-  grpc_channel_update_call_size_estimate(channel, arena->Destroy());
+  size_t arena_size = arena->Destroy();
+  if (arena_size > initial_arena_size) {
+    GRPC_STATS_INC_CALL_ARENA_OVERFLOWS();
+  }
+  if (call_size_estimator != nullptr) {
+    call_size_estimator->UpdateCallSizeEstimate(arena_size);
+  }
+  grpc_channel_update_call_size_estimate(channel, arena_size);
   GRPC_CHANNEL_INTERNAL_UNREF(channel, "call");
 }
 
@@ -1227,10 +1247,13 @@ static void validate_filtered_metadata(batch_control* bctl) {
       grpc_channel_compression_options(call->channel);
   const grpc_compression_algorithm compression_algorithm =
       call->incoming_compression_algorithm;
-  if (GPR_UNLIKELY(!grpc_core::CompressionAlgorithmSet::FromUint32(
-                        compression_options.enabled_algorithms_bitset)
-                        .IsSet(compression_algorithm))) {
-    /* check if algorithm is supported by current channel config */
+  if (GPR_UNLIKELY(
+          !grpc_core::CompressionAlgorithmSet::FromUint32(
+               compression_options.enabled_algorithms_bitset)
+               .Intersect(grpc_core::CompressionAlgorithmSet::Supported())
+               .IsSet(compression_algorithm))) {
+    /* check if algorithm is supported by current channel config and by this
+       build */
     handle_compression_algorithm_disabled(call, compression_algorithm);
   }
   /* GRPC_COMPRESS_NONE is always set. */
@@ -30,6 +30,10 @@
 #include "src/core/lib/surface/api_trace.h"
 #include "src/core/lib/surface/server.h"
 
+namespace grpc_core {
+class CallSizeEstimator;
+}  // namespace grpc_core
+
 typedef void (*grpc_ioreq_completion_func)(grpc_call* call, int success,
                                            void* user_data);
 
@@ -50,6 +54,10 @@ typedef struct grpc_call_create_args {
   absl::optional<grpc_core::Slice> authority;
 
   grpc_millis send_deadline;
+
+  /* if not NULL, sizes the call arena in lieu of the channel wide estimate,
+     and is updated with the final arena size of the call */
+  grpc_core::CallSizeEstimator* call_size_estimator;
 } grpc_call_create_args;
 
 /* Create a new call based on \a args.
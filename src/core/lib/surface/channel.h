@@ -21,6 +21,7 @@
 
 #include <grpc/support/port_platform.h>
 
+#include <atomic>
 #include <map>
 
 #include "src/core/lib/channel/channel_stack.h"
@@ -72,9 +73,36 @@ void grpc_channel_update_call_size_estimate(grpc_channel* channel, size_t size);
 
 namespace grpc_core {
 
+// Tracks the arena size of calls as a decaying high-water mark: the estimate
+// rises immediately to the size of any larger call, and decays slowly towards
+// the size of smaller ones. Used to size the initial zone of new call arenas,
+// so that most calls never allocate an additional zone.
+class CallSizeEstimator {
+ public:
+  explicit CallSizeEstimator(size_t initial_estimate)
+      : call_size_estimate_(initial_estimate) {}
+  CallSizeEstimator(const CallSizeEstimator& other)
+      : call_size_estimate_(
+            other.call_size_estimate_.load(std::memory_order_relaxed)) {}
+  CallSizeEstimator& operator=(const CallSizeEstimator&) = delete;
+
+  // Returns the initial arena size for a new call, or 0 if there is no
+  // estimate yet.
+  size_t CallSizeEstimate() const;
+  // Records the final arena size of a call.
+  void UpdateCallSizeEstimate(size_t size);
+
+ private:
+  std::atomic<size_t> call_size_estimate_;
+};
+
 struct RegisteredCall {
   Slice path;
   absl::optional<Slice> authority;
+  // Arena size of calls to this method. Calls on methods with large metadata
+  // or that pick up deep filter stacks would otherwise overflow arenas sized
+  // from the channel wide estimate.
+  CallSizeEstimator call_size_estimator{0};
 
   explicit RegisteredCall(const char* method_arg, const char* host_arg);
   RegisteredCall(const RegisteredCall& other);
@@ -99,7 +127,8 @@ struct grpc_channel {
   int is_client;
   grpc_compression_options compression_options;
 
-  gpr_atm call_size_estimate;
+  grpc_core::ManualConstructor<grpc_core::CallSizeEstimator>
+      call_size_estimator;
 
   // TODO(vjpai): Once the grpc_channel is allocated via new rather than malloc,
   //              expand the members of the CallRegistrationTable directly into
@@ -60,6 +60,9 @@ namespace {
 // NOTE: Only one event will ever be cached.
 GPR_THREAD_LOCAL(grpc_cq_completion*) g_cached_event;
 GPR_THREAD_LOCAL(grpc_completion_queue*) g_cached_cq;
+// The callback completion queue this thread is polling in
+// grpc_cq_poll_callback, if any.
+GPR_THREAD_LOCAL(grpc_completion_queue*) g_polling_callback_cq;
 
 struct plucker {
   grpc_pollset_worker** worker;
@@ -867,9 +870,11 @@ static void cq_end_op_for_callback(
   // 2. The callback is marked inlineable and there is an ACEC available
   // 3. We are already running in a background poller thread (which always has
   //    an ACEC available at the base of the stack).
+  // 4. We are polling this CQ in grpc_cq_poll_callback (which also has one).
   auto* functor = static_cast<grpc_completion_queue_functor*>(tag);
   if (((internal || functor->inlineable) &&
        grpc_core::ApplicationCallbackExecCtx::Available()) ||
+      g_polling_callback_cq == cq ||
       grpc_iomgr_is_any_background_poller_thread()) {
     grpc_core::ApplicationCallbackExecCtx::Enqueue(functor,
                                                    (error == GRPC_ERROR_NONE));
@@ -1424,6 +1429,32 @@ grpc_pollset* grpc_cq_pollset(grpc_completion_queue* cq) {
   return cq->poller_vtable->can_get_pollset ? POLLSET_FROM_CQ(cq) : nullptr;
 }
 
+bool grpc_cq_poll_callback(grpc_completion_queue* cq, gpr_timespec deadline) {
+  GPR_ASSERT(cq->vtable->cq_completion_type == GRPC_CQ_CALLBACK);
+  cq_callback_data* cqd = static_cast<cq_callback_data*> DATA_FROM_CQ(cq);
+  // Declared first so that the callbacks queued on it run once exec_ctx has
+  // been flushed, and never nest in one another.
+  grpc_core::ApplicationCallbackExecCtx callback_exec_ctx(
+      GRPC_APP_CALLBACK_EXEC_CTX_FLAG_IS_INTERNAL_THREAD);
+  {
+    grpc_core::ExecCtx exec_ctx;
+    gpr_mu_lock(cq->mu);
+    if (cqd->shutdown_called &&
+        cqd->pending_events.load(std::memory_order_acquire) == 0) {
+      gpr_mu_unlock(cq->mu);
+      return false;
+    }
+    g_polling_callback_cq = cq;
+    grpc_error_handle err = cq->poller_vtable->work(
+        POLLSET_FROM_CQ(cq), nullptr,
+        grpc_timespec_to_millis_round_up(deadline));
+    gpr_mu_unlock(cq->mu);
+    GRPC_LOG_IF_ERROR("grpc_cq_poll_callback", err);
+  }
+  g_polling_callback_cq = nullptr;
+  return true;
+}
+
 bool grpc_cq_can_listen(grpc_completion_queue* cq) {
   return cq->poller_vtable->can_listen;
 }
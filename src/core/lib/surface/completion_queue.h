@@ -85,6 +85,15 @@ void grpc_cq_end_op(grpc_completion_queue* cq, void* tag,
 
 grpc_pollset* grpc_cq_pollset(grpc_completion_queue* cq);
 
+/* Polls the pollset of the callback completion queue \a cq once, returning by
+   \a deadline at the latest. The callbacks of operations on \a cq completed by
+   this thread meanwhile, including those not marked inlineable, are run
+   before returning, one after the other at the bottom of the stack. For
+   threads dedicated to polling callback queues when the iomgr has no
+   background pollers. Returns false once \a cq is shut down and has no pending
+   operations left. */
+bool grpc_cq_poll_callback(grpc_completion_queue* cq, gpr_timespec deadline);
+
 bool grpc_cq_can_listen(grpc_completion_queue* cq);
 
 grpc_cq_completion_type grpc_get_cq_completion_type(grpc_completion_queue* cq);
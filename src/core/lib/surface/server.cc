@@ -43,6 +43,7 @@
 #include "src/core/lib/debug/stats.h"
 #include "src/core/lib/gpr/spinlock.h"
 #include "src/core/lib/gpr/string.h"
+#include "src/core/lib/gprpp/mpmcq.h"
 #include "src/core/lib/gprpp/mpscq.h"
 #include "src/core/lib/iomgr/executor.h"
 #include "src/core/lib/iomgr/iomgr.h"
@@ -190,31 +191,44 @@ class Server::RequestMatcherInterface {
 // application to explicitly request RPCs and then matching those to incoming
 // RPCs, along with a slow path by which incoming RPCs are put on a locked
 // pending list if they aren't able to be matched to an application request.
+//
+// Matching an incoming RPC against a request, and queueing a request, are lock
+// free as long as the pending list is empty: each CQ has its own lock free
+// queue of requests, and an incoming RPC takes a request from the CQ its
+// channel is bound to before looking at the others. Only when an RPC finds no
+// request at all is the server's mu_call_ taken.
+//
+// With GRPC_ARG_SERVER_CQ_AFFINITY, RPCs only ever take requests from the CQ
+// their channel is bound to, and wait on a pending list of that CQ.
 class Server::RealRequestMatcher : public RequestMatcherInterface {
  public:
   explicit RealRequestMatcher(Server* server)
-      : server_(server), requests_per_cq_(server->cqs_.size()) {}
+      : server_(server),
+        pending_(server->cq_affinity_ ? server->cqs_.size() : 1),
+        requests_per_cq_(server->cqs_.size()) {}
 
   ~RealRequestMatcher() override {
-    for (LockedMultiProducerSingleConsumerQueue& queue : requests_per_cq_) {
-      GPR_ASSERT(queue.Pop() == nullptr);
+    for (RequestQueue& queue : requests_per_cq_) {
+      GPR_ASSERT(queue.TryPop() == nullptr);
     }
   }
 
   void ZombifyPending() override {
-    while (!pending_.empty()) {
-      CallData* calld = pending_.front();
-      calld->SetState(CallData::CallState::ZOMBIED);
-      calld->KillZombie();
-      pending_.pop();
+    for (std::queue<CallData*>& pending : pending_) {
+      while (!pending.empty()) {
+        CallData* calld = pending.front();
+        calld->SetState(CallData::CallState::ZOMBIED);
+        calld->KillZombie();
+        pending.pop();
+        num_pending_.fetch_sub(1, std::memory_order_relaxed);
+      }
     }
   }
 
   void KillRequests(grpc_error_handle error) override {
     for (size_t i = 0; i < requests_per_cq_.size(); i++) {
       RequestedCall* rc;
-      while ((rc = reinterpret_cast<RequestedCall*>(
-                  requests_per_cq_[i].Pop())) != nullptr) {
+      while ((rc = requests_per_cq_[i].TryPop()) != nullptr) {
         server_->FailCall(i, rc, GRPC_ERROR_REF(error));
       }
     }
@@ -227,47 +241,50 @@ class Server::RealRequestMatcher : public RequestMatcherInterface {
 
   void RequestCallWithPossiblePublish(size_t request_queue_index,
                                       RequestedCall* call) override {
-    if (requests_per_cq_[request_queue_index].Push(&call->mpscq_node)) {
-      /* this was the first queued request: we need to lock and start
-         matching calls */
-      struct PendingCall {
-        RequestedCall* rc = nullptr;
-        CallData* calld;
-      };
-      auto pop_next_pending = [this, request_queue_index] {
-        PendingCall pending_call;
-        {
-          MutexLock lock(&server_->mu_call_);
-          if (!pending_.empty()) {
-            pending_call.rc = reinterpret_cast<RequestedCall*>(
-                requests_per_cq_[request_queue_index].Pop());
-            if (pending_call.rc != nullptr) {
-              pending_call.calld = pending_.front();
-              pending_.pop();
-            }
+    requests_per_cq_[request_queue_index].Push(call);
+    // Pairs with the fence in MatchOrQueue: either it sees our request, or we
+    // see the RPC it is about to queue as pending.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_pending_.load(std::memory_order_relaxed) == 0) return;
+    struct PendingCall {
+      RequestedCall* rc = nullptr;
+      CallData* calld;
+    };
+    std::queue<CallData*>& pending = PendingFor(request_queue_index);
+    auto pop_next_pending = [this, request_queue_index, &pending] {
+      PendingCall pending_call;
+      {
+        MutexLock lock(&server_->mu_call_);
+        if (!pending.empty()) {
+          pending_call.rc = requests_per_cq_[request_queue_index].TryPop();
+          if (pending_call.rc != nullptr) {
+            pending_call.calld = pending.front();
+            pending.pop();
+            num_pending_.fetch_sub(1, std::memory_order_relaxed);
           }
         }
-        return pending_call;
-      };
-      while (true) {
-        PendingCall next_pending = pop_next_pending();
-        if (next_pending.rc == nullptr) break;
-        if (!next_pending.calld->MaybeActivate()) {
-          // Zombied Call
-          next_pending.calld->KillZombie();
-        } else {
-          next_pending.calld->Publish(request_queue_index, next_pending.rc);
-        }
+      }
+      return pending_call;
+    };
+    while (true) {
+      PendingCall next_pending = pop_next_pending();
+      if (next_pending.rc == nullptr) break;
+      if (!next_pending.calld->MaybeActivate()) {
+        // Zombied Call
+        next_pending.calld->KillZombie();
+      } else {
+        next_pending.calld->Publish(request_queue_index, next_pending.rc);
       }
     }
   }
 
   void MatchOrQueue(size_t start_request_queue_index,
                     CallData* calld) override {
-    for (size_t i = 0; i < requests_per_cq_.size(); i++) {
+    const size_t num_request_queues =
+        server_->cq_affinity_ ? 1 : requests_per_cq_.size();
+    for (size_t i = 0; i < num_request_queues; i++) {
       size_t cq_idx = (start_request_queue_index + i) % requests_per_cq_.size();
-      RequestedCall* rc =
-          reinterpret_cast<RequestedCall*>(requests_per_cq_[cq_idx].TryPop());
+      RequestedCall* rc = requests_per_cq_[cq_idx].TryPop();
       if (rc != nullptr) {
         GRPC_STATS_INC_SERVER_CQS_CHECKED(i);
         calld->SetState(CallData::CallState::ACTIVATED);
@@ -277,30 +294,32 @@ class Server::RealRequestMatcher : public RequestMatcherInterface {
     }
     // No cq to take the request found; queue it on the slow list.
     GRPC_STATS_INC_SERVER_SLOWPATH_REQUESTS_QUEUED();
-    // We need to ensure that all the queues are empty.  We do this under
-    // the server mu_call_ lock to ensure that if something is added to
-    // an empty request queue, it will block until the call is actually
-    // added to the pending list.
+    // Announce the pending RPC before checking the queues one last time, so
+    // that a request queued from now on is matched against it by
+    // RequestCallWithPossiblePublish.
     RequestedCall* rc = nullptr;
     size_t cq_idx = 0;
     size_t loop_count;
     {
       MutexLock lock(&server_->mu_call_);
-      for (loop_count = 0; loop_count < requests_per_cq_.size(); loop_count++) {
+      num_pending_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      for (loop_count = 0; loop_count < num_request_queues; loop_count++) {
         cq_idx =
             (start_request_queue_index + loop_count) % requests_per_cq_.size();
-        rc = reinterpret_cast<RequestedCall*>(requests_per_cq_[cq_idx].Pop());
+        rc = requests_per_cq_[cq_idx].TryPop();
         if (rc != nullptr) {
           break;
         }
       }
       if (rc == nullptr) {
         calld->SetState(CallData::CallState::PENDING);
-        pending_.push(calld);
+        PendingFor(start_request_queue_index).push(calld);
         return;
       }
+      num_pending_.fetch_sub(1, std::memory_order_relaxed);
     }
-    GRPC_STATS_INC_SERVER_CQS_CHECKED(loop_count + requests_per_cq_.size());
+    GRPC_STATS_INC_SERVER_CQS_CHECKED(loop_count + num_request_queues);
     calld->SetState(CallData::CallState::ACTIVATED);
     calld->Publish(cq_idx, rc);
   }
@@ -308,9 +327,52 @@ class Server::RealRequestMatcher : public RequestMatcherInterface {
   Server* server() const override { return server_; }
 
  private:
+  // Requests queued for one CQ. They live in a bounded lock free ring, and
+  // only overflow onto a locked queue when the application keeps an unusually
+  // large number of requests outstanding on the CQ.
+  class RequestQueue {
+   public:
+    RequestQueue() : ring_(kRingSize) {}
+
+    void Push(RequestedCall* rc) {
+      if (ring_.TryPush(rc)) return;
+      num_overflowed_.fetch_add(1, std::memory_order_relaxed);
+      overflow_.Push(&rc->mpscq_node);
+    }
+
+    // Returns nullptr if there is no request, or if the requests being
+    // queued concurrently are not visible yet.
+    RequestedCall* TryPop() {
+      RequestedCall* rc = ring_.TryPop();
+      if (rc != nullptr ||
+          num_overflowed_.load(std::memory_order_relaxed) == 0) {
+        return rc;
+      }
+      rc = reinterpret_cast<RequestedCall*>(overflow_.Pop());
+      if (rc != nullptr) {
+        num_overflowed_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      return rc;
+    }
+
+   private:
+    static constexpr size_t kRingSize = 256;
+
+    MultiProducerMultiConsumerQueue<RequestedCall> ring_;
+    std::atomic<size_t> num_overflowed_{0};
+    LockedMultiProducerSingleConsumerQueue overflow_;
+  };
+
+  std::queue<CallData*>& PendingFor(size_t request_queue_index) {
+    return pending_[pending_.size() == 1 ? 0 : request_queue_index];
+  }
+
   Server* const server_;
-  std::queue<CallData*> pending_;
-  std::vector<LockedMultiProducerSingleConsumerQueue> requests_per_cq_;
+  // A single list, or one per CQ with GRPC_ARG_SERVER_CQ_AFFINITY.
+  std::vector<std::queue<CallData*>> pending_;
+  // Total size of pending_, readable without holding mu_call_.
+  std::atomic<size_t> num_pending_{0};
+  std::vector<RequestQueue> requests_per_cq_;
 };
 
 // AllocatingRequestMatchers don't allow the application to request an RPC in
@@ -534,7 +596,9 @@ RefCountedPtr<channelz::ServerNode> CreateChannelzNode(
 
 Server::Server(const grpc_channel_args* args)
     : channel_args_(grpc_channel_args_copy(args)),
-      channelz_node_(CreateChannelzNode(args)) {}
+      channelz_node_(CreateChannelzNode(args)),
+      cq_affinity_(grpc_channel_args_find_bool(
+          args, GRPC_ARG_SERVER_CQ_AFFINITY, false)) {}
 
 Server::~Server() {
   grpc_channel_args_destroy(channel_args_);
@@ -1111,6 +1175,7 @@ void Server::ChannelData::AcceptStream(void* arg, grpc_transport* /*transport*/,
   args.pollset_set_alternative = nullptr;
   args.server_transport_data = transport_server_data;
   args.send_deadline = GRPC_MILLIS_INF_FUTURE;
+  args.call_size_estimator = nullptr;
   grpc_call* call;
   grpc_error_handle error = grpc_call_create(&args, &call);
   grpc_call_element* elem =
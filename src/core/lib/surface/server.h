@@ -414,6 +414,8 @@ class Server : public InternallyRefCounted<Server>,
   grpc_channel_args* const channel_args_;
   RefCountedPtr<channelz::ServerNode> channelz_node_;
   std::unique_ptr<grpc_server_config_fetcher> config_fetcher_;
+  // Whether calls are only ever published to the CQ of their channel.
+  const bool cq_affinity_;
 
   std::vector<grpc_completion_queue*> cqs_;
   std::vector<grpc_pollset*> pollsets_;
@@ -438,6 +438,25 @@ struct GrpcRetryPushbackMsMetadata
   static absl::string_view key() { return "grpc-retry-pushback-ms"; }
 };
 
+// grpc-accept-encoding-dictionary metadata trait: the id of the compression
+// dictionary that the sender holds for the call, and so can decompress
+// GRPC_COMPRESS_ZSTD messages primed with.
+struct GrpcAcceptEncodingDictionaryMetadata
+    : public SimpleIntBasedMetadata<uint32_t, 0> {
+  static constexpr bool kRepeatable = false;
+  static absl::string_view key() { return "grpc-accept-encoding-dictionary"; }
+};
+
+// grpc-encoding-dictionary metadata trait: the id of the compression
+// dictionary that the sender primes GRPC_COMPRESS_ZSTD messages with. Only
+// sent once the receiver has advertised the dictionary in
+// grpc-accept-encoding-dictionary.
+struct GrpcEncodingDictionaryMetadata
+    : public SimpleIntBasedMetadata<uint32_t, 0> {
+  static constexpr bool kRepeatable = false;
+  static absl::string_view key() { return "grpc-encoding-dictionary"; }
+};
+
 // :status metadata trait.
 // TODO(ctiller): consider moving to uint16_t
 struct HttpStatusMetadata : public SimpleIntBasedMetadata<uint32_t, 0> {
@@ -1292,7 +1311,9 @@ using grpc_metadata_batch_base = grpc_core::MetadataMap<
     // Non-colon prefixed headers begin here
     grpc_core::ContentTypeMetadata, grpc_core::TeMetadata,
     grpc_core::GrpcEncodingMetadata, grpc_core::GrpcInternalEncodingRequest,
-    grpc_core::GrpcAcceptEncodingMetadata, grpc_core::GrpcStatusMetadata,
+    grpc_core::GrpcAcceptEncodingMetadata,
+    grpc_core::GrpcAcceptEncodingDictionaryMetadata,
+    grpc_core::GrpcEncodingDictionaryMetadata, grpc_core::GrpcStatusMetadata,
     grpc_core::GrpcTimeoutMetadata, grpc_core::GrpcPreviousRpcAttemptsMetadata,
     grpc_core::GrpcRetryPushbackMsMetadata, grpc_core::UserAgentMetadata,
     grpc_core::GrpcMessageMetadata, grpc_core::HostMetadata,
@@ -52,6 +52,10 @@ void FaultInjectionFilterInit(void);
 void FaultInjectionFilterShutdown(void);
 void GrpcLbPolicyRingHashInit(void);
 void GrpcLbPolicyRingHashShutdown(void);
+void GrpcLbPolicyLeastRequestInit(void);
+void GrpcLbPolicyLeastRequestShutdown(void);
+void GrpcLbPolicyWeightedRoundRobinInit(void);
+void GrpcLbPolicyWeightedRoundRobinShutdown(void);
 #ifndef GRPC_NO_RLS
 void RlsLbPluginInit();
 void RlsLbPluginShutdown();
@@ -116,6 +120,10 @@ void grpc_register_built_in_plugins(void) {
                        grpc_lb_policy_round_robin_shutdown);
   grpc_register_plugin(grpc_core::GrpcLbPolicyRingHashInit,
                        grpc_core::GrpcLbPolicyRingHashShutdown);
+  grpc_register_plugin(grpc_core::GrpcLbPolicyLeastRequestInit,
+                       grpc_core::GrpcLbPolicyLeastRequestShutdown);
+  grpc_register_plugin(grpc_core::GrpcLbPolicyWeightedRoundRobinInit,
+                       grpc_core::GrpcLbPolicyWeightedRoundRobinShutdown);
   grpc_register_plugin(grpc_resolver_dns_ares_init,
                        grpc_resolver_dns_ares_shutdown);
   grpc_register_plugin(grpc_resolver_dns_native_init,
@@ -52,6 +52,10 @@ void FaultInjectionFilterInit(void);
 void FaultInjectionFilterShutdown(void);
 void GrpcLbPolicyRingHashInit(void);
 void GrpcLbPolicyRingHashShutdown(void);
+void GrpcLbPolicyLeastRequestInit(void);
+void GrpcLbPolicyLeastRequestShutdown(void);
+void GrpcLbPolicyWeightedRoundRobinInit(void);
+void GrpcLbPolicyWeightedRoundRobinShutdown(void);
 void ServiceConfigParserInit(void);
 void ServiceConfigParserShutdown(void);
 }  // namespace grpc_core
@@ -80,6 +84,10 @@ void grpc_register_built_in_plugins(void) {
                        grpc_lb_policy_round_robin_shutdown);
   grpc_register_plugin(grpc_core::GrpcLbPolicyRingHashInit,
                        grpc_core::GrpcLbPolicyRingHashShutdown);
+  grpc_register_plugin(grpc_core::GrpcLbPolicyLeastRequestInit,
+                       grpc_core::GrpcLbPolicyLeastRequestShutdown);
+  grpc_register_plugin(grpc_core::GrpcLbPolicyWeightedRoundRobinInit,
+                       grpc_core::GrpcLbPolicyWeightedRoundRobinShutdown);
   grpc_register_plugin(grpc_message_size_filter_init,
                        grpc_message_size_filter_shutdown);
   grpc_register_plugin(grpc_core::FaultInjectionFilterInit,
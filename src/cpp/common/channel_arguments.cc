@@ -84,6 +84,10 @@ void ChannelArguments::SetCompressionAlgorithm(
   SetInt(GRPC_COMPRESSION_CHANNEL_DEFAULT_ALGORITHM, algorithm);
 }
 
+void ChannelArguments::SetZstdCompressionLevel(int level) {
+  SetInt(GRPC_COMPRESSION_CHANNEL_ZSTD_LEVEL, level);
+}
+
 void ChannelArguments::SetGrpclbFallbackTimeout(int fallback_timeout) {
   SetInt(GRPC_ARG_GRPCLB_FALLBACK_TIMEOUT_MS, fallback_timeout);
 }
@@ -25,9 +25,18 @@
 #include <grpcpp/support/time.h>
 
 #include "src/core/lib/gpr/useful.h"
+#include "src/core/lib/gprpp/global_config.h"
 #include "src/core/lib/gprpp/manual_constructor.h"
 #include "src/core/lib/gprpp/sync.h"
 #include "src/core/lib/gprpp/thd.h"
+#include "src/core/lib/surface/completion_queue.h"
+
+GPR_GLOBAL_CONFIG_DEFINE_BOOL(
+    grpc_callback_inline_execution, false,
+    "If set, and the iomgr has no background pollers, callback API reactions "
+    "run inline on the threads polling for the I/O that completed them, "
+    "rather than being handed from those threads to others. Methods "
+    "marked with MarkMethodMayBlock are not affected.");
 
 namespace grpc {
 namespace {
@@ -37,24 +46,72 @@ internal::GrpcLibraryInitializer g_gli_initializer;
 gpr_once g_once_init_callback_alternative = GPR_ONCE_INIT;
 grpc_core::Mutex* g_callback_alternative_mu;
 
+// The inline callback CQ is a real callback CQ: its poller threads observe
+// its shutdown themselves, so its shutdown callback has nothing to do.
+struct NoopShutdownCallback : public grpc_completion_queue_functor {
+  NoopShutdownCallback() {
+    functor_run = &NoopShutdownCallback::Run;
+    inlineable = true;
+  }
+  static void Run(grpc_completion_queue_functor* /*cb*/, int /*ok*/) {}
+};
+
+NoopShutdownCallback g_noop_shutdown_callback;
+
 // Implement a ref-counted callback CQ for global use in the alternative
 // implementation so that its threads are only created once. Do this using
 // explicit ref-counts and raw pointers rather than a shared-ptr since that
 // has a non-trivial destructor and thus can't be used for global variables.
+//
+// By default, the CQ is a next CQ drained by "nexting" threads that run the
+// callbacks of the events they get. With inline execution, it is a callback
+// CQ whose threads poll its pollset and run the callbacks of the operations
+// completed by the I/O they process right away, saving the handoff through
+// the queue.
 struct CallbackAlternativeCQ {
+  const bool inline_execution;
   int refs ABSL_GUARDED_BY(g_callback_alternative_mu) = 0;
   CompletionQueue* cq ABSL_GUARDED_BY(g_callback_alternative_mu);
   std::vector<grpc_core::Thread>* nexting_threads
       ABSL_GUARDED_BY(g_callback_alternative_mu);
 
+  explicit CallbackAlternativeCQ(bool inline_execution)
+      : inline_execution(inline_execution) {}
+
   CompletionQueue* Ref() {
     grpc_core::MutexLock lock(&*g_callback_alternative_mu);
     refs++;
     if (refs == 1) {
-      cq = new CompletionQueue;
       int num_nexting_threads =
           grpc_core::Clamp(gpr_cpu_num_cores() / 2, 2u, 16u);
       nexting_threads = new std::vector<grpc_core::Thread>;
+      if (inline_execution) {
+        grpc_completion_queue_attributes attributes{
+            GRPC_CQ_CURRENT_VERSION, GRPC_CQ_CALLBACK, GRPC_CQ_DEFAULT_POLLING,
+            &g_noop_shutdown_callback};
+        cq = new CompletionQueue(grpc_completion_queue_create(
+            grpc_completion_queue_factory_lookup(&attributes), &attributes,
+            nullptr));
+        for (int i = 0; i < num_nexting_threads; i++) {
+          nexting_threads->emplace_back(
+              "callback_poller",
+              [](void* arg) {
+                grpc_completion_queue* cq =
+                    static_cast<CompletionQueue*>(arg)->cq();
+                while (grpc_cq_poll_callback(
+                    cq, gpr_time_add(gpr_now(GPR_CLOCK_MONOTONIC),
+                                     gpr_time_from_millis(1000,
+                                                          GPR_TIMESPAN)))) {
+                }
+              },
+              cq);
+        }
+        for (auto& th : *nexting_threads) {
+          th.Start();
+        }
+        return cq;
+      }
+      cq = new CompletionQueue;
       for (int i = 0; i < num_nexting_threads; i++) {
         nexting_threads->emplace_back(
             "nexting_thread",
@@ -116,7 +173,8 @@ struct CallbackAlternativeCQ {
   }
 };
 
-CallbackAlternativeCQ g_callback_alternative_cq;
+CallbackAlternativeCQ g_callback_alternative_cq(/*inline_execution=*/false);
+CallbackAlternativeCQ g_callback_inline_cq(/*inline_execution=*/true);
 
 }  // namespace
 
@@ -188,17 +246,23 @@ bool CompletionQueue::CompletionQueueTLSCache::Flush(void** tag, bool* ok) {
   return false;
 }
 
-CompletionQueue* CompletionQueue::CallbackAlternativeCQ() {
+CompletionQueue* CompletionQueue::CallbackAlternativeCQ(bool may_block) {
   gpr_once_init(&g_once_init_callback_alternative,
                 [] { g_callback_alternative_mu = new grpc_core::Mutex(); });
+  if (!may_block && GPR_GLOBAL_CONFIG_GET(grpc_callback_inline_execution)) {
+    return g_callback_inline_cq.Ref();
+  }
   return g_callback_alternative_cq.Ref();
 }
 
 void CompletionQueue::ReleaseCallbackAlternativeCQ(CompletionQueue* cq)
     ABSL_NO_THREAD_SAFETY_ANALYSIS {
-  (void)cq;
-  // This accesses g_callback_alternative_cq without acquiring the mutex
-  // but it's considered safe because it just reads the pointer address.
+  // This accesses the CQ pointers without acquiring the mutex but it's
+  // considered safe because it just reads the pointer addresses.
+  if (cq == g_callback_inline_cq.cq) {
+    g_callback_inline_cq.Unref();
+    return;
+  }
   GPR_DEBUG_ASSERT(cq == g_callback_alternative_cq.cq);
   g_callback_alternative_cq.Unref();
 }
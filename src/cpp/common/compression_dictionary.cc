@@ -0,0 +1,38 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <grpcpp/support/compression_dictionary.h>
+
+#include "src/core/lib/compression/compression_dictionary.h"
+
+namespace grpc {
+namespace experimental {
+Status RegisterCompressionDictionary(const std::string& method,
+                                     const std::string& dictionary,
+                                     uint32_t* id) {
+  absl::StatusOr<uint32_t> result =
+      grpc_core::CompressionDictionaryRegistry::Register(method, dictionary);
+  if (!result.ok()) {
+    return Status(static_cast<StatusCode>(result.status().raw_code()),
+                  std::string(result.status().message()));
+  }
+  if (id != nullptr) *id = *result;
+  return Status::OK;
+}
+}  // namespace experimental
+}  // namespace grpc
@@ -16,18 +16,72 @@
  *
  */
 
+#include <string.h>
+
+#include <functional>
+
 #include <grpc/support/cpu.h>
+#include <grpc/support/log.h>
 
+#include "src/core/lib/gprpp/global_config.h"
+#include "src/core/lib/iomgr/executor/work_stealing_threadpool.h"
 #include "src/cpp/server/dynamic_thread_pool.h"
 
 #ifndef GRPC_CUSTOM_DEFAULT_THREAD_POOL
 
+GPR_GLOBAL_CONFIG_DEFINE_STRING(
+    grpc_cpp_thread_pool, "dynamic",
+    "Declares which thread pool runs C++ callbacks such as auth metadata "
+    "plugins: 'dynamic' (grows while callbacks block) or 'work_stealing' "
+    "(fixed size, one thread per core).")
+
 namespace grpc {
 namespace {
 
+// Runs callbacks on a grpc_core::WorkStealingThreadPool. Unlike
+// DynamicThreadPool, it never adds threads: callbacks that block hold up the
+// ones queued behind them.
+class WorkStealingThreadPool final : public ThreadPoolInterface {
+ public:
+  explicit WorkStealingThreadPool(int num_threads)
+      : pool_(num_threads, "grpcpp_work_stealing") {}
+
+  void Add(const std::function<void()>& callback) override {
+    pool_.Add(new Callback(callback));
+  }
+
+ private:
+  struct Callback : public grpc_completion_queue_functor {
+    explicit Callback(const std::function<void()>& callback)
+        : callback(callback) {
+      functor_run = &Callback::Run;
+      inlineable = false;
+      internal_success = 1;
+    }
+
+    static void Run(grpc_completion_queue_functor* functor, int /*ok*/) {
+      Callback* self = static_cast<Callback*>(functor);
+      self->callback();
+      delete self;
+    }
+
+    std::function<void()> callback;
+  };
+
+  grpc_core::WorkStealingThreadPool pool_;
+};
+
 ThreadPoolInterface* CreateDefaultThreadPoolImpl() {
   int cores = gpr_cpu_num_cores();
   if (!cores) cores = 4;
+  grpc_core::UniquePtr<char> value =
+      GPR_GLOBAL_CONFIG_GET(grpc_cpp_thread_pool);
+  if (strcmp(value.get(), "work_stealing") == 0) {
+    return new WorkStealingThreadPool(cores);
+  }
+  if (strcmp(value.get(), "dynamic") != 0) {
+    gpr_log(GPR_ERROR, "Unknown thread pool '%s', using dynamic", value.get());
+  }
   return new DynamicThreadPool(cores);
 }
 
@@ -59,6 +59,8 @@ ServerBuilder::ServerBuilder()
          sizeof(maybe_default_compression_level_));
   memset(&maybe_default_compression_algorithm_, 0,
          sizeof(maybe_default_compression_algorithm_));
+  memset(&maybe_zstd_compression_level_, 0,
+         sizeof(maybe_zstd_compression_level_));
 }
 
 ServerBuilder::~ServerBuilder() {
@@ -145,6 +147,11 @@ ServerBuilder& ServerBuilder::SetOption(
   return *this;
 }
 
+ServerBuilder& ServerBuilder::SetConnectionCompletionQueueAffinity(
+    bool enable) {
+  return AddChannelArgument(GRPC_ARG_SERVER_CQ_AFFINITY, enable ? 1 : 0);
+}
+
 ServerBuilder& ServerBuilder::SetSyncServerOption(
     ServerBuilder::SyncServerOption option, int val) {
   switch (option) {
@@ -160,6 +167,9 @@ ServerBuilder& ServerBuilder::SetSyncServerOption(
     case CQ_TIMEOUT_MSEC:
       sync_server_settings_.cq_timeout_msec = val;
       break;
+    case QUEUEING_DELAY_TARGET_USEC:
+      AddChannelArgument(GRPC_ARG_SYNC_SERVER_QUEUEING_DELAY_TARGET_US, val);
+      break;
   }
   return *this;
 }
@@ -188,6 +198,12 @@ ServerBuilder& ServerBuilder::SetDefaultCompressionAlgorithm(
   return *this;
 }
 
+ServerBuilder& ServerBuilder::SetZstdCompressionLevel(int level) {
+  maybe_zstd_compression_level_.is_set = true;
+  maybe_zstd_compression_level_.level = level;
+  return *this;
+}
+
 ServerBuilder& ServerBuilder::SetResourceQuota(
     const grpc::ResourceQuota& resource_quota) {
   if (resource_quota_ != nullptr) {
@@ -235,6 +251,10 @@ ChannelArguments ServerBuilder::BuildChannelArgs() {
     args.SetInt(GRPC_COMPRESSION_CHANNEL_DEFAULT_ALGORITHM,
                 maybe_default_compression_algorithm_.algorithm);
   }
+  if (maybe_zstd_compression_level_.is_set) {
+    args.SetInt(GRPC_COMPRESSION_CHANNEL_ZSTD_LEVEL,
+                maybe_zstd_compression_level_.level);
+  }
   if (resource_quota_ != nullptr) {
     args.SetPointerWithVtable(GRPC_ARG_RESOURCE_QUOTA, resource_quota_,
                               grpc_resource_quota_arg_vtable());
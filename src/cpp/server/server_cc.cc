@@ -458,6 +458,13 @@ class Server::SyncRequest final : public grpc::internal::CompletionQueueTag {
     delete this;
   }
 
+  // Time elapsed since the call was matched to this request, which happens as
+  // soon as the call arrives.
+  int64_t queueing_delay_us() const {
+    return static_cast<int64_t>(gpr_timespec_to_micros(
+        gpr_time_sub(gpr_now(GPR_CLOCK_MONOTONIC), matched_)));
+  }
+
  private:
   SyncRequest(Server* server, grpc::internal::RpcServiceMethod* method)
       : server_(server),
@@ -476,6 +483,7 @@ class Server::SyncRequest final : public grpc::internal::CompletionQueueTag {
     data->call = &call_;
     data->initial_metadata = &request_metadata_;
     data->cq = cq_.cq();
+    matched_ = gpr_now(GPR_CLOCK_MONOTONIC);
   }
 
   Server* const server_;
@@ -484,6 +492,7 @@ class Server::SyncRequest final : public grpc::internal::CompletionQueueTag {
   grpc_call* call_;
   grpc_call_details* call_details_ = nullptr;
   gpr_timespec deadline_;
+  gpr_timespec matched_;
   grpc_metadata_array request_metadata_;
   grpc_byte_buffer* request_payload_ = nullptr;
   grpc::CompletionQueue cq_;
@@ -791,6 +800,10 @@ class Server::SyncRequestThreadManager : public grpc::ThreadManager {
     sync_req->Run(global_callbacks_, resources);
   }
 
+  int64_t QueueingDelayUs(void* tag) override {
+    return static_cast<SyncRequest*>(tag)->queueing_delay_us();
+  }
+
   void AddSyncMethod(grpc::internal::RpcServiceMethod* method, void* tag) {
     grpc_core::Server::FromC(server_->server())
         ->SetRegisteredMethodAllocator(server_cq_->cq(), tag, [this, method] {
@@ -917,6 +930,14 @@ Server::Server(
         strcmp(channel_args.args[i].key, GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH)) {
       max_receive_message_size_ = channel_args.args[i].value.integer;
     }
+    if (0 == strcmp(channel_args.args[i].key,
+                    GRPC_ARG_SYNC_SERVER_QUEUEING_DELAY_TARGET_US) &&
+        channel_args.args[i].type == GRPC_ARG_INTEGER &&
+        channel_args.args[i].value.integer > 0) {
+      for (const auto& mgr : sync_req_mgrs_) {
+        mgr->SetQueueingDelayTarget(channel_args.args[i].value.integer);
+      }
+    }
   }
   server_ = grpc_server_create(&channel_args, nullptr);
   grpc_server_set_config_fetcher(server_, server_config_fetcher);
@@ -944,6 +965,10 @@ Server::~Server() {
         }
         callback_cq_.store(nullptr, std::memory_order_release);
       }
+      if (blocking_callback_cq_ != nullptr) {
+        CompletionQueue::ReleaseCallbackAlternativeCQ(blocking_callback_cq_);
+        blocking_callback_cq_ = nullptr;
+      }
     }
   }
   // Destroy health check service before we destroy the C server so that
@@ -983,6 +1008,18 @@ Server::experimental_type::InProcessChannelWithInterceptors(
       std::move(interceptor_creators));
 }
 
+std::vector<uint64_t>
+Server::experimental_type::GetSyncQueueingDelayHistogram() {
+  std::vector<uint64_t> histogram(grpc::ThreadManager::kQueueingDelayBuckets);
+  for (const auto& mgr : server_->sync_req_mgrs_) {
+    std::vector<uint64_t> mgr_histogram = mgr->GetQueueingDelayHistogram();
+    for (size_t i = 0; i < histogram.size(); i++) {
+      histogram[i] += mgr_histogram[i];
+    }
+  }
+  return histogram;
+}
+
 static grpc_server_register_method_payload_handling PayloadHandlingForMethod(
     grpc::internal::RpcServiceMethod* method) {
   switch (method->method_type()) {
@@ -1030,7 +1067,8 @@ bool Server::RegisterService(const std::string* addr, grpc::Service* service) {
     } else {
       has_callback_methods_ = true;
       grpc::internal::RpcServiceMethod* method_value = method.get();
-      grpc::CompletionQueue* cq = CallbackCQ();
+      grpc::CompletionQueue* cq =
+          method->may_block() ? BlockingCallbackCQ() : CallbackCQ();
       grpc_core::Server::FromC(server_)->SetRegisteredMethodAllocator(
           cq->cq(), method_registration_tag, [this, cq, method_value] {
             grpc_core::Server::RegisteredCallAllocation result;
@@ -1273,6 +1311,10 @@ void Server::ShutdownInternal(gpr_timespec deadline) {
     }
     callback_cq_.store(nullptr, std::memory_order_release);
   }
+  if (blocking_callback_cq_ != nullptr) {
+    CompletionQueue::ReleaseCallbackAlternativeCQ(blocking_callback_cq_);
+    blocking_callback_cq_ = nullptr;
+  }
 
   // Drain the shutdown queue (if the previous call to AsyncNext() timed out
   // and we didn't remove the tag from the queue yet)
@@ -1368,4 +1410,16 @@ grpc::CompletionQueue* Server::CallbackCQ() {
   return callback_cq;
 }
 
+grpc::CompletionQueue* Server::BlockingCallbackCQ() {
+  if (grpc_iomgr_run_in_background()) {
+    // Callbacks only ever run inline on gRPC-core's own background pollers.
+    return CallbackCQ();
+  }
+  if (blocking_callback_cq_ == nullptr) {
+    blocking_callback_cq_ =
+        CompletionQueue::CallbackAlternativeCQ(/*may_block=*/true);
+  }
+  return blocking_callback_cq_;
+}
+
 }  // namespace grpc
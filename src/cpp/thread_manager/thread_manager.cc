@@ -18,15 +18,31 @@
 
 #include "src/cpp/thread_manager/thread_manager.h"
 
+#include <algorithm>
 #include <climits>
 
 #include <grpc/support/log.h>
+#include <grpc/support/time.h>
 
 #include "src/core/lib/gprpp/thd.h"
 #include "src/core/lib/iomgr/exec_ctx.h"
 
 namespace grpc {
 
+namespace {
+
+// How often the queueing delay controller revisits its target
+constexpr int64_t kControlIntervalUs = 100 * 1000;
+
+int64_t NowUs() {
+  return static_cast<int64_t>(
+      gpr_timespec_to_micros(gpr_now(GPR_CLOCK_MONOTONIC)));
+}
+
+}  // namespace
+
+constexpr size_t ThreadManager::kQueueingDelayBuckets;
+
 ThreadManager::WorkerThread::WorkerThread(ThreadManager* thd_mgr)
     : thd_mgr_(thd_mgr) {
   // Make thread creation exclusive with respect to its join happening in
@@ -59,12 +75,14 @@ ThreadManager::ThreadManager(const char*, grpc_resource_quota* resource_quota,
       min_pollers_(min_pollers),
       max_pollers_(max_pollers == -1 ? INT_MAX : max_pollers),
       num_threads_(0),
-      max_active_threads_sofar_(0) {}
+      max_active_threads_sofar_(0),
+      target_threads_(min_pollers),
+      queueing_delay_histogram_(kQueueingDelayBuckets) {}
 
 ThreadManager::~ThreadManager() {
   {
     grpc_core::MutexLock lock(&mu_);
-    GPR_ASSERT(num_threads_ == 0);
+    GPR_ASSERT(num_threads_ == 0 && num_exiting_ == 0);
   }
 
   CleanupCompletedThreads();
@@ -72,7 +90,7 @@ ThreadManager::~ThreadManager() {
 
 void ThreadManager::Wait() {
   grpc_core::MutexLock lock(&mu_);
-  while (num_threads_ != 0) {
+  while (num_threads_ != 0 || num_exiting_ != 0) {
     shutdown_cv_.Wait(&mu_);
   }
 }
@@ -92,6 +110,72 @@ int ThreadManager::GetMaxActiveThreadsSoFar() {
   return max_active_threads_sofar_;
 }
 
+int ThreadManager::GetNumThreads() {
+  grpc_core::MutexLock lock(&mu_);
+  return num_threads_;
+}
+
+void ThreadManager::SetQueueingDelayTarget(int64_t target_us) {
+  grpc_core::MutexLock lock(&mu_);
+  queueing_delay_target_us_ = target_us;
+  interval_start_us_ = NowUs();
+}
+
+std::vector<uint64_t> ThreadManager::GetQueueingDelayHistogram() {
+  grpc_core::MutexLock lock(&mu_);
+  return queueing_delay_histogram_;
+}
+
+bool ThreadManager::NeedsPollerLocked() const {
+  if (queueing_delay_target_us_ == 0) return num_pollers_ < min_pollers_;
+  // Without any poller, new work would wait for some work to finish, however
+  // long that takes.
+  return num_pollers_ == 0 ||
+         (num_threads_ < target_threads_ && num_pollers_ < max_pollers_);
+}
+
+bool ThreadManager::HasSurplusThreadLocked() const {
+  return queueing_delay_target_us_ != 0 && num_threads_ > target_threads_ &&
+         num_pollers_ > 0;
+}
+
+void ThreadManager::RecordQueueingDelayLocked(int64_t delay_us) {
+  size_t bucket = 0;
+  while (bucket + 1 < kQueueingDelayBuckets &&
+         (int64_t{1} << bucket) <= delay_us) {
+    bucket++;
+  }
+  queueing_delay_histogram_[bucket]++;
+  if (interval_min_delay_us_ < 0 || delay_us < interval_min_delay_us_) {
+    interval_min_delay_us_ = delay_us;
+  }
+}
+
+void ThreadManager::MaybeUpdateTargetThreadsLocked(int64_t now_us) {
+  const int64_t elapsed_us = now_us - interval_start_us_;
+  if (elapsed_us < kControlIntervalUs) return;
+  if (interval_min_delay_us_ > queueing_delay_target_us_) {
+    // Grow from the current number of threads rather than from the target,
+    // so that the target does not run away while the quota is exhausted.
+    target_threads_ = std::max(target_threads_,
+                               num_threads_ + std::max(1, num_threads_ / 4));
+  } else if (interval_busy_us_ * 2 < elapsed_us * num_threads_) {
+    // Work finishing after the interval is accounted to the next one, which
+    // is fine as long as the intervals are much longer than most work.
+    const int target = std::min(target_threads_, num_threads_);
+    target_threads_ =
+        std::max(min_pollers_, target - std::max(1, target / 8));
+  }
+  interval_start_us_ = now_us;
+  interval_min_delay_us_ = -1;
+  interval_busy_us_ = 0;
+}
+
+void ThreadManager::MarkAsExitingLocked() {
+  num_threads_--;
+  num_exiting_++;
+}
+
 void ThreadManager::MarkAsCompleted(WorkerThread* thd) {
   {
     grpc_core::MutexLock list_lock(&list_mu_);
@@ -100,8 +184,8 @@ void ThreadManager::MarkAsCompleted(WorkerThread* thd) {
 
   {
     grpc_core::MutexLock lock(&mu_);
-    num_threads_--;
-    if (num_threads_ == 0) {
+    num_exiting_--;
+    if (num_threads_ == 0 && num_exiting_ == 0) {
       shutdown_cv_.Signal();
     }
   }
@@ -149,16 +233,24 @@ void ThreadManager::MainWorkLoop() {
     void* tag;
     bool ok;
     WorkStatus work_status = PollForWork(&tag, &ok);
+    const int64_t queueing_delay_us =
+        work_status == WORK_FOUND ? QueueingDelayUs(tag) : -1;
 
     grpc_core::LockableAndReleasableMutexLock lock(&mu_);
     // Reduce the number of pollers by 1 and check what happened with the poll
     num_pollers_--;
+    if (queueing_delay_us >= 0) RecordQueueingDelayLocked(queueing_delay_us);
+    const bool controlled = queueing_delay_target_us_ != 0;
+    if (controlled) MaybeUpdateTargetThreadsLocked(NowUs());
     bool done = false;
     switch (work_status) {
       case TIMEOUT:
         // If we timed out and we have more pollers than we need (or we are
         // shutdown), finish this thread
-        if (shutdown_ || num_pollers_ > max_pollers_) done = true;
+        if (shutdown_ || num_pollers_ > max_pollers_ ||
+            HasSurplusThreadLocked()) {
+          done = true;
+        }
         break;
       case SHUTDOWN:
         // If the thread manager is shutdown, finish this thread
@@ -168,7 +260,7 @@ void ThreadManager::MainWorkLoop() {
         // If we got work and there are now insufficient pollers and there is
         // quota available to create a new thread, start a new poller thread
         bool resource_exhausted = false;
-        if (!shutdown_ && num_pollers_ < min_pollers_) {
+        if (!shutdown_ && NeedsPollerLocked()) {
           if (thread_quota_->Reserve(1)) {
             // We can allocate a new poller thread
             num_pollers_++;
@@ -192,11 +284,17 @@ void ThreadManager::MainWorkLoop() {
           } else if (num_pollers_ > 0) {
             // There is still at least some thread polling, so we can go on
             // even though we are below the number of pollers that we would
-            // like to have (min_pollers_)
+            // like to have (min_pollers_, or the controller's target)
+            if (controlled) {
+              target_threads_ = std::min(target_threads_, num_threads_);
+            }
             lock.Release();
           } else {
             // There are no pollers to spare and we couldn't allocate
             // a new thread, so resources are exhausted!
+            if (controlled) {
+              target_threads_ = std::min(target_threads_, num_threads_);
+            }
             lock.Release();
             resource_exhausted = true;
           }
@@ -208,15 +306,22 @@ void ThreadManager::MainWorkLoop() {
         // Lock is always released at this point - do the application work
         // or return resource exhausted if there is new work but we couldn't
         // get a thread in which to do it.
+        const int64_t work_start_us = controlled ? NowUs() : 0;
         DoWork(tag, ok, !resource_exhausted);
+        const int64_t work_end_us = controlled ? NowUs() : 0;
         // Take the lock again to check post conditions
         lock.Lock();
-        // If we're shutdown, we should finish at this point.
-        if (shutdown_) done = true;
+        interval_busy_us_ += work_end_us - work_start_us;
+        // If we're shutdown, we should finish at this point. So should we if
+        // the controller wants fewer threads.
+        if (shutdown_ || HasSurplusThreadLocked()) done = true;
         break;
     }
     // If we decided to finish the thread, break out of the while loop
-    if (done) break;
+    if (done) {
+      MarkAsExitingLocked();
+      break;
+    }
 
     // Otherwise go back to polling as long as it doesn't exceed max_pollers_
     //
@@ -248,6 +353,7 @@ void ThreadManager::MainWorkLoop() {
     if (num_pollers_ < max_pollers_) {
       num_pollers_++;
     } else {
+      MarkAsExitingLocked();
       break;
     }
   };
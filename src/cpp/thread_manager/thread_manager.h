@@ -19,8 +19,11 @@
 #ifndef GRPC_INTERNAL_CPP_THREAD_MANAGER_H
 #define GRPC_INTERNAL_CPP_THREAD_MANAGER_H
 
+#include <stdint.h>
+
 #include <list>
 #include <memory>
+#include <vector>
 
 #include <grpc/grpc.h>
 #include <grpcpp/support/config.h>
@@ -40,6 +43,17 @@ class ThreadManager {
   // Initializes and Starts the Rpc Manager threads
   void Initialize();
 
+  // Makes the number of threads follow the queueing delay of the work instead
+  // of merely keeping min_pollers threads polling. Every control interval, the
+  // thread manager grows its target number of threads if even the least
+  // delayed work waited longer than target_us (so work queues up persistently
+  // rather than in bursts), and shrinks it if fewer than half of the threads
+  // were busy. Threads above the target exit once idle. The target never goes
+  // below min_pollers, and threads are still reserved from the resource
+  // quota. Requires QueueingDelayUs() to be implemented. Must be called before
+  // Initialize(). A target_us of 0 (the default) disables the controller.
+  void SetQueueingDelayTarget(int64_t target_us);
+
   // The return type of PollForWork() function
   enum WorkStatus { WORK_FOUND, SHUTDOWN, TIMEOUT };
 
@@ -76,6 +90,11 @@ class ThreadManager {
   // actually finds some work
   virtual void DoWork(void* tag, bool ok, bool resources) = 0;
 
+  // Returns how long, in microseconds, the work found by PollForWork() waited
+  // before being found, or -1 if unknown. The tag is the one returned by
+  // PollForWork(), and the call happens right before DoWork().
+  virtual int64_t QueueingDelayUs(void* /*tag*/) { return -1; }
+
   // Mark the ThreadManager as shutdown and begin draining the work. This is a
   // non-blocking call and the caller should call Wait(), a blocking call which
   // returns only once the shutdown is complete
@@ -93,6 +112,18 @@ class ThreadManager {
   // to check if resource_quota is properly being enforced.
   int GetMaxActiveThreadsSoFar();
 
+  // Number of threads currently active, not counting the ones already exiting.
+  // Like GetMaxActiveThreadsSoFar(), mostly useful in unit tests.
+  int GetNumThreads();
+
+  // Number of buckets of the queueing delay histogram. Bucket 0 counts delays
+  // below 1us, bucket i delays in [2^(i-1), 2^i) microseconds, and the last
+  // bucket everything above.
+  static constexpr size_t kQueueingDelayBuckets = 24;
+
+  // Histogram of the queueing delays reported by QueueingDelayUs() so far.
+  std::vector<uint64_t> GetQueueingDelayHistogram();
+
  private:
   // Helper wrapper class around grpc_core::Thread. Takes a ThreadManager object
   // and starts a new grpc_core::Thread to calls the Run() function.
@@ -139,11 +170,22 @@ class ThreadManager {
   // The main function in ThreadManager
   void MainWorkLoop();
 
+  // Takes the calling thread out of num_threads_ once it has decided to exit
+  void MarkAsExitingLocked();
   void MarkAsCompleted(WorkerThread* thd);
   void CleanupCompletedThreads();
 
-  // Protects shutdown_, num_pollers_, num_threads_ and
-  // max_active_threads_sofar_
+  // Whether a thread that found work should start a new poller thread
+  bool NeedsPollerLocked() const;
+  // Whether a thread done with polling or working should exit because there
+  // are more threads than the controller targets
+  bool HasSurplusThreadLocked() const;
+  void RecordQueueingDelayLocked(int64_t delay_us);
+  // Moves target_threads_ at the end of each control interval
+  void MaybeUpdateTargetThreadsLocked(int64_t now_us);
+
+  // Protects shutdown_, num_pollers_, num_threads_, num_exiting_, the
+  // controller state and the queueing delay histogram
   grpc_core::Mutex mu_;
 
   bool shutdown_;
@@ -168,11 +210,27 @@ class ThreadManager {
   // threads that are currently polling i.e num_pollers_)
   int num_threads_;
 
+  // Threads that have decided to exit but have not called MarkAsCompleted()
+  // yet. They no longer count in num_threads_, so that the threads deciding
+  // whether to exit at the same time see them gone.
+  int num_exiting_ = 0;
+
   // See GetMaxActiveThreadsSoFar()'s description.
   // To be more specific, this variable tracks the max value num_threads_ was
   // ever set so far
   int max_active_threads_sofar_;
 
+  // Queueing delay controller, enabled when queueing_delay_target_us_ > 0
+  int64_t queueing_delay_target_us_ = 0;
+  int target_threads_;
+  // State of the current control interval: when it started, the smallest
+  // queueing delay seen (-1 if none) and the time threads spent in DoWork()
+  int64_t interval_start_us_ = 0;
+  int64_t interval_min_delay_us_ = -1;
+  int64_t interval_busy_us_ = 0;
+
+  std::vector<uint64_t> queueing_delay_histogram_;
+
   grpc_core::Mutex list_mu_;
   std::list<WorkerThread*> completed_threads_;
 };
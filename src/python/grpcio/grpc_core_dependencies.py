@@ -38,11 +38,14 @@ CORE_SOURCE_FILES = [
     'src/core/ext/filters/client_channel/lb_policy/grpclb/grpclb_channel_secure.cc',
     'src/core/ext/filters/client_channel/lb_policy/grpclb/grpclb_client_stats.cc',
     'src/core/ext/filters/client_channel/lb_policy/grpclb/load_balancer_api.cc',
+    'src/core/ext/filters/client_channel/lb_policy/least_request/least_request.cc',
     'src/core/ext/filters/client_channel/lb_policy/pick_first/pick_first.cc',
     'src/core/ext/filters/client_channel/lb_policy/priority/priority.cc',
     'src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.cc',
     'src/core/ext/filters/client_channel/lb_policy/rls/rls.cc',
     'src/core/ext/filters/client_channel/lb_policy/round_robin/round_robin.cc',
+    'src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/static_stride_scheduler.cc',
+    'src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/weighted_round_robin.cc',
     'src/core/ext/filters/client_channel/lb_policy/weighted_target/weighted_target.cc',
     'src/core/ext/filters/client_channel/lb_policy/xds/cds.cc',
     'src/core/ext/filters/client_channel/lb_policy/xds/xds_cluster_impl.cc',
@@ -113,6 +116,8 @@ CORE_SOURCE_FILES = [
     'src/core/ext/transport/chttp2/transport/frame_window_update.cc',
     'src/core/ext/transport/chttp2/transport/hpack_encoder.cc',
     'src/core/ext/transport/chttp2/transport/hpack_encoder_table.cc',
+    'src/core/ext/transport/chttp2/transport/hpack_huffman_decoder.cc',
+    'src/core/ext/transport/chttp2/transport/hpack_huffman_encoder.cc',
     'src/core/ext/transport/chttp2/transport/hpack_parser.cc',
     'src/core/ext/transport/chttp2/transport/hpack_parser_table.cc',
     'src/core/ext/transport/chttp2/transport/http2_settings.cc',
@@ -433,6 +438,7 @@ CORE_SOURCE_FILES = [
     'src/core/lib/channel/handshaker_registry.cc',
     'src/core/lib/channel/status_util.cc',
     'src/core/lib/compression/compression.cc',
+    'src/core/lib/compression/compression_dictionary.cc',
     'src/core/lib/compression/compression_internal.cc',
     'src/core/lib/compression/message_compress.cc',
     'src/core/lib/config/core_configuration.cc',
@@ -505,6 +511,7 @@ CORE_SOURCE_FILES = [
     'src/core/lib/iomgr/ev_apple.cc',
     'src/core/lib/iomgr/ev_epoll1_linux.cc',
     'src/core/lib/iomgr/ev_epollex_linux.cc',
+    'src/core/lib/iomgr/ev_io_uring_linux.cc',
     'src/core/lib/iomgr/ev_poll_posix.cc',
     'src/core/lib/iomgr/ev_posix.cc',
     'src/core/lib/iomgr/ev_windows.cc',
@@ -520,6 +527,7 @@ CORE_SOURCE_FILES = [
     'src/core/lib/iomgr/executor.cc',
     'src/core/lib/iomgr/executor/mpmcqueue.cc',
     'src/core/lib/iomgr/executor/threadpool.cc',
+    'src/core/lib/iomgr/executor/work_stealing_threadpool.cc',
     'src/core/lib/iomgr/fork_posix.cc',
     'src/core/lib/iomgr/fork_windows.cc',
     'src/core/lib/iomgr/gethostname_fallback.cc',
@@ -577,6 +585,7 @@ CORE_SOURCE_FILES = [
     'src/core/lib/iomgr/timer_generic.cc',
     'src/core/lib/iomgr/timer_heap.cc',
     'src/core/lib/iomgr/timer_manager.cc',
+    'src/core/lib/iomgr/timer_wheel.cc',
     'src/core/lib/iomgr/unix_sockets_posix.cc',
     'src/core/lib/iomgr/unix_sockets_posix_noop.cc',
     'src/core/lib/iomgr/wakeup_fd_eventfd.cc',
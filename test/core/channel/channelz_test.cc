@@ -532,6 +532,27 @@ TEST(ChannelzServerTest, BasicServerAPIFunctionality) {
   ValidateServer(channelz_server, {3, 3, 3});
 }
 
+TEST(ChannelzSocketTest, SocketOptions) {
+  ExecCtx exec_ctx;
+  auto socket = MakeRefCounted<SocketNode>("ipv4:127.0.0.1:1",
+                                           "ipv4:127.0.0.1:2", "test", nullptr);
+  Json json = socket->RenderJson();
+  EXPECT_EQ(json.object_value().at("data").object_value().count("option"), 0);
+  socket->SetOption("GRPC_TCP_TX_ZEROCOPY", "enabled");
+  socket->SetOption("GRPC_TCP_TX_ZEROCOPY_SEND_BYTES_THRESHOLD", "16384");
+  socket->SetOption("GRPC_TCP_TX_ZEROCOPY", "adaptive");
+  json = socket->RenderJson();
+  const Json::Array& options =
+      json.object_value().at("data").object_value().at("option").array_value();
+  ASSERT_EQ(options.size(), 2);
+  EXPECT_EQ(options[0].object_value().at("name").string_value(),
+            "GRPC_TCP_TX_ZEROCOPY");
+  EXPECT_EQ(options[0].object_value().at("value").string_value(), "adaptive");
+  EXPECT_EQ(options[1].object_value().at("name").string_value(),
+            "GRPC_TCP_TX_ZEROCOPY_SEND_BYTES_THRESHOLD");
+  EXPECT_EQ(options[1].object_value().at("value").string_value(), "16384");
+}
+
 TEST_F(ChannelzRegistryBasedTest, BasicGetServersTest) {
   ExecCtx exec_ctx;
   ServerFixture server;
@@ -0,0 +1,312 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+#include <gtest/gtest.h>
+
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+std::vector<RingHashAddressWeight> MakeAddresses(size_t num_addresses) {
+  std::vector<RingHashAddressWeight> address_weights;
+  for (size_t i = 0; i < num_addresses; ++i) {
+    address_weights.push_back({absl::StrCat("10.0.0.", i, ":443"), 1});
+  }
+  return address_weights;
+}
+
+template <typename T>
+std::vector<size_t> CountEntries(const std::vector<T>& table,
+                                 size_t num_addresses) {
+  std::vector<size_t> counts(num_addresses);
+  for (const T& entry : table) ++counts[entry];
+  return counts;
+}
+
+std::vector<uint32_t> RingIndices(const std::vector<RingHashEntry>& ring) {
+  std::vector<uint32_t> indices;
+  for (const RingHashEntry& entry : ring) indices.push_back(entry.index);
+  return indices;
+}
+
+TEST(RingHashTest, RingFollowsWeights) {
+  std::vector<RingHashAddressWeight> address_weights = MakeAddresses(3);
+  address_weights[1].weight = 2;
+  address_weights[2].weight = 3;
+  std::vector<RingHashEntry> ring = MakeHashRing(address_weights, 1024, 4096);
+  EXPECT_GE(ring.size(), 1024);
+  EXPECT_LE(ring.size(), 4096);
+  std::vector<size_t> counts = CountEntries(RingIndices(ring), 3);
+  EXPECT_NEAR(counts[1], 2 * counts[0], 1);
+  EXPECT_NEAR(counts[2], 3 * counts[0], 1);
+  for (size_t i = 1; i < ring.size(); ++i) {
+    EXPECT_LE(ring[i - 1].hash, ring[i].hash);
+  }
+}
+
+TEST(RingHashTest, FindInHashRing) {
+  const std::vector<RingHashEntry> ring = {{10, 0}, {20, 1}, {30, 2}};
+  EXPECT_EQ(FindInHashRing(ring, 5), 0);
+  EXPECT_EQ(FindInHashRing(ring, 10), 0);
+  EXPECT_EQ(FindInHashRing(ring, 11), 1);
+  EXPECT_EQ(FindInHashRing(ring, 30), 2);
+  // Hashes past the last entry wrap around to the first.
+  EXPECT_EQ(FindInHashRing(ring, 31), 0);
+}
+
+TEST(RingHashTest, MaglevTableIsBalanced) {
+  const size_t kNumAddresses = 10;
+  const size_t kTableSize = 65537;
+  std::vector<uint32_t> table =
+      MakeMaglevTable(MakeAddresses(kNumAddresses), kTableSize);
+  ASSERT_EQ(table.size(), kTableSize);
+  for (size_t count : CountEntries(table, kNumAddresses)) {
+    EXPECT_NEAR(count, kTableSize / kNumAddresses, 1);
+  }
+}
+
+TEST(RingHashTest, MaglevTableFollowsWeights) {
+  std::vector<RingHashAddressWeight> address_weights = MakeAddresses(3);
+  address_weights[1].weight = 2;
+  address_weights[2].weight = 3;
+  const size_t kTableSize = 65537;
+  std::vector<size_t> counts =
+      CountEntries(MakeMaglevTable(address_weights, kTableSize), 3);
+  EXPECT_NEAR(counts[0], kTableSize / 6, 2);
+  EXPECT_NEAR(counts[1], kTableSize * 2 / 6, 2);
+  EXPECT_NEAR(counts[2], kTableSize * 3 / 6, 2);
+}
+
+TEST(RingHashTest, MaglevTableChangesLittleWhenAnAddressIsRemoved) {
+  const size_t kNumAddresses = 10;
+  const size_t kRemoved = 3;
+  const size_t kTableSize = 65537;
+  std::vector<RingHashAddressWeight> address_weights =
+      MakeAddresses(kNumAddresses);
+  std::vector<uint32_t> before = MakeMaglevTable(address_weights, kTableSize);
+  address_weights.erase(address_weights.begin() + kRemoved);
+  std::vector<uint32_t> after = MakeMaglevTable(address_weights, kTableSize);
+  size_t num_moved = 0;
+  for (size_t i = 0; i < kTableSize; ++i) {
+    if (before[i] == kRemoved) continue;
+    const uint32_t new_index = after[i] < kRemoved ? after[i] : after[i] + 1;
+    if (new_index != before[i]) ++num_moved;
+  }
+  // Only the entries of the removed address need to move.  Maglev moves a
+  // few others, but far fewer than a modulo hash would.
+  EXPECT_LT(num_moved, kTableSize / 100);
+}
+
+TEST(RingHashTest, ParseConfig) {
+  grpc_error_handle error = GRPC_ERROR_NONE;
+  Json json = Json::Parse(
+      "{\"lookup_table\":\"MAGLEV\",\"maglev_table_size\":251,"
+      "\"hash_balance_factor\":125}",
+      &error);
+  ASSERT_EQ(error, GRPC_ERROR_NONE) << grpc_error_std_string(error);
+  size_t min_ring_size;
+  size_t max_ring_size;
+  RingHashLookupTable lookup_table;
+  size_t maglev_table_size;
+  uint32_t hash_balance_factor;
+  std::vector<grpc_error_handle> error_list;
+  ParseRingHashLbConfig(json, &min_ring_size, &max_ring_size, &lookup_table,
+                        &maglev_table_size, &hash_balance_factor, &error_list);
+  EXPECT_TRUE(error_list.empty());
+  EXPECT_EQ(lookup_table, RingHashLookupTable::kMaglev);
+  EXPECT_EQ(maglev_table_size, 251);
+  EXPECT_EQ(hash_balance_factor, 125);
+}
+
+TEST(RingHashTest, ParseConfigDefaults) {
+  size_t min_ring_size;
+  size_t max_ring_size;
+  RingHashLookupTable lookup_table;
+  size_t maglev_table_size;
+  uint32_t hash_balance_factor;
+  std::vector<grpc_error_handle> error_list;
+  ParseRingHashLbConfig(Json::Object(), &min_ring_size, &max_ring_size,
+                        &lookup_table, &maglev_table_size,
+                        &hash_balance_factor, &error_list);
+  EXPECT_TRUE(error_list.empty());
+  EXPECT_EQ(lookup_table, RingHashLookupTable::kRing);
+  EXPECT_EQ(maglev_table_size, 65537);
+  EXPECT_EQ(hash_balance_factor, 0);
+}
+
+TEST(RingHashTest, ParseConfigErrors) {
+  grpc_error_handle error = GRPC_ERROR_NONE;
+  Json json = Json::Parse(
+      "{\"lookup_table\":\"CARP\",\"maglev_table_size\":256,"
+      "\"hash_balance_factor\":99}",
+      &error);
+  ASSERT_EQ(error, GRPC_ERROR_NONE) << grpc_error_std_string(error);
+  size_t min_ring_size;
+  size_t max_ring_size;
+  RingHashLookupTable lookup_table;
+  size_t maglev_table_size;
+  uint32_t hash_balance_factor;
+  std::vector<grpc_error_handle> error_list;
+  ParseRingHashLbConfig(json, &min_ring_size, &max_ring_size, &lookup_table,
+                        &maglev_table_size, &hash_balance_factor, &error_list);
+  EXPECT_EQ(error_list.size(), 3);
+  for (grpc_error_handle child : error_list) GRPC_ERROR_UNREF(child);
+}
+
+TEST(RingHashTest, ParseConfigRejectsMaglevTableSizesThatAreNotPrime) {
+  for (const char* size : {"0", "1", "65536", "8388609"}) {
+    grpc_error_handle error = GRPC_ERROR_NONE;
+    Json json = Json::Parse(
+        absl::StrCat("{\"lookup_table\":\"MAGLEV\",\"maglev_table_size\":",
+                     size, "}"),
+        &error);
+    ASSERT_EQ(error, GRPC_ERROR_NONE) << grpc_error_std_string(error);
+    size_t min_ring_size;
+    size_t max_ring_size;
+    RingHashLookupTable lookup_table;
+    size_t maglev_table_size;
+    uint32_t hash_balance_factor;
+    std::vector<grpc_error_handle> error_list;
+    ParseRingHashLbConfig(json, &min_ring_size, &max_ring_size, &lookup_table,
+                          &maglev_table_size, &hash_balance_factor,
+                          &error_list);
+    EXPECT_EQ(error_list.size(), 1) << size;
+    for (grpc_error_handle child : error_list) GRPC_ERROR_UNREF(child);
+  }
+}
+
+TEST(RingHashTest, MaglevTableMustHoldEveryAddress) {
+  EXPECT_TRUE(ValidateMaglevTableSize(251, 1).ok());
+  EXPECT_TRUE(ValidateMaglevTableSize(251, 251).ok());
+  absl::Status status = ValidateMaglevTableSize(251, 252);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(status.message(),
+            "maglev_table_size 251 is smaller than the number of addresses "
+            "(252)");
+}
+
+TEST(RingHashTest, CapacityFactorsFollowReadyWeights) {
+  // A hash_balance_factor of 125 lets each of 4 equal READY addresses have
+  // 125% of a quarter of the calls in flight.
+  std::vector<double> factors =
+      RingHashCapacityFactors({1, 1, 1, 1}, {true, true, true, true}, 125);
+  ASSERT_EQ(factors.size(), 4);
+  for (double factor : factors) EXPECT_DOUBLE_EQ(factor, 0.3125);
+  // Weights scale the shares.
+  factors = RingHashCapacityFactors({1, 3}, {true, true}, 125);
+  EXPECT_DOUBLE_EQ(factors[0], 0.3125);
+  EXPECT_DOUBLE_EQ(factors[1], 0.9375);
+  // Addresses that are not READY get no share, and the others split theirs.
+  factors = RingHashCapacityFactors({1, 1, 1, 1}, {true, false, true, true},
+                                    150);
+  EXPECT_DOUBLE_EQ(factors[0], 0.5);
+  EXPECT_DOUBLE_EQ(factors[1], 0);
+  EXPECT_DOUBLE_EQ(factors[2], 0.5);
+  EXPECT_DOUBLE_EQ(factors[3], 0.5);
+  // Before any address is READY, all of them share.
+  factors = RingHashCapacityFactors({1, 1, 2}, {false, false, false}, 200);
+  EXPECT_DOUBLE_EQ(factors[0], 0.5);
+  EXPECT_DOUBLE_EQ(factors[1], 0.5);
+  EXPECT_DOUBLE_EQ(factors[2], 1);
+}
+
+TEST(RingHashTest, HasCapacityRoundsUp) {
+  // An idle address can always take a call.
+  EXPECT_TRUE(RingHashHasCapacity(0, 0, 0.3125));
+  // With the call being picked, 2 calls would be in flight, and 31.25% of
+  // them rounds up to 1, which the address already has.
+  EXPECT_FALSE(RingHashHasCapacity(1, 1, 0.3125));
+  // 31.25% of 4 calls rounds up to 2.
+  EXPECT_TRUE(RingHashHasCapacity(1, 3, 0.3125));
+  EXPECT_FALSE(RingHashHasCapacity(2, 3, 0.3125));
+  // A share of 0 never has capacity.
+  EXPECT_FALSE(RingHashHasCapacity(0, 10, 0));
+}
+
+// Picks as the ring_hash picker does when loads are bounded, for calls that
+// all hash to position 0 of ring, and stay in flight.  Returns how many
+// calls each address got.
+std::vector<uint32_t> PickWithBoundedLoads(const std::vector<uint32_t>& ring,
+                                           const std::vector<bool>& ready,
+                                           uint32_t hash_balance_factor,
+                                           size_t num_calls) {
+  const std::vector<double> factors = RingHashCapacityFactors(
+      std::vector<uint32_t>(ready.size(), 1), ready, hash_balance_factor);
+  std::vector<uint32_t> counts(ready.size());
+  uint32_t total = 0;
+  for (size_t i = 0; i < num_calls; ++i) {
+    const size_t position = FindRingHashPositionWithCapacity(
+        0, ring.size(), [&](size_t position) {
+          const uint32_t index = ring[position];
+          return ready[index] &&
+                 RingHashHasCapacity(counts[index], total, factors[index]);
+        });
+    ++counts[ring[position]];
+    ++total;
+  }
+  return counts;
+}
+
+TEST(RingHashTest, BoundedLoadsSpillToTheNextAddressAtTheCap) {
+  const std::vector<uint32_t> ring = {0, 0, 1, 2, 1, 3};
+  const std::vector<bool> ready(4, true);
+  // The first call stays with the address that its hash maps to.
+  EXPECT_EQ(PickWithBoundedLoads(ring, ready, 125, 1),
+            std::vector<uint32_t>({1, 0, 0, 0}));
+  // The second would put it over 31.25% of 2 calls, rounded up, so it goes
+  // to the next address in the ring, skipping the other entry for the
+  // first.
+  EXPECT_EQ(PickWithBoundedLoads(ring, ready, 125, 2),
+            std::vector<uint32_t>({1, 1, 0, 0}));
+  // No address gets more than its share of the calls in flight, rounded up,
+  // and the one the calls hash to gets all of that.
+  std::vector<uint32_t> counts = PickWithBoundedLoads(ring, ready, 125, 100);
+  EXPECT_EQ(counts[0], 32);
+  for (uint32_t count : counts) EXPECT_LE(count, 32);
+}
+
+TEST(RingHashTest, BoundedLoadsSkipAddressesThatAreNotReady) {
+  const std::vector<uint32_t> ring = {0, 1, 2};
+  EXPECT_EQ(PickWithBoundedLoads(ring, {true, false, true}, 100, 2),
+            std::vector<uint32_t>({1, 0, 1}));
+}
+
+TEST(RingHashTest, BoundedLoadsStayPutWhenNoAddressHasCapacity) {
+  // Only possible when states change after the capacity factors were
+  // computed.
+  EXPECT_EQ(FindRingHashPositionWithCapacity(
+                1, 3, [](size_t /*position*/) { return false; }),
+            1);
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
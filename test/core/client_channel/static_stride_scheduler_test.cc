@@ -0,0 +1,100 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/ext/filters/client_channel/lb_policy/weighted_round_robin/static_stride_scheduler.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+// Returns how many times each item is picked in num_picks picks.
+std::vector<size_t> CountPicks(const StaticStrideScheduler& scheduler,
+                               size_t num_picks) {
+  std::vector<size_t> counts(scheduler.weights().size());
+  uint64_t sequence = 0;
+  for (size_t i = 0; i < num_picks; ++i) {
+    ++counts[scheduler.Pick([&sequence]() { return sequence++; })];
+  }
+  return counts;
+}
+
+TEST(StaticStrideSchedulerTest, NeedsTwoWeights) {
+  EXPECT_FALSE(StaticStrideScheduler::Make({}).has_value());
+  EXPECT_FALSE(StaticStrideScheduler::Make({0, 0, 0}).has_value());
+  EXPECT_FALSE(StaticStrideScheduler::Make({0, 5, 0}).has_value());
+  EXPECT_TRUE(StaticStrideScheduler::Make({0, 5, 1}).has_value());
+}
+
+TEST(StaticStrideSchedulerTest, ScalesWeights) {
+  auto scheduler = StaticStrideScheduler::Make({1, 2, 4});
+  ASSERT_TRUE(scheduler.has_value());
+  EXPECT_EQ(scheduler->weights(),
+            std::vector<uint16_t>({StaticStrideScheduler::kMaxWeight / 4 + 1,
+                                   StaticStrideScheduler::kMaxWeight / 2 + 1,
+                                   StaticStrideScheduler::kMaxWeight}));
+}
+
+TEST(StaticStrideSchedulerTest, MissingWeightsGetTheMean) {
+  auto scheduler = StaticStrideScheduler::Make({1, 0, 3});
+  ASSERT_TRUE(scheduler.has_value());
+  EXPECT_EQ(scheduler->weights()[1],
+            (StaticStrideScheduler::kMaxWeight * 2 + 1) / 3);
+}
+
+TEST(StaticStrideSchedulerTest, ClampsOutliers) {
+  auto scheduler = StaticStrideScheduler::Make({1, 1000, 1000});
+  ASSERT_TRUE(scheduler.has_value());
+  // The mean is about 667, so the first weight is raised to a tenth of it.
+  EXPECT_NEAR(static_cast<double>(scheduler->weights()[0]) /
+                  scheduler->weights()[1],
+              0.0667, 0.001);
+}
+
+TEST(StaticStrideSchedulerTest, PicksInProportionToWeights) {
+  auto scheduler = StaticStrideScheduler::Make({1, 2, 3, 4});
+  ASSERT_TRUE(scheduler.has_value());
+  const size_t kNumPicks = 100000;
+  std::vector<size_t> counts = CountPicks(*scheduler, kNumPicks);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    EXPECT_NEAR(counts[i], kNumPicks * (i + 1) / 10, kNumPicks / 1000)
+        << "index " << i;
+  }
+}
+
+TEST(StaticStrideSchedulerTest, EqualWeightsPickInTurn) {
+  auto scheduler = StaticStrideScheduler::Make({5, 5, 5});
+  ASSERT_TRUE(scheduler.has_value());
+  uint64_t sequence = 0;
+  for (size_t i = 0; i < 30; ++i) {
+    EXPECT_EQ(scheduler->Pick([&sequence]() { return sequence++; }), i % 3);
+  }
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/lib/compression/compression_dictionary.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include <gtest/gtest.h>
+
+#include <grpc/grpc.h>
+#include <grpc/slice_buffer.h>
+
+#include "src/core/lib/compression/message_compress.h"
+#include "src/core/lib/iomgr/exec_ctx.h"
+#include "src/core/lib/slice/slice_internal.h"
+#include "test/core/util/slice_splitter.h"
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+bool HaveZstd() {
+  return CompressionAlgorithmSet::Supported().IsSet(GRPC_COMPRESS_ZSTD);
+}
+
+// Small messages sharing a layout, as the dictionary is meant for.
+std::string Message(int i) {
+  return absl::StrCat("{\"user_id\":", 1000 + i * 7,
+                      ",\"region\":\"europe-west4\",\"state\":\"RUNNING\","
+                      "\"labels\":{\"team\":\"storage\",\"tier\":\"",
+                      i % 3, "\"},\"sequence\":", i, "}");
+}
+
+std::vector<std::string> Samples() {
+  std::vector<std::string> samples;
+  for (int i = 0; i < 1000; i++) samples.push_back(Message(i));
+  return samples;
+}
+
+class CompressionDictionaryTest : public ::testing::Test {
+ protected:
+  void TearDown() override { CompressionDictionaryRegistry::TestOnlyReset(); }
+};
+
+TEST_F(CompressionDictionaryTest, RegisterRequiresZstd) {
+  auto id = CompressionDictionaryRegistry::Register("/foo.Bar/Baz", "dict");
+  if (!HaveZstd()) {
+    EXPECT_EQ(id.status().code(), absl::StatusCode::kUnimplemented);
+    EXPECT_EQ(CompressionDictionaryRegistry::ForMethod("/foo.Bar/Baz"),
+              nullptr);
+    return;
+  }
+  ASSERT_TRUE(id.ok()) << id.status();
+  EXPECT_NE(*id, 0);
+}
+
+TEST_F(CompressionDictionaryTest, RejectsInvalidRegistrations) {
+  EXPECT_EQ(CompressionDictionaryRegistry::Register("foo.Bar/Baz", "dict")
+                .status()
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(CompressionDictionaryRegistry::Register("/foo.Bar/Baz", "")
+                .status()
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(CompressionDictionaryTest, LookupByMethodAndService) {
+  if (!HaveZstd()) return;
+  auto method_id =
+      CompressionDictionaryRegistry::Register("/foo.Bar/Baz", "method dict");
+  auto service_id =
+      CompressionDictionaryRegistry::Register("/foo.Bar/", "service dict");
+  ASSERT_TRUE(method_id.ok());
+  ASSERT_TRUE(service_id.ok());
+  EXPECT_NE(*method_id, *service_id);
+  EXPECT_EQ(CompressionDictionaryRegistry::ForMethod("/foo.Bar/Baz")->id(),
+            *method_id);
+  EXPECT_EQ(CompressionDictionaryRegistry::ForMethod("/foo.Bar/Qux")->id(),
+            *service_id);
+  EXPECT_EQ(CompressionDictionaryRegistry::ForMethod("/foo.Other/Baz"),
+            nullptr);
+  EXPECT_EQ(CompressionDictionaryRegistry::ForId(*method_id)->data(),
+            "method dict");
+  // Replacing the method's dictionary keeps the old one available by id, for
+  // peers still using it.
+  auto new_id =
+      CompressionDictionaryRegistry::Register("/foo.Bar/Baz", "new dict");
+  ASSERT_TRUE(new_id.ok());
+  EXPECT_EQ(CompressionDictionaryRegistry::ForMethod("/foo.Bar/Baz")->id(),
+            *new_id);
+  EXPECT_NE(CompressionDictionaryRegistry::ForId(*method_id), nullptr);
+}
+
+TEST_F(CompressionDictionaryTest, LookupsRaceWithRegistrations) {
+  if (!HaveZstd()) return;
+  // Each registration replaces the snapshot that the lookups read; the
+  // replaced ones are destroyed as the lookups move on, which leak checkers
+  // and sanitizers would flag if it went wrong.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&done]() {
+      while (!done.load(std::memory_order_relaxed)) {
+        RefCountedPtr<CompressionDictionary> dictionary =
+            CompressionDictionaryRegistry::ForMethod("/foo.Bar/Baz");
+        if (dictionary == nullptr) continue;
+        // Unless a reset came in between, the dictionary is registered by
+        // id too.
+        RefCountedPtr<CompressionDictionary> by_id =
+            CompressionDictionaryRegistry::ForId(dictionary->id());
+        if (by_id != nullptr) {
+          EXPECT_EQ(by_id, dictionary);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 200; i++) {
+    EXPECT_TRUE(CompressionDictionaryRegistry::Register(
+                    "/foo.Bar/Baz", absl::StrCat("dict ", i))
+                    .ok());
+    if (i % 50 == 49) CompressionDictionaryRegistry::TestOnlyReset();
+  }
+  done.store(true);
+  for (auto& reader : readers) reader.join();
+}
+
+TEST_F(CompressionDictionaryTest, TrainedDictionaryRoundTrip) {
+  if (!HaveZstd()) {
+    EXPECT_FALSE(TrainCompressionDictionary(Samples(), 4096).ok());
+    return;
+  }
+  auto trained = TrainCompressionDictionary(Samples(), 4096);
+  ASSERT_TRUE(trained.ok()) << trained.status();
+  EXPECT_LE(trained->size(), 4096);
+  auto id = CompressionDictionaryRegistry::Register("/foo.Bar/", *trained);
+  ASSERT_TRUE(id.ok()) << id.status();
+  RefCountedPtr<CompressionDictionary> dictionary =
+      CompressionDictionaryRegistry::ForId(*id);
+  ASSERT_NE(dictionary, nullptr);
+  ExecCtx exec_ctx;
+  const std::string message = Message(123456);
+  grpc_slice_buffer input;
+  grpc_slice_buffer plain;
+  grpc_slice_buffer primed;
+  grpc_slice_buffer output;
+  grpc_slice_buffer_init(&input);
+  grpc_slice_buffer_init(&plain);
+  grpc_slice_buffer_init(&primed);
+  grpc_slice_buffer_init(&output);
+  grpc_slice_buffer_add(&input, grpc_slice_from_copied_buffer(
+                                    message.data(), message.size()));
+  // Without a dictionary, a message this small barely compresses.
+  const bool plain_compressed = grpc_msg_compress_with_dictionary(
+      GRPC_COMPRESS_ZSTD, 0, nullptr, &input, &plain);
+  ASSERT_TRUE(grpc_msg_compress_with_dictionary(
+      GRPC_COMPRESS_ZSTD, 0, dictionary.get(), &input, &primed));
+  EXPECT_LT(primed.length, plain_compressed ? plain.length : message.size());
+  EXPECT_LT(primed.length * 2, message.size());
+  ASSERT_TRUE(grpc_msg_decompress_with_dictionary(
+      GRPC_COMPRESS_ZSTD, dictionary.get(), &primed, &output));
+  grpc_slice merged = grpc_slice_merge(output.slices, output.count);
+  EXPECT_EQ(StringViewFromSlice(merged), message);
+  grpc_slice_unref_internal(merged);
+  // The same frame cannot be decoded without the dictionary.
+  grpc_slice_buffer_reset_and_unref_internal(&output);
+  EXPECT_FALSE(grpc_msg_decompress(GRPC_COMPRESS_ZSTD, &primed, &output));
+  grpc_slice_buffer_destroy_internal(&input);
+  grpc_slice_buffer_destroy_internal(&plain);
+  grpc_slice_buffer_destroy_internal(&primed);
+  grpc_slice_buffer_destroy_internal(&output);
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  grpc::testing::TestEnvironment env(argc, argv);
+  grpc_init();
+  int r = RUN_ALL_TESTS();
+  grpc_shutdown();
+  return r;
+}
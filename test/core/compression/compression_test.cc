@@ -32,11 +32,10 @@
 
 static void test_compression_algorithm_parse(void) {
   size_t i;
-  const char* valid_names[] = {"identity", "gzip", "deflate"};
+  const char* valid_names[] = {"identity", "gzip", "deflate", "zstd", "lz4"};
   const grpc_compression_algorithm valid_algorithms[] = {
-      GRPC_COMPRESS_NONE,
-      GRPC_COMPRESS_GZIP,
-      GRPC_COMPRESS_DEFLATE,
+      GRPC_COMPRESS_NONE, GRPC_COMPRESS_GZIP, GRPC_COMPRESS_DEFLATE,
+      GRPC_COMPRESS_ZSTD, GRPC_COMPRESS_LZ4,
   };
   const char* invalid_names[] = {"gzip2", "foo", "", "2gzip"};
 
@@ -66,11 +65,10 @@ static void test_compression_algorithm_name(void) {
   int success;
   const char* name;
   size_t i;
-  const char* valid_names[] = {"identity", "gzip", "deflate"};
+  const char* valid_names[] = {"identity", "gzip", "deflate", "zstd", "lz4"};
   const grpc_compression_algorithm valid_algorithms[] = {
-      GRPC_COMPRESS_NONE,
-      GRPC_COMPRESS_GZIP,
-      GRPC_COMPRESS_DEFLATE,
+      GRPC_COMPRESS_NONE, GRPC_COMPRESS_GZIP, GRPC_COMPRESS_DEFLATE,
+      GRPC_COMPRESS_ZSTD, GRPC_COMPRESS_LZ4,
   };
 
   gpr_log(GPR_DEBUG, "test_compression_algorithm_name");
@@ -207,6 +205,29 @@ static void test_compression_algorithm_for_level(void) {
   }
 }
 
+static void test_compression_algorithm_for_level_supported(void) {
+  gpr_log(GPR_DEBUG, "test_compression_algorithm_for_level_supported");
+
+  /* algorithms the build does not support are never picked, even if the peer
+     accepts them */
+  grpc_core::CompressionAlgorithmSet accepted{
+      GRPC_COMPRESS_NONE, GRPC_COMPRESS_GZIP, GRPC_COMPRESS_DEFLATE,
+      GRPC_COMPRESS_ZSTD, GRPC_COMPRESS_LZ4};
+  const grpc_core::CompressionAlgorithmSet supported =
+      grpc_core::CompressionAlgorithmSet::Supported();
+  for (grpc_compression_level level :
+       {GRPC_COMPRESS_LEVEL_LOW, GRPC_COMPRESS_LEVEL_MED,
+        GRPC_COMPRESS_LEVEL_HIGH}) {
+    GPR_ASSERT(supported.IsSet(accepted.CompressionAlgorithmForLevel(level)));
+  }
+  GPR_ASSERT(accepted.CompressionAlgorithmForLevel(GRPC_COMPRESS_LEVEL_LOW) ==
+             (supported.IsSet(GRPC_COMPRESS_LZ4) ? GRPC_COMPRESS_LZ4
+                                                 : GRPC_COMPRESS_GZIP));
+  GPR_ASSERT(accepted.CompressionAlgorithmForLevel(GRPC_COMPRESS_LEVEL_HIGH) ==
+             (supported.IsSet(GRPC_COMPRESS_ZSTD) ? GRPC_COMPRESS_ZSTD
+                                                  : GRPC_COMPRESS_DEFLATE));
+}
+
 static void test_compression_enable_disable_algorithm(void) {
   grpc_compression_options options;
   grpc_compression_algorithm algorithm;
@@ -312,6 +333,7 @@ int main(int argc, char** argv) {
   test_compression_algorithm_parse();
   test_compression_algorithm_name();
   test_compression_algorithm_for_level();
+  test_compression_algorithm_for_level_supported();
   test_compression_enable_disable_algorithm();
   test_channel_args_set_compression_algorithm();
   test_channel_args_compression_algorithm_states();
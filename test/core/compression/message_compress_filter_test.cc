@@ -0,0 +1,502 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Dictionary negotiation of the message compression filters, driven through a
+// channel stack whose last filter stands in for the transport.
+
+#include "src/core/ext/filters/http/message_compress/message_compress_filter.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include <gtest/gtest.h>
+
+#include <grpc/grpc.h>
+#include <grpc/slice_buffer.h>
+#include <grpc/support/alloc.h>
+
+#include "src/core/ext/filters/http/message_compress/message_decompress_filter.h"
+#include "src/core/lib/channel/channel_args.h"
+#include "src/core/lib/channel/channel_stack.h"
+#include "src/core/lib/compression/compression_dictionary.h"
+#include "src/core/lib/compression/compression_internal.h"
+#include "src/core/lib/compression/message_compress.h"
+#include "src/core/lib/iomgr/call_combiner.h"
+#include "src/core/lib/iomgr/exec_ctx.h"
+#include "src/core/lib/resource_quota/resource_quota.h"
+#include "src/core/lib/slice/slice_internal.h"
+#include "src/core/lib/transport/byte_stream.h"
+#include "src/core/lib/transport/error_utils.h"
+#include "src/core/lib/transport/transport.h"
+#include "test/core/util/slice_splitter.h"
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+auto* g_memory_allocator = new MemoryAllocator(
+    ResourceQuota::Default()->memory_quota()->CreateMemoryAllocator("test"));
+
+// Batches that reached the bottom of the stack under test.
+auto* g_captured_batches = new std::vector<grpc_transport_stream_op_batch*>();
+
+bool HaveZstd() {
+  return CompressionAlgorithmSet::Supported().IsSet(GRPC_COMPRESS_ZSTD);
+}
+
+std::string Message(int i) {
+  return absl::StrCat("{\"user_id\":", 1000 + i * 7,
+                      ",\"region\":\"europe-west4\",\"state\":\"RUNNING\","
+                      "\"sequence\":", i, "}");
+}
+
+// A message that compresses with or without a dictionary.
+std::string LongMessage() {
+  std::string message;
+  for (int i = 0; i < 20; i++) message += Message(i);
+  return message;
+}
+
+std::string Dictionary() {
+  std::string dictionary;
+  for (int i = 0; i < 100; i++) dictionary += Message(i);
+  return dictionary;
+}
+
+std::string Decompress(const CompressionDictionary* dictionary,
+                       grpc_slice_buffer* compressed) {
+  grpc_slice_buffer output;
+  grpc_slice_buffer_init(&output);
+  std::string result;
+  if (grpc_msg_decompress_with_dictionary(GRPC_COMPRESS_ZSTD, dictionary,
+                                          compressed, &output)) {
+    grpc_slice merged = grpc_slice_merge(output.slices, output.count);
+    result = std::string(StringViewFromSlice(merged));
+    grpc_slice_unref_internal(merged);
+  }
+  grpc_slice_buffer_destroy_internal(&output);
+  return result;
+}
+
+void DoNothing(void* /*arg*/, grpc_error_handle /*error*/) {}
+
+// The last filter of the stack under test, in place of a transport: it keeps
+// the batches it gets for the test to complete.
+void CaptureStartTransportStreamOpBatch(grpc_call_element* /*elem*/,
+                                        grpc_transport_stream_op_batch* batch) {
+  g_captured_batches->push_back(batch);
+}
+
+void CaptureStartTransportOp(grpc_channel_element* /*elem*/,
+                             grpc_transport_op* /*op*/) {}
+
+grpc_error_handle CaptureInitCallElem(grpc_call_element* /*elem*/,
+                                      const grpc_call_element_args* /*args*/) {
+  return GRPC_ERROR_NONE;
+}
+
+void CaptureDestroyCallElem(grpc_call_element* /*elem*/,
+                            const grpc_call_final_info* /*final_info*/,
+                            grpc_closure* /*then_sched_closure*/) {}
+
+grpc_error_handle CaptureInitChannelElem(grpc_channel_element* /*elem*/,
+                                         grpc_channel_element_args* /*args*/) {
+  return GRPC_ERROR_NONE;
+}
+
+void CaptureDestroyChannelElem(grpc_channel_element* /*elem*/) {}
+
+void CaptureGetChannelInfo(grpc_channel_element* /*elem*/,
+                           const grpc_channel_info* /*channel_info*/) {}
+
+const grpc_channel_filter kCaptureFilter = {
+    CaptureStartTransportStreamOpBatch,
+    nullptr,
+    CaptureStartTransportOp,
+    0,
+    CaptureInitCallElem,
+    grpc_call_stack_ignore_set_pollset_or_pollset_set,
+    CaptureDestroyCallElem,
+    0,
+    CaptureInitChannelElem,
+    CaptureDestroyChannelElem,
+    CaptureGetChannelInfo,
+    "capture"};
+
+// A channel of the filter under test, compressing with zstd by default.
+class TestChannel {
+ public:
+  explicit TestChannel(const grpc_channel_filter* filter) {
+    grpc_arg arg = grpc_channel_arg_integer_create(
+        const_cast<char*>(GRPC_COMPRESSION_CHANNEL_DEFAULT_ALGORITHM),
+        GRPC_COMPRESS_ZSTD);
+    grpc_channel_args args = {1, &arg};
+    const grpc_channel_filter* filters[] = {filter, &kCaptureFilter};
+    stack_ = static_cast<grpc_channel_stack*>(
+        gpr_zalloc(grpc_channel_stack_size(filters, 2)));
+    GPR_ASSERT(GRPC_LOG_IF_ERROR(
+        "grpc_channel_stack_init",
+        grpc_channel_stack_init(1, DoNothing, nullptr, filters, 2, &args,
+                                nullptr, "test", stack_)));
+  }
+
+  ~TestChannel() {
+    grpc_channel_stack_destroy(stack_);
+    gpr_free(stack_);
+  }
+
+  grpc_channel_stack* stack() { return stack_; }
+
+ private:
+  grpc_channel_stack* stack_;
+};
+
+// A call on a TestChannel. Client calls have a path, server calls do not.
+class TestCall {
+ public:
+  TestCall(TestChannel* channel, const char* path)
+      : arena_(Arena::Create(4096, g_memory_allocator)),
+        path_(grpc_slice_from_static_string(path)) {
+    stack_ = static_cast<grpc_call_stack*>(
+        gpr_zalloc(channel->stack()->call_stack_size));
+    const grpc_call_element_args args = {
+        stack_, nullptr, context_, path_,  0, GRPC_MILLIS_INF_FUTURE,
+        arena_, &call_combiner_};
+    GPR_ASSERT(GRPC_LOG_IF_ERROR(
+        "grpc_call_stack_init",
+        grpc_call_stack_init(channel->stack(), 1, DoNothing, nullptr, &args)));
+  }
+
+  ~TestCall() {
+    grpc_call_final_info final_info;
+    grpc_call_stack_destroy(stack_, &final_info, nullptr);
+    gpr_free(stack_);
+    arena_->Destroy();
+  }
+
+  Arena* arena() { return arena_; }
+
+  // Sends initial_metadata and message, and returns the message as it reaches
+  // the transport in compressed.
+  void Send(grpc_metadata_batch* initial_metadata, const std::string& message,
+            grpc_slice_buffer* compressed) {
+    grpc_slice_buffer input;
+    grpc_slice_buffer_init(&input);
+    grpc_slice_buffer_add(&input, grpc_slice_from_copied_buffer(
+                                      message.data(), message.size()));
+    SliceBufferByteStream stream(&input, 0);
+    grpc_transport_stream_op_batch_payload payload(context_);
+    grpc_transport_stream_op_batch batch;
+    grpc_closure on_complete;
+    GRPC_CLOSURE_INIT(&on_complete, DoNothing, nullptr,
+                      grpc_schedule_on_exec_ctx);
+    batch.payload = &payload;
+    batch.on_complete = &on_complete;
+    batch.send_initial_metadata = true;
+    payload.send_initial_metadata.send_initial_metadata = initial_metadata;
+    batch.send_message = true;
+    payload.send_message.send_message.reset(&stream);
+    grpc_transport_stream_op_batch* captured = Start(&batch);
+    // The transport takes the message it sends.
+    OrphanablePtr<ByteStream> sent =
+        std::move(captured->payload->send_message.send_message);
+    EXPECT_NE(sent->flags() & GRPC_WRITE_INTERNAL_COMPRESS, 0);
+    while (compressed->length < sent->length()) {
+      GPR_ASSERT(sent->Next(SIZE_MAX, nullptr));
+      grpc_slice slice;
+      GPR_ASSERT(sent->Pull(&slice) == GRPC_ERROR_NONE);
+      grpc_slice_buffer_add(compressed, slice);
+    }
+    Closure::Run(DEBUG_LOCATION, captured->on_complete, GRPC_ERROR_NONE);
+    ExecCtx::Get()->Flush();
+    grpc_slice_buffer_destroy_internal(&input);
+  }
+
+  // Receives the peer's initial_metadata.
+  void ReceiveInitialMetadata(grpc_metadata_batch* initial_metadata) {
+    grpc_transport_stream_op_batch_payload payload(context_);
+    grpc_transport_stream_op_batch batch;
+    grpc_closure ready;
+    GRPC_CLOSURE_INIT(&ready, DoNothing, nullptr, grpc_schedule_on_exec_ctx);
+    batch.payload = &payload;
+    batch.recv_initial_metadata = true;
+    payload.recv_initial_metadata.recv_initial_metadata = initial_metadata;
+    payload.recv_initial_metadata.recv_initial_metadata_ready = &ready;
+    grpc_transport_stream_op_batch* captured = Start(&batch);
+    Closure::Run(DEBUG_LOCATION,
+                 captured->payload->recv_initial_metadata
+                     .recv_initial_metadata_ready,
+                 GRPC_ERROR_NONE);
+    ExecCtx::Get()->Flush();
+  }
+
+  // Receives the peer's initial_metadata, a message compressed with flags
+  // and the trailing metadata, and returns the status the message failed
+  // with.
+  grpc_status_code Receive(grpc_metadata_batch* initial_metadata,
+                           grpc_slice_buffer* message, uint32_t flags) {
+    grpc_metadata_batch trailing_metadata(arena_);
+    SliceBufferByteStream stream(message, flags);
+    OrphanablePtr<ByteStream> recv_message;
+    grpc_transport_stream_op_batch_payload payload(context_);
+    grpc_transport_stream_op_batch batch;
+    grpc_closure initial_metadata_ready;
+    grpc_closure message_ready;
+    grpc_closure trailing_metadata_ready;
+    grpc_status_code status = GRPC_STATUS_OK;
+    GRPC_CLOSURE_INIT(&initial_metadata_ready, DoNothing, nullptr,
+                      grpc_schedule_on_exec_ctx);
+    GRPC_CLOSURE_INIT(
+        &message_ready,
+        [](void* arg, grpc_error_handle error) {
+          grpc_error_get_status(error, GRPC_MILLIS_INF_FUTURE,
+                                static_cast<grpc_status_code*>(arg), nullptr,
+                                nullptr, nullptr);
+        },
+        &status, grpc_schedule_on_exec_ctx);
+    GRPC_CLOSURE_INIT(&trailing_metadata_ready, DoNothing, nullptr,
+                      grpc_schedule_on_exec_ctx);
+    batch.payload = &payload;
+    batch.recv_initial_metadata = true;
+    payload.recv_initial_metadata.recv_initial_metadata = initial_metadata;
+    payload.recv_initial_metadata.recv_initial_metadata_ready =
+        &initial_metadata_ready;
+    batch.recv_message = true;
+    payload.recv_message.recv_message = &recv_message;
+    payload.recv_message.recv_message_ready = &message_ready;
+    batch.recv_trailing_metadata = true;
+    payload.recv_trailing_metadata.recv_trailing_metadata = &trailing_metadata;
+    payload.recv_trailing_metadata.recv_trailing_metadata_ready =
+        &trailing_metadata_ready;
+    grpc_transport_stream_op_batch* captured = Start(&batch);
+    Closure::Run(DEBUG_LOCATION,
+                 captured->payload->recv_initial_metadata
+                     .recv_initial_metadata_ready,
+                 GRPC_ERROR_NONE);
+    recv_message.reset(&stream);
+    Closure::Run(DEBUG_LOCATION,
+                 captured->payload->recv_message.recv_message_ready,
+                 GRPC_ERROR_NONE);
+    Closure::Run(DEBUG_LOCATION,
+                 captured->payload->recv_trailing_metadata
+                     .recv_trailing_metadata_ready,
+                 GRPC_ERROR_NONE);
+    ExecCtx::Get()->Flush();
+    return status;
+  }
+
+ private:
+  // Starts batch at the top of the stack, and returns it as it reaches the
+  // bottom.
+  grpc_transport_stream_op_batch* Start(grpc_transport_stream_op_batch* batch) {
+    g_captured_batches->clear();
+    grpc_call_element* elem = grpc_call_stack_element(stack_, 0);
+    elem->filter->start_transport_stream_op_batch(elem, batch);
+    ExecCtx::Get()->Flush();
+    GPR_ASSERT(g_captured_batches->size() == 1);
+    return (*g_captured_batches)[0];
+  }
+
+  Arena* arena_;
+  grpc_slice path_;
+  CallCombiner call_combiner_;
+  grpc_call_context_element context_[GRPC_CONTEXT_COUNT] = {};
+  grpc_call_stack* stack_;
+};
+
+class MessageCompressFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!HaveZstd()) GTEST_SKIP() << "zstd is not supported";
+    auto id = CompressionDictionaryRegistry::Register("/foo.Bar/", Dictionary());
+    ASSERT_TRUE(id.ok()) << id.status();
+    dictionary_ = CompressionDictionaryRegistry::ForId(*id);
+  }
+
+  void TearDown() override {
+    dictionary_.reset();
+    CompressionDictionaryRegistry::TestOnlyReset();
+  }
+
+  ExecCtx exec_ctx_;
+  RefCountedPtr<CompressionDictionary> dictionary_;
+};
+
+TEST_F(MessageCompressFilterTest, ClientPrimesOnlyOnceTheServerHoldsIt) {
+  TestChannel channel(&grpc_message_compress_filter);
+  const std::string message = LongMessage();
+  {
+    // The first call advertises the dictionary, but cannot assume the server
+    // holds it.
+    TestCall call(&channel, "/foo.Bar/Baz");
+    grpc_metadata_batch initial_metadata(call.arena());
+    grpc_slice_buffer compressed;
+    grpc_slice_buffer_init(&compressed);
+    call.Send(&initial_metadata, message, &compressed);
+    EXPECT_EQ(initial_metadata.get(GrpcAcceptEncodingDictionaryMetadata()),
+              dictionary_->id());
+    EXPECT_FALSE(initial_metadata.get(GrpcEncodingDictionaryMetadata())
+                     .has_value());
+    EXPECT_EQ(Decompress(nullptr, &compressed), message);
+    grpc_slice_buffer_destroy_internal(&compressed);
+    // The server answers that it holds the dictionary too.
+    grpc_metadata_batch server_initial_metadata(call.arena());
+    server_initial_metadata.Set(GrpcAcceptEncodingDictionaryMetadata(),
+                                dictionary_->id());
+    call.ReceiveInitialMetadata(&server_initial_metadata);
+  }
+  {
+    // The following calls prime their messages with it.
+    TestCall call(&channel, "/foo.Bar/Qux");
+    grpc_metadata_batch initial_metadata(call.arena());
+    grpc_slice_buffer compressed;
+    grpc_slice_buffer_init(&compressed);
+    call.Send(&initial_metadata, message, &compressed);
+    EXPECT_EQ(initial_metadata.get(GrpcAcceptEncodingDictionaryMetadata()),
+              dictionary_->id());
+    EXPECT_EQ(initial_metadata.get(GrpcEncodingDictionaryMetadata()),
+              dictionary_->id());
+    EXPECT_EQ(Decompress(dictionary_.get(), &compressed), message);
+    grpc_slice_buffer_destroy_internal(&compressed);
+  }
+}
+
+TEST_F(MessageCompressFilterTest, ClientIgnoresOtherServerDictionaries) {
+  TestChannel channel(&grpc_message_compress_filter);
+  const std::string message = LongMessage();
+  {
+    TestCall call(&channel, "/foo.Bar/Baz");
+    grpc_metadata_batch initial_metadata(call.arena());
+    grpc_slice_buffer compressed;
+    grpc_slice_buffer_init(&compressed);
+    call.Send(&initial_metadata, message, &compressed);
+    grpc_slice_buffer_destroy_internal(&compressed);
+    grpc_metadata_batch server_initial_metadata(call.arena());
+    server_initial_metadata.Set(GrpcAcceptEncodingDictionaryMetadata(),
+                                dictionary_->id() + 1);
+    call.ReceiveInitialMetadata(&server_initial_metadata);
+  }
+  TestCall call(&channel, "/foo.Bar/Baz");
+  grpc_metadata_batch initial_metadata(call.arena());
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer_init(&compressed);
+  call.Send(&initial_metadata, message, &compressed);
+  EXPECT_FALSE(
+      initial_metadata.get(GrpcEncodingDictionaryMetadata()).has_value());
+  EXPECT_EQ(Decompress(nullptr, &compressed), message);
+  grpc_slice_buffer_destroy_internal(&compressed);
+}
+
+TEST_F(MessageCompressFilterTest, ServerLearnsTheClientDictionary) {
+  TestChannel channel(&grpc_message_compress_filter);
+  TestCall call(&channel, "");
+  grpc_metadata_batch client_initial_metadata(call.arena());
+  client_initial_metadata.Set(GrpcAcceptEncodingDictionaryMetadata(),
+                              dictionary_->id());
+  call.ReceiveInitialMetadata(&client_initial_metadata);
+  const std::string message = LongMessage();
+  grpc_metadata_batch initial_metadata(call.arena());
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer_init(&compressed);
+  call.Send(&initial_metadata, message, &compressed);
+  // The server confirms the dictionary to the client, and uses it right away
+  // since the client holds it.
+  EXPECT_EQ(initial_metadata.get(GrpcAcceptEncodingDictionaryMetadata()),
+            dictionary_->id());
+  EXPECT_EQ(initial_metadata.get(GrpcEncodingDictionaryMetadata()),
+            dictionary_->id());
+  EXPECT_EQ(Decompress(dictionary_.get(), &compressed), message);
+  grpc_slice_buffer_destroy_internal(&compressed);
+}
+
+TEST_F(MessageCompressFilterTest, ServerIgnoresUnknownDictionaries) {
+  TestChannel channel(&grpc_message_compress_filter);
+  TestCall call(&channel, "");
+  grpc_metadata_batch client_initial_metadata(call.arena());
+  client_initial_metadata.Set(GrpcAcceptEncodingDictionaryMetadata(),
+                              dictionary_->id() + 1);
+  call.ReceiveInitialMetadata(&client_initial_metadata);
+  const std::string message = LongMessage();
+  grpc_metadata_batch initial_metadata(call.arena());
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer_init(&compressed);
+  call.Send(&initial_metadata, message, &compressed);
+  EXPECT_FALSE(initial_metadata.get(GrpcAcceptEncodingDictionaryMetadata())
+                   .has_value());
+  EXPECT_FALSE(
+      initial_metadata.get(GrpcEncodingDictionaryMetadata()).has_value());
+  EXPECT_EQ(Decompress(nullptr, &compressed), message);
+  grpc_slice_buffer_destroy_internal(&compressed);
+}
+
+TEST_F(MessageCompressFilterTest, UnknownDictionaryIsUnimplemented) {
+  TestChannel channel(&MessageDecompressFilter);
+  TestCall call(&channel, "");
+  grpc_metadata_batch initial_metadata(call.arena());
+  initial_metadata.Set(GrpcEncodingMetadata(), GRPC_COMPRESS_ZSTD);
+  initial_metadata.Set(GrpcEncodingDictionaryMetadata(), dictionary_->id() + 1);
+  const std::string message = LongMessage();
+  grpc_slice_buffer input;
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer_init(&input);
+  grpc_slice_buffer_init(&compressed);
+  grpc_slice_buffer_add(&input, grpc_slice_from_copied_buffer(
+                                    message.data(), message.size()));
+  ASSERT_TRUE(grpc_msg_compress_with_dictionary(
+      GRPC_COMPRESS_ZSTD, 0, dictionary_.get(), &input, &compressed));
+  EXPECT_EQ(call.Receive(&initial_metadata, &compressed,
+                         GRPC_WRITE_INTERNAL_COMPRESS),
+            GRPC_STATUS_UNIMPLEMENTED);
+  grpc_slice_buffer_destroy_internal(&input);
+  grpc_slice_buffer_destroy_internal(&compressed);
+}
+
+TEST_F(MessageCompressFilterTest, KnownDictionaryDecompresses) {
+  TestChannel channel(&MessageDecompressFilter);
+  TestCall call(&channel, "");
+  grpc_metadata_batch initial_metadata(call.arena());
+  initial_metadata.Set(GrpcEncodingMetadata(), GRPC_COMPRESS_ZSTD);
+  initial_metadata.Set(GrpcEncodingDictionaryMetadata(), dictionary_->id());
+  const std::string message = LongMessage();
+  grpc_slice_buffer input;
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer_init(&input);
+  grpc_slice_buffer_init(&compressed);
+  grpc_slice_buffer_add(&input, grpc_slice_from_copied_buffer(
+                                    message.data(), message.size()));
+  ASSERT_TRUE(grpc_msg_compress_with_dictionary(
+      GRPC_COMPRESS_ZSTD, 0, dictionary_.get(), &input, &compressed));
+  EXPECT_EQ(call.Receive(&initial_metadata, &compressed,
+                         GRPC_WRITE_INTERNAL_COMPRESS),
+            GRPC_STATUS_OK);
+  grpc_slice_buffer_destroy_internal(&input);
+  grpc_slice_buffer_destroy_internal(&compressed);
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  grpc::testing::TestEnvironment env(argc, argv);
+  grpc_init();
+  int r = RUN_ALL_TESTS();
+  grpc_shutdown();
+  return r;
+}
@@ -24,6 +24,7 @@
 #include <grpc/grpc.h>
 #include <grpc/support/log.h>
 
+#include "src/core/lib/compression/compression_internal.h"
 #include "src/core/lib/gpr/murmur_hash.h"
 #include "src/core/lib/gpr/useful.h"
 #include "src/core/lib/iomgr/exec_ctx.h"
@@ -303,6 +304,114 @@ static void test_bad_decompression_algorithm(void) {
   grpc_slice_buffer_destroy(&output);
 }
 
+static void test_reused_contexts(void) {
+  grpc_core::MessageCompressionContexts contexts;
+  grpc_slice_buffer input;
+  grpc_slice_buffer garbage;
+  grpc_slice_buffer first;
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer output;
+
+  grpc_slice_buffer_init(&input);
+  grpc_slice_buffer_init(&garbage);
+  grpc_slice_buffer_init(&first);
+  grpc_slice_buffer_init(&compressed);
+  grpc_slice_buffer_init(&output);
+  grpc_slice_buffer_add(&input, create_test_value(ONE_KB_A));
+  grpc_slice_buffer_add(&garbage,
+                        grpc_slice_from_copied_string("not compressed data"));
+
+  for (int i = 0; i < GRPC_COMPRESS_ALGORITHMS_COUNT; i++) {
+    const auto algorithm = static_cast<grpc_compression_algorithm>(i);
+    if (algorithm == GRPC_COMPRESS_NONE ||
+        !grpc_core::CompressionAlgorithmSet::Supported().IsSet(algorithm)) {
+      continue;
+    }
+    grpc_core::ExecCtx exec_ctx;
+    for (int round = 0; round < 3; round++) {
+      /* messages stay independent: a reused context produces the same bytes
+         as a fresh one, even after failing on the previous message */
+      GPR_ASSERT(grpc_msg_compress_with_dictionary(algorithm, 0, nullptr,
+                                                   &input, &compressed,
+                                                   &contexts));
+      if (round == 0) {
+        GPR_ASSERT(grpc_msg_compress(algorithm, &input, &first));
+      }
+      grpc_slice merged_first = grpc_slice_merge(first.slices, first.count);
+      grpc_slice merged = grpc_slice_merge(compressed.slices, compressed.count);
+      GPR_ASSERT(grpc_slice_eq(merged_first, merged));
+      grpc_slice_unref(merged_first);
+      grpc_slice_unref(merged);
+      GPR_ASSERT(grpc_msg_decompress_with_dictionary(
+          algorithm, nullptr, &compressed, &output, &contexts));
+      GPR_ASSERT(output.length == input.length);
+      grpc_slice_buffer_reset_and_unref(&output);
+      GPR_ASSERT(0 == grpc_msg_decompress_with_dictionary(
+                          algorithm, nullptr, &garbage, &output, &contexts));
+      GPR_ASSERT(output.length == 0);
+      grpc_slice_buffer_reset_and_unref(&compressed);
+    }
+    grpc_slice_buffer_reset_and_unref(&first);
+  }
+
+  grpc_slice_buffer_destroy(&input);
+  grpc_slice_buffer_destroy(&garbage);
+  grpc_slice_buffer_destroy(&first);
+  grpc_slice_buffer_destroy(&compressed);
+  grpc_slice_buffer_destroy(&output);
+}
+
+static void test_block_compression(void) {
+  grpc_slice_buffer input;
+  grpc_slice_buffer compressed;
+  grpc_slice_buffer output;
+
+  /* a mix of repetitive and random data, in slices that straddle blocks */
+  grpc_slice_buffer_init(&input);
+  grpc_slice_buffer_init(&compressed);
+  grpc_slice_buffer_init(&output);
+  uint32_t seed = 1;
+  for (int i = 0; i < 40; i++) {
+    grpc_slice slice = GRPC_SLICE_MALLOC(7777);
+    uint8_t* p = GRPC_SLICE_START_PTR(slice);
+    for (size_t j = 0; j < GRPC_SLICE_LENGTH(slice); j++) {
+      seed = seed * 1103515245 + 12345;
+      p[j] = (j / 64) % 2 == 0 ? static_cast<uint8_t>('a' + j % 7)
+                               : static_cast<uint8_t>(seed >> 24);
+    }
+    grpc_slice_buffer_add(&input, slice);
+  }
+
+  for (grpc_compression_algorithm algorithm :
+       {GRPC_COMPRESS_DEFLATE, GRPC_COMPRESS_GZIP}) {
+    grpc_core::ExecCtx exec_ctx;
+    GPR_ASSERT(grpc_core::BlockMessageCompressor::Supports(algorithm));
+    grpc_core::BlockMessageCompressor compressor(algorithm, &input,
+                                                 32 * 1024 + 5);
+    GPR_ASSERT(compressor.num_blocks() == 10);
+    /* blocks are independent, so may be compressed in any order */
+    for (size_t i = compressor.num_blocks(); i > 0; i--) {
+      compressor.CompressBlock(i - 1);
+    }
+    GPR_ASSERT(compressor.Finish(&compressed));
+    GPR_ASSERT(compressed.length < input.length);
+    /* the blocks make up a single stream that any decoder accepts */
+    GPR_ASSERT(grpc_msg_decompress(algorithm, &compressed, &output));
+    grpc_slice expected = grpc_slice_merge(input.slices, input.count);
+    grpc_slice actual = grpc_slice_merge(output.slices, output.count);
+    GPR_ASSERT(grpc_slice_eq(expected, actual));
+    grpc_slice_unref(expected);
+    grpc_slice_unref(actual);
+    grpc_slice_buffer_reset_and_unref(&compressed);
+    grpc_slice_buffer_reset_and_unref(&output);
+  }
+  GPR_ASSERT(!grpc_core::BlockMessageCompressor::Supports(GRPC_COMPRESS_ZSTD));
+
+  grpc_slice_buffer_destroy(&input);
+  grpc_slice_buffer_destroy(&compressed);
+  grpc_slice_buffer_destroy(&output);
+}
+
 int main(int argc, char** argv) {
   unsigned i, j, k, m;
   grpc_slice_split_mode uncompressed_split_modes[] = {
@@ -315,6 +424,11 @@ int main(int argc, char** argv) {
   grpc_init();
 
   for (i = 0; i < GRPC_COMPRESS_ALGORITHMS_COUNT; i++) {
+    /* zstd and lz4 are only available if the build links them in */
+    if (!grpc_core::CompressionAlgorithmSet::Supported().IsSet(
+            static_cast<grpc_compression_algorithm>(i))) {
+      continue;
+    }
     for (j = 0; j < GPR_ARRAY_SIZE(uncompressed_split_modes); j++) {
       for (k = 0; k < GPR_ARRAY_SIZE(compressed_split_modes); k++) {
         for (m = 0; m < TEST_VALUE_COUNT; m++) {
@@ -338,6 +452,8 @@ int main(int argc, char** argv) {
   test_bad_decompression_data_trailing_garbage();
   test_bad_compression_algorithm();
   test_bad_decompression_algorithm();
+  test_reused_contexts();
+  test_block_compression();
   grpc_shutdown();
 
   return 0;
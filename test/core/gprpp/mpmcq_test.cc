@@ -0,0 +1,162 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/lib/gprpp/mpmcq.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <thread>
+
+#include <grpc/support/log.h>
+#include <grpc/support/sync.h>
+
+#include "src/core/lib/gpr/useful.h"
+#include "src/core/lib/gprpp/thd.h"
+#include "test/core/util/test_config.h"
+
+using grpc_core::MultiProducerMultiConsumerQueue;
+
+typedef struct test_node {
+  size_t i;
+  size_t producer;
+} test_node;
+
+static void test_serial(void) {
+  gpr_log(GPR_DEBUG, "test_serial");
+  MultiProducerMultiConsumerQueue<test_node> q(1024);
+  test_node nodes[1024];
+  // Go around the ring several times.
+  for (size_t lap = 0; lap < 10; lap++) {
+    GPR_ASSERT(q.TryPop() == nullptr);
+    for (size_t i = 0; i < GPR_ARRAY_SIZE(nodes); i++) {
+      nodes[i].i = i;
+      GPR_ASSERT(q.TryPush(&nodes[i]));
+    }
+    test_node extra;
+    GPR_ASSERT(!q.TryPush(&extra));
+    GPR_ASSERT(q.ApproximateSize() == GPR_ARRAY_SIZE(nodes));
+    for (size_t i = 0; i < GPR_ARRAY_SIZE(nodes); i++) {
+      test_node* n = q.TryPop();
+      GPR_ASSERT(n == &nodes[i]);
+      GPR_ASSERT(n->i == i);
+      GPR_ASSERT(q.ApproximateSize() == GPR_ARRAY_SIZE(nodes) - i - 1);
+    }
+  }
+  GPR_ASSERT(q.TryPop() == nullptr);
+  GPR_ASSERT(q.ApproximateSize() == 0);
+}
+
+#define THREAD_ITERATIONS 10000
+#define NUM_PRODUCERS 20
+#define NUM_CONSUMERS 20
+
+typedef struct {
+  MultiProducerMultiConsumerQueue<test_node>* q;
+  gpr_event* start;
+  size_t producer;
+  test_node nodes[THREAD_ITERATIONS];
+} push_args;
+
+static void push_thread(void* arg) {
+  push_args* a = static_cast<push_args*>(arg);
+  gpr_event_wait(a->start, gpr_inf_future(GPR_CLOCK_REALTIME));
+  for (size_t i = 0; i < THREAD_ITERATIONS; i++) {
+    a->nodes[i].i = i;
+    a->nodes[i].producer = a->producer;
+    // The queue is bounded: wait for the consumers to make room.
+    while (!a->q->TryPush(&a->nodes[i])) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+typedef struct {
+  MultiProducerMultiConsumerQueue<test_node>* q;
+  gpr_event* start;
+  std::atomic<size_t>* num_popped;
+  // The last item seen from each producer, plus one.
+  size_t next[NUM_PRODUCERS];
+  size_t spins;
+} pop_args;
+
+static void pop_thread(void* arg) {
+  pop_args* a = static_cast<pop_args*>(arg);
+  gpr_event_wait(a->start, gpr_inf_future(GPR_CLOCK_REALTIME));
+  while (a->num_popped->load() != NUM_PRODUCERS * THREAD_ITERATIONS) {
+    test_node* n = a->q->TryPop();
+    if (n == nullptr) {
+      a->spins++;
+      std::this_thread::yield();
+      continue;
+    }
+    // Each consumer sees the items of any one producer in order.
+    GPR_ASSERT(n->i >= a->next[n->producer]);
+    a->next[n->producer] = n->i + 1;
+    a->num_popped->fetch_add(1);
+  }
+}
+
+static void test_mt(void) {
+  gpr_log(GPR_DEBUG, "test_mt");
+  gpr_event start;
+  gpr_event_init(&start);
+  MultiProducerMultiConsumerQueue<test_node> q(64);
+  std::atomic<size_t> num_popped{0};
+  grpc_core::Thread push_thds[NUM_PRODUCERS];
+  grpc_core::Thread pop_thds[NUM_CONSUMERS];
+  push_args* pushes = new push_args[NUM_PRODUCERS];
+  pop_args pops[NUM_CONSUMERS];
+  for (size_t i = 0; i < NUM_PRODUCERS; i++) {
+    pushes[i].q = &q;
+    pushes[i].start = &start;
+    pushes[i].producer = i;
+    push_thds[i] = grpc_core::Thread("grpc_mt_push", push_thread, &pushes[i]);
+    push_thds[i].Start();
+  }
+  for (size_t i = 0; i < NUM_CONSUMERS; i++) {
+    pops[i].q = &q;
+    pops[i].start = &start;
+    pops[i].num_popped = &num_popped;
+    for (size_t& next : pops[i].next) next = 0;
+    pops[i].spins = 0;
+    pop_thds[i] = grpc_core::Thread("grpc_mt_pop", pop_thread, &pops[i]);
+    pop_thds[i].Start();
+  }
+  gpr_event_set(&start, reinterpret_cast<void*>(1));
+  size_t spins = 0;
+  for (size_t i = 0; i < NUM_CONSUMERS; i++) {
+    pop_thds[i].Join();
+    spins += pops[i].spins;
+  }
+  for (auto& th : push_thds) {
+    th.Join();
+  }
+  gpr_log(GPR_DEBUG, "spins: %" PRIdPTR, spins);
+  GPR_ASSERT(num_popped.load() == NUM_PRODUCERS * THREAD_ITERATIONS);
+  GPR_ASSERT(q.TryPop() == nullptr);
+  delete[] pushes;
+}
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  test_serial();
+  test_mt();
+  return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/lib/gprpp/per_cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+constexpr size_t kNumItems = 7;
+
+TEST(PerCpuTest, ShardsAreZeroedAndClamped) {
+  PerCpu<std::atomic<int>> none(0);
+  EXPECT_EQ(none.size(), 1);
+  PerCpu<std::atomic<int>> many(1000);
+  EXPECT_EQ(many.size(), PerCpu<std::atomic<int>>::kMaxShards);
+  for (size_t i = 0; i < many.size(); i++) {
+    EXPECT_EQ(many[i].load(), 0);
+  }
+}
+
+TEST(PerCpuTest, CpusWrapAroundTheShards) {
+  PerCpu<std::atomic<int>> shards(4);
+  for (unsigned cpu = 0; cpu < 12; cpu++) {
+    shards.ForCpu(cpu).fetch_add(1);
+  }
+  for (size_t i = 0; i < shards.size(); i++) {
+    EXPECT_EQ(shards[i].load(), 3);
+    EXPECT_EQ(&shards.ForCpu(i), &shards[i]);
+  }
+  // Each shard has cachelines of its own.
+  EXPECT_GE(reinterpret_cast<char*>(&shards[1]) -
+                reinterpret_cast<char*>(&shards[0]),
+            GPR_CACHELINE_SIZE);
+}
+
+TEST(PerCpuRoundRobinIndexTest, SingleItem) {
+  PerCpuRoundRobinIndex index(1);
+  EXPECT_EQ(index.num_cursors(), 1);
+  for (unsigned cpu = 0; cpu < 100; cpu++) {
+    EXPECT_EQ(index.Next(cpu), 0);
+  }
+}
+
+TEST(PerCpuRoundRobinIndexTest, StrictOrderOnOneCpu) {
+  PerCpuRoundRobinIndex index(kNumItems);
+  size_t expected = index.Next(0);
+  ASSERT_LT(expected, kNumItems);
+  for (size_t i = 0; i < 10 * kNumItems; i++) {
+    expected = (expected + 1) % kNumItems;
+    EXPECT_EQ(index.Next(0), expected);
+  }
+}
+
+TEST(PerCpuRoundRobinIndexTest, SequentialPicksShareOneCursor) {
+  // Without contention the CPU a pick runs on doesn't matter: picks that
+  // hop between CPUs still see every item in order.
+  PerCpuRoundRobinIndex index(kNumItems);
+  size_t expected = index.Next(0);
+  for (unsigned cpu = 1; cpu < 10 * kNumItems; cpu++) {
+    expected = (expected + 1) % kNumItems;
+    EXPECT_EQ(index.Next(cpu), expected);
+  }
+}
+
+TEST(PerCpuRoundRobinIndexTest, BoundedSkewUnderConcurrentPicks) {
+  constexpr unsigned kNumThreads = 8;
+  constexpr size_t kPicksPerThread = 100000;
+  PerCpuRoundRobinIndex index(kNumItems);
+  std::atomic<size_t> counts[kNumItems];
+  for (auto& count : counts) count.store(0);
+  std::atomic<bool> start{false};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&index, &counts, &start, t]() {
+      while (!start.load()) {
+      }
+      for (size_t i = 0; i < kPicksPerThread; i++) {
+        counts[index.Next(t)].fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  start.store(true);
+  for (auto& thread : threads) thread.join();
+  size_t total = 0;
+  size_t min_count = kNumThreads * kPicksPerThread;
+  size_t max_count = 0;
+  for (const auto& count : counts) {
+    total += count.load();
+    min_count = std::min(min_count, count.load());
+    max_count = std::max(max_count, count.load());
+  }
+  EXPECT_EQ(total, kNumThreads * kPicksPerThread);
+  // Each cursor walks the whole list in order, so it hands out any item at
+  // most once more than any other.
+  EXPECT_LE(max_count - min_count, index.num_cursors())
+      << "min " << min_count << " max " << max_count;
+  // Whether or not the picks collided often enough to go per-CPU, a single
+  // CPU keeps seeing the items in order afterwards.
+  size_t expected = index.Next(3);
+  for (size_t i = 0; i < 10 * kNumItems; i++) {
+    expected = (expected + 1) % kNumItems;
+    EXPECT_EQ(index.Next(3), expected);
+  }
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
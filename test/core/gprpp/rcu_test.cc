@@ -0,0 +1,149 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/lib/gprpp/rcu.h"
+
+#include <inttypes.h>
+
+#include <atomic>
+#include <memory>
+
+#include <grpc/support/log.h>
+#include <grpc/support/sync.h>
+
+#include "src/core/lib/gprpp/thd.h"
+#include "test/core/util/test_config.h"
+
+using grpc_core::RcuPointer;
+
+// Counts the live values, and poisons destroyed ones so that readers using
+// them after they are destroyed trip the assertion.
+struct test_value {
+  explicit test_value(std::atomic<int>* live, int n) : live(live), n(n) {
+    live->fetch_add(1);
+  }
+  ~test_value() {
+    n = -1;
+    live->fetch_sub(1);
+  }
+  std::atomic<int>* live;
+  int n;
+};
+
+static void test_serial(void) {
+  gpr_log(GPR_DEBUG, "test_serial");
+  std::atomic<int> live{0};
+  int wanted = 0;
+  {
+    RcuPointer<test_value> rcu([&wanted] { wanted++; });
+    GPR_ASSERT(rcu.get() == nullptr);
+    rcu.Publish(std::unique_ptr<test_value>(new test_value(&live, 1)));
+    // Without readers, retired values are destroyed right away.
+    rcu.Publish(std::unique_ptr<test_value>(new test_value(&live, 2)));
+    GPR_ASSERT(live.load() == 2);
+    rcu.Reclaim();
+    GPR_ASSERT(live.load() == 1);
+    GPR_ASSERT(rcu.get()->n == 2);
+    {
+      // A reader keeps the value it saw alive, until it is gone.
+      RcuPointer<test_value>::ReadGuard guard(&rcu);
+      GPR_ASSERT(guard->n == 2);
+      rcu.Publish(std::unique_ptr<test_value>(new test_value(&live, 3)));
+      rcu.Reclaim();
+      GPR_ASSERT(live.load() == 2);
+      GPR_ASSERT(guard->n == 2);
+      // New readers see the new value.
+      RcuPointer<test_value>::ReadGuard new_guard(&rcu);
+      GPR_ASSERT(new_guard->n == 3);
+      GPR_ASSERT(wanted == 0);
+    }
+    // The last reader asked for the reclamation it held back.
+    GPR_ASSERT(wanted == 1);
+    rcu.Reclaim();
+    GPR_ASSERT(live.load() == 1);
+    rcu.Publish(nullptr);
+    rcu.Reclaim();
+    GPR_ASSERT(live.load() == 0);
+    GPR_ASSERT(wanted == 1);
+  }
+}
+
+#define NUM_READERS 16
+#define NUM_UPDATES 10000
+
+typedef struct {
+  RcuPointer<test_value>* rcu;
+  gpr_event* start;
+  std::atomic<bool>* done;
+  size_t reads;
+} read_args;
+
+static void read_thread(void* arg) {
+  read_args* a = static_cast<read_args*>(arg);
+  gpr_event_wait(a->start, gpr_inf_future(GPR_CLOCK_REALTIME));
+  while (!a->done->load()) {
+    RcuPointer<test_value>::ReadGuard guard(a->rcu);
+    // Values are only ever replaced by larger ones.
+    GPR_ASSERT(guard->n > 0);
+    a->reads++;
+  }
+}
+
+static void test_mt(void) {
+  gpr_log(GPR_DEBUG, "test_mt");
+  gpr_event start;
+  gpr_event_init(&start);
+  std::atomic<int> live{0};
+  std::atomic<bool> done{false};
+  std::atomic<size_t> wanted{0};
+  RcuPointer<test_value> rcu([&wanted] { wanted.fetch_add(1); });
+  rcu.Publish(std::unique_ptr<test_value>(new test_value(&live, 1)));
+  grpc_core::Thread thds[NUM_READERS];
+  read_args reads[NUM_READERS];
+  for (size_t i = 0; i < NUM_READERS; i++) {
+    reads[i].rcu = &rcu;
+    reads[i].start = &start;
+    reads[i].done = &done;
+    reads[i].reads = 0;
+    thds[i] = grpc_core::Thread("grpc_rcu_read", read_thread, &reads[i]);
+    thds[i].Start();
+  }
+  gpr_event_set(&start, reinterpret_cast<void*>(1));
+  for (int i = 2; i <= NUM_UPDATES; i++) {
+    rcu.Publish(std::unique_ptr<test_value>(new test_value(&live, i)));
+    rcu.Reclaim();
+  }
+  done.store(true);
+  size_t total_reads = 0;
+  for (size_t i = 0; i < NUM_READERS; i++) {
+    thds[i].Join();
+    total_reads += reads[i].reads;
+  }
+  gpr_log(GPR_DEBUG, "reads: %" PRIuPTR ", reclaims wanted: %" PRIuPTR,
+          total_reads, wanted.load());
+  rcu.Reclaim();
+  GPR_ASSERT(live.load() == 1);
+  GPR_ASSERT(rcu.get()->n == NUM_UPDATES);
+}
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  test_serial();
+  test_mt();
+  return 0;
+}
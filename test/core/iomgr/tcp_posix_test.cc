@@ -311,6 +311,68 @@ static void large_read_test(size_t slice_size) {
       static_cast<grpc_resource_quota*>(a[1].value.pointer.p));
 }
 
+/* Write to an inet socket, then read from it using the grpc_tcp API with TCP
+   RX zerocopy enabled. Loopback traffic is not page aligned, so this mostly
+   exercises the fallback to copying reads. */
+static void rx_zerocopy_read_test(size_t num_bytes) {
+  int sv[2];
+  grpc_endpoint* ep;
+  struct read_socket_state state;
+  size_t written_bytes;
+  grpc_millis deadline =
+      grpc_timespec_to_millis_round_up(grpc_timeout_seconds_to_deadline(20));
+  grpc_core::ExecCtx exec_ctx;
+
+  gpr_log(GPR_INFO, "RX zerocopy read test of size %" PRIuPTR, num_bytes);
+
+  create_inet_sockets(sv);
+
+  grpc_arg a[3];
+  a[0].key = const_cast<char*>(GRPC_ARG_TCP_RX_ZEROCOPY_ENABLED);
+  a[0].type = GRPC_ARG_INTEGER;
+  a[0].value.integer = 1;
+  a[1].key = const_cast<char*>(GRPC_ARG_TCP_RX_ZEROCOPY_RECV_BYTES_THRESHOLD);
+  a[1].type = GRPC_ARG_INTEGER;
+  a[1].value.integer = 4096;
+  a[2].key = const_cast<char*>(GRPC_ARG_RESOURCE_QUOTA);
+  a[2].type = GRPC_ARG_POINTER;
+  a[2].value.pointer.p = grpc_resource_quota_create("test");
+  a[2].value.pointer.vtable = grpc_resource_quota_arg_vtable();
+  grpc_channel_args args = {GPR_ARRAY_SIZE(a), a};
+  ep = grpc_tcp_create(grpc_fd_create(sv[0], "rx_zerocopy_read_test", false),
+                       &args, "test");
+  grpc_endpoint_add_to_pollset(ep, g_pollset);
+
+  written_bytes = fill_socket_partial(sv[1], num_bytes);
+  gpr_log(GPR_INFO, "Wrote %" PRIuPTR " bytes", written_bytes);
+
+  state.ep = ep;
+  state.read_bytes = 0;
+  state.target_read_bytes = written_bytes;
+  grpc_slice_buffer_init(&state.incoming);
+  GRPC_CLOSURE_INIT(&state.read_cb, read_cb, &state, grpc_schedule_on_exec_ctx);
+
+  grpc_endpoint_read(ep, &state.incoming, &state.read_cb, /*urgent=*/false);
+
+  gpr_mu_lock(g_mu);
+  while (state.read_bytes < state.target_read_bytes) {
+    grpc_pollset_worker* worker = nullptr;
+    GPR_ASSERT(GRPC_LOG_IF_ERROR(
+        "pollset_work", grpc_pollset_work(g_pollset, &worker, deadline)));
+    gpr_mu_unlock(g_mu);
+
+    gpr_mu_lock(g_mu);
+  }
+  GPR_ASSERT(state.read_bytes == state.target_read_bytes);
+  gpr_mu_unlock(g_mu);
+
+  grpc_slice_buffer_destroy_internal(&state.incoming);
+  grpc_endpoint_destroy(ep);
+  close(sv[1]);
+  grpc_resource_quota_unref(
+      static_cast<grpc_resource_quota*>(a[2].value.pointer.p));
+}
+
 struct write_socket_state {
   grpc_endpoint* ep;
   int write_done;
@@ -590,6 +652,8 @@ void run_tests(void) {
   read_test(10000, 1);
   large_read_test(8192);
   large_read_test(1);
+  rx_zerocopy_read_test(100);
+  rx_zerocopy_read_test(1024 * 1024);
 
   write_test(100, 8192, false);
   write_test(100, 1, false);
@@ -30,7 +30,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include <grpc/grpc.h>
 #include <grpc/support/alloc.h>
@@ -39,6 +41,7 @@
 #include <grpc/support/time.h>
 
 #include "src/core/lib/address_utils/sockaddr_utils.h"
+#include "src/core/lib/channel/channel_args.h"
 #include "src/core/lib/gprpp/memory.h"
 #include "src/core/lib/iomgr/error.h"
 #include "src/core/lib/iomgr/iomgr.h"
@@ -53,6 +56,12 @@
 static gpr_mu* g_mu;
 static grpc_pollset* g_pollset;
 static int g_nconnects = 0;
+/* A second pollset for servers started with more than one, polled by
+   tcp_connect() when set. */
+static gpr_mu* g_extra_mu;
+static grpc_pollset* g_extra_pollset;
+/* The pollset passed to the last on_connect(). */
+static grpc_pollset* g_connect_pollset;
 
 typedef struct {
   /* Owns a ref to server. */
@@ -143,7 +152,7 @@ static void test_addr_init_str(test_addr* addr) {
 }
 
 static void on_connect(void* /*arg*/, grpc_endpoint* tcp,
-                       grpc_pollset* /*pollset*/,
+                       grpc_pollset* pollset,
                        grpc_tcp_server_acceptor* acceptor) {
   grpc_endpoint_shutdown(tcp,
                          GRPC_ERROR_CREATE_FROM_STATIC_STRING("Connected"));
@@ -155,6 +164,7 @@ static void on_connect(void* /*arg*/, grpc_endpoint* tcp,
 
   gpr_mu_lock(g_mu);
   g_result = temp_result;
+  g_connect_pollset = pollset;
   g_nconnects++;
   GPR_ASSERT(
       GRPC_LOG_IF_ERROR("pollset_kick", grpc_pollset_kick(g_pollset, nullptr)));
@@ -267,7 +277,13 @@ static grpc_error_handle tcp_connect(const test_addr* remote,
          deadline > grpc_core::ExecCtx::Get()->Now()) {
     grpc_pollset_worker* worker = nullptr;
     grpc_error_handle err;
-    if ((err = grpc_pollset_work(g_pollset, &worker, deadline)) !=
+    /* Take turns with the extra pollset, which may own the listener that
+       accepts the connection. */
+    grpc_millis poll_deadline =
+        g_extra_pollset == nullptr
+            ? deadline
+            : std::min(deadline, grpc_core::ExecCtx::Get()->Now() + 10);
+    if ((err = grpc_pollset_work(g_pollset, &worker, poll_deadline)) !=
         GRPC_ERROR_NONE) {
       gpr_mu_unlock(g_mu);
       close(clifd);
@@ -275,6 +291,18 @@ static grpc_error_handle tcp_connect(const test_addr* remote,
     }
     gpr_mu_unlock(g_mu);
 
+    if (g_extra_pollset != nullptr) {
+      gpr_mu_lock(g_extra_mu);
+      grpc_core::ExecCtx::Get()->InvalidateNow();
+      err = grpc_pollset_work(g_extra_pollset, nullptr,
+                              grpc_core::ExecCtx::Get()->Now() + 10);
+      gpr_mu_unlock(g_extra_mu);
+      if (err != GRPC_ERROR_NONE) {
+        close(clifd);
+        return err;
+      }
+    }
+
     gpr_mu_lock(g_mu);
   }
   gpr_log(GPR_DEBUG, "wait done");
@@ -449,6 +477,86 @@ static void destroy_pollset(void* p, grpc_error_handle /*error*/) {
   grpc_pollset_destroy(static_cast<grpc_pollset*>(p));
 }
 
+/* Tests a tcp server on a wildcard port started with two pollsets, which on
+   platforms with SO_REUSEPORT gives each pollset its own listener for the port.
+   With sharded_listeners, connections must be handed to the pollset of the
+   listener that accepted them. */
+static void test_connect_with_pollsets(bool sharded_listeners) {
+  grpc_core::ExecCtx exec_ctx;
+  grpc_resolved_address resolved_addr;
+  struct sockaddr_in* addr =
+      reinterpret_cast<struct sockaddr_in*>(resolved_addr.addr);
+  grpc_tcp_server* s;
+  const int kNumConnects = 20;
+  gpr_log(GPR_INFO, "test_connect_with_pollsets sharded_listeners=%d",
+          sharded_listeners);
+  grpc_arg arg = grpc_channel_arg_integer_create(
+      const_cast<char*>(GRPC_ARG_SHARDED_LISTENERS), sharded_listeners);
+  grpc_channel_args channel_args = {1, &arg};
+  const grpc_channel_args* args = grpc_core::CoreConfiguration::Get()
+                                      .channel_args_preconditioning()
+                                      .PreconditionChannelArgs(&channel_args);
+  GPR_ASSERT(GRPC_ERROR_NONE == grpc_tcp_server_create(nullptr, args, &s));
+  grpc_channel_args_destroy(args);
+
+  memset(&resolved_addr, 0, sizeof(resolved_addr));
+  resolved_addr.len = static_cast<socklen_t>(sizeof(struct sockaddr_in));
+  addr->sin_family = AF_INET;
+  int port = -1;
+  GPR_ASSERT(grpc_tcp_server_add_port(s, &resolved_addr, &port) ==
+                 GRPC_ERROR_NONE &&
+             port > 0);
+
+  g_extra_pollset =
+      static_cast<grpc_pollset*>(gpr_zalloc(grpc_pollset_size()));
+  grpc_pollset_init(g_extra_pollset, &g_extra_mu);
+  std::vector<grpc_pollset*> pollsets = {g_pollset, g_extra_pollset};
+  grpc_tcp_server_start(s, &pollsets, on_connect, nullptr);
+  gpr_log(GPR_INFO, "%d listeners on port %d",
+          grpc_tcp_server_port_fd_count(s, 0), port);
+
+  test_addr dst;
+  memset(&dst, 0, sizeof(dst));
+  dst.addr.len = static_cast<socklen_t>(sizeof(struct sockaddr_in));
+  struct sockaddr_in* dst_addr =
+      reinterpret_cast<struct sockaddr_in*>(dst.addr.addr);
+  dst_addr->sin_family = AF_INET;
+  dst_addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  GPR_ASSERT(grpc_sockaddr_set_port(&dst.addr, port));
+  test_addr_init_str(&dst);
+
+  std::map<unsigned, grpc_pollset*> pollset_by_fd_index;
+  for (int i = 0; i < kNumConnects; ++i) {
+    on_connect_result result;
+    on_connect_result_init(&result);
+    GPR_ASSERT(GRPC_LOG_IF_ERROR("tcp_connect", tcp_connect(&dst, &result)));
+    GPR_ASSERT(result.port_index == 0);
+    GPR_ASSERT(result.fd_index <
+               static_cast<unsigned>(grpc_tcp_server_port_fd_count(s, 0)));
+    GPR_ASSERT(g_connect_pollset == g_pollset ||
+               g_connect_pollset == g_extra_pollset);
+    if (sharded_listeners) {
+      /* Every connection from a listener goes to the same pollset. */
+      auto it = pollset_by_fd_index.emplace(result.fd_index, g_connect_pollset)
+                    .first;
+      GPR_ASSERT(it->second == g_connect_pollset);
+    }
+  }
+
+  grpc_tcp_server_unref(s);
+  grpc_core::ExecCtx::Get()->Flush();
+
+  grpc_closure destroyed;
+  GRPC_CLOSURE_INIT(&destroyed, destroy_pollset, g_extra_pollset,
+                    grpc_schedule_on_exec_ctx);
+  gpr_mu_lock(g_extra_mu);
+  grpc_pollset_shutdown(g_extra_pollset, &destroyed);
+  gpr_mu_unlock(g_extra_mu);
+  grpc_core::ExecCtx::Get()->Flush();
+  gpr_free(g_extra_pollset);
+  g_extra_pollset = nullptr;
+}
+
 int main(int argc, char** argv) {
   grpc_closure destroyed;
   grpc_arg chan_args[1];
@@ -518,6 +626,10 @@ int main(int argc, char** argv) {
     /* Test connect(2) with dst_addrs. */
     test_connect(10, &channel_args, dst_addrs, false);
 
+    /* Listeners for several pollsets, shared and sharded. */
+    test_connect_with_pollsets(false);
+    test_connect_with_pollsets(true);
+
     GRPC_CLOSURE_INIT(&destroyed, destroy_pollset, g_pollset,
                       grpc_schedule_on_exec_ctx);
     grpc_pollset_shutdown(g_pollset, &destroyed);
@@ -0,0 +1,200 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "src/core/lib/iomgr/port.h"
+
+// This test won't work except with posix sockets enabled
+#ifdef GRPC_POSIX_SOCKET_TCP
+
+#include "src/core/lib/iomgr/tcp_zerocopy_send_ctx.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+constexpr size_t kKiB = 1024;
+// Copies of the constants the tests compare against, which would otherwise
+// be ODR-used by the EXPECT macros.
+const size_t kMinThreshold = TcpZerocopySendCtx::kMinSendBytesThreshold;
+const size_t kMaxThreshold = TcpZerocopySendCtx::kMaxSendBytesThreshold;
+const size_t kNoThreshold = TcpZerocopySendCtx::kNoSendBytesThreshold;
+const int kRetuneCompletions = TcpZerocopySendCtx::kRetuneCompletions;
+
+// Takes send records until the in-flight limit is reached.
+std::vector<TcpZerocopySendRecord*> TakeRecords(TcpZerocopySendCtx* ctx) {
+  std::vector<TcpZerocopySendRecord*> records;
+  while (TcpZerocopySendRecord* record = ctx->GetSendRecord()) {
+    records.push_back(record);
+  }
+  return records;
+}
+
+void PutRecords(TcpZerocopySendCtx* ctx,
+                std::vector<TcpZerocopySendRecord*>* records) {
+  for (TcpZerocopySendRecord* record : *records) ctx->PutSendRecord(record);
+  records->clear();
+}
+
+// Feeds the ctx estimates whose crossover is completion_ns / (copy_ns -
+// zerocopy_ns) bytes, and one window of completions to retune on.
+void RetuneWith(TcpZerocopySendCtx* ctx, double copy_ns_per_byte,
+                double zerocopy_ns_per_byte, int64_t completion_ns,
+                uint32_t copied = 0) {
+  ctx->NoteCopySend(64 * kKiB, static_cast<int64_t>(copy_ns_per_byte * 64 *
+                                                     kKiB));
+  ctx->NoteZerocopySend(
+      64 * kKiB, static_cast<int64_t>(zerocopy_ns_per_byte * 64 * kKiB));
+  ctx->NoteCompletions(kRetuneCompletions, copied,
+                       completion_ns * kRetuneCompletions);
+}
+
+TEST(TcpZerocopySendCtxTest, GrowInflightLimitDoublesUpToMaxSends) {
+  TcpZerocopySendCtx ctx(16, 16 * kKiB, /*adaptive=*/true);
+  ctx.set_enabled(true);
+  std::vector<TcpZerocopySendRecord*> records = TakeRecords(&ctx);
+  EXPECT_EQ(records.size(), 4);
+  EXPECT_TRUE(ctx.GrowInflightLimit());
+  std::vector<TcpZerocopySendRecord*> more = TakeRecords(&ctx);
+  EXPECT_EQ(more.size(), 4);
+  EXPECT_TRUE(ctx.GrowInflightLimit());
+  records.insert(records.end(), more.begin(), more.end());
+  more = TakeRecords(&ctx);
+  EXPECT_EQ(more.size(), 8);
+  // All the records allocated are in use.
+  EXPECT_FALSE(ctx.GrowInflightLimit());
+  EXPECT_EQ(ctx.GetSendRecord(), nullptr);
+  PutRecords(&ctx, &more);
+  PutRecords(&ctx, &records);
+  EXPECT_TRUE(ctx.AllSendRecordsEmpty());
+}
+
+TEST(TcpZerocopySendCtxTest, GrowInflightLimitOnlyWhenAdaptive) {
+  TcpZerocopySendCtx fixed(8, 16 * kKiB, /*adaptive=*/false);
+  fixed.set_enabled(true);
+  std::vector<TcpZerocopySendRecord*> records = TakeRecords(&fixed);
+  EXPECT_EQ(records.size(), 8);
+  EXPECT_FALSE(fixed.GrowInflightLimit());
+  PutRecords(&fixed, &records);
+  // Adaptive tuning only starts once zerocopy is enabled on the socket.
+  TcpZerocopySendCtx disabled(8, 16 * kKiB, /*adaptive=*/true);
+  EXPECT_FALSE(disabled.GrowInflightLimit());
+}
+
+TEST(TcpZerocopySendCtxTest, RetuneMovesThresholdToCrossover) {
+  TcpZerocopySendCtx ctx(16, 16 * kKiB, /*adaptive=*/true);
+  ctx.set_enabled(true);
+  // Saving 0.75ns per byte pays for a 6us completion from 8000 bytes on.
+  ctx.NoteCopySend(64 * kKiB, 64 * kKiB);
+  ctx.NoteZerocopySend(64 * kKiB, 16 * kKiB);
+  ctx.NoteCompletions(kRetuneCompletions - 1, 0,
+                      6000 * (kRetuneCompletions - 1));
+  // Nothing changes until a whole window of completions came in.
+  EXPECT_EQ(ctx.threshold_bytes(), 16 * kKiB);
+  ctx.NoteCompletions(1, 0, 6000);
+  EXPECT_EQ(ctx.threshold_bytes(), 8000);
+}
+
+TEST(TcpZerocopySendCtxTest, RetuneKeepsThresholdInRange) {
+  TcpZerocopySendCtx ctx(16, 16 * kKiB, /*adaptive=*/true);
+  ctx.set_enabled(true);
+  RetuneWith(&ctx, 1.0, 0.25, 100);
+  EXPECT_EQ(ctx.threshold_bytes(), kMinThreshold);
+  // Zerocopy costing more per byte than copying never pays off.
+  TcpZerocopySendCtx slower(16, 16 * kKiB, /*adaptive=*/true);
+  slower.set_enabled(true);
+  RetuneWith(&slower, 0.5, 1.0, 6000);
+  EXPECT_EQ(slower.threshold_bytes(), kMaxThreshold);
+}
+
+TEST(TcpZerocopySendCtxTest, RetuneStopsZerocopyWhenKernelCopies) {
+  TcpZerocopySendCtx ctx(16, 16 * kKiB, /*adaptive=*/true);
+  ctx.set_enabled(true);
+  RetuneWith(&ctx, 1.0, 0.25, 6000, /*copied=*/kRetuneCompletions / 2 + 1);
+  EXPECT_EQ(ctx.threshold_bytes(), kNoThreshold);
+  // Only the occasional probe still uses zerocopy, to notice if that changes.
+  int probes = 0;
+  for (int i = 0; i < 4 * TcpZerocopySendCtx::kProbeInterval; ++i) {
+    if (ctx.ShouldProbe(64 * kKiB)) ++probes;
+  }
+  EXPECT_EQ(probes, 4);
+  EXPECT_FALSE(ctx.ShouldProbe(kMinThreshold - 1));
+}
+
+TEST(TcpZerocopySendCtxTest, RetuneGivesBackUnusedInflightHeadroom) {
+  TcpZerocopySendCtx ctx(16, 16 * kKiB, /*adaptive=*/true);
+  ctx.set_enabled(true);
+  std::vector<TcpZerocopySendRecord*> records = TakeRecords(&ctx);
+  ASSERT_EQ(records.size(), 4);
+  ASSERT_TRUE(ctx.GrowInflightLimit());
+  PutRecords(&ctx, &records);
+  // At most half of the limit of 8 was used, so it drops back to 4.
+  ctx.NoteCompletions(kRetuneCompletions, 0, 0);
+  records = TakeRecords(&ctx);
+  EXPECT_EQ(records.size(), 4);
+  ASSERT_TRUE(ctx.GrowInflightLimit());
+  std::vector<TcpZerocopySendRecord*> more = TakeRecords(&ctx);
+  EXPECT_EQ(more.size(), 4);
+  PutRecords(&ctx, &more);
+  PutRecords(&ctx, &records);
+  // The whole limit of 8 was used, so it stays.
+  ctx.NoteCompletions(kRetuneCompletions, 0, 0);
+  records = TakeRecords(&ctx);
+  EXPECT_EQ(records.size(), 8);
+  PutRecords(&ctx, &records);
+  // It never drops below the default.
+  for (int i = 0; i < 3; ++i) ctx.NoteCompletions(kRetuneCompletions, 0, 0);
+  records = TakeRecords(&ctx);
+  EXPECT_EQ(records.size(), 4);
+  PutRecords(&ctx, &records);
+}
+
+TEST(TcpZerocopySendCtxTest, ExplicitThresholdStaysFixed) {
+  // grpc_tcp_create turns adaptive tuning off when the application sets
+  // GRPC_ARG_TCP_TX_ZEROCOPY_SEND_BYTES_THRESHOLD.
+  TcpZerocopySendCtx ctx(4, 8 * kKiB, /*adaptive=*/false);
+  ctx.set_enabled(true);
+  EXPECT_FALSE(ctx.adaptive());
+  for (int i = 0; i < 4; ++i) {
+    RetuneWith(&ctx, 1.0, 0.25, 6000, /*copied=*/kRetuneCompletions);
+  }
+  EXPECT_EQ(ctx.threshold_bytes(), 8 * kKiB);
+  EXPECT_FALSE(ctx.ShouldProbe(64 * kKiB));
+  std::vector<TcpZerocopySendRecord*> records = TakeRecords(&ctx);
+  EXPECT_EQ(records.size(), 4);
+  PutRecords(&ctx, &records);
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else /* GRPC_POSIX_SOCKET_TCP */
+
+int main(int argc, char** argv) { return 1; }
+
+#endif /* GRPC_POSIX_SOCKET_TCP */
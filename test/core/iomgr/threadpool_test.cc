@@ -18,6 +18,8 @@
 
 #include "src/core/lib/iomgr/executor/threadpool.h"
 
+#include "src/core/lib/iomgr/executor/work_stealing_threadpool.h"
+
 #include "test/core/util/test_config.h"
 
 static const int kSmallThreadPoolSize = 20;
@@ -25,20 +27,22 @@ static const int kLargeThreadPoolSize = 100;
 static const int kThreadSmallIter = 100;
 static const int kThreadLargeIter = 10000;
 
+template <class ThreadPoolType>
 static void test_size_zero(void) {
   gpr_log(GPR_INFO, "test_size_zero");
-  grpc_core::ThreadPool* pool_size_zero = new grpc_core::ThreadPool(0);
+  grpc_core::ThreadPoolInterface* pool_size_zero = new ThreadPoolType(0);
   GPR_ASSERT(pool_size_zero->pool_capacity() == 1);
   delete pool_size_zero;
 }
 
+template <class ThreadPoolType>
 static void test_constructor_option(void) {
   gpr_log(GPR_INFO, "test_constructor_option");
   // Tests options
   grpc_core::Thread::Options options;
   options.set_stack_size(192 * 1024);  // Random non-default value
-  grpc_core::ThreadPool* pool =
-      new grpc_core::ThreadPool(0, "test_constructor_option", options);
+  grpc_core::ThreadPoolInterface* pool =
+      new ThreadPoolType(0, "test_constructor_option", options);
   GPR_ASSERT(pool->thread_options().stack_size() == options.stack_size());
   delete pool;
 }
@@ -65,10 +69,11 @@ class SimpleFunctorForAdd : public grpc_completion_queue_functor {
   std::atomic<int> count_{0};
 };
 
+template <class ThreadPoolType>
 static void test_add(void) {
   gpr_log(GPR_INFO, "test_add");
-  grpc_core::ThreadPool* pool =
-      new grpc_core::ThreadPool(kSmallThreadPoolSize, "test_add");
+  grpc_core::ThreadPoolInterface* pool =
+      new ThreadPoolType(kSmallThreadPoolSize, "test_add");
 
   SimpleFunctorForAdd* functor = new SimpleFunctorForAdd();
   for (int i = 0; i < kThreadSmallIter; ++i) {
@@ -83,7 +88,8 @@ static void test_add(void) {
 // Thread that adds closures to pool
 class WorkThread {
  public:
-  WorkThread(grpc_core::ThreadPool* pool, SimpleFunctorForAdd* cb, int num_add)
+  WorkThread(grpc_core::ThreadPoolInterface* pool, SimpleFunctorForAdd* cb,
+             int num_add)
       : num_add_(num_add), cb_(cb), pool_(pool) {
     thd_ = grpc_core::Thread(
         "thread_pool_test_add_thd",
@@ -103,15 +109,16 @@ class WorkThread {
 
   int num_add_;
   SimpleFunctorForAdd* cb_;
-  grpc_core::ThreadPool* pool_;
+  grpc_core::ThreadPoolInterface* pool_;
   grpc_core::Thread thd_;
 };
 
+template <class ThreadPoolType>
 static void test_multi_add(void) {
   gpr_log(GPR_INFO, "test_multi_add");
   const int num_work_thds = 10;
-  grpc_core::ThreadPool* pool =
-      new grpc_core::ThreadPool(kLargeThreadPoolSize, "test_multi_add");
+  grpc_core::ThreadPoolInterface* pool =
+      new ThreadPoolType(kLargeThreadPoolSize, "test_multi_add");
   SimpleFunctorForAdd* functor = new SimpleFunctorForAdd();
   WorkThread** work_thds = static_cast<WorkThread**>(
       gpr_zalloc(sizeof(WorkThread*) * num_work_thds));
@@ -155,11 +162,12 @@ class SimpleFunctorCheckForAdd : public grpc_completion_queue_functor {
   int* count_;
 };
 
+template <class ThreadPoolType>
 static void test_one_thread_FIFO(void) {
   gpr_log(GPR_INFO, "test_one_thread_FIFO");
   int counter = 0;
-  grpc_core::ThreadPool* pool =
-      new grpc_core::ThreadPool(1, "test_one_thread_FIFO");
+  grpc_core::ThreadPoolInterface* pool =
+      new ThreadPoolType(1, "test_one_thread_FIFO");
   SimpleFunctorCheckForAdd** check_functors =
       static_cast<SimpleFunctorCheckForAdd**>(
           gpr_zalloc(sizeof(SimpleFunctorCheckForAdd*) * kThreadSmallIter));
@@ -176,14 +184,73 @@ static void test_one_thread_FIFO(void) {
   gpr_log(GPR_DEBUG, "Done.");
 }
 
+// Adds a copy of itself with num_add - 1 from within the pool, and waits for
+// it to run before completing.
+class AddFromPoolFunctor : public grpc_completion_queue_functor {
+ public:
+  AddFromPoolFunctor(grpc_core::ThreadPoolInterface* pool, int num_add,
+                     std::atomic<int>* count, gpr_event* done)
+      : pool_(pool), num_add_(num_add), count_(count), done_(done) {
+    functor_run = &AddFromPoolFunctor::Run;
+    inlineable = true;
+    internal_success = 0;
+  }
+  ~AddFromPoolFunctor() {}
+  static void Run(struct grpc_completion_queue_functor* cb, int /*ok*/) {
+    auto* callback = static_cast<AddFromPoolFunctor*>(cb);
+    if (callback->num_add_ > 0) {
+      gpr_event follow_up_done;
+      gpr_event_init(&follow_up_done);
+      callback->pool_->Add(
+          new AddFromPoolFunctor(callback->pool_, callback->num_add_ - 1,
+                                 callback->count_, &follow_up_done));
+      gpr_event_wait(&follow_up_done, gpr_inf_future(GPR_CLOCK_REALTIME));
+    }
+    callback->count_->fetch_add(1, std::memory_order_relaxed);
+    gpr_event_set(callback->done_, reinterpret_cast<void*>(1));
+    delete callback;
+  }
+
+ private:
+  grpc_core::ThreadPoolInterface* pool_;
+  int num_add_;
+  std::atomic<int>* count_;
+  gpr_event* done_;
+};
+
+// Closures added from a worker thread must still run when that worker blocks
+// on them.
+template <class ThreadPoolType>
+static void test_add_from_pool(void) {
+  gpr_log(GPR_INFO, "test_add_from_pool");
+  const int num_add = 8;
+  std::atomic<int> count{0};
+  gpr_event done;
+  gpr_event_init(&done);
+  grpc_core::ThreadPoolInterface* pool =
+      new ThreadPoolType(num_add + 1, "test_add_from_pool");
+  pool->Add(new AddFromPoolFunctor(pool, num_add, &count, &done));
+  gpr_event_wait(&done, gpr_inf_future(GPR_CLOCK_REALTIME));
+  delete pool;
+  GPR_ASSERT(count.load(std::memory_order_relaxed) == num_add + 1);
+  gpr_log(GPR_DEBUG, "Done.");
+}
+
+template <class ThreadPoolType>
+static void test_thread_pool(void) {
+  test_size_zero<ThreadPoolType>();
+  test_constructor_option<ThreadPoolType>();
+  test_add<ThreadPoolType>();
+  test_multi_add<ThreadPoolType>();
+  test_one_thread_FIFO<ThreadPoolType>();
+  test_add_from_pool<ThreadPoolType>();
+}
+
 int main(int argc, char** argv) {
   grpc::testing::TestEnvironment env(argc, argv);
   grpc_init();
-  test_size_zero();
-  test_constructor_option();
-  test_add();
-  test_multi_add();
-  test_one_thread_FIFO();
+  test_thread_pool<grpc_core::ThreadPool>();
+  test_thread_pool<grpc_core::WorkStealingThreadPool>();
   grpc_shutdown();
   return 0;
 }
@@ -18,7 +18,7 @@
 
 #include "src/core/lib/iomgr/port.h"
 
-// This test only works with the generic timer implementation
+// This test only works with the generic and timing wheel implementations
 #ifndef GRPC_CUSTOM_SOCKET
 
 #include <string.h>
@@ -37,6 +37,9 @@
 extern grpc_core::TraceFlag grpc_timer_trace;
 extern grpc_core::TraceFlag grpc_timer_check_trace;
 
+extern grpc_timer_vtable grpc_generic_timer_vtable;
+extern grpc_timer_vtable grpc_wheel_timer_vtable;
+
 static int cb_called[MAX_CB][2];
 static const int64_t kMillisIn25Days = 2160000000;
 static const int64_t kHoursIn25Days = 600;
@@ -153,6 +156,92 @@ void destruction_test(void) {
   GPR_ASSERT(1 == cb_called[2][0]);
 }
 
+/* Adds timers after the list has been idle for a day. */
+void idle_test(void) {
+  grpc_timer timers[2];
+  grpc_core::ExecCtx exec_ctx;
+
+  gpr_log(GPR_INFO, "idle_test");
+
+  grpc_timer_list_init();
+  grpc_core::testing::grpc_tracer_enable_flag(&grpc_timer_trace);
+  grpc_core::testing::grpc_tracer_enable_flag(&grpc_timer_check_trace);
+  memset(cb_called, 0, sizeof(cb_called));
+
+  const grpc_millis start = grpc_core::ExecCtx::Get()->Now() + 86400000;
+  grpc_core::ExecCtx::Get()->TestOnlySetNow(start);
+  GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_CHECKED_AND_EMPTY);
+  grpc_timer_init(
+      &timers[0], start + 10,
+      GRPC_CLOSURE_CREATE(cb, (void*)(intptr_t)0, grpc_schedule_on_exec_ctx));
+  grpc_timer_init(
+      &timers[1], start + 1010,
+      GRPC_CLOSURE_CREATE(cb, (void*)(intptr_t)1, grpc_schedule_on_exec_ctx));
+
+  grpc_core::ExecCtx::Get()->TestOnlySetNow(start + 9);
+  GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_CHECKED_AND_EMPTY);
+  grpc_core::ExecCtx::Get()->TestOnlySetNow(start + 10);
+  GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_FIRED);
+  grpc_core::ExecCtx::Get()->Flush();
+  GPR_ASSERT(1 == cb_called[0][1]);
+  GPR_ASSERT(0 == cb_called[1][1]);
+
+  grpc_core::ExecCtx::Get()->TestOnlySetNow(start + 1010);
+  GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_FIRED);
+  grpc_core::ExecCtx::Get()->Flush();
+  GPR_ASSERT(1 == cb_called[1][1]);
+
+  grpc_timer_list_shutdown();
+}
+
+/* Advances the list by hours at a time while it holds timers at every level
+   of the wheel, and in its overflow list. */
+void long_advance_test(void) {
+  grpc_timer timers[4];
+  grpc_core::ExecCtx exec_ctx;
+
+  gpr_log(GPR_INFO, "long_advance_test");
+
+  grpc_timer_list_init();
+  grpc_core::testing::grpc_tracer_enable_flag(&grpc_timer_trace);
+  grpc_core::testing::grpc_tracer_enable_flag(&grpc_timer_check_trace);
+  memset(cb_called, 0, sizeof(cb_called));
+
+  const grpc_millis kHour = 3600000;
+  const grpc_millis start = grpc_core::ExecCtx::Get()->Now();
+  const grpc_millis deadlines[] = {start + 50, start + kHour / 2,
+                                   start + kHour + 5, start + 5 * kHour};
+  for (int i = 0; i < 4; i++) {
+    grpc_timer_init(
+        &timers[i], deadlines[i],
+        GRPC_CLOSURE_CREATE(cb, (void*)(intptr_t)i, grpc_schedule_on_exec_ctx));
+  }
+
+  /* A single check an hour on fires both timers that came due, late. */
+  grpc_core::ExecCtx::Get()->TestOnlySetNow(start + kHour);
+  GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_FIRED);
+  grpc_core::ExecCtx::Get()->Flush();
+  GPR_ASSERT(1 == cb_called[0][1]);
+  GPR_ASSERT(1 == cb_called[1][1]);
+  GPR_ASSERT(0 == cb_called[2][1]);
+
+  /* The timers still pending fire on time. */
+  for (int i = 2; i < 4; i++) {
+    grpc_core::ExecCtx::Get()->TestOnlySetNow(deadlines[i] - 1);
+    GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_CHECKED_AND_EMPTY);
+    GPR_ASSERT(0 == cb_called[i][1]);
+    grpc_core::ExecCtx::Get()->TestOnlySetNow(deadlines[i]);
+    GPR_ASSERT(grpc_timer_check(nullptr) == GRPC_TIMERS_FIRED);
+    grpc_core::ExecCtx::Get()->Flush();
+    GPR_ASSERT(1 == cb_called[i][1]);
+  }
+
+  grpc_timer_list_shutdown();
+  for (int i = 0; i < 4; i++) {
+    GPR_ASSERT(0 == cb_called[i][0]);
+  }
+}
+
 /* Cleans up a list with pending timers that simulate long-running-services.
    This test does the following:
     1) Simulates grpc server start time to 25 days in the past (completed in
@@ -219,41 +308,49 @@ void long_running_service_cleanup_test(void) {
 }
 
 int main(int argc, char** argv) {
-  /* Tests with default g_start_time */
-  {
-    grpc::testing::TestEnvironment env(argc, argv);
-    grpc_core::ExecCtx::GlobalInit();
-    grpc_core::ExecCtx exec_ctx;
-    grpc_set_default_iomgr_platform();
-    grpc_iomgr_platform_init();
-    gpr_set_log_verbosity(GPR_LOG_SEVERITY_DEBUG);
-    add_test();
-    destruction_test();
-    grpc_iomgr_platform_shutdown();
-  }
-  grpc_core::ExecCtx::GlobalShutdown();
-
-  /* Begin long running service tests */
-  {
-    grpc::testing::TestEnvironment env(argc, argv);
-    /* Set g_start_time back 25 days. */
-    /* We set g_start_time here in case there are any initialization
-        dependencies that use g_start_time. */
-    gpr_timespec new_start =
-        gpr_time_sub(gpr_now(gpr_clock_type::GPR_CLOCK_MONOTONIC),
-                     gpr_time_from_hours(kHoursIn25Days,
-                                         gpr_clock_type::GPR_CLOCK_MONOTONIC));
-    grpc_core::ExecCtx::TestOnlyGlobalInit(new_start);
-    grpc_core::ExecCtx exec_ctx;
-    grpc_set_default_iomgr_platform();
-    grpc_iomgr_platform_init();
-    gpr_set_log_verbosity(GPR_LOG_SEVERITY_DEBUG);
-    long_running_service_cleanup_test();
-    add_test();
-    destruction_test();
-    grpc_iomgr_platform_shutdown();
+  grpc_timer_vtable* impls[] = {&grpc_generic_timer_vtable,
+                                &grpc_wheel_timer_vtable};
+  for (grpc_timer_vtable* impl : impls) {
+    /* Tests with default g_start_time */
+    {
+      grpc::testing::TestEnvironment env(argc, argv);
+      grpc_core::ExecCtx::GlobalInit();
+      grpc_core::ExecCtx exec_ctx;
+      grpc_set_default_iomgr_platform();
+      grpc_set_timer_impl(impl);
+      grpc_iomgr_platform_init();
+      gpr_set_log_verbosity(GPR_LOG_SEVERITY_DEBUG);
+      add_test();
+      destruction_test();
+      idle_test();
+      long_advance_test();
+      grpc_iomgr_platform_shutdown();
+    }
+    grpc_core::ExecCtx::GlobalShutdown();
+
+    /* Begin long running service tests */
+    {
+      grpc::testing::TestEnvironment env(argc, argv);
+      /* Set g_start_time back 25 days. */
+      /* We set g_start_time here in case there are any initialization
+          dependencies that use g_start_time. */
+      gpr_timespec new_start =
+          gpr_time_sub(gpr_now(gpr_clock_type::GPR_CLOCK_MONOTONIC),
+                       gpr_time_from_hours(kHoursIn25Days,
+                                           gpr_clock_type::GPR_CLOCK_MONOTONIC));
+      grpc_core::ExecCtx::TestOnlyGlobalInit(new_start);
+      grpc_core::ExecCtx exec_ctx;
+      grpc_set_default_iomgr_platform();
+      grpc_set_timer_impl(impl);
+      grpc_iomgr_platform_init();
+      gpr_set_log_verbosity(GPR_LOG_SEVERITY_DEBUG);
+      long_running_service_cleanup_test();
+      add_test();
+      destruction_test();
+      grpc_iomgr_platform_shutdown();
+    }
+    grpc_core::ExecCtx::GlobalShutdown();
   }
-  grpc_core::ExecCtx::GlobalShutdown();
 
   return 0;
 }
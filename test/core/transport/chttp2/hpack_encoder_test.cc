@@ -214,6 +214,43 @@ static void test_basic_headers() {
          "b", "c");
 }
 
+static void test_huffman_headers() {
+  verify_params params = {
+      false,
+      false,
+  };
+  // Values that shrink are huffman compressed, others are sent as is.
+  verify(params, "000012 0104 deadbeef 00 036b6579 8cf1e3c2e5f23a6ba0ab90f4ff",
+         1, "key", "www.example.com");
+  verify(params,
+         "000026 0104 deadbeef 00 036b6579 "
+         "a04ce55bb5a62755a3b0fe2a5a53f95ba5b4d6858fdcb62c99cab503f7e9690f37",
+         1, "key", "the-quick-brown-fox-jumps-over-the-lazy-dog");
+  verify(params, "000009 0104 deadbeef 00 036b6579 037e7e7e", 1, "key",
+         "~~~");
+}
+
+static void test_pre_encoded_headers() {
+  verify_params params = {
+      false,
+      false,
+  };
+  // First use on a connection is a literal with incremental indexing, later
+  // uses hit the dynamic table.
+  verify(params, "00000c 0104 deadbeef 40 88 9acac8b21234da8f 01 30", 1,
+         "grpc-status", "0");
+  verify(params, "000001 0104 deadbeef be", 1, "grpc-status", "0");
+  verify(params, "00000b 0104 deadbeef 40 02 7465 86 4d833505b11f", 1, "te",
+         "trailers");
+  verify(params, "000001 0104 deadbeef be", 1, "te", "trailers");
+  // content-type reuses the static table name.
+  verify(params, "00000d 0104 deadbeef 5f 8b 1d75d0620d263d4c4d6564", 1,
+         "content-type", "application/grpc");
+  verify(params, "000001 0104 deadbeef be", 1, "content-type",
+         "application/grpc");
+  verify(params, "000001 0104 deadbeef c0", 1, "grpc-status", "0");
+}
+
 static void verify_continuation_headers(const char* key, const char* value,
                                         bool is_eof) {
   auto arena = grpc_core::MakeScopedArena(1024, g_memory_allocator);
@@ -245,6 +282,12 @@ static void test_continuation_headers() {
   memset(value2, 'b', 400);
   value2[399] = 0;  // null terminator
   verify_continuation_headers("key2", value2, true);
+
+  // Incompressible, so the value alone still spans several frames.
+  char value3[200];
+  memset(value3, '~', 200);
+  value3[199] = 0;  // null terminator
+  verify_continuation_headers("key3", value3, true);
 }
 
 static void run_test(void (*test)(), const char* name) {
@@ -260,6 +303,8 @@ int main(int argc, char** argv) {
   grpc::testing::TestEnvironment env(argc, argv);
   grpc_init();
   TEST(test_basic_headers);
+  TEST(test_huffman_headers);
+  TEST(test_pre_encoded_headers);
   TEST(test_continuation_headers);
   grpc_shutdown();
   return g_failure;
@@ -0,0 +1,103 @@
+// Copyright 2022 gRPC authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/core/ext/transport/chttp2/transport/hpack_huffman_decoder.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <grpc/grpc.h>
+#include <grpc/slice.h>
+
+#include "src/core/ext/transport/chttp2/transport/bin_encoder.h"
+#include "src/core/lib/slice/slice_internal.h"
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+std::string Decode(const std::vector<uint8_t>& input) {
+  std::vector<uint8_t> output;
+  HPackHuffmanDecoder::Decode(input.data(), input.size(), &output);
+  return std::string(output.begin(), output.end());
+}
+
+std::string RoundTrip(const std::string& input) {
+  grpc_slice plain =
+      grpc_slice_from_copied_buffer(input.data(), input.size());
+  grpc_slice compressed = grpc_chttp2_huffman_compress(plain);
+  std::vector<uint8_t> encoded(GRPC_SLICE_START_PTR(compressed),
+                               GRPC_SLICE_END_PTR(compressed));
+  grpc_slice_unref_internal(plain);
+  grpc_slice_unref_internal(compressed);
+  return Decode(encoded);
+}
+
+}  // namespace
+
+TEST(HpackHuffmanDecoderTest, Empty) { EXPECT_EQ(Decode({}), ""); }
+
+TEST(HpackHuffmanDecoderTest, Rfc7541Examples) {
+  // RFC 7541 appendix C.4
+  EXPECT_EQ(Decode({0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90,
+                    0xf4, 0xff}),
+            "www.example.com");
+  EXPECT_EQ(Decode({0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf}), "no-cache");
+  EXPECT_EQ(Decode({0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9, 0x7d, 0x7f}),
+            "custom-key");
+  EXPECT_EQ(Decode({0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf}),
+            "custom-value");
+  // RFC 7541 appendix C.6
+  EXPECT_EQ(Decode({0x64, 0x0e, 0xff}), "307");
+  EXPECT_EQ(Decode({0xd0, 0x7a, 0xbe, 0x94, 0x10, 0x54, 0xd4, 0x44,
+                    0xa8, 0x20, 0x05, 0x95, 0x04, 0x0b, 0x81, 0x66,
+                    0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff}),
+            "Mon, 21 Oct 2013 20:13:21 GMT");
+}
+
+TEST(HpackHuffmanDecoderTest, AllBytes) {
+  std::string all;
+  for (int i = 0; i < 256; i++) all.push_back(static_cast<char>(i));
+  EXPECT_EQ(RoundTrip(all), all);
+}
+
+TEST(HpackHuffmanDecoderTest, AllLengths) {
+  // Cover every alignment of the bulk and tail decode loops, and every
+  // code length.
+  std::string input;
+  for (int i = 0; i < 300; i++) {
+    input.push_back(static_cast<char>((i * 37 + 11) & 0xff));
+    EXPECT_EQ(RoundTrip(input), input);
+  }
+}
+
+TEST(HpackHuffmanDecoderTest, AppendsToOutput) {
+  std::vector<uint8_t> output = {'x', '-'};
+  const std::vector<uint8_t> input = {0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf};
+  HPackHuffmanDecoder::Decode(input.data(), input.size(), &output);
+  EXPECT_EQ(std::string(output.begin(), output.end()), "x-no-cache");
+}
+
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  grpc::testing::TestEnvironment env(argc, argv);
+  grpc_init();
+  int r = RUN_ALL_TESTS();
+  grpc_shutdown();
+  return r;
+}
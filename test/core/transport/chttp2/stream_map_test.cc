@@ -167,6 +167,33 @@ static void test_periodic_compaction(uint32_t n) {
   grpc_chttp2_stream_map_destroy(&map);
 }
 
+static void delete_in_for_each(void* user_data, uint32_t stream_id,
+                               void* ptr) {
+  grpc_chttp2_stream_map* map = static_cast<grpc_chttp2_stream_map*>(user_data);
+  GPR_ASSERT(ptr == grpc_chttp2_stream_map_delete(map, stream_id));
+}
+
+/* delete every entry from within for_each (as cancelling all streams does),
+   and ensure the table shrinks back down afterwards */
+static void test_delete_during_for_each(uint32_t n) {
+  grpc_chttp2_stream_map map;
+  uint32_t i;
+
+  LOG_TEST("test_delete_during_for_each");
+  gpr_log(GPR_INFO, "n = %d", n);
+
+  grpc_chttp2_stream_map_init(&map, 8);
+  for (i = 1; i <= n; i++) {
+    grpc_chttp2_stream_map_add(&map, 2 * i + 1,
+                               reinterpret_cast<void*>(2 * i + 1));
+  }
+  grpc_chttp2_stream_map_for_each(&map, delete_in_for_each, &map);
+  GPR_ASSERT(0 == grpc_chttp2_stream_map_size(&map));
+  GPR_ASSERT(nullptr == grpc_chttp2_stream_map_rand(&map));
+  GPR_ASSERT(map.capacity == 8);
+  grpc_chttp2_stream_map_destroy(&map);
+}
+
 int main(int argc, char** argv) {
   uint32_t n = 1;
   uint32_t prev = 1;
@@ -182,6 +209,7 @@ int main(int argc, char** argv) {
     test_delete_evens_sweep(n);
     test_delete_evens_incremental(n);
     test_periodic_compaction(n);
+    test_delete_during_for_each(n);
 
     tmp = n;
     n += prev;
@@ -0,0 +1,104 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/core/ext/transport/chttp2/transport/internal.h"
+#include "test/core/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+constexpr uint32_t kDefault = 1024 * 1024;
+constexpr uint32_t kMax = 4 * 1024 * 1024;
+constexpr uint32_t kFrameSize = 16384;
+
+grpc_endpoint_send_info SendInfo(uint32_t cwnd_bytes, uint64_t pacing_rate) {
+  grpc_endpoint_send_info info;
+  info.cwnd_bytes = cwnd_bytes;
+  info.pacing_rate = pacing_rate;
+  return info;
+}
+
+TEST(TargetWriteSizeTest, NoSignalsKeepsTheDefault) {
+  EXPECT_EQ(grpc_chttp2_target_write_size(nullptr, 0, 1, kFrameSize),
+            kDefault);
+}
+
+TEST(TargetWriteSizeTest, UnknownCwndFallsBackToTheBdp) {
+  grpc_endpoint_send_info info = SendInfo(0, 0);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 0, 1, kFrameSize), kDefault);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 3 * 1024 * 1024, 1,
+                                          kFrameSize),
+            3 * 1024 * 1024);
+  EXPECT_EQ(grpc_chttp2_target_write_size(nullptr, 3 * 1024 * 1024, 1,
+                                          kFrameSize),
+            3 * 1024 * 1024);
+}
+
+TEST(TargetWriteSizeTest, SmallSignalsDoNotShrinkTheTarget) {
+  grpc_endpoint_send_info info = SendInfo(14600, 1000000);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 0, 1, kFrameSize), kDefault);
+  EXPECT_EQ(grpc_chttp2_target_write_size(nullptr, 65536, 1, kFrameSize),
+            kDefault);
+}
+
+TEST(TargetWriteSizeTest, LargeCwndRaisesTheTarget) {
+  grpc_endpoint_send_info info = SendInfo(1024 * 1024, 0);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 0, 1, kFrameSize),
+            2 * 1024 * 1024);
+}
+
+TEST(TargetWriteSizeTest, CwndTakesPrecedenceOverTheBdp) {
+  grpc_endpoint_send_info info = SendInfo(1024 * 1024, 0);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 3 * 1024 * 1024, 1,
+                                          kFrameSize),
+            2 * 1024 * 1024);
+}
+
+TEST(TargetWriteSizeTest, PacingRateRaisesTheTarget) {
+  // 3 GB/s drains 3 MB in the 1ms a write is allowed to take.
+  grpc_endpoint_send_info info = SendInfo(65536, 3000000000);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 0, 1, kFrameSize), 3000000);
+}
+
+TEST(TargetWriteSizeTest, WritableStreamsRaiseTheTarget) {
+  EXPECT_EQ(grpc_chttp2_target_write_size(nullptr, 0, 100, kFrameSize),
+            100 * kFrameSize);
+}
+
+TEST(TargetWriteSizeTest, ClampedToTheMaximum) {
+  grpc_endpoint_send_info info = SendInfo(64 * 1024 * 1024, 0);
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 0, 1, kFrameSize), kMax);
+  info = SendInfo(65536, UINT64_C(100000000000));
+  EXPECT_EQ(grpc_chttp2_target_write_size(&info, 0, 1, kFrameSize), kMax);
+  EXPECT_EQ(grpc_chttp2_target_write_size(nullptr, INT64_C(1) << 40, 1,
+                                          kFrameSize),
+            kMax);
+  EXPECT_EQ(grpc_chttp2_target_write_size(nullptr, 0, 10000, kFrameSize),
+            kMax);
+}
+
+}  // namespace
+}  // namespace grpc_core
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
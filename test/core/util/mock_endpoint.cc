@@ -102,6 +102,9 @@ static int me_get_fd(grpc_endpoint* /*ep*/) { return -1; }
 
 static bool me_can_track_err(grpc_endpoint* /*ep*/) { return false; }
 
+static void me_set_channelz_socket_node(
+    grpc_endpoint* /*ep*/, grpc_core::channelz::SocketNode* /*node*/) {}
+
 static const grpc_endpoint_vtable vtable = {me_read,
                                             me_write,
                                             me_add_to_pollset,
@@ -112,7 +115,8 @@ static const grpc_endpoint_vtable vtable = {me_read,
                                             me_get_peer,
                                             me_get_local_address,
                                             me_get_fd,
-                                            me_can_track_err};
+                                            me_can_track_err,
+                                            me_set_channelz_socket_node};
 
 grpc_endpoint* grpc_mock_endpoint_create(void (*on_write)(grpc_slice slice)) {
   mock_endpoint* m = static_cast<mock_endpoint*>(gpr_malloc(sizeof(*m)));
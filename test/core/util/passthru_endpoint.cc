@@ -378,6 +378,9 @@ static int me_get_fd(grpc_endpoint* /*ep*/) { return -1; }
 
 static bool me_can_track_err(grpc_endpoint* /*ep*/) { return false; }
 
+static void me_set_channelz_socket_node(
+    grpc_endpoint* /*ep*/, grpc_core::channelz::SocketNode* /*node*/) {}
+
 static const grpc_endpoint_vtable vtable = {
     me_read,
     me_write,
@@ -390,6 +393,7 @@ static const grpc_endpoint_vtable vtable = {
     me_get_local_address,
     me_get_fd,
     me_can_track_err,
+    me_set_channelz_socket_node,
 };
 
 static void half_init(half* m, passthru_endpoint* parent,
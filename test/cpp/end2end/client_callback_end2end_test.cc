@@ -38,6 +38,7 @@
 #include <grpcpp/support/client_callback.h>
 
 #include "src/core/lib/gpr/env.h"
+#include "src/core/lib/gprpp/global_config.h"
 #include "src/core/lib/iomgr/iomgr.h"
 #include "src/proto/grpc/testing/echo.grpc.pb.h"
 #include "test/core/util/port.h"
@@ -48,6 +49,8 @@
 #include "test/cpp/util/string_ref_helper.h"
 #include "test/cpp/util/test_credentials_provider.h"
 
+GPR_GLOBAL_CONFIG_DECLARE_BOOL(grpc_callback_inline_execution);
+
 namespace grpc {
 namespace testing {
 namespace {
@@ -57,16 +60,20 @@ enum class Protocol { INPROC, TCP };
 class TestScenario {
  public:
   TestScenario(bool serve_callback, Protocol protocol, bool intercept,
-               const std::string& creds_type)
+               const std::string& creds_type, bool run_inline = false)
       : callback_server(serve_callback),
         protocol(protocol),
         use_interceptors(intercept),
-        credentials_type(creds_type) {}
+        credentials_type(creds_type),
+        inline_execution(run_inline) {}
   void Log() const;
   bool callback_server;
   Protocol protocol;
   bool use_interceptors;
   const std::string credentials_type;
+  // Whether callback reactions run inline on the polling threads
+  // (grpc_callback_inline_execution).
+  bool inline_execution;
 };
 
 std::ostream& operator<<(std::ostream& out, const TestScenario& scenario) {
@@ -74,7 +81,9 @@ std::ostream& operator<<(std::ostream& out, const TestScenario& scenario) {
              << (scenario.callback_server ? "true" : "false") << ",protocol="
              << (scenario.protocol == Protocol::INPROC ? "INPROC" : "TCP")
              << ",intercept=" << (scenario.use_interceptors ? "true" : "false")
-             << ",creds=" << scenario.credentials_type << "}";
+             << ",creds=" << scenario.credentials_type
+             << ",inline=" << (scenario.inline_execution ? "true" : "false")
+             << "}";
 }
 
 void TestScenario::Log() const {
@@ -83,6 +92,12 @@ void TestScenario::Log() const {
   gpr_log(GPR_DEBUG, "%s", out.str().c_str());
 }
 
+class MayBlockCallbackTestServiceImpl : public CallbackTestServiceImpl {
+ public:
+  // Echo is the first method of EchoTestService.
+  void MarkEchoMayBlock() { MarkMethodMayBlock(0); }
+};
+
 class ClientCallbackEnd2endTest
     : public ::testing::TestWithParam<TestScenario> {
  protected:
@@ -100,6 +115,12 @@ class ClientCallbackEnd2endTest
       server_address_ << "localhost:" << picked_port_;
       builder.AddListeningPort(server_address_.str(), server_creds);
     }
+    if (GetParam().inline_execution) {
+      GPR_GLOBAL_CONFIG_SET(grpc_callback_inline_execution, true);
+      // Echo then runs on the threads that callbacks are handed to, and the
+      // other methods inline.
+      callback_service_.MarkEchoMayBlock();
+    }
     if (!GetParam().callback_server) {
       builder.RegisterService(&service_);
     } else {
@@ -167,6 +188,7 @@ class ClientCallbackEnd2endTest
     if (picked_port_ > 0) {
       grpc_recycle_unused_port(picked_port_);
     }
+    GPR_GLOBAL_CONFIG_SET(grpc_callback_inline_execution, false);
   }
 
   void SendRpcs(int num_rpcs, bool with_binary_metadata) {
@@ -338,7 +360,7 @@ class ClientCallbackEnd2endTest
   std::unique_ptr<grpc::testing::EchoTestService::Stub> stub_;
   std::unique_ptr<grpc::GenericStub> generic_stub_;
   TestServiceImpl service_;
-  CallbackTestServiceImpl callback_service_;
+  MayBlockCallbackTestServiceImpl callback_service_;
   std::unique_ptr<Server> server_;
   std::ostringstream server_address_;
 };
@@ -1557,6 +1579,14 @@ std::vector<TestScenario> CreateTestScenarios(bool test_insecure) {
       }
     }
   }
+  // Run inline reactions over TCP, whose I/O the polling threads complete.
+  if (test_insecure && insec_ok()) {
+    for (bool use_interceptors : barr) {
+      scenarios.emplace_back(true, Protocol::TCP, use_interceptors,
+                             kInsecureCredentialsType,
+                             /*run_inline=*/true);
+    }
+  }
   return scenarios;
 }
 
@@ -1665,6 +1665,103 @@ TEST_F(ClientLbEnd2endTest,
   EnableDefaultHealthCheckService(false);
 }
 
+TEST_F(ClientLbEnd2endTest, LeastRequest) {
+  const int kNumServers = 3;
+  StartServers(kNumServers);
+  auto response_generator = BuildResolverResponseGenerator();
+  auto channel = BuildChannel("", response_generator);
+  auto stub = BuildStub(channel);
+  response_generator.SetNextResolution(
+      GetServersPorts(),
+      "{\"loadBalancingConfig\": [{\"least_request_experimental\":{}}]}");
+  // With no calls in flight, all backends should get some traffic.
+  do {
+    CheckRpcSendOk(stub, DEBUG_LOCATION);
+  } while (!SeenAllServers());
+  // Check LB policy name for the channel.
+  EXPECT_EQ("least_request_experimental",
+            channel->GetLoadBalancingPolicyName());
+}
+
+TEST_F(ClientLbEnd2endTest, LeastRequestAvoidsBusyBackend) {
+  const int kNumServers = 2;
+  StartServers(kNumServers);
+  auto response_generator = BuildResolverResponseGenerator();
+  auto channel = BuildChannel("", response_generator);
+  auto stub = BuildStub(channel);
+  // With 10 choices, the busy backend is picked only when all of the
+  // choices land on it, i.e. about once every thousand calls.
+  response_generator.SetNextResolution(
+      GetServersPorts(),
+      "{\"loadBalancingConfig\": [{\"least_request_experimental\":"
+      "{\"choice_count\":10}}]}");
+  do {
+    CheckRpcSendOk(stub, DEBUG_LOCATION);
+  } while (!SeenAllServers());
+  ResetCounters();
+  // Keep a slow call in flight on one of the backends.
+  std::thread slow_call([&stub]() {
+    EchoRequest request;
+    EchoResponse response;
+    request.set_message("slow");
+    request.mutable_param()->set_server_sleep_us(3 * 1000 * 1000);
+    ClientContext context;
+    context.set_deadline(grpc_timeout_seconds_to_deadline(10));
+    EXPECT_TRUE(stub->Echo(&context, request, &response).ok());
+  });
+  while (servers_[0]->service_.request_count() +
+             servers_[1]->service_.request_count() ==
+         0) {
+    gpr_sleep_until(grpc_timeout_milliseconds_to_deadline(10));
+  }
+  const size_t busy = servers_[0]->service_.request_count() > 0 ? 0 : 1;
+  const int kNumRpcs = 20;
+  for (int i = 0; i < kNumRpcs; ++i) {
+    CheckRpcSendOk(stub, DEBUG_LOCATION);
+  }
+  EXPECT_GE(servers_[1 - busy]->service_.request_count(), kNumRpcs - 1);
+  slow_call.join();
+}
+
+TEST_F(ClientLbEnd2endTest, WeightedRoundRobin) {
+  const int kNumServers = 2;
+  StartServers(kNumServers);
+  // Both backends serve the same QPS, but the first one does so at a fifth
+  // of the CPU utilization, so it should get 5 times as many calls.
+  xds::data::orca::v3::OrcaLoadReport light_load;
+  light_load.set_rps(100);
+  light_load.set_cpu_utilization(0.1);
+  servers_[0]->service_.set_load_report(&light_load);
+  xds::data::orca::v3::OrcaLoadReport heavy_load;
+  heavy_load.set_rps(100);
+  heavy_load.set_cpu_utilization(0.5);
+  servers_[1]->service_.set_load_report(&heavy_load);
+  auto response_generator = BuildResolverResponseGenerator();
+  auto channel = BuildChannel("", response_generator);
+  auto stub = BuildStub(channel);
+  response_generator.SetNextResolution(
+      GetServersPorts(),
+      "{\"loadBalancingConfig\": [{\"weighted_round_robin_experimental\":"
+      "{\"blackoutPeriod\":\"0s\",\"weightUpdatePeriod\":\"0.1s\"}}]}");
+  // Until both backends have reported their load, calls are spread evenly.
+  do {
+    CheckRpcSendOk(stub, DEBUG_LOCATION);
+  } while (!SeenAllServers());
+  // Wait for the picker to be rebuilt with the weights.
+  gpr_sleep_until(grpc_timeout_milliseconds_to_deadline(500));
+  ResetCounters();
+  const int kNumRpcs = 600;
+  for (int i = 0; i < kNumRpcs; ++i) {
+    CheckRpcSendOk(stub, DEBUG_LOCATION);
+  }
+  EXPECT_GE(servers_[0]->service_.request_count(),
+            4 * servers_[1]->service_.request_count());
+  // Check LB policy name for the channel.
+  EXPECT_EQ("weighted_round_robin_experimental",
+            channel->GetLoadBalancingPolicyName());
+  for (const auto& server : servers_) server->service_.set_load_report(nullptr);
+}
+
 TEST_F(ClientLbEnd2endTest, ChannelIdleness) {
   // Start server.
   const int kNumServers = 1;
@@ -6685,6 +6685,52 @@ TEST_P(CdsTest, WrongLbPolicy) {
               ::testing::HasSubstr("LB policy is not supported."));
 }
 
+// Tests that the least_request policy, once enabled, is used for a
+// LEAST_REQUEST cluster and spreads RPCs across the backends of all
+// localities.
+TEST_P(CdsTest, LeastRequest) {
+  gpr_setenv("GRPC_XDS_EXPERIMENTAL_ENABLE_LEAST_REQUEST", "true");
+  auto cluster = default_cluster_;
+  cluster.set_lb_policy(Cluster::LEAST_REQUEST);
+  cluster.mutable_least_request_lb_config()->mutable_choice_count()->set_value(
+      3);
+  balancer_->ads_service()->SetCdsResource(cluster);
+  EdsResourceArgs args({
+      {"locality0", CreateEndpointsForBackends(0, 2)},
+      {"locality1", CreateEndpointsForBackends(2, 4)},
+  });
+  balancer_->ads_service()->SetEdsResource(BuildEdsResource(args));
+  WaitForAllBackends();
+  auto response_state = balancer_->ads_service()->cds_response_state();
+  ASSERT_TRUE(response_state.has_value());
+  EXPECT_EQ(response_state->state, AdsServiceImpl::ResponseState::ACKED);
+  ResetBackendCounters();
+  const size_t kNumRpcs = 100 * backends_.size();
+  CheckRpcSendOk(kNumRpcs);
+  // With no RPCs outstanding, every pick is a tie between random choices.
+  for (size_t i = 0; i < backends_.size(); ++i) {
+    EXPECT_GT(backends_[i]->backend_service()->request_count(), 0)
+        << "backend " << i;
+  }
+  gpr_unsetenv("GRPC_XDS_EXPERIMENTAL_ENABLE_LEAST_REQUEST");
+}
+
+// Tests that CDS client should send a NACK if the LEAST_REQUEST config has
+// a choice_count below 2.
+TEST_P(CdsTest, LeastRequestChoiceCountTooSmall) {
+  gpr_setenv("GRPC_XDS_EXPERIMENTAL_ENABLE_LEAST_REQUEST", "true");
+  auto cluster = default_cluster_;
+  cluster.set_lb_policy(Cluster::LEAST_REQUEST);
+  cluster.mutable_least_request_lb_config()->mutable_choice_count()->set_value(
+      1);
+  balancer_->ads_service()->SetCdsResource(cluster);
+  const auto response_state = WaitForCdsNack();
+  ASSERT_TRUE(response_state.has_value()) << "timed out waiting for NACK";
+  EXPECT_THAT(response_state->error_message,
+              ::testing::HasSubstr("choice_count must be at least 2."));
+  gpr_unsetenv("GRPC_XDS_EXPERIMENTAL_ENABLE_LEAST_REQUEST");
+}
+
 // Tests that CDS client should send a NACK if the lrs_server in CDS response
 // is other than SELF.
 TEST_P(CdsTest, WrongLrsServer) {
@@ -22,6 +22,8 @@
 #include <string.h>
 
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
@@ -320,6 +322,76 @@ static void BM_LameChannelCallCreateCoreSeparateBatch(benchmark::State& state) {
 }
 BENCHMARK(BM_LameChannelCallCreateCoreSeparateBatch);
 
+// Mixes calls on two registered methods with very different arena sizes: one
+// in every state.range(0) calls sends a large set of initial metadata. With a
+// single channel wide arena size estimate, the estimate decays between large
+// calls and they overflow their arenas (see call_arena_overflows/iter).
+static void BM_LameChannelCallCreateMixedMethods(benchmark::State& state) {
+  TrackCounters track_counters;
+  const int large_call_interval = state.range(0);
+
+  grpc_channel* channel = grpc_lame_client_channel_create(
+      "localhost:1234", GRPC_STATUS_UNAUTHENTICATED, "blah");
+  grpc_completion_queue* cq = grpc_completion_queue_create_for_next(nullptr);
+  void* small_rc =
+      grpc_channel_register_call(channel, "/foo/Small", nullptr, nullptr);
+  void* large_rc =
+      grpc_channel_register_call(channel, "/foo/Large", nullptr, nullptr);
+  std::vector<std::string> keys;
+  std::vector<grpc_metadata> large_metadata(64);
+  for (size_t i = 0; i < large_metadata.size(); i++) {
+    keys.push_back("x-large-metadata-" + std::to_string(i));
+  }
+  for (size_t i = 0; i < large_metadata.size(); i++) {
+    memset(&large_metadata[i], 0, sizeof(grpc_metadata));
+    large_metadata[i].key = grpc_slice_from_static_string(keys[i].c_str());
+    large_metadata[i].value = grpc_slice_from_static_string("value");
+  }
+  grpc_metadata_array trailing_metadata_recv;
+  grpc_status_code status;
+  grpc_slice details;
+  int n = 0;
+  for (auto _ : state) {
+    GPR_TIMER_SCOPE("BenchmarkCycle", 0);
+    const bool large = ++n % large_call_interval == 0;
+    grpc_call* call = grpc_channel_create_registered_call(
+        channel, nullptr, GRPC_PROPAGATE_DEFAULTS, cq,
+        large ? large_rc : small_rc, gpr_inf_future(GPR_CLOCK_REALTIME),
+        nullptr);
+    grpc_metadata_array_init(&trailing_metadata_recv);
+
+    grpc_op ops[3];
+    memset(ops, 0, sizeof(ops));
+    grpc_op* op = ops;
+    op->op = GRPC_OP_SEND_INITIAL_METADATA;
+    if (large) {
+      op->data.send_initial_metadata.count = large_metadata.size();
+      op->data.send_initial_metadata.metadata = large_metadata.data();
+    }
+    op++;
+    op->op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
+    op++;
+    op->op = GRPC_OP_RECV_STATUS_ON_CLIENT;
+    op->data.recv_status_on_client.trailing_metadata = &trailing_metadata_recv;
+    op->data.recv_status_on_client.status = &status;
+    op->data.recv_status_on_client.status_details = &details;
+    op++;
+    GPR_ASSERT(GRPC_CALL_OK == grpc_call_start_batch(call, ops,
+                                                     (size_t)(op - ops),
+                                                     (void*)1, nullptr));
+    grpc_event ev = grpc_completion_queue_next(
+        cq, gpr_inf_future(GPR_CLOCK_REALTIME), nullptr);
+    GPR_ASSERT(ev.type != GRPC_QUEUE_SHUTDOWN);
+    grpc_call_unref(call);
+    grpc_slice_unref(details);
+    grpc_metadata_array_destroy(&trailing_metadata_recv);
+  }
+  grpc_channel_destroy(channel);
+  grpc_completion_queue_destroy(cq);
+  track_counters.Finish(state);
+}
+BENCHMARK(BM_LameChannelCallCreateMixedMethods)->Arg(2)->Arg(16)->Arg(256);
+
 static void FilterDestroy(void* arg, grpc_error_handle /*error*/) {
   gpr_free(arg);
 }
@@ -0,0 +1,205 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Benchmark LB picks on a client channel shared by many threads */
+
+#include <string.h>
+
+#include <benchmark/benchmark.h>
+
+#include <grpc/grpc.h>
+#include <grpc/support/log.h>
+
+#include "src/core/ext/filters/client_channel/lb_policy_registry.h"
+#include "src/core/lib/channel/channel_args.h"
+#include "test/core/util/test_config.h"
+#include "test/cpp/microbenchmarks/helpers.h"
+#include "test/cpp/util/test_config.h"
+
+namespace grpc_core {
+namespace {
+
+const char* kDropPolicyName = "bm_drop_lb";
+
+// Drops every call, so that a call completes as soon as it is picked for,
+// without needing a server.
+class DropPolicy : public LoadBalancingPolicy {
+ public:
+  explicit DropPolicy(Args args) : LoadBalancingPolicy(std::move(args)) {}
+
+  const char* name() const override { return kDropPolicyName; }
+
+  void UpdateLocked(UpdateArgs) override {
+    channel_control_helper()->UpdateState(GRPC_CHANNEL_READY, absl::Status(),
+                                          absl::make_unique<DropPicker>());
+  }
+
+  void ResetBackoffLocked() override {}
+  void ShutdownLocked() override {}
+
+ private:
+  class DropPicker : public SubchannelPicker {
+   public:
+    PickResult Pick(PickArgs /*args*/) override {
+      return PickResult::Drop(
+          absl::UnavailableError("Call dropped by drop LB policy"));
+    }
+  };
+};
+
+class DropLbConfig : public LoadBalancingPolicy::Config {
+ public:
+  const char* name() const override { return kDropPolicyName; }
+};
+
+class DropPolicyFactory : public LoadBalancingPolicyFactory {
+ public:
+  OrphanablePtr<LoadBalancingPolicy> CreateLoadBalancingPolicy(
+      LoadBalancingPolicy::Args args) const override {
+    return MakeOrphanable<DropPolicy>(std::move(args));
+  }
+
+  const char* name() const override { return kDropPolicyName; }
+
+  RefCountedPtr<LoadBalancingPolicy::Config> ParseLoadBalancingConfig(
+      const Json& /*json*/, grpc_error_handle* /*error*/) const override {
+    return MakeRefCounted<DropLbConfig>();
+  }
+};
+
+}  // namespace
+}  // namespace grpc_core
+
+namespace grpc {
+namespace testing {
+
+static gpr_mu g_mu;
+static gpr_cv g_cv;
+static int g_threads_active;
+static bool g_active;
+static grpc_channel* g_channel;
+
+static void setup() {
+  grpc_arg arg = grpc_channel_arg_string_create(
+      const_cast<char*>(GRPC_ARG_SERVICE_CONFIG),
+      const_cast<char*>("{\"loadBalancingConfig\":[{\"bm_drop_lb\":{}}]}"));
+  grpc_channel_args args = {1, &arg};
+  g_channel = grpc_insecure_channel_create("ipv4:127.0.0.1:1234", &args,
+                                           nullptr);
+}
+
+static void teardown() { grpc_channel_destroy(g_channel); }
+
+/* Each thread starts calls on the same channel, one at a time. The LB policy
+   drops them, so the cost measured is mostly that of creating each call and
+   picking for it, which all threads do concurrently on the one channel. */
+static void BM_ChannelPick(benchmark::State& state) {
+  gpr_timespec deadline = gpr_inf_future(GPR_CLOCK_MONOTONIC);
+  auto thd_idx = state.thread_index();
+
+  gpr_mu_lock(&g_mu);
+  g_threads_active++;
+  if (thd_idx == 0) {
+    setup();
+    g_active = true;
+    gpr_cv_broadcast(&g_cv);
+  } else {
+    while (!g_active) {
+      gpr_cv_wait(&g_cv, &g_mu, deadline);
+    }
+  }
+  gpr_mu_unlock(&g_mu);
+
+  TrackCounters track_counters;
+  grpc_completion_queue* cq = grpc_completion_queue_create_for_next(nullptr);
+  grpc_slice method = grpc_slice_from_static_string("/foo/bar");
+  grpc_op ops[2];
+  memset(ops, 0, sizeof(ops));
+  ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
+  ops[1].op = GRPC_OP_RECV_STATUS_ON_CLIENT;
+  grpc_metadata_array trailing_metadata;
+  grpc_metadata_array_init(&trailing_metadata);
+  grpc_status_code status;
+  grpc_slice details;
+  ops[1].data.recv_status_on_client.trailing_metadata = &trailing_metadata;
+  ops[1].data.recv_status_on_client.status = &status;
+  ops[1].data.recv_status_on_client.status_details = &details;
+
+  for (auto _ : state) {
+    grpc_call* call =
+        grpc_channel_create_call(g_channel, nullptr, GRPC_PROPAGATE_DEFAULTS,
+                                 cq, method, nullptr, deadline, nullptr);
+    GPR_ASSERT(GRPC_CALL_OK == grpc_call_start_batch(call, ops, 2, call,
+                                                     nullptr));
+    grpc_event ev = grpc_completion_queue_next(cq, deadline, nullptr);
+    GPR_ASSERT(ev.type == GRPC_OP_COMPLETE && ev.tag == call);
+    GPR_ASSERT(status == GRPC_STATUS_UNAVAILABLE);
+    grpc_slice_unref(details);
+    grpc_metadata_array_destroy(&trailing_metadata);
+    grpc_metadata_array_init(&trailing_metadata);
+    grpc_call_unref(call);
+  }
+
+  grpc_metadata_array_destroy(&trailing_metadata);
+  grpc_completion_queue_shutdown(cq);
+  GPR_ASSERT(grpc_completion_queue_next(cq, deadline, nullptr).type ==
+             GRPC_QUEUE_SHUTDOWN);
+  grpc_completion_queue_destroy(cq);
+  state.SetItemsProcessed(state.iterations());
+  track_counters.Finish(state);
+
+  gpr_mu_lock(&g_mu);
+  g_threads_active--;
+  if (g_threads_active == 0) {
+    gpr_cv_broadcast(&g_cv);
+  } else {
+    while (g_threads_active > 0) {
+      gpr_cv_wait(&g_cv, &g_mu, deadline);
+    }
+  }
+  gpr_mu_unlock(&g_mu);
+
+  if (thd_idx == 0) {
+    teardown();
+    g_active = false;
+  }
+}
+BENCHMARK(BM_ChannelPick)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace testing
+}  // namespace grpc
+
+// Some distros have RunSpecifiedBenchmarks under the benchmark namespace,
+// and others do not. This allows us to support both modes.
+namespace benchmark {
+void RunTheBenchmarksNamespaced() { RunSpecifiedBenchmarks(); }
+}  // namespace benchmark
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  LibraryInitializer libInit;
+  grpc_core::LoadBalancingPolicyRegistry::Builder::
+      RegisterLoadBalancingPolicyFactory(
+          absl::make_unique<grpc_core::DropPolicyFactory>());
+  gpr_mu_init(&grpc::testing::g_mu);
+  gpr_cv_init(&grpc::testing::g_cv);
+  ::benchmark::Initialize(&argc, argv);
+  ::grpc::testing::InitTest(&argc, &argv, false);
+  benchmark::RunTheBenchmarksNamespaced();
+  return 0;
+}
@@ -25,10 +25,13 @@
 
 #include <benchmark/benchmark.h>
 
+#include "absl/strings/str_cat.h"
+
 #include <grpc/slice.h>
 #include <grpc/support/alloc.h>
 #include <grpc/support/log.h>
 
+#include "src/core/ext/transport/chttp2/transport/bin_encoder.h"
 #include "src/core/ext/transport/chttp2/transport/hpack_encoder.h"
 #include "src/core/ext/transport/chttp2/transport/hpack_parser.h"
 #include "src/core/lib/resource_quota/resource_quota.h"
@@ -614,6 +617,123 @@ class NonIndexedBinaryElem<100, false> {
   }
 };
 
+// Huffman heavy corpora: peers such as browsers and proxies huffman compress
+// every literal, so large auth tokens and tracing headers all go through the
+// huffman decoder.
+
+// Append an HPACK string literal (huffman compressed if huffman is set).
+static void AppendStringLiteral(absl::string_view value, bool huffman,
+                                std::vector<uint8_t>* out) {
+  grpc_slice s = grpc_slice_from_copied_buffer(value.data(), value.size());
+  if (huffman) {
+    grpc_slice compressed = grpc_chttp2_huffman_compress(s);
+    grpc_slice_unref(s);
+    s = compressed;
+  }
+  const uint8_t huff_bit = huffman ? 0x80 : 0x00;
+  size_t length = GRPC_SLICE_LENGTH(s);
+  if (length < 0x7f) {
+    out->push_back(huff_bit | static_cast<uint8_t>(length));
+  } else {
+    out->push_back(huff_bit | 0x7f);
+    length -= 0x7f;
+    while (length >= 0x80) {
+      out->push_back(static_cast<uint8_t>(0x80 | (length & 0x7f)));
+      length >>= 7;
+    }
+    out->push_back(static_cast<uint8_t>(length));
+  }
+  out->insert(out->end(), GRPC_SLICE_START_PTR(s), GRPC_SLICE_END_PTR(s));
+  grpc_slice_unref(s);
+}
+
+// Append a literal header field without indexing, with a huffman compressed
+// key and value.
+static void AppendHuffmanLiteralHeader(absl::string_view key,
+                                       absl::string_view value,
+                                       std::vector<uint8_t>* out) {
+  out->push_back(0x00);
+  AppendStringLiteral(key, true, out);
+  AppendStringLiteral(value, true, out);
+}
+
+// Deterministic pseudo random string drawn from alphabet.
+static std::string MakeRandomString(size_t length, absl::string_view alphabet,
+                                    uint32_t seed) {
+  std::string out;
+  for (size_t i = 0; i < length; i++) {
+    seed = seed * 1103515245 + 12345;
+    out.push_back(alphabet[(seed >> 16) % alphabet.size()]);
+  }
+  return out;
+}
+
+static constexpr absl::string_view kBase64UrlAlphabet =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+static constexpr absl::string_view kHexAlphabet = "0123456789abcdef";
+
+template <int kLength>
+class NonIndexedHuffmanElem {
+ public:
+  static std::vector<grpc_slice> GetInitSlices() { return {}; }
+  static std::vector<grpc_slice> GetBenchmarkSlices() {
+    std::vector<uint8_t> v;
+    AppendHuffmanLiteralHeader(
+        "x-custom-value", MakeRandomString(kLength, kBase64UrlAlphabet, 1),
+        &v);
+    return {MakeSlice(v)};
+  }
+};
+
+// A JWT-sized bearer token.
+class HuffmanAuthorizationElem {
+ public:
+  static std::vector<grpc_slice> GetInitSlices() { return {}; }
+  static std::vector<grpc_slice> GetBenchmarkSlices() {
+    std::vector<uint8_t> v;
+    AppendHuffmanLiteralHeader(
+        "authorization",
+        absl::StrCat("Bearer ",
+                     MakeRandomString(36, kBase64UrlAlphabet, 2), ".",
+                     MakeRandomString(800, kBase64UrlAlphabet, 3), ".",
+                     MakeRandomString(342, kBase64UrlAlphabet, 4)),
+        &v);
+    return {MakeSlice(v)};
+  }
+};
+
+// W3C trace context plus B3 propagation headers.
+class HuffmanTracingElems {
+ public:
+  static std::vector<grpc_slice> GetInitSlices() { return {}; }
+  static std::vector<grpc_slice> GetBenchmarkSlices() {
+    const std::string trace_id = MakeRandomString(32, kHexAlphabet, 5);
+    const std::string span_id = MakeRandomString(16, kHexAlphabet, 6);
+    const std::string parent_id = MakeRandomString(16, kHexAlphabet, 7);
+    std::vector<uint8_t> v;
+    AppendHuffmanLiteralHeader(
+        "traceparent", absl::StrCat("00-", trace_id, "-", span_id, "-01"), &v);
+    AppendHuffmanLiteralHeader(
+        "tracestate",
+        absl::StrCat("congo=", MakeRandomString(16, kBase64UrlAlphabet, 8),
+                     ",rojo=", MakeRandomString(16, kHexAlphabet, 9)),
+        &v);
+    AppendHuffmanLiteralHeader("x-b3-traceid", trace_id, &v);
+    AppendHuffmanLiteralHeader("x-b3-spanid", span_id, &v);
+    AppendHuffmanLiteralHeader("x-b3-parentspanid", parent_id, &v);
+    AppendHuffmanLiteralHeader("x-b3-sampled", "1", &v);
+    AppendHuffmanLiteralHeader(
+        "x-request-id",
+        absl::StrCat(MakeRandomString(8, kHexAlphabet, 10), "-",
+                     MakeRandomString(4, kHexAlphabet, 11), "-",
+                     MakeRandomString(4, kHexAlphabet, 12), "-",
+                     MakeRandomString(4, kHexAlphabet, 13), "-",
+                     MakeRandomString(12, kHexAlphabet, 14)),
+        &v);
+    return {MakeSlice(v)};
+  }
+};
+
 using RepresentativeClientInitialMetadata = FromEncoderFixture<
     hpack_encoder_fixtures::RepresentativeClientInitialMetadata>;
 using RepresentativeServerInitialMetadata = FromEncoderFixture<
@@ -670,6 +790,11 @@ BENCHMARK_TEMPLATE(BM_HpackParserParseHeader,
 BENCHMARK_TEMPLATE(BM_HpackParserParseHeader,
                    RepresentativeServerInitialMetadata);
 BENCHMARK_TEMPLATE(BM_HpackParserParseHeader, SameDeadline);
+BENCHMARK_TEMPLATE(BM_HpackParserParseHeader, NonIndexedHuffmanElem<10>);
+BENCHMARK_TEMPLATE(BM_HpackParserParseHeader, NonIndexedHuffmanElem<100>);
+BENCHMARK_TEMPLATE(BM_HpackParserParseHeader, NonIndexedHuffmanElem<1000>);
+BENCHMARK_TEMPLATE(BM_HpackParserParseHeader, HuffmanAuthorizationElem);
+BENCHMARK_TEMPLATE(BM_HpackParserParseHeader, HuffmanTracingElems);
 
 }  // namespace hpack_parser_fixtures
 
@@ -0,0 +1,204 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Microbenchmarks around the chttp2 stream map, compared against the sorted
+   array map it replaced */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "src/core/ext/transport/chttp2/transport/stream_map.h"
+#include "test/core/util/test_config.h"
+#include "test/cpp/microbenchmarks/helpers.h"
+#include "test/cpp/util/test_config.h"
+
+namespace {
+
+// The previous grpc_chttp2_stream_map: sorted key and value arrays searched
+// with binary search, with deleted entries compacted lazily.
+class SortedArrayStreamMap {
+ public:
+  ~SortedArrayStreamMap() {
+    free(keys_);
+    free(values_);
+  }
+
+  void Add(uint32_t key, void* value) {
+    if (count_ == capacity_) {
+      if (free_ > capacity_ / 4) {
+        Compact();
+      } else {
+        capacity_ = std::max<size_t>(8, 2 * capacity_);
+        keys_ = static_cast<uint32_t*>(
+            realloc(keys_, capacity_ * sizeof(uint32_t)));
+        values_ =
+            static_cast<void**>(realloc(values_, capacity_ * sizeof(void*)));
+      }
+    }
+    keys_[count_] = key;
+    values_[count_] = value;
+    count_++;
+  }
+
+  void* Find(uint32_t key) {
+    void** pvalue = FindSlot(key);
+    return pvalue != nullptr ? *pvalue : nullptr;
+  }
+
+  void* Delete(uint32_t key) {
+    void** pvalue = FindSlot(key);
+    void* out = *pvalue;
+    *pvalue = nullptr;
+    free_++;
+    if (free_ == count_) free_ = count_ = 0;
+    return out;
+  }
+
+ private:
+  void Compact() {
+    size_t out = 0;
+    for (size_t i = 0; i < count_; i++) {
+      if (values_[i] != nullptr) {
+        keys_[out] = keys_[i];
+        values_[out] = values_[i];
+        out++;
+      }
+    }
+    count_ = out;
+    free_ = 0;
+  }
+
+  void** FindSlot(uint32_t key) {
+    size_t min_idx = 0;
+    size_t max_idx = count_;
+    while (min_idx < max_idx) {
+      size_t mid_idx = min_idx + ((max_idx - min_idx) / 2);
+      if (keys_[mid_idx] < key) {
+        min_idx = mid_idx + 1;
+      } else if (keys_[mid_idx] > key) {
+        max_idx = mid_idx;
+      } else {
+        return &values_[mid_idx];
+      }
+    }
+    return nullptr;
+  }
+
+  uint32_t* keys_ = nullptr;
+  void** values_ = nullptr;
+  size_t count_ = 0;
+  size_t free_ = 0;
+  size_t capacity_ = 0;
+};
+
+class HashStreamMap {
+ public:
+  HashStreamMap() { grpc_chttp2_stream_map_init(&map_, 8); }
+  ~HashStreamMap() { grpc_chttp2_stream_map_destroy(&map_); }
+
+  void Add(uint32_t key, void* value) {
+    grpc_chttp2_stream_map_add(&map_, key, value);
+  }
+  void* Find(uint32_t key) { return grpc_chttp2_stream_map_find(&map_, key); }
+  void* Delete(uint32_t key) {
+    return grpc_chttp2_stream_map_delete(&map_, key);
+  }
+
+ private:
+  grpc_chttp2_stream_map map_;
+};
+
+void* ValueFor(uint32_t id) { return reinterpret_cast<void*>(id); }
+
+// Client initiated (odd) stream ids, as seen by a server.
+uint32_t StreamId(size_t n) { return static_cast<uint32_t>(2 * n + 1); }
+
+// Lookup of live streams in a random order, as incoming frames do.
+template <class Map>
+void BM_StreamMapFind(benchmark::State& state) {
+  const size_t num_streams = state.range(0);
+  Map map;
+  for (size_t i = 0; i < num_streams; i++) {
+    map.Add(StreamId(i), ValueFor(StreamId(i)));
+  }
+  std::vector<uint32_t> lookups(4096);
+  for (auto& id : lookups) id = StreamId(rand() % num_streams);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.Find(lookups[i++ & 4095]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_StreamMapFind, SortedArrayStreamMap)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_StreamMapFind, HashStreamMap)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+
+// Steady state stream churn: each iteration opens a new stream and closes a
+// random live one, keeping the number of concurrent streams constant.
+template <class Map>
+void BM_StreamMapChurn(benchmark::State& state) {
+  const size_t num_streams = state.range(0);
+  Map map;
+  std::vector<uint32_t> live;
+  size_t next = 0;
+  for (; next < num_streams; next++) {
+    map.Add(StreamId(next), ValueFor(StreamId(next)));
+    live.push_back(StreamId(next));
+  }
+  for (auto _ : state) {
+    const size_t victim = rand() % num_streams;
+    benchmark::DoNotOptimize(map.Delete(live[victim]));
+    live[victim] = StreamId(next++);
+    map.Add(live[victim], ValueFor(live[victim]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_StreamMapChurn, SortedArrayStreamMap)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_StreamMapChurn, HashStreamMap)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+
+}  // namespace
+
+// Some distros have RunSpecifiedBenchmarks under the benchmark namespace,
+// and others do not. This allows us to support both modes.
+namespace benchmark {
+void RunTheBenchmarksNamespaced() { RunSpecifiedBenchmarks(); }
+}  // namespace benchmark
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  LibraryInitializer libInit;
+  ::benchmark::Initialize(&argc, argv);
+  ::grpc::testing::InitTest(&argc, &argv, false);
+  benchmark::RunTheBenchmarksNamespaced();
+  return 0;
+}
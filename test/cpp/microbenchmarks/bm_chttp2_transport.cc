@@ -20,9 +20,11 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <memory>
 #include <queue>
 #include <sstream>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
@@ -61,7 +63,8 @@ class PhonyEndpoint : public grpc_endpoint {
                                                    get_peer,
                                                    get_local_address,
                                                    get_fd,
-                                                   can_track_err};
+                                                   can_track_err,
+                                                   set_channelz_socket_node};
     grpc_endpoint::vtable = &my_vtable;
   }
 
@@ -129,6 +132,8 @@ class PhonyEndpoint : public grpc_endpoint {
   }
   static int get_fd(grpc_endpoint* /*ep*/) { return 0; }
   static bool can_track_err(grpc_endpoint* /*ep*/) { return false; }
+  static void set_channelz_socket_node(
+      grpc_endpoint* /*ep*/, grpc_core::channelz::SocketNode* /*node*/) {}
 };
 
 class Fixture {
@@ -490,6 +495,123 @@ static void BM_TransportStreamSend(benchmark::State& state) {
 }
 BENCHMARK(BM_TransportStreamSend)->Range(0, 128 * 1024 * 1024);
 
+// Sends one message on each of state.range(0) concurrent streams per
+// iteration. Reports throughput, and alongside it the mean latency from
+// starting a round of sends to each message's send completing, which depends
+// on how the transport splits the queued data into writes.
+static void BM_TransportStreamSendConcurrent(benchmark::State& state) {
+  TrackCounters track_counters;
+  grpc_core::ExecCtx exec_ctx;
+  Fixture f(grpc::ChannelArguments(), true);
+  const int num_streams = state.range(0);
+  const size_t message_size = state.range(1);
+  struct SendingStream {
+    Stream* s;
+    grpc_transport_stream_op_batch op;
+    grpc_transport_stream_op_batch_payload op_payload{nullptr};
+    grpc_core::ManualConstructor<grpc_core::SliceBufferByteStream> send_stream;
+    std::unique_ptr<TestClosure> on_complete;
+    bool done;
+  };
+  std::vector<std::unique_ptr<SendingStream>> streams;
+  grpc_slice send_slice = grpc_slice_malloc_large(message_size);
+  memset(GRPC_SLICE_START_PTR(send_slice), 0, GRPC_SLICE_LENGTH(send_slice));
+  auto arena = grpc_core::MakeScopedArena(1024, g_memory_allocator);
+  grpc_metadata_batch b(arena.get());
+  RepresentativeClientInitialMetadata::Prepare(&b);
+
+  gpr_timespec round_start;
+  double total_latency_us = 0;
+  int num_pending = 0;
+  for (int i = 0; i < num_streams; i++) {
+    auto* ss = new SendingStream;
+    streams.emplace_back(ss);
+    ss->s = new Stream(&f);
+    ss->s->Init(state);
+    ss->on_complete = MakeTestClosure([&, ss](grpc_error_handle error) {
+      GPR_ASSERT(error == GRPC_ERROR_NONE);
+      if (ss->done) return;
+      ss->done = true;
+      total_latency_us += gpr_timespec_to_micros(
+          gpr_time_sub(gpr_now(GPR_CLOCK_MONOTONIC), round_start));
+      num_pending--;
+    });
+    ss->done = true;
+    ss->op = {};
+    ss->op.payload = &ss->op_payload;
+    ss->op.send_initial_metadata = true;
+    ss->op.payload->send_initial_metadata.send_initial_metadata = &b;
+    ss->op.on_complete = ss->on_complete.get();
+    ss->s->Op(&ss->op);
+  }
+  f.FlushExecCtx();
+
+  for (auto _ : state) {
+    round_start = gpr_now(GPR_CLOCK_MONOTONIC);
+    num_pending = num_streams;
+    for (auto& ss : streams) {
+      grpc_slice_buffer send_buffer;
+      grpc_slice_buffer_init(&send_buffer);
+      grpc_slice_buffer_add(&send_buffer, grpc_slice_ref(send_slice));
+      ss->send_stream.Init(&send_buffer, 0);
+      grpc_slice_buffer_destroy(&send_buffer);
+      // force outgoing window to be yuge
+      ss->s->chttp2_stream()->flow_control->TestOnlyForceHugeWindow();
+      f.chttp2_transport()->flow_control->TestOnlyForceHugeWindow();
+      ss->done = false;
+      ss->op = {};
+      ss->op.payload = &ss->op_payload;
+      ss->op.on_complete = ss->on_complete.get();
+      ss->op.send_message = true;
+      ss->op.payload->send_message.send_message.reset(ss->send_stream.get());
+      ss->s->Op(&ss->op);
+    }
+    f.FlushExecCtx();
+    GPR_ASSERT(num_pending == 0);
+  }
+
+  for (auto& ss : streams) {
+    gpr_event* stream_cancel_done = new gpr_event;
+    gpr_event_init(stream_cancel_done);
+    std::unique_ptr<TestClosure> stream_cancel_closure =
+        MakeTestClosure([&](grpc_error_handle error) {
+          GPR_ASSERT(error == GRPC_ERROR_NONE);
+          gpr_event_set(stream_cancel_done, reinterpret_cast<void*>(1));
+        });
+    ss->op = {};
+    ss->op.payload = &ss->op_payload;
+    ss->op.cancel_stream = true;
+    ss->op.payload->cancel_stream.cancel_error = GRPC_ERROR_CANCELLED;
+    ss->op.on_complete = stream_cancel_closure.get();
+    ss->s->Op(&ss->op);
+    f.FlushExecCtx();
+    gpr_event_wait(stream_cancel_done, gpr_inf_future(GPR_CLOCK_REALTIME));
+    done_events.emplace_back(stream_cancel_done);
+    Stream* s = ss->s;
+    s->DestroyThen(
+        MakeOnceClosure([s](grpc_error_handle /*error*/) { delete s; }));
+    f.FlushExecCtx();
+  }
+  state.SetBytesProcessed(state.iterations() * num_streams * message_size);
+  std::ostringstream label;
+  label << "latency_us:"
+        << total_latency_us /
+               std::max<double>(1, state.iterations() * num_streams);
+  track_counters.AddLabel(label.str());
+  track_counters.Finish(state);
+  grpc_slice_unref(send_slice);
+}
+static void ConcurrentSendArgs(benchmark::internal::Benchmark* b) {
+  for (int num_streams : {1, 16, 256}) {
+    for (int message_size : {1024, 64 * 1024, 1024 * 1024}) {
+      // Keep each round to a reasonable amount of data.
+      if (num_streams * message_size > 16 * 1024 * 1024) continue;
+      b->Args({num_streams, message_size});
+    }
+  }
+}
+BENCHMARK(BM_TransportStreamSendConcurrent)->Apply(ConcurrentSendArgs);
+
 #define SLICE_FROM_BUFFER(s) grpc_slice_from_static_buffer(s, sizeof(s) - 1)
 
 static grpc_slice CreateIncomingDataSlice(size_t length, size_t frame_size) {
@@ -77,6 +77,13 @@ BENCHMARK_TEMPLATE(BM_StreamingPingPongMsgs, MinInProcess, NoOpMutator,
                    NoOpMutator)
     ->Range(0, 128 * 1024 * 1024);
 
+BENCHMARK_TEMPLATE(BM_StreamingPingPongMsgs, GzipInProcessCHTTP2, NoOpMutator,
+                   NoOpMutator)
+    ->Range(0, 1024 * 1024);
+BENCHMARK_TEMPLATE(BM_StreamingPingPongMsgs, GzipPerCallContextsInProcessCHTTP2,
+                   NoOpMutator, NoOpMutator)
+    ->Range(0, 1024 * 1024);
+
 // Generate Args for StreamingPingPongWithCoalescingApi benchmarks. Currently
 // generates args for only "small streams" (i.e streams with 0, 1 or 2 messages)
 static void StreamingPingPongWithCoalescingApiArgs(
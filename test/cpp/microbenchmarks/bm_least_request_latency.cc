@@ -0,0 +1,146 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Simulate calls to backends of unequal speed, and compare the latencies
+   seen when picking with round robin and with least_request */
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <grpc/grpc.h>
+
+#include "src/core/ext/filters/client_channel/lb_policy/least_request/least_request.h"
+#include "test/core/util/test_config.h"
+#include "test/cpp/microbenchmarks/helpers.h"
+#include "test/cpp/util/test_config.h"
+
+namespace grpc {
+namespace testing {
+
+/* 8 backends serve a call in 1ms on average, and 2 take twice as long, so
+   that round robin overloads the slow ones above 55% of the total capacity. */
+static constexpr int kNumFastBackends = 8;
+static constexpr int kNumSlowBackends = 2;
+static constexpr double kFastServiceMs = 1;
+static constexpr double kSlowServiceMs = 2;
+static constexpr int kNumCalls = 100000;
+
+/* A backend serving one call at a time, in order of arrival. */
+struct Backend {
+  double service_ms;
+  /* Completion times of the calls in flight, oldest first. */
+  std::deque<double> completions;
+
+  size_t Outstanding(double now) {
+    while (!completions.empty() && completions.front() <= now) {
+      completions.pop_front();
+    }
+    return completions.size();
+  }
+};
+
+/* Sends kNumCalls calls at state.range(0) percent of the backends' total
+   capacity, and reports the latency percentiles as counters. */
+template <typename PickFn>
+static void SimulateCalls(benchmark::State& state, PickFn pick) {
+  const double capacity_per_ms =
+      kNumFastBackends / kFastServiceMs + kNumSlowBackends / kSlowServiceMs;
+  const double arrivals_per_ms = capacity_per_ms * state.range(0) / 100;
+  std::vector<double> latencies(kNumCalls);
+  for (auto _ : state) {
+    std::mt19937_64 rng(42);
+    std::exponential_distribution<double> interarrival(arrivals_per_ms);
+    std::vector<Backend> backends;
+    for (int i = 0; i < kNumFastBackends; ++i) {
+      backends.push_back({kFastServiceMs, {}});
+    }
+    for (int i = 0; i < kNumSlowBackends; ++i) {
+      backends.push_back({kSlowServiceMs, {}});
+    }
+    double now = 0;
+    for (int i = 0; i < kNumCalls; ++i) {
+      now += interarrival(rng);
+      Backend& backend = backends[pick(&rng, &backends, now)];
+      std::exponential_distribution<double> service(1 / backend.service_ms);
+      const double start = backend.Outstanding(now) == 0
+                               ? now
+                               : backend.completions.back();
+      backend.completions.push_back(start + service(rng));
+      latencies[i] = backend.completions.back() - now;
+    }
+    std::sort(latencies.begin(), latencies.end());
+  }
+  state.counters["p50_ms"] = latencies[kNumCalls / 2];
+  state.counters["p99_ms"] = latencies[kNumCalls * 99 / 100];
+  state.counters["p999_ms"] = latencies[kNumCalls * 999 / 1000];
+  state.SetItemsProcessed(state.iterations() * kNumCalls);
+}
+
+static void BM_RoundRobinLatency(benchmark::State& state) {
+  TrackCounters track_counters;
+  size_t next = 0;
+  SimulateCalls(state, [&next](std::mt19937_64* /*rng*/,
+                               std::vector<Backend>* backends,
+                               double /*now*/) {
+    return next++ % backends->size();
+  });
+  track_counters.Finish(state);
+}
+BENCHMARK(BM_RoundRobinLatency)->Arg(50)->Arg(70)->Arg(90);
+
+static void BM_LeastRequestLatency(benchmark::State& state) {
+  TrackCounters track_counters;
+  const uint32_t choice_count = static_cast<uint32_t>(state.range(1));
+  SimulateCalls(state, [choice_count](std::mt19937_64* rng,
+                                      std::vector<Backend>* backends,
+                                      double now) {
+    return grpc_core::PickLeastLoaded(
+        backends->size(), choice_count, [rng]() { return (*rng)(); },
+        [backends, now](size_t i) { return (*backends)[i].Outstanding(now); });
+  });
+  track_counters.Finish(state);
+}
+
+static void LeastRequestArgs(benchmark::internal::Benchmark* b) {
+  for (int load_percent : {50, 70, 90}) {
+    for (int choice_count : {2, 3}) b->Args({load_percent, choice_count});
+  }
+}
+BENCHMARK(BM_LeastRequestLatency)->Apply(LeastRequestArgs);
+
+}  // namespace testing
+}  // namespace grpc
+
+// Some distros have RunSpecifiedBenchmarks under the benchmark namespace,
+// and others do not. This allows us to support both modes.
+namespace benchmark {
+void RunTheBenchmarksNamespaced() { RunSpecifiedBenchmarks(); }
+}  // namespace benchmark
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  LibraryInitializer libInit;
+  ::benchmark::Initialize(&argc, argv);
+  ::grpc::testing::InitTest(&argc, &argv, false);
+  benchmark::RunTheBenchmarksNamespaced();
+  return 0;
+}
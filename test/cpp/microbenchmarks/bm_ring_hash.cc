@@ -0,0 +1,140 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Compare the build time, size and lookup time of the hash rings and Maglev
+   tables of the ring_hash LB policy */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "absl/strings/str_cat.h"
+
+#include <grpc/grpc.h>
+
+#include "src/core/ext/filters/client_channel/lb_policy/ring_hash/ring_hash.h"
+#include "test/core/util/test_config.h"
+#include "test/cpp/microbenchmarks/helpers.h"
+#include "test/cpp/util/test_config.h"
+
+namespace grpc {
+namespace testing {
+
+static std::vector<grpc_core::RingHashAddressWeight> MakeAddresses(
+    int num_addresses) {
+  std::vector<grpc_core::RingHashAddressWeight> address_weights;
+  for (int i = 0; i < num_addresses; ++i) {
+    address_weights.push_back(
+        {absl::StrCat("10.0.", i / 256, ".", i % 256, ":443"), 1});
+  }
+  return address_weights;
+}
+
+/* state.range(0) is the number of addresses, and state.range(1) the minimum
+   ring size, or the Maglev table size. */
+
+static void BM_BuildHashRing(benchmark::State& state) {
+  TrackCounters track_counters;
+  auto address_weights = MakeAddresses(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    auto ring = grpc_core::MakeHashRing(address_weights, state.range(1),
+                                        8388608);
+    size = ring.size() * sizeof(ring[0]);
+    benchmark::DoNotOptimize(ring.data());
+  }
+  state.counters["bytes"] = size;
+  track_counters.Finish(state);
+}
+
+static void BM_BuildMaglevTable(benchmark::State& state) {
+  TrackCounters track_counters;
+  auto address_weights = MakeAddresses(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    auto table = grpc_core::MakeMaglevTable(address_weights, state.range(1));
+    size = table.size() * sizeof(table[0]);
+    benchmark::DoNotOptimize(table.data());
+  }
+  state.counters["bytes"] = size;
+  track_counters.Finish(state);
+}
+
+static void BM_FindInHashRing(benchmark::State& state) {
+  TrackCounters track_counters;
+  auto ring = grpc_core::MakeHashRing(MakeAddresses(state.range(0)),
+                                      state.range(1), 8388608);
+  std::mt19937_64 rng(42);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(grpc_core::FindInHashRing(ring, rng()));
+  }
+  track_counters.Finish(state);
+}
+
+static void BM_FindInMaglevTable(benchmark::State& state) {
+  TrackCounters track_counters;
+  auto table =
+      grpc_core::MakeMaglevTable(MakeAddresses(state.range(0)), state.range(1));
+  std::mt19937_64 rng(42);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(table[rng() % table.size()]);
+  }
+  track_counters.Finish(state);
+}
+
+/* The default ring (1024 entries at least) and larger ones, against the
+   default Maglev table and one ten times larger. */
+static void RingArgs(benchmark::internal::Benchmark* b) {
+  for (int num_addresses : {10, 100, 1000}) {
+    for (int min_ring_size : {1024, 65536, 1048576}) {
+      b->Args({num_addresses, min_ring_size});
+    }
+  }
+}
+
+static void MaglevArgs(benchmark::internal::Benchmark* b) {
+  for (int num_addresses : {10, 100, 1000}) {
+    for (int table_size : {65537, 655373}) {
+      b->Args({num_addresses, table_size});
+    }
+  }
+}
+
+BENCHMARK(BM_BuildHashRing)->Apply(RingArgs);
+BENCHMARK(BM_BuildMaglevTable)->Apply(MaglevArgs);
+BENCHMARK(BM_FindInHashRing)->Apply(RingArgs);
+BENCHMARK(BM_FindInMaglevTable)->Apply(MaglevArgs);
+
+}  // namespace testing
+}  // namespace grpc
+
+// Some distros have RunSpecifiedBenchmarks under the benchmark namespace,
+// and others do not. This allows us to support both modes.
+namespace benchmark {
+void RunTheBenchmarksNamespaced() { RunSpecifiedBenchmarks(); }
+}  // namespace benchmark
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  LibraryInitializer libInit;
+  ::benchmark::Initialize(&argc, argv);
+  ::grpc::testing::InitTest(&argc, &argv, false);
+  benchmark::RunTheBenchmarksNamespaced();
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Benchmark round robin picks from many threads over a 100-backend list */
+
+#include <atomic>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <grpc/grpc.h>
+
+#include "src/core/lib/gprpp/per_cpu.h"
+#include "src/core/lib/iomgr/exec_ctx.h"
+#include "test/core/util/test_config.h"
+#include "test/cpp/microbenchmarks/helpers.h"
+#include "test/cpp/util/test_config.h"
+
+namespace grpc {
+namespace testing {
+
+static constexpr size_t kNumBackends = 100;
+
+static const std::vector<int>& Backends() {
+  static const std::vector<int>* backends = new std::vector<int>(kNumBackends);
+  return *backends;
+}
+
+/* What round_robin used to do: every pick advances one shared index. */
+static void BM_SharedIndexPick(benchmark::State& state) {
+  static std::atomic<size_t> index{0};
+  TrackCounters track_counters;
+  grpc_core::ExecCtx exec_ctx;
+  const std::vector<int>& backends = Backends();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        backends[index.fetch_add(1, std::memory_order_relaxed) %
+                 backends.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+  track_counters.Finish(state);
+}
+BENCHMARK(BM_SharedIndexPick)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_PerCpuIndexPick(benchmark::State& state) {
+  static grpc_core::PerCpuRoundRobinIndex* index =
+      new grpc_core::PerCpuRoundRobinIndex(kNumBackends);
+  TrackCounters track_counters;
+  grpc_core::ExecCtx exec_ctx;
+  const std::vector<int>& backends = Backends();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(backends[index->Next(exec_ctx.starting_cpu())]);
+  }
+  state.SetItemsProcessed(state.iterations());
+  track_counters.Finish(state);
+}
+BENCHMARK(BM_PerCpuIndexPick)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace testing
+}  // namespace grpc
+
+// Some distros have RunSpecifiedBenchmarks under the benchmark namespace,
+// and others do not. This allows us to support both modes.
+namespace benchmark {
+void RunTheBenchmarksNamespaced() { RunSpecifiedBenchmarks(); }
+}  // namespace benchmark
+
+int main(int argc, char** argv) {
+  grpc::testing::TestEnvironment env(argc, argv);
+  LibraryInitializer libInit;
+  ::benchmark::Initialize(&argc, argv);
+  ::grpc::testing::InitTest(&argc, &argv, false);
+  benchmark::RunTheBenchmarksNamespaced();
+  return 0;
+}
@@ -24,6 +24,7 @@
 #include <grpc/grpc.h>
 
 #include "src/core/lib/iomgr/executor/threadpool.h"
+#include "src/core/lib/iomgr/executor/work_stealing_threadpool.h"
 #include "test/core/util/test_config.h"
 #include "test/cpp/microbenchmarks/helpers.h"
 #include "test/cpp/util/test_config.h"
@@ -58,6 +59,27 @@ class BlockingCounter {
   std::condition_variable cv_;
 };
 
+// First argument is the number of closures run (num_iterations), second
+// argument is the thread pool size (num_threads), scaling from 1 to 64.
+static void ThreadScalingArgs(benchmark::internal::Benchmark* b) {
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    b->Args({524288, num_threads});
+  }
+}
+
+// Registers benchmark "name" for ThreadPoolType, over a range of concurrent
+// closures.
+#define BENCHMARK_THREAD_POOL_ADD(name, ThreadPoolType)                    \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 1)->Apply(ThreadScalingArgs);   \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 4)->Apply(ThreadScalingArgs);   \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 8)->Apply(ThreadScalingArgs);   \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 16)->Apply(ThreadScalingArgs);  \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 32)->Apply(ThreadScalingArgs);  \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 64)->Apply(ThreadScalingArgs);  \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 128)->Apply(ThreadScalingArgs); \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 512)->Apply(ThreadScalingArgs); \
+  BENCHMARK_TEMPLATE(name, ThreadPoolType, 2048)->Apply(ThreadScalingArgs)
+
 // This is a functor/closure class for threadpool microbenchmark.
 // This functor (closure) class will add another functor into pool if the
 // number passed in (num_add) is greater than 0. Otherwise, it will decrement
@@ -65,8 +87,8 @@ class BlockingCounter {
 // the end, therefore, no need for caller to do clean-ups.
 class AddAnotherFunctor : public grpc_completion_queue_functor {
  public:
-  AddAnotherFunctor(grpc_core::ThreadPool* pool, BlockingCounter* counter,
-                    int num_add)
+  AddAnotherFunctor(grpc_core::ThreadPoolInterface* pool,
+                    BlockingCounter* counter, int num_add)
       : pool_(pool), counter_(counter), num_add_(num_add) {
     functor_run = &AddAnotherFunctor::Run;
     inlineable = false;
@@ -88,18 +110,18 @@ class AddAnotherFunctor : public grpc_completion_queue_functor {
   }
 
  private:
-  grpc_core::ThreadPool* pool_;
+  grpc_core::ThreadPoolInterface* pool_;
   BlockingCounter* counter_;
   int num_add_;
 };
 
-template <int kConcurrentFunctor>
+template <class ThreadPoolType, int kConcurrentFunctor>
 static void ThreadPoolAddAnother(benchmark::State& state) {
   const int num_iterations = state.range(0);
   const int num_threads = state.range(1);
   // Number of adds done by each closure.
   const int num_add = num_iterations / kConcurrentFunctor;
-  grpc_core::ThreadPool pool(num_threads);
+  ThreadPoolType pool(num_threads);
   while (state.KeepRunningBatch(num_iterations)) {
     BlockingCounter counter(kConcurrentFunctor);
     for (int i = 0; i < kConcurrentFunctor; ++i) {
@@ -110,23 +132,9 @@ static void ThreadPoolAddAnother(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations());
 }
 
-// First pair of arguments is range for number of iterations (num_iterations).
-// Second pair of arguments is range for thread pool size (num_threads).
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 1)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 4)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 8)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 16)
-    ->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 32)
-    ->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 64)
-    ->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 128)
-    ->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 512)
-    ->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddAnother, 2048)
-    ->RangePair(524288, 524288, 1, 1024);
+BENCHMARK_THREAD_POOL_ADD(ThreadPoolAddAnother, grpc_core::ThreadPool);
+BENCHMARK_THREAD_POOL_ADD(ThreadPoolAddAnother,
+                          grpc_core::WorkStealingThreadPool);
 
 // A functor class that will delete self on end of running.
 class SuicideFunctorForAdd : public grpc_completion_queue_functor {
@@ -150,13 +158,14 @@ class SuicideFunctorForAdd : public grpc_completion_queue_functor {
 };
 
 // Performs the scenario of external thread(s) adding closures into pool.
+template <class ThreadPoolType>
 static void BM_ThreadPoolExternalAdd(benchmark::State& state) {
-  static grpc_core::ThreadPool* external_add_pool = nullptr;
+  static grpc_core::ThreadPoolInterface* external_add_pool = nullptr;
   int thread_idx = state.thread_index();
   // Setup for each run of test.
   if (thread_idx == 0) {
     const int num_threads = state.range(1);
-    external_add_pool = new grpc_core::ThreadPool(num_threads);
+    external_add_pool = new ThreadPoolType(num_threads);
   }
   const int num_iterations = state.range(0) / state.threads();
   while (state.KeepRunningBatch(num_iterations)) {
@@ -173,17 +182,18 @@ static void BM_ThreadPoolExternalAdd(benchmark::State& state) {
     delete external_add_pool;
   }
 }
-BENCHMARK(BM_ThreadPoolExternalAdd)
-    // First pair is range for number of iterations (num_iterations).
-    // Second pair is range for thread pool size (num_threads).
-    ->RangePair(524288, 524288, 1, 1024)
+BENCHMARK_TEMPLATE(BM_ThreadPoolExternalAdd, grpc_core::ThreadPool)
+    ->Apply(ThreadScalingArgs)
     ->ThreadRange(1, 256);  // Concurrent external thread(s) up to 256
+BENCHMARK_TEMPLATE(BM_ThreadPoolExternalAdd, grpc_core::WorkStealingThreadPool)
+    ->Apply(ThreadScalingArgs)
+    ->ThreadRange(1, 256);
 
 // Functor (closure) that adds itself into pool repeatedly. By adding self, the
 // overhead would be low and can measure the time of add more accurately.
 class AddSelfFunctor : public grpc_completion_queue_functor {
  public:
-  AddSelfFunctor(grpc_core::ThreadPool* pool, BlockingCounter* counter,
+  AddSelfFunctor(grpc_core::ThreadPoolInterface* pool, BlockingCounter* counter,
                  int num_add)
       : pool_(pool), counter_(counter), num_add_(num_add) {
     functor_run = &AddSelfFunctor::Run;
@@ -205,18 +215,18 @@ class AddSelfFunctor : public grpc_completion_queue_functor {
   }
 
  private:
-  grpc_core::ThreadPool* pool_;
+  grpc_core::ThreadPoolInterface* pool_;
   BlockingCounter* counter_;
   int num_add_;
 };
 
-template <int kConcurrentFunctor>
+template <class ThreadPoolType, int kConcurrentFunctor>
 static void ThreadPoolAddSelf(benchmark::State& state) {
   const int num_iterations = state.range(0);
   const int num_threads = state.range(1);
   // Number of adds done by each closure.
   const int num_add = num_iterations / kConcurrentFunctor;
-  grpc_core::ThreadPool pool(num_threads);
+  ThreadPoolType pool(num_threads);
   while (state.KeepRunningBatch(num_iterations)) {
     BlockingCounter counter(kConcurrentFunctor);
     for (int i = 0; i < kConcurrentFunctor; ++i) {
@@ -227,17 +237,8 @@ static void ThreadPoolAddSelf(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations());
 }
 
-// First pair of arguments is range for number of iterations (num_iterations).
-// Second pair of arguments is range for thread pool size (num_threads).
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 1)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 4)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 8)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 16)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 32)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 64)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 128)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 512)->RangePair(524288, 524288, 1, 1024);
-BENCHMARK_TEMPLATE(ThreadPoolAddSelf, 2048)->RangePair(524288, 524288, 1, 1024);
+BENCHMARK_THREAD_POOL_ADD(ThreadPoolAddSelf, grpc_core::ThreadPool);
+BENCHMARK_THREAD_POOL_ADD(ThreadPoolAddSelf, grpc_core::WorkStealingThreadPool);
 
 #if defined(__GNUC__) && !defined(SWIG)
 #if defined(__i386__) || defined(__x86_64__)
@@ -291,13 +292,14 @@ class ShortWorkFunctorForAdd : public grpc_completion_queue_functor {
 // continuously so the number of workers running changes overtime.
 //
 // In effect this tests how well the threadpool avoids spurious wakeups.
+template <class ThreadPoolType>
 static void BM_SpikyLoad(benchmark::State& state) {
   const int num_threads = state.range(0);
 
   const int kNumSpikes = 1000;
   const int batch_size = 3 * num_threads;
   std::vector<ShortWorkFunctorForAdd> work_vector(batch_size);
-  grpc_core::ThreadPool pool(num_threads);
+  ThreadPoolType pool(num_threads);
   while (state.KeepRunningBatch(kNumSpikes * batch_size)) {
     for (int i = 0; i != kNumSpikes; ++i) {
       BlockingCounter counter(batch_size);
@@ -310,7 +312,12 @@ static void BM_SpikyLoad(benchmark::State& state) {
   }
   state.SetItemsProcessed(state.iterations() * batch_size);
 }
-BENCHMARK(BM_SpikyLoad)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_TEMPLATE(BM_SpikyLoad, grpc_core::ThreadPool)
+    ->RangeMultiplier(2)
+    ->Range(1, 64);
+BENCHMARK_TEMPLATE(BM_SpikyLoad, grpc_core::WorkStealingThreadPool)
+    ->RangeMultiplier(2)
+    ->Range(1, 64);
 
 }  // namespace testing
 }  // namespace grpc
@@ -18,6 +18,7 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <atomic>
 #include <vector>
 
@@ -104,6 +105,54 @@ BENCHMARK(BM_TimerBatch)
     ->Args({/*check=*/true, /*reverse=*/true})
     ->ThreadRange(1, 128);
 
+// Many pending timers, with deadlines spread over the next minute, almost all
+// of which are cancelled before they expire: the pattern of call deadlines
+// for calls that complete normally. Run with GRPC_TIMER_IMPL=wheel to compare
+// the timing wheel against the default implementation. state.range(0) is the
+// total number of pending timers, split evenly across the threads.
+static void BM_InitCancelManyTimers(benchmark::State& state) {
+  const int timer_count = std::max<int>(1, state.range(0) / state.threads());
+  TrackCounters track_counters;
+  grpc_core::ExecCtx exec_ctx;
+  std::vector<TimerClosure> timer_closures(timer_count);
+  const grpc_millis now = grpc_core::ExecCtx::Get()->Now();
+  for (int i = 0; i < timer_count; i++) {
+    GRPC_CLOSURE_INIT(
+        &timer_closures[i].closure,
+        [](void* /*args*/, grpc_error_handle /*err*/) {}, nullptr,
+        grpc_schedule_on_exec_ctx);
+    grpc_timer_init(&timer_closures[i].timer,
+                    now + 1000 + (i * grpc_millis{7919}) % 60000,
+                    &timer_closures[i].closure);
+  }
+  // Each iteration cancels the oldest timer and sets a new one in its place,
+  // keeping timer_count timers pending.
+  int i = 0;
+  for (auto _ : state) {
+    TimerClosure* timer_closure = &timer_closures[i];
+    grpc_timer_cancel(&timer_closure->timer);
+    grpc_timer_init(&timer_closure->timer,
+                    now + 1000 + (i * grpc_millis{7919}) % 60000,
+                    &timer_closure->closure);
+    if (++i == timer_count) {
+      i = 0;
+      exec_ctx.Flush();
+    }
+  }
+  exec_ctx.Flush();
+  for (auto& timer_closure : timer_closures) {
+    grpc_timer_cancel(&timer_closure.timer);
+  }
+  exec_ctx.Flush();
+  state.SetItemsProcessed(state.iterations());
+  track_counters.Finish(state);
+}
+BENCHMARK(BM_InitCancelManyTimers)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->ThreadRange(1, 64);
+
 }  // namespace testing
 }  // namespace grpc
 
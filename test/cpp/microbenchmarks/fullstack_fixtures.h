@@ -327,6 +327,35 @@ typedef MinStackize<InProcess> MinInProcess;
 typedef MinStackize<SockPair> MinSockPair;
 typedef MinStackize<InProcessCHTTP2> MinInProcessCHTTP2;
 
+////////////////////////////////////////////////////////////////////////////////
+// Compression fixtures
+
+template <bool kPerCallContexts>
+class GzipConfiguration : public FixtureConfiguration {
+  void ApplyCommonChannelArguments(ChannelArguments* a) const override {
+    a->SetCompressionAlgorithm(GRPC_COMPRESS_GZIP);
+    a->SetInt(GRPC_COMPRESSION_CHANNEL_PER_CALL_CONTEXTS, kPerCallContexts);
+    FixtureConfiguration::ApplyCommonChannelArguments(a);
+  }
+
+  void ApplyCommonServerBuilderConfig(ServerBuilder* b) const override {
+    b->SetDefaultCompressionAlgorithm(GRPC_COMPRESS_GZIP);
+    b->AddChannelArgument(GRPC_COMPRESSION_CHANNEL_PER_CALL_CONTEXTS,
+                          kPerCallContexts);
+    FixtureConfiguration::ApplyCommonServerBuilderConfig(b);
+  }
+};
+
+template <class Base, bool kPerCallContexts>
+class Gzipize : public Base {
+ public:
+  explicit Gzipize(Service* service)
+      : Base(service, GzipConfiguration<kPerCallContexts>()) {}
+};
+
+typedef Gzipize<InProcessCHTTP2, false> GzipInProcessCHTTP2;
+typedef Gzipize<InProcessCHTTP2, true> GzipPerCallContextsInProcessCHTTP2;
+
 }  // namespace testing
 }  // namespace grpc
 
@@ -16,6 +16,7 @@
  *
  */
 
+#include <chrono>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -153,6 +154,100 @@ TEST(ServerRequestCallTest, ShortDeadlineDoesNotCauseOkayFalse) {
   t.join();
 }
 
+// Polls both CQs until deadline. Returns the index of the CQ the first event
+// was delivered to, or -1 if there was none.
+int NextEvent(std::unique_ptr<ServerCompletionQueue>* cqs, void** tag,
+              bool* ok, std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::system_clock::now() + timeout;
+  while (std::chrono::system_clock::now() < deadline) {
+    for (int i = 0; i < 2; i++) {
+      if (cqs[i]->AsyncNext(tag, ok,
+                            std::chrono::system_clock::now() +
+                                std::chrono::milliseconds(10)) ==
+          CompletionQueue::GOT_EVENT) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+TEST(ServerRequestCallTest, ConnectionCompletionQueueAffinity) {
+  std::ostringstream s;
+  int p = grpc_pick_unused_port_or_die();
+  s << "[::1]:" << p;
+  const string address = s.str();
+  testing::EchoTestService::AsyncService service;
+  ServerBuilder builder;
+  builder.AddListeningPort(address, InsecureServerCredentials());
+  builder.SetConnectionCompletionQueueAffinity(true);
+  std::unique_ptr<ServerCompletionQueue> cqs[2] = {
+      builder.AddCompletionQueue(), builder.AddCompletionQueue()};
+  builder.RegisterService(&service);
+  auto server = builder.BuildAndStart();
+
+  struct Request {
+    ServerContext ctx;
+    testing::EchoRequest req;
+    ServerAsyncResponseWriter<testing::EchoResponse> responder{&ctx};
+  };
+  Request requests[3];
+  auto request_echo = [&](int request, int cq) {
+    service.RequestEcho(&requests[request].ctx, &requests[request].req,
+                        &requests[request].responder, cqs[cq].get(),
+                        cqs[cq].get(), reinterpret_cast<void*>(request));
+  };
+  auto finish = [&](int request, int cq) {
+    testing::EchoResponse response;
+    response.set_message(requests[request].req.message());
+    requests[request].responder.Finish(response, Status::OK,
+                                       reinterpret_cast<void*>(100));
+    void* tag;
+    bool ok;
+    EXPECT_EQ(NextEvent(cqs, &tag, &ok, std::chrono::seconds(10)), cq);
+    EXPECT_EQ(tag, reinterpret_cast<void*>(100));
+  };
+
+  auto stub = testing::EchoTestService::NewStub(
+      grpc::CreateChannel(address, InsecureChannelCredentials()));
+  std::thread client([&stub] {
+    for (int i = 0; i < 2; i++) {
+      ClientContext ctx;
+      testing::EchoRequest request;
+      testing::EchoResponse response;
+      request.set_message("foobar");
+      EXPECT_TRUE(stub->Echo(&ctx, request, &response).ok());
+    }
+  });
+
+  // The first call goes to the CQ its connection is bound to.
+  request_echo(0, 0);
+  request_echo(1, 1);
+  void* tag;
+  bool ok;
+  const int bound_cq = NextEvent(cqs, &tag, &ok, std::chrono::seconds(10));
+  ASSERT_NE(bound_cq, -1);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(tag, reinterpret_cast<void*>(bound_cq));
+  finish(bound_cq, bound_cq);
+  // With no request left on that CQ, the second call waits for one rather
+  // than taking the request outstanding on the other CQ.
+  EXPECT_EQ(NextEvent(cqs, &tag, &ok, std::chrono::milliseconds(500)), -1);
+  request_echo(2, bound_cq);
+  EXPECT_EQ(NextEvent(cqs, &tag, &ok, std::chrono::seconds(10)), bound_cq);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(tag, reinterpret_cast<void*>(2));
+  finish(2, bound_cq);
+  client.join();
+
+  server->Shutdown();
+  for (auto& cq : cqs) {
+    cq->Shutdown();
+    while (cq->Next(&tag, &ok)) {
+    }
+  }
+}
+
 }  // namespace
 }  // namespace grpc
 
@@ -20,6 +20,7 @@
 
 #include "src/cpp/thread_manager/thread_manager.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <climits>
@@ -57,6 +58,9 @@ struct TestThreadManagerSettings {
 
   // How many should be instantiated
   int thread_manager_count;
+
+  // The queueing delay target, or 0 to leave the controller disabled
+  int64_t queueing_delay_target_us;
 };
 
 class TestThreadManager final : public grpc::ThreadManager {
@@ -67,7 +71,11 @@ class TestThreadManager final : public grpc::ThreadManager {
         settings_(settings),
         num_do_work_(0),
         num_poll_for_work_(0),
-        num_work_found_(0) {}
+        num_work_found_(0) {
+    if (settings.queueing_delay_target_us > 0) {
+      SetQueueingDelayTarget(settings.queueing_delay_target_us);
+    }
+  }
 
   grpc::ThreadManager::WorkStatus PollForWork(void** tag, bool* ok) override;
   void DoWork(void* /* tag */, bool /*ok*/, bool /*resources*/) override {
@@ -78,6 +86,11 @@ class TestThreadManager final : public grpc::ThreadManager {
         std::chrono::milliseconds(settings_.work_duration_ms));
   }
 
+  // Pretend that work waited for as long as polling took
+  int64_t QueueingDelayUs(void* /* tag */) override {
+    return settings_.poll_duration_ms * 1000;
+  }
+
   // Get number of times PollForWork() was called
   int num_poll_for_work() const {
     return num_poll_for_work_.load(std::memory_order_relaxed);
@@ -151,10 +164,14 @@ class ThreadManagerTest
 TestThreadManagerSettings scenarios[] = {
     {2 /* min_pollers */, 10 /* max_pollers */, 10 /* poll_duration_ms */,
      1 /* work_duration_ms */, 50 /* max_poll_calls */,
-     INT_MAX /* thread_limit */, 1 /* thread_manager_count */},
+     INT_MAX /* thread_limit */, 1 /* thread_manager_count */,
+     0 /* queueing_delay_target_us */},
     {1 /* min_pollers */, 1 /* max_pollers */, 1 /* poll_duration_ms */,
      10 /* work_duration_ms */, 50 /* max_poll_calls */, 3 /* thread_limit */,
-     2 /* thread_manager_count */}};
+     2 /* thread_manager_count */, 0 /* queueing_delay_target_us */},
+    {1 /* min_pollers */, 10 /* max_pollers */, 1 /* poll_duration_ms */,
+     10 /* work_duration_ms */, 200 /* max_poll_calls */, 4 /* thread_limit */,
+     1 /* thread_manager_count */, 100 /* queueing_delay_target_us */}};
 
 INSTANTIATE_TEST_SUITE_P(ThreadManagerTest, ThreadManagerTest,
                          ::testing::ValuesIn(scenarios));
@@ -178,6 +195,96 @@ TEST_P(ThreadManagerTest, TestThreadQuota) {
   }
 }
 
+TEST_P(ThreadManagerTest, TestQueueingDelayHistogram) {
+  for (auto& tm : thread_manager_) {
+    std::vector<uint64_t> histogram = tm->GetQueueingDelayHistogram();
+    ASSERT_EQ(histogram.size(), grpc::ThreadManager::kQueueingDelayBuckets);
+    uint64_t total = 0;
+    for (uint64_t count : histogram) total += count;
+    EXPECT_EQ(total, static_cast<uint64_t>(tm->num_work_found()));
+  }
+}
+
+// Finds work that waited well past the queueing delay target while loaded,
+// and times out while idle.
+class LoadThenIdleThreadManager final : public grpc::ThreadManager {
+ public:
+  explicit LoadThenIdleThreadManager(grpc_resource_quota* rq)
+      : ThreadManager("LoadThenIdleThreadManager", rq, 1 /* min_pollers */,
+                      64 /* max_pollers */) {
+    SetQueueingDelayTarget(100);
+  }
+
+  void set_loaded(bool loaded) {
+    loaded_.store(loaded, std::memory_order_relaxed);
+  }
+
+  grpc::ThreadManager::WorkStatus PollForWork(void** tag, bool* ok) override {
+    if (IsShutdown()) return SHUTDOWN;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    *tag = nullptr;
+    *ok = true;
+    return loaded_.load(std::memory_order_relaxed) ? WORK_FOUND : TIMEOUT;
+  }
+
+  void DoWork(void* /* tag */, bool /*ok*/, bool /*resources*/) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  int64_t QueueingDelayUs(void* /* tag */) override { return 1000; }
+
+ private:
+  std::atomic<bool> loaded_{true};
+};
+
+// Polls GetNumThreads() until it is at most max_threads or 20 seconds have
+// passed, and returns its last value.
+int WaitForNumThreadsAtMost(grpc::ThreadManager* tm, int max_threads) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  int num_threads = tm->GetNumThreads();
+  while (num_threads > max_threads &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    num_threads = tm->GetNumThreads();
+  }
+  return num_threads;
+}
+
+// The smallest GetNumThreads() seen over the given time.
+int MinNumThreadsOver(grpc::ThreadManager* tm,
+                      std::chrono::milliseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  int min_threads = tm->GetNumThreads();
+  while (std::chrono::steady_clock::now() < end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    min_threads = std::min(min_threads, tm->GetNumThreads());
+  }
+  return min_threads;
+}
+
+TEST(ThreadManagerControllerTest, GrowsUnderLoadAndShrinksWhenIdle) {
+  grpc_resource_quota* rq = grpc_resource_quota_create("Thread manager test");
+  LoadThenIdleThreadManager tm(rq);
+  grpc_resource_quota_unref(rq);
+  tm.Initialize();
+  // Work queues up past the target in every control interval, so the
+  // controller raises its target several times over. Threads above the
+  // target would exit as soon as they are done with their work, so only a
+  // raised target keeps them around.
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  const int loaded_threads =
+      MinNumThreadsOver(&tm, std::chrono::milliseconds(300));
+  EXPECT_GE(loaded_threads, 4);
+  // Without work, nothing is busy and the target drops back to min_pollers.
+  tm.set_loaded(false);
+  EXPECT_EQ(WaitForNumThreadsAtMost(&tm, 1), 1);
+  // And stays there.
+  EXPECT_EQ(MinNumThreadsOver(&tm, std::chrono::milliseconds(300)), 1);
+  tm.Shutdown();
+  tm.Wait();
+}
+
 }  // namespace
 }  // namespace grpc
 
@@ -0,0 +1,124 @@
+/*
+ *
+ * Copyright 2022 gRPC authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+  Trains a dictionary for zstd message compression from captured payloads,
+  to be registered with grpc::experimental::RegisterCompressionDictionary.
+
+  Each argument is a file holding one serialized message, or with
+  --delimited, a stream of messages each prefixed by its varint encoded length
+  (as written by protobuf's writeDelimitedTo). For example:
+
+  train_compression_dictionary --output=echo.dict --delimited captured.bin
+*/
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+
+#include <grpc/grpc.h>
+
+#include "src/core/lib/compression/compression_dictionary.h"
+#include "test/cpp/util/test_config.h"
+
+ABSL_FLAG(std::string, output, "", "file to write the dictionary to");
+ABSL_FLAG(int32_t, max_size, 32 * 1024, "maximum size of the dictionary");
+ABSL_FLAG(bool, delimited, false,
+          "input files hold length delimited messages rather than a single "
+          "message each");
+
+namespace {
+
+bool ReadFile(const char* path, std::string* contents) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  contents->assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Appends the length delimited messages in data to samples. Returns false if
+// data is truncated.
+bool SplitDelimited(const std::string& data,
+                    std::vector<std::string>* samples) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    uint64_t length = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      if (pos == data.size() || shift > 63) return false;
+      byte = static_cast<uint8_t>(data[pos++]);
+      length |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    if (length > data.size() - pos) return false;
+    samples->push_back(data.substr(pos, length));
+    pos += length;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  grpc::testing::InitTest(&argc, &argv, true);
+  if (argc < 2 || absl::GetFlag(FLAGS_output).empty()) {
+    std::cerr << "usage: " << argv[0]
+              << " --output=<dictionary> [--delimited] <payload files>..."
+              << std::endl;
+    return 1;
+  }
+  std::vector<std::string> samples;
+  for (int i = 1; i < argc; i++) {
+    std::string data;
+    if (!ReadFile(argv[i], &data)) {
+      std::cerr << "cannot read " << argv[i] << std::endl;
+      return 1;
+    }
+    if (!absl::GetFlag(FLAGS_delimited)) {
+      samples.push_back(std::move(data));
+    } else if (!SplitDelimited(data, &samples)) {
+      std::cerr << argv[i] << " is not a stream of length delimited messages"
+                << std::endl;
+      return 1;
+    }
+  }
+  absl::StatusOr<std::string> dictionary =
+      grpc_core::TrainCompressionDictionary(samples,
+                                            absl::GetFlag(FLAGS_max_size));
+  if (!dictionary.ok()) {
+    std::cerr << dictionary.status().ToString() << std::endl;
+    return 1;
+  }
+  std::ofstream out(absl::GetFlag(FLAGS_output), std::ios::binary);
+  out << *dictionary;
+  if (!out.flush()) {
+    std::cerr << "cannot write " << absl::GetFlag(FLAGS_output) << std::endl;
+    return 1;
+  }
+  grpc_core::RefCountedPtr<grpc_core::CompressionDictionary> dict =
+      grpc_core::CompressionDictionary::Create(*dictionary);
+  std::cout << "Trained a " << dictionary->size() << " byte dictionary from "
+            << samples.size() << " samples, id " << dict->id() << std::endl;
+  return 0;
+}
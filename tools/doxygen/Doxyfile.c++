@@ -1034,6 +1034,7 @@ include/grpcpp/support/byte_buffer.h \
 include/grpcpp/support/channel_arguments.h \
 include/grpcpp/support/client_callback.h \
 include/grpcpp/support/client_interceptor.h \
+include/grpcpp/support/compression_dictionary.h \
 include/grpcpp/support/config.h \
 include/grpcpp/support/interceptor.h \
 include/grpcpp/support/message_allocator.h \
@@ -22,9 +22,15 @@ _AVAILABLE_BENCHMARK_TESTS = [
     'bm_closure',
     'bm_cq',
     'bm_call_create',
+    'bm_channel_pick',
+    'bm_round_robin_pick',
+    'bm_least_request_latency',
+    'bm_ring_hash',
     'bm_error',
     'bm_chttp2_hpack',
+    'bm_chttp2_stream_map',
     'bm_chttp2_transport',
+    'bm_compression',
     'bm_pollset',
 ]
 
@@ -33,6 +33,9 @@ def massage_qps_stats(scenario_result):
             stats[
                 "core_server_calls_created"] = massage_qps_stats_helpers.counter(
                     core_stats, "server_calls_created")
+            stats[
+                "core_call_arena_overflows"] = massage_qps_stats_helpers.counter(
+                    core_stats, "call_arena_overflows")
             stats["core_cqs_created"] = massage_qps_stats_helpers.counter(
                 core_stats, "cqs_created")
             stats[
@@ -83,6 +86,8 @@ def massage_qps_stats(scenario_result):
             stats[
                 "core_tcp_backup_poller_polls"] = massage_qps_stats_helpers.counter(
                     core_stats, "tcp_backup_poller_polls")
+            stats["core_tcp_read_zerocopy"] = massage_qps_stats_helpers.counter(
+                core_stats, "tcp_read_zerocopy")
             stats["core_http2_op_batches"] = massage_qps_stats_helpers.counter(
                 core_stats, "http2_op_batches")
             stats["core_http2_op_cancel"] = massage_qps_stats_helpers.counter(
@@ -263,6 +268,9 @@ def massage_qps_stats(scenario_result):
             stats[
                 "core_hpack_send_binary_base64"] = massage_qps_stats_helpers.counter(
                     core_stats, "hpack_send_binary_base64")
+            stats[
+                "core_hpack_send_pre_encoded"] = massage_qps_stats_helpers.counter(
+                    core_stats, "hpack_send_pre_encoded")
             stats[
                 "core_combiner_locks_initiated"] = massage_qps_stats_helpers.counter(
                     core_stats, "combiner_locks_initiated")
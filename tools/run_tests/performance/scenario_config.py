@@ -375,6 +375,24 @@ class CXXLanguage(Language):
                 channels=1,
                 outstanding=100)
 
+            # Many streams with mid-sized messages sharing one connection:
+            # sensitive to how writes are sized and coalesced, so watch the
+            # latency percentiles alongside qps.
+            yield _ping_pong_scenario(
+                'cpp_generic_async_streaming_qps_1channel_64KBmsg_%s' % secstr,
+                rpc_type='STREAMING',
+                req_size=64 * 1024,
+                resp_size=64 * 1024,
+                client_type='ASYNC_CLIENT',
+                server_type='ASYNC_GENERIC_SERVER',
+                unconstrained_client='async',
+                use_generic_payload=True,
+                secure=secure,
+                minimal_stack=not secure,
+                categories=inproc_categories + [SCALABLE],
+                channels=1,
+                outstanding=100)
+
             yield _ping_pong_scenario(
                 'cpp_generic_async_streaming_qps_unconstrained_64KBmsg_%s' %
                 secstr,
@@ -19,6 +19,7 @@ from __future__ import print_function
 import argparse
 import ast
 import collections
+import ctypes
 import glob
 import itertools
 import json
@@ -63,7 +64,7 @@ _FORCE_ENVIRON_FOR_WRAPPERS = {
 }
 
 _POLLING_STRATEGIES = {
-    'linux': ['epollex', 'epoll1', 'poll'],
+    'linux': ['epollex', 'epoll1', 'io_uring', 'poll'],
     'mac': ['poll'],
 }
 
@@ -1733,6 +1734,22 @@ def _has_epollexclusive():
         return False
 
 
+def _has_io_uring():
+    """Whether the kernel offers the multishot poll requests (5.13+) needed by
+    the io_uring polling engine, and lets this process set up a ring."""
+    match = re.match(r'(\d+)\.(\d+)', platform.release())
+    if not match or (int(match.group(1)), int(match.group(2))) < (5, 13):
+        return False
+    # __NR_io_uring_setup is 425 on the architectures tests run on
+    libc = ctypes.CDLL(None, use_errno=True)
+    params = ctypes.create_string_buffer(120)
+    fd = libc.syscall(425, 1, params)
+    if fd < 0:
+        return False
+    os.close(fd)
+    return True
+
+
 # returns a list of things that failed (or an empty list on success)
 def _build_and_run(check_cancelled,
                    newline_on_success,
@@ -1760,6 +1777,12 @@ def _build_and_run(check_cancelled,
         print('\n\nOmitting EPOLLEXCLUSIVE tests\n\n')
         _POLLING_STRATEGIES[platform_string()].remove('epollex')
 
+    if platform_string(
+    ) in _POLLING_STRATEGIES and 'io_uring' in _POLLING_STRATEGIES[
+            platform_string()] and not _has_io_uring():
+        print('\n\nOmitting io_uring tests\n\n')
+        _POLLING_STRATEGIES[platform_string()].remove('io_uring')
+
     # start antagonists
     antagonists = [
         subprocess.Popen(['tools/run_tests/python_utils/antagonist.py'])